@@ -13,6 +13,46 @@
 #include "stm32f4xx_hal_rcc.h"
 #include "stm32f4xx_ll_dma.h"
 #include "cmsis_os.h"
+#include "DMAController.hpp"
+#include "etl/queue_spsc_atomic.h"
+
+/* Constants ------------------------------------------------------------------*/
+constexpr uint16_t UART_DMA_TX_BUFFER_BYTES = 256;			// Size of each of the two DMA transmit buffers
+constexpr uint16_t UART_DMA_TX_TIMEOUT_MS = 100;			// Max time to wait for a DMA transfer, 256 bytes take ~22ms at 115200 baud
+constexpr uint32_t UART_DRIVER_EVENT_TX_DONE = (1UL << 30);	// Task event bit set on the transmitting task when a DMA transfer completes or the TX ring has room, reserved like TASK_EVENT_QUEUE
+constexpr uint16_t UART_DMA_RX_BUFFER_BYTES = 256;			// Size of the circular DMA receive buffer, must hold the bytes received between two interrupts
+constexpr uint16_t UART_TX_RING_BYTES = 512;				// Size of the interrupt transmit ring
+constexpr uint16_t UART_TX_RING_TIMEOUT_MS = 100;			// Max time Transmit or FlushTx waits for the ring to drain
+
+/* Structs ------------------------------------------------------------------*/
+/**
+ * @brief One contiguous piece of a scatter-gather transmit, eg. a frame header, body or CRC
+ */
+struct UARTSegment
+{
+	const uint8_t* data;	// Bytes to send, must stay valid until Transmit returns
+	uint16_t len;			// Number of bytes
+};
+
+/**
+ * @brief Link statistics of one UART instance, since boot or the last ResetLinkStats
+ */
+struct UARTLinkStats
+{
+	uint32_t rxBytes;			// Bytes received, including bytes dropped because no receiver was registered
+	uint32_t txBytes;			// Bytes passed to Transmit
+	uint32_t overrunErrors;		// ORE, a byte arrived before the last one was read, the interrupt was serviced too late
+	uint32_t noiseErrors;		// NE
+	uint32_t framingErrors;		// FE
+	uint32_t parityErrors;		// PE
+	uint32_t isrCount;			// UART and DMA stream interrupts serviced
+	uint32_t maxIsrCycles;		// Longest interrupt in CPU cycles, 0 unless EnableIsrTiming was called
+	uint32_t txBusyTicks;		// Ticks callers spent inside Transmit, waiting for buffers or polling
+};
+
+/* Types ------------------------------------------------------------------*/
+// Interrupt transmit ring, producers are serialized by a critical section and the TXE interrupt is the only consumer
+using UARTTxRing = etl::queue_spsc_atomic<uint8_t, UART_TX_RING_BYTES, etl::memory_model::MEMORY_MODEL_MEDIUM>;
 
 /* UART Driver Instances ------------------------------------------------------------------*/
 class UARTDriver;
@@ -38,13 +78,38 @@ class UARTReceiverBase
 {
 public:
 	virtual void InterruptRxData(uint8_t errors) = 0;
+
+	/**
+	 * @brief Called in ISR context with a contiguous span of bytes when the driver receives through DMA,
+	 *        override to take whole spans instead of one InterruptRxData call per byte
+	 * @param data Received bytes, only valid during the call
+	 * @param len Number of bytes
+	 * @param errors UART receive errors
+	 * @return true if the span was consumed, false to have it delivered byte by byte through InterruptRxData
+	 */
+	virtual bool InterruptRxSpan(const uint8_t* data, uint16_t len, uint8_t errors) { return false; }
 };
 
 
 /* UART Driver Class ------------------------------------------------------------------*/
 /**
- * @brief This is a basic UART driver designed for Interrupt Rx and Polling Tx
+ * @brief This is a basic UART driver designed for Interrupt or DMA Rx and Polling or DMA Tx
  *	      based on the STM32 LL Library
+ *
+ * With ConfigureTxDMA, Transmit copies into one of two buffers while the other is on the wire and
+ * returns once its data is copied, the calling task blocks only while both buffers are in use.
+ * Only one task may transmit on an instance at a time. The stream cannot be extended while it runs, so a
+ * full buffer is started by the task once the one in flight completes. The wire stays gap-free only if that
+ * task runs within the two frames the USART still holds at the transfer complete interrupt, ~170us at
+ * 115200 baud, and a message shorter than a buffer is started on its own, it is never topped up by the next.
+ *
+ * With ConfigureTxInterrupt, for instances without a free DMA stream, Transmit copies into a ring that the TXE
+ * interrupt drains and returns immediately, FlushTx waits until the last byte is on the wire. A message that fits
+ * in the ring is never interleaved with another task's message.
+ *
+ * With ConfigureRxDMA, received bytes go into a circular buffer and are handed to the receiver
+ * in spans on the half transfer, transfer complete and IDLE line interrupts. ReceiveIT then only
+ * registers the receiver. Instances without it receive one RXNE interrupt per byte.
  */
 class UARTDriver
 {
@@ -52,22 +117,63 @@ public:
 	UARTDriver(USART_TypeDef* uartInstance) :
 		kUart_(uartInstance),
 		rxCharBuf_(nullptr),
-		rxReceiver_(nullptr) {}
-
-	// Polling Functions
-	bool Transmit(uint8_t* data, uint16_t len);
+		rxReceiver_(nullptr),
+		txDma_(nullptr),
+		txBuffers_(nullptr),
+		txFillIndex_(0),
+		txDmaBusy_(false),
+		txWaitTask_(nullptr),
+		rxDma_(nullptr),
+		rxDmaBuffer_(nullptr),
+		rxDmaReadIndex_(0),
+		txRing_(nullptr),
+		txNotifyTask_(nullptr),
+		txNotifyEvents_(0),
+		linkStats_{} {}
+
+	// Setup
+	static void EnableIsrTiming();	// Starts the DWT cycle counter used for maxIsrCycles
+	void ConfigureTxDMA(DMAController* dma, uint8_t* buffers);	// buffers must hold 2 * UART_DMA_TX_BUFFER_BYTES
+	void ConfigureRxDMA(DMAController* dma, uint8_t* buffer);	// buffer must hold UART_DMA_RX_BUFFER_BYTES
+	void ConfigureTxInterrupt(UARTTxRing* ring);				// Exclusive with ConfigureTxDMA
+	void SetTxNotifyTarget(TaskHandle_t task, uint32_t events);	// Events set on task when TryTransmit can accept data again
+
+	// Transmit Functions
+	bool Transmit(uint8_t* data, uint16_t len);			// DMA if configured and called from a task, polling otherwise
+	bool Transmit(const UARTSegment* segments, uint8_t count);	// Sends the segments back to back, as one message
+	bool TryTransmit(const UARTSegment* segments, uint8_t count);	// Like Transmit, but returns false instead of waiting for the DMA stream or ring
+	bool TransmitPolling(const uint8_t* data, uint16_t len);	// Always polls, safe with the scheduler suspended (assert handler)
+	bool FlushTx(uint32_t timeout_ms = UART_TX_RING_TIMEOUT_MS);	// Waits until all data passed to Transmit is on the wire
 
 	// Interrupt Functions
 	bool ReceiveIT(uint8_t* charBuf, UARTReceiverBase* receiver);
 
+	// Statistics
+	void GetLinkStats(UARTLinkStats& statsOut) const;
+	void ResetLinkStats();
+
 
 	// Interrupt Handlers
 	void HandleIRQ_UART(); // This MUST be called inside USARTx_IRQHandler
+	void HandleIRQ_TxDMA(); // This MUST be called inside the TX DMAx_Streamy_IRQHandler
+	void HandleIRQ_RxDMA(); // This MUST be called inside the RX DMAx_Streamy_IRQHandler
 
 protected:
 	// Helper Functions
 	bool HandleAndClearRxError();
 	bool GetRxErrors();
+	bool TransmitPollingSegments(const UARTSegment* segments, uint8_t count);
+	void CountTx(uint32_t bytes, TickType_t busyTicks);
+	void NotifyTxTargetFromISR(BaseType_t* pxHigherPriorityTaskWoken);
+	bool TransmitDMA(const UARTSegment* segments, uint8_t count);
+	bool StartTxDMA(uint16_t len);
+	bool WaitTxDMAIdle();
+	void ProcessRxDMA();
+	bool TransmitRing(const UARTSegment* segments, uint8_t count);
+	bool PushTxRing(const UARTSegment* segments, uint8_t count);
+	void HandleTxRingIRQ();
+	bool IsTxRingActive() const { return txRing_ != nullptr && LL_USART_IsEnabledIT_TXE(kUart_); }
+	void DeliverRx(const uint8_t* data, uint16_t len, uint8_t errors);
 
 
 	// Constants
@@ -76,6 +182,29 @@ protected:
 	// Variables
 	uint8_t* rxCharBuf_; // Stores a pointer to the buffer to store the received data
 	UARTReceiverBase* rxReceiver_; // Stores a pointer to the receiver object
+
+	// DMA Transmit
+	DMAController* txDma_; // Transmit stream, nullptr for polling
+	uint8_t* txBuffers_; // Two UART_DMA_TX_BUFFER_BYTES ping-pong buffers
+	uint8_t txFillIndex_; // Buffer the next Transmit copies into, never the one in flight
+	volatile bool txDmaBusy_; // Set when a transfer starts, cleared by the DMA interrupt
+	volatile TaskHandle_t txWaitTask_; // Task waiting for the transfer in flight, notified with UART_DRIVER_EVENT_TX_DONE
+
+	// DMA Receive
+	DMAController* rxDma_; // Circular receive stream, nullptr for RXNE interrupts
+	uint8_t* rxDmaBuffer_; // UART_DMA_RX_BUFFER_BYTES circular buffer written by the stream
+	uint16_t rxDmaReadIndex_; // First byte not yet handed to the receiver, only used in the UART and RX DMA interrupts
+
+	// Interrupt Transmit
+	UARTTxRing* txRing_; // Ring drained by the TXE interrupt, nullptr if not configured
+
+	// Asynchronous Transmit
+	TaskHandle_t txNotifyTask_; // Task told when the DMA stream completes or the ring has room, nullptr if none
+	uint32_t txNotifyEvents_; // Events set on txNotifyTask_
+
+	// Statistics, the receive and interrupt counters are only written at the UART interrupt priority
+	UARTLinkStats linkStats_;
+	friend class UARTIsrTimer;
 };
 
 
@@ -8,11 +8,15 @@
 #define SOAR_COMMS_UARTTASK_HPP_
 /* Includes ------------------------------------------------------------------*/
 #include "Task.hpp"
+#include "CommandRouter.hpp"
 #include "SystemDefines.hpp"
+#include "BinaryLog.hpp"
 
 
 
 /* Macros ------------------------------------------------------------------*/
+constexpr uint32_t UART_TASK_EVENT_LOG = (1UL << 0);	// A task printed a line into its TaskLog
+constexpr uint32_t UART_TASK_EVENT_TX_READY = (1UL << 1);	// A UART finished a transfer or has ring space, a pending burst can be sent
 enum UART_TASK_COMMANDS {
 	UART_TASK_COMMAND_NONE = 0,
 	UART_TASK_COMMAND_SEND_DEBUG,
@@ -20,9 +24,35 @@ enum UART_TASK_COMMANDS {
 	UART_TASK_COMMAND_MAX
 };
 
+constexpr uint8_t UART_TASK_MAX_SEGMENTS = 8;	// Max segments passed to SendProtocolSegments, and in one transmit of a pending message
+constexpr uint16_t UART_TASK_BURST_BYTES = 256;	// Max bytes of consecutive messages coalesced into one transmit, per channel
+constexpr uint8_t UART_TASK_BURST_SEGMENTS = 8;	// Max messages coalesced into one transmit, per channel
+constexpr uint16_t UART_TASK_BURST_LATENCY_MS = 10;	// Time a burst stays open for more messages after its first, unless it fills up first
+
+static_assert(TASK_LOG_FORMAT_BYTES <= UART_TASK_BURST_BYTES && BINARY_LOG_DRAIN_BUFFER_BYTES <= UART_TASK_BURST_BYTES,
+	"A task log line or binary log drain must fit in one UART burst");
+
+/* Structs ------------------------------------------------------------------*/
+struct UARTBurstStats
+{
+	uint32_t burstCount;		// Transmits issued for coalesced bursts
+	uint32_t messageCount;		// Messages and log lines packed into the bursts, burstCount less than this is the transmits saved
+	uint32_t byteCount;			// Bytes sent in bursts
+	uint32_t transmitTicks;		// Total ticks the task spent in Transmit
+	uint16_t maxBurstBytes;		// Largest burst sent
+	uint32_t droppedCount;		// Messages dropped because their channel already held a pending message
+};
+
+using UARTSendDebugMessage = CommandMessage<DATA_COMMAND, UART_TASK_COMMAND_SEND_DEBUG>;
+using UARTSendProtocolMessage = CommandMessage<DATA_COMMAND, UART_TASK_COMMAND_SEND_PROTOCOL>;
+
+class UARTTask;
+using UARTTaskRouter = CommandRouter<UARTTask, UARTSendDebugMessage, UARTSendProtocolMessage>;
+
 
 /* Class ------------------------------------------------------------------*/
-class UARTTask : public Task
+class UARTTask : public StaticTask<UART_TASK_STACK_DEPTH_WORDS,
+	0, UART_TASK_QUEUE_DEPTH_OBJS, UART_TASK_DEBUG_QUEUE_DEPTH_OBJS>, public UARTTaskRouter
 {
 public:
 	static UARTTask& Inst() {
@@ -32,18 +62,83 @@ public:
 
 	void InitTask();
 
+	static bool SendProtocolSegments(const UARTSegment* segments, uint8_t count);	// Copies the frame, the segments may be reused on return
+
+	void GetBurstStats(UARTBurstStats& statsOut) const;
+
 protected:
 	static void RunTask(void* pvParams) { UARTTask::Inst().Run(pvParams); } // Static Task Interface, passes control to the instance Run();
 
 	void Run(void* pvParams);	// Main run code
 
 	void ConfigureUART();
-	void HandleCommand(Command& cm);
+	void DrainTaskLogs();
+	void DrainBinaryLog();
+
+	// Transmit coalescing, consecutive messages for a channel are gathered into one transmit. Each message is a
+	// segment pointing at its own data, the driver copies every segment once into the DMA buffer or ring.
+	// A burst is sent once its first message has waited UART_TASK_BURST_LATENCY_MS, or earlier when the next
+	// message does not fit. Nothing waits for a busy channel, a message that does not fit is held in the pending
+	// slot of its channel and sent on UART_TASK_EVENT_TX_READY, the channel's queue lane is not received from until then.
+	struct Burst
+	{
+		UARTDriver* uart;							// Channel the burst is sent on
+		TickType_t startTick;						// Tick the first message was packed
+		uint16_t len;								// Bytes packed
+		uint8_t count;								// Segments packed
+		UARTSegment segments[UART_TASK_BURST_SEGMENTS];	// Data of each message, in order
+		Command held[UART_TASK_BURST_SEGMENTS];		// Commands owning the segment data, reset once sent, empty for log segments
+		uint8_t* stage;								// Log lines and records are read out of their rings into here, nullptr if unused
+		uint16_t stageLen;							// Bytes used in stage
+
+		Command pending;							// Message that did not fit while the channel was busy, sent after the burst
+		UARTSegment pendingSegment;					// Data of the pending message
+		const UARTSegment* pendingSegments;			// Segments of the pending message, pendingSegment
+		uint8_t pendingCount;						// Segments in the pending message, 0 if there is none
+		uint8_t pendingIndex;						// Next segment of the pending message to send
+		uint16_t pendingOffset;						// Bytes of pendingIndex already sent
+		uint8_t lane;								// QUEUE_LANE messages for the channel are sent on
+	};
+	bool ReceiveNext(Command& cm);
+	void Coalesce(Burst& burst, Command& cm);
+	void PackCommand(Burst& burst, Command& cm);
+	void PackBytes(Burst& burst, const uint8_t* data, uint16_t len);
+	void HoldPending(Burst& burst, Command& cm);
+	bool SendPending(Burst& burst);
+	bool ServiceChannel(Burst& burst);
+	bool SendChannel(Burst& burst) { return FlushBurst(burst) && SendPending(burst); }	// Sends the burst then the pending message, false while the channel is busy
+	bool FlushBurst(Burst& burst);
+	bool IsBurstDue(const Burst& burst) const {
+		return burst.count > 0 && xTaskGetTickCount() - burst.startTick >= MS_TO_TICKS(UART_TASK_BURST_LATENCY_MS);
+	}
+	uint32_t GetWaitMs() const;
+	bool HasRoom(const Burst& burst, uint16_t len, uint8_t count = 1) const {
+		return burst.pendingCount == 0 && burst.count + count <= UART_TASK_BURST_SEGMENTS && len <= UART_TASK_BURST_BYTES - burst.len;
+	}
+	bool MakeRoom(Burst& burst, uint16_t len, uint8_t count = 1);
+	bool TransmitCounted(UARTDriver* uart, const UARTSegment* segments, uint8_t count, uint16_t messages);
+
+	// Message handlers
+	friend UARTTaskRouter;
+	void OnMessage(const UARTSendDebugMessage& msg);
+	void OnMessage(const UARTSendProtocolMessage& msg);
+	void OnUnsupported(Command& cm);
 
 private:
-	UARTTask() : Task(UART_TASK_QUEUE_DEPTH_OBJS) {}	// Private constructor
+	UARTTask() : debugBurst{ UART::Debug, 0, 0, 0, {}, {}, logStage, 0, {}, {}, nullptr, 0, 0, 0, QUEUE_LANE_DEBUG },
+		protocolBurst{ UART::Protocol, 0, 0, 0, {}, {}, nullptr, 0, {}, {}, nullptr, 0, 0, 0, QUEUE_LANE_DEFAULT }, burstStats{} {	// Private constructor
+		// Prints are sent from every task, so never block a sender on a full debug lane, keep the newest output instead.
+		// Protocol frames use the default lane, which keeps blocking so debug load never evicts them
+		qEvtQueue->SetSendPolicy(QUEUE_SEND_DROP_OLDEST, QUEUE_LANE_DEBUG);
+	}
 	UARTTask(const UARTTask&);						// Prevent copy-construction
 	UARTTask& operator=(const UARTTask&);			// Prevent assignment
+
+	uint8_t logStage[UART_TASK_BURST_BYTES];			// Task log lines and deferred log records waiting in the debug burst
+
+	Burst debugBurst;
+	Burst protocolBurst;
+	UARTBurstStats burstStats;
 };
 
 
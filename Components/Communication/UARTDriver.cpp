@@ -14,6 +14,9 @@
 */
 #include "UARTDriver.hpp"
 #include "main_avionics.hpp"
+#include "Utils.hpp"
+
+#include <cstring>
 
 // Declare the global UART driver objects
 namespace Driver {
@@ -22,19 +25,243 @@ namespace Driver {
 }
 
 /**
- * @brief Transmits data via polling
- * @param data The data to transmit
+ * @brief Counts an interrupt of a driver and tracks the longest one, for the lifetime of the handler
+ */
+class UARTIsrTimer
+{
+public:
+	UARTIsrTimer(UARTLinkStats& stats) : stats_(stats), start_(DWT->CYCCNT) {}
+	~UARTIsrTimer()
+	{
+		const uint32_t cycles = DWT->CYCCNT - start_;
+		stats_.isrCount++;
+		if (cycles > stats_.maxIsrCycles)
+			stats_.maxIsrCycles = cycles;
+	}
+
+private:
+	UARTLinkStats& stats_;
+	const uint32_t start_;
+};
+
+/**
+ * @brief Enables the DWT cycle counter so interrupt durations are measured, shared by all instances
+ */
+void UARTDriver::EnableIsrTiming()
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Gets a snapshot of the link statistics, safe to call from any task
+ * @param statsOut Filled with the statistics
+ */
+void UARTDriver::GetLinkStats(UARTLinkStats& statsOut) const
+{
+	UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	statsOut = linkStats_;
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
+
+/**
+ * @brief Clears the link statistics
+ */
+void UARTDriver::ResetLinkStats()
+{
+	UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	linkStats_ = {};
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
+
+/**
+ * @brief Switches transmit to DMA with two ping-pong buffers, call from a task before transmitting
+ * @param dma DMA stream connected to this UART's TX request
+ * @param buffers Storage for the two buffers, 2 * UART_DMA_TX_BUFFER_BYTES
+ */
+void UARTDriver::ConfigureTxDMA(DMAController* dma, uint8_t* buffers)
+{
+	txBuffers_ = buffers;
+	txFillIndex_ = 0;
+	txDmaBusy_ = false;
+
+	dma->ConfigureMemoryToPeripheral(LL_USART_DMA_GetRegAddr(kUart_));
+	LL_USART_EnableDMAReq_TX(kUart_);
+	txDma_ = dma;
+}
+
+/**
+ * @brief Switches receive to a circular DMA buffer with IDLE line detection, call before the receiver calls ReceiveIT
+ * @param dma DMA stream connected to this UART's RX request
+ * @param buffer Storage for the circular buffer, UART_DMA_RX_BUFFER_BYTES
+ */
+void UARTDriver::ConfigureRxDMA(DMAController* dma, uint8_t* buffer)
+{
+	// The stream takes every byte from the data register, so the RXNE interrupt must not
+	LL_USART_DisableIT_RXNE(kUart_);
+
+	// Last chance to clear errors through the data register, from here on only the stream reads it
+	HandleAndClearRxError();
+
+	rxDmaBuffer_ = buffer;
+	rxDmaReadIndex_ = 0;
+	rxDma_ = dma;
+
+	dma->ConfigurePeripheralToMemoryCircular(LL_USART_DMA_GetRegAddr(kUart_));
+	dma->Start(buffer, UART_DMA_RX_BUFFER_BYTES);
+
+	LL_USART_EnableDMAReq_RX(kUart_);
+	LL_USART_EnableIT_IDLE(kUart_);
+}
+
+/**
+ * @brief Switches transmit to a ring drained by the TXE interrupt, call before transmitting
+ * @param ring Transmit ring, must outlive the driver
+ */
+void UARTDriver::ConfigureTxInterrupt(UARTTxRing* ring)
+{
+	LL_USART_DisableIT_TXE(kUart_);
+	ring->clear();
+	txRing_ = ring;
+}
+
+/**
+ * @brief Transmits data, through DMA or the interrupt ring if either is configured
+ * @param data The data to transmit, may be reused once this returns
  * @param len The length of the data to transmit
  * @return True if the transmission was successful, false otherwise
  */
 bool UARTDriver::Transmit(uint8_t* data, uint16_t len)
 {
+	const UARTSegment segment = { data, len };
+	return Transmit(&segment, 1);
+}
+
+/**
+ * @brief Transmits several buffers back to back as one message, eg. a frame header, body and CRC without
+ *        first copying them together. On the DMA path the segments are gathered into the transmit buffers.
+ * @param segments The buffers to transmit, in order
+ * @param count Number of segments
+ * @return True if the transmission was successful, false otherwise
+ */
+bool UARTDriver::Transmit(const UARTSegment* segments, uint8_t count)
+{
+	uint32_t total = 0;
+	for (uint8_t s = 0; s < count; s++)
+		total += segments[s].len;
+
+	// The DMA and ring paths block on a task notification, so ISRs and the pre-scheduler code poll
+	if (xPortIsInsideInterrupt() || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+		CountTx(total, 0);
+		return TransmitPollingSegments(segments, count);
+	}
+
+	const TickType_t start = xTaskGetTickCount();
+	bool success;
+	if (txDma_ != nullptr)
+		success = TransmitDMA(segments, count);
+	else if (txRing_ != nullptr)
+		success = TransmitRing(segments, count);
+	else
+		success = TransmitPollingSegments(segments, count);
+
+	CountTx(total, xTaskGetTickCount() - start);
+	return success;
+}
+
+/**
+ * @brief Transmits the segments only if that does not have to wait for the DMA stream or ring, so a task
+ *        serving several UARTs is never held up by a busy one. Instances without DMA or a ring still poll.
+ * @param segments The buffers to transmit, in order
+ * @param count Number of segments
+ * @return True if the data was sent or queued, false if the instance is busy or the data can never fit
+ *         in one DMA buffer or the ring, retry once the SetTxNotifyTarget events are set or use Transmit
+ */
+bool UARTDriver::TryTransmit(const UARTSegment* segments, uint8_t count)
+{
+	if (xPortIsInsideInterrupt() || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING || (txDma_ == nullptr && txRing_ == nullptr))
+		return Transmit(segments, count);
+
+	uint32_t total = 0;
+	for (uint8_t s = 0; s < count; s++)
+		total += segments[s].len;
+
+	bool success = false;
+	if (txDma_ != nullptr) {
+		// An idle stream starts right away, TransmitDMA does not wait
+		if (!txDmaBusy_ && total <= UART_DMA_TX_BUFFER_BYTES)
+			success = TransmitDMA(segments, count);
+	}
+	else if (total <= UART_TX_RING_BYTES) {
+		success = PushTxRing(segments, count);
+	}
+
+	if (success)
+		CountTx(total, 0);
+	return success;
+}
+
+/**
+ * @brief Sets the task told when TryTransmit can accept data again, ie. a DMA transfer completed or the
+ *        ring drained to half, call before the scheduler starts or from the target task
+ * @param task Task to notify, nullptr to stop
+ * @param events Event bits set on the task
+ */
+void UARTDriver::SetTxNotifyTarget(TaskHandle_t task, uint32_t events)
+{
+	taskENTER_CRITICAL();
+	txNotifyEvents_ = events;
+	txNotifyTask_ = task;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Adds a transmit to the link statistics
+ * @param bytes Bytes transmitted
+ * @param busyTicks Ticks the caller was blocked for
+ */
+void UARTDriver::CountTx(uint32_t bytes, TickType_t busyTicks)
+{
+	UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	linkStats_.txBytes += bytes;
+	linkStats_.txBusyTicks += busyTicks;
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
+
+/**
+ * @brief Transmits data via polling, waits for any DMA transfer in flight first
+ * @param data The data to transmit
+ * @param len The length of the data to transmit
+ * @return True if the transmission was successful, false otherwise
+ */
+bool UARTDriver::TransmitPolling(const uint8_t* data, uint16_t len)
+{
+	const UARTSegment segment = { data, len };
+	return TransmitPollingSegments(&segment, 1);
+}
+
+/**
+ * @brief Transmits segments via polling, waits for any DMA transfer or ring in flight first
+ * @param segments The buffers to transmit, in order
+ * @param count Number of segments
+ * @return True if the transmission was successful, false otherwise
+ */
+bool UARTDriver::TransmitPollingSegments(const UARTSegment* segments, uint8_t count)
+{
+	// Let a DMA transfer or the ring in flight finish so the bytes do not interleave
+	if (txDma_ != nullptr) {
+		while (txDma_->IsBusy()) {}
+	}
+	while (IsTxRingActive()) {}
+
 	// Loop through and transmit each byte via. polling
-	for (uint16_t i = 0; i < len; i++) {
-		LL_USART_TransmitData8(kUart_, data[i]);
+	for (uint8_t s = 0; s < count; s++) {
+		for (uint16_t i = 0; i < segments[s].len; i++) {
+			LL_USART_TransmitData8(kUart_, segments[s].data[i]);
 
-		// Wait until the TX Register Empty Flag is set
-		while (!LL_USART_IsActiveFlag_TXE(kUart_)) {}
+			// Wait until the TX Register Empty Flag is set
+			while (!LL_USART_IsActiveFlag_TXE(kUart_)) {}
+		}
 	}
 
 	// Wait until the transfer complete flag is set
@@ -43,6 +270,205 @@ bool UARTDriver::Transmit(uint8_t* data, uint16_t len)
 	return true;
 }
 
+/**
+ * @brief Transmits segments via DMA, gathering them into the free ping-pong buffer while the other is on the wire.
+ *        Segments within a buffer are always contiguous, across buffers only if this task is woken by the
+ *        transfer complete interrupt before the USART runs out of the two frames it holds
+ * @param segments The buffers to transmit, in order
+ * @param count Number of segments
+ * @return True if all data was started, false if a transfer timed out
+ */
+bool UARTDriver::TransmitDMA(const UARTSegment* segments, uint8_t count)
+{
+	uint16_t fill = 0;
+
+	for (uint8_t s = 0; s < count; s++) {
+		const uint8_t* data = segments[s].data;
+		uint16_t len = segments[s].len;
+
+		while (len > 0) {
+			const uint16_t space = UART_DMA_TX_BUFFER_BYTES - fill;
+			const uint16_t chunk = (len < space) ? len : space;
+
+			// At most one buffer is in flight, so the fill buffer can be written while it transmits
+			memcpy(&txBuffers_[txFillIndex_ * UART_DMA_TX_BUFFER_BYTES + fill], data, chunk);
+			fill += chunk;
+			data += chunk;
+			len -= chunk;
+
+			if (fill == UART_DMA_TX_BUFFER_BYTES) {
+				if (!StartTxDMA(fill))
+					return false;
+				fill = 0;
+			}
+		}
+	}
+
+	if (fill > 0)
+		return StartTxDMA(fill);
+
+	return true;
+}
+
+/**
+ * @brief Starts the fill buffer once the transfer in flight completes, and switches to the other buffer
+ * @param len Number of bytes in the fill buffer
+ * @return True if the transfer was started, false if the transfer in flight timed out
+ */
+bool UARTDriver::StartTxDMA(uint16_t len)
+{
+	if (!WaitTxDMAIdle())
+		return false;
+
+	txDmaBusy_ = true;
+	txDma_->Start(&txBuffers_[txFillIndex_ * UART_DMA_TX_BUFFER_BYTES], len);
+	txFillIndex_ ^= 1;
+	return true;
+}
+
+/**
+ * @brief Blocks the calling task until the DMA transfer in flight completes
+ * @return True if the stream is idle, false if the transfer timed out and was aborted
+ */
+bool UARTDriver::WaitTxDMAIdle()
+{
+	TickType_t ticksToWait = MS_TO_TICKS(UART_DMA_TX_TIMEOUT_MS);
+	TimeOut_t timeOut;
+	vTaskSetTimeOutState(&timeOut);
+	uint32_t otherEvents = 0;
+	bool idle = true;
+
+	while (txDmaBusy_) {
+		txWaitTask_ = xTaskGetCurrentTaskHandle();
+
+		// The interrupt may have completed before the waiting task was set
+		if (!txDmaBusy_)
+			break;
+
+		uint32_t events = 0;
+		xTaskNotifyWait(0, UART_DRIVER_EVENT_TX_DONE, &events, ticksToWait);
+		otherEvents |= events & ~UART_DRIVER_EVENT_TX_DONE;
+
+		if (txDmaBusy_ && xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE) {
+			txDma_->Stop();
+			txDmaBusy_ = false;
+			idle = false;
+		}
+	}
+
+	txWaitTask_ = nullptr;
+
+	// Waking here consumed the notification of any task events, raise them again so WaitEvents sees them
+	if (otherEvents != 0)
+		xTaskNotify(xTaskGetCurrentTaskHandle(), otherEvents, eSetBits);
+
+	return idle;
+}
+
+/**
+ * @brief Copies segments into the transmit ring and starts the TXE interrupt, waits only while the ring is full
+ * @param segments The buffers to transmit, in order
+ * @param count Number of segments
+ * @return True if all data was queued, false if the ring did not drain in time
+ */
+bool UARTDriver::TransmitRing(const UARTSegment* segments, uint8_t count)
+{
+	TickType_t ticksToWait = MS_TO_TICKS(UART_TX_RING_TIMEOUT_MS);
+	TimeOut_t timeOut;
+	vTaskSetTimeOutState(&timeOut);
+	uint32_t otherEvents = 0;
+
+	uint32_t total = 0;
+	for (uint8_t s = 0; s < count; s++)
+		total += segments[s].len;
+
+	// Messages that fit are queued whole, longer ones in ring sized pieces of each segment
+	const bool whole = (total <= UART_TX_RING_BYTES);
+	uint8_t s = 0;
+	uint16_t offset = 0;
+
+	while (s < count) {
+		if (whole) {
+			if (PushTxRing(segments, count)) {
+				s = count;
+				continue;
+			}
+		}
+		else {
+			const uint16_t remaining = segments[s].len - offset;
+			const UARTSegment piece = { segments[s].data + offset, (remaining < UART_TX_RING_BYTES) ? remaining : UART_TX_RING_BYTES };
+			if (PushTxRing(&piece, 1)) {
+				offset += piece.len;
+				if (offset == segments[s].len) {
+					s++;
+					offset = 0;
+				}
+				continue;
+			}
+		}
+
+		// Wait for the interrupt to free half the ring, several producers may wait so each wait is one tick
+		txWaitTask_ = xTaskGetCurrentTaskHandle();
+		uint32_t events = 0;
+		xTaskNotifyWait(0, UART_DRIVER_EVENT_TX_DONE, &events, 1);
+		otherEvents |= events & ~UART_DRIVER_EVENT_TX_DONE;
+
+		if (xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdTRUE)
+			break;
+	}
+
+	// Waking here consumed the notification of any task events, raise them again so WaitEvents sees them
+	if (otherEvents != 0)
+		xTaskNotify(xTaskGetCurrentTaskHandle(), otherEvents, eSetBits);
+
+	return s == count;
+}
+
+/**
+ * @brief Pushes all of the segments into the transmit ring or none of them, and enables the TXE interrupt
+ * @param segments The buffers to push, at most UART_TX_RING_BYTES in total
+ * @param count Number of segments
+ * @return True if the data was pushed, false if the ring does not have room for all of it
+ */
+bool UARTDriver::PushTxRing(const UARTSegment* segments, uint8_t count)
+{
+	bool pushed = false;
+
+	uint32_t total = 0;
+	for (uint8_t s = 0; s < count; s++)
+		total += segments[s].len;
+
+	// The critical section makes concurrent producers a single producer for the ring
+	taskENTER_CRITICAL();
+	if (txRing_->available() >= total) {
+		for (uint8_t s = 0; s < count; s++) {
+			for (uint16_t i = 0; i < segments[s].len; i++)
+				txRing_->push(segments[s].data[i]);
+		}
+		LL_USART_EnableIT_TXE(kUart_);
+		pushed = true;
+	}
+	taskEXIT_CRITICAL();
+
+	return pushed;
+}
+
+/**
+ * @brief Waits until the transmit ring or DMA transfer in flight is empty and the last byte has left the shift register
+ * @param timeout_ms Time to wait for
+ * @return True if the transmitter is idle, false on timeout
+ */
+bool UARTDriver::FlushTx(uint32_t timeout_ms)
+{
+	const uint32_t start = xTaskGetTickCount();
+	while (IsTxRingActive() || (txDma_ != nullptr && txDma_->IsBusy()) || !LL_USART_IsActiveFlag_TC(kUart_)) {
+		if (xTaskGetTickCount() - start >= MS_TO_TICKS(timeout_ms))
+			return false;
+		osDelay(1);
+	}
+	return true;
+}
+
 /**
 * @brief Receives 1 byte of data via interrupt
 * @param receiver
@@ -50,16 +476,21 @@ bool UARTDriver::Transmit(uint8_t* data, uint16_t len)
 */
 bool UARTDriver::ReceiveIT(uint8_t* charBuf, UARTReceiverBase* receiver)
 {
+	// Set the buffer and receiver
+	rxCharBuf_ = charBuf;
+	rxReceiver_ = receiver;
+
+	// The DMA stream is already receiving and owns the data register, receivers that re-arm from InterruptRxData
+	// only update the pointers. Clearing the flags here would read the data register and take bytes from the stream.
+	if (rxDma_ != nullptr)
+		return true;
+
 	// Check flags
 	HandleAndClearRxError();
 	if (LL_USART_IsActiveFlag_RXNE(kUart_)) {
 		LL_USART_ClearFlag_RXNE(kUart_);
 	}
 
-	// Set the buffer and receiver
-	rxCharBuf_ = charBuf;
-	rxReceiver_ = receiver;
-
 	// Enable the receive interrupt
 	LL_USART_EnableIT_RXNE(kUart_);
 
@@ -67,27 +498,32 @@ bool UARTDriver::ReceiveIT(uint8_t* charBuf, UARTReceiverBase* receiver)
 }
 
 /**
- * @brief Clears any error flags that may have been set, printing a warning message if necessary
+ * @brief Counts and clears any error flags that may have been set. While the DMA stream receives, only the
+ *        status register is read, the stream's next read of the data register completes the clear sequence.
  * @return true if flags had to be cleared, false otherwise
  */
 bool UARTDriver::HandleAndClearRxError()
 {
 	bool shouldClearFlags = false;
 	if (LL_USART_IsActiveFlag_ORE(kUart_)) {
+		linkStats_.overrunErrors++;
 		shouldClearFlags = true;
 	}
 	if (LL_USART_IsActiveFlag_NE(kUart_)) {
+		linkStats_.noiseErrors++;
 		shouldClearFlags = true;
 	}
 	if(LL_USART_IsActiveFlag_FE(kUart_)) {
+		linkStats_.framingErrors++;
 		shouldClearFlags = true;
 	}
 	if(LL_USART_IsActiveFlag_PE(kUart_)) {
+		linkStats_.parityErrors++;
 		shouldClearFlags = true;
 	}
 
-	// Clearing the ORE here also clears PE, NE, FE, IDLE
-	if(shouldClearFlags)
+	// Clearing the ORE here also clears PE, NE, FE, IDLE, it reads the data register so the stream must not own it
+	if(shouldClearFlags && rxDma_ == nullptr)
 		LL_USART_ClearFlag_ORE(kUart_);
 
 	return !shouldClearFlags;
@@ -123,12 +559,31 @@ bool UARTDriver::GetRxErrors()
  */
 void UARTDriver::HandleIRQ_UART()
 {
+	UARTIsrTimer timer(linkStats_);
+
+	// Send the next bytes of the transmit ring
+	if (IsTxRingActive() && LL_USART_IsActiveFlag_TXE(kUart_))
+		HandleTxRingIRQ();
+
+	// The line went idle after a burst, hand over what the stream received so far
+	if (rxDma_ != nullptr) {
+		if (LL_USART_IsEnabledIT_IDLE(kUart_) && LL_USART_IsActiveFlag_IDLE(kUart_)) {
+			// IDLE clears on a status then data register read, the data register is only read once the stream has
+			// taken the last byte, otherwise the stream's own read clears it
+			if (!LL_USART_IsActiveFlag_RXNE(kUart_))
+				(void)LL_USART_ReceiveData8(kUart_);
+			ProcessRxDMA();
+		}
+		return;
+	}
+
 	// Call the callback if RXNE is set
 	if (LL_USART_IsActiveFlag_RXNE(kUart_)) {
 		// Read the data from the data register
 		if (rxCharBuf_ != nullptr) {
 			*rxCharBuf_ = LL_USART_ReceiveData8(kUart_);
 		}
+		linkStats_.rxBytes++;
 
 		// Call the receiver interrupt
 		if(rxReceiver_ != nullptr) {
@@ -136,3 +591,136 @@ void UARTDriver::HandleIRQ_UART()
 		}
 	}
 }
+
+/**
+ * @brief Handles an interrupt for the transmit DMA stream, wakes the task waiting for the transfer
+ * @attention MUST be called inside the DMAx_Streamy_IRQHandler of the TX stream
+ */
+void UARTDriver::HandleIRQ_TxDMA()
+{
+	if (txDma_ == nullptr)
+		return;
+
+	UARTIsrTimer timer(linkStats_);
+
+	const uint32_t events = txDma_->HandleIRQ();
+	if ((events & (DMA_EVENT_TRANSFER_COMPLETE | DMA_EVENT_ERROR)) == 0)
+		return;
+
+	txDmaBusy_ = false;
+
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	TaskHandle_t waitTask = txWaitTask_;
+	if (waitTask != nullptr)
+		xTaskNotifyFromISR(waitTask, UART_DRIVER_EVENT_TX_DONE, eSetBits, &xHigherPriorityTaskWoken);
+	NotifyTxTargetFromISR(&xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+ * @brief Sets the SetTxNotifyTarget events, if a target is set
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a context switch should be requested on ISR exit
+ */
+void UARTDriver::NotifyTxTargetFromISR(BaseType_t* pxHigherPriorityTaskWoken)
+{
+	TaskHandle_t notifyTask = txNotifyTask_;
+	if (notifyTask != nullptr)
+		xTaskNotifyFromISR(notifyTask, txNotifyEvents_, eSetBits, pxHigherPriorityTaskWoken);
+}
+
+/**
+ * @brief Writes the next byte of the transmit ring, stops the TXE interrupt once the ring is empty,
+ *        and wakes a producer waiting for room once half the ring is free
+ */
+void UARTDriver::HandleTxRingIRQ()
+{
+	uint8_t c;
+	if (txRing_->pop(c))
+		LL_USART_TransmitData8(kUart_, c);
+	if (txRing_->empty())
+		LL_USART_DisableIT_TXE(kUart_);
+
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	TaskHandle_t waitTask = txWaitTask_;
+	if (waitTask != nullptr && txRing_->available() >= UART_TX_RING_BYTES / 2) {
+		txWaitTask_ = nullptr;
+		xTaskNotifyFromISR(waitTask, UART_DRIVER_EVENT_TX_DONE, eSetBits, &xHigherPriorityTaskWoken);
+	}
+
+	// Tell the notify target once as the ring crosses half free, and once when it is empty
+	const uint16_t available = txRing_->available();
+	if (available == UART_TX_RING_BYTES / 2 || available == UART_TX_RING_BYTES)
+		NotifyTxTargetFromISR(&xHigherPriorityTaskWoken);
+
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/**
+ * @brief Handles an interrupt for the receive DMA stream, hands the filled half of the buffer to the receiver
+ * @attention MUST be called inside the DMAx_Streamy_IRQHandler of the RX stream
+ */
+void UARTDriver::HandleIRQ_RxDMA()
+{
+	if (rxDma_ == nullptr)
+		return;
+
+	UARTIsrTimer timer(linkStats_);
+
+	if (rxDma_->HandleIRQ() & (DMA_EVENT_HALF_TRANSFER | DMA_EVENT_TRANSFER_COMPLETE))
+		ProcessRxDMA();
+}
+
+/**
+ * @brief Hands the bytes written by the stream since the last call to the receiver, in at most two spans when the buffer wrapped
+ * @attention Only call from the UART and RX DMA interrupts, they must share a priority
+ */
+void UARTDriver::ProcessRxDMA()
+{
+	// The stream counts down from the buffer size and reloads it on wrap
+	uint16_t writeIndex = UART_DMA_RX_BUFFER_BYTES - rxDma_->GetRemaining();
+	if (writeIndex == UART_DMA_RX_BUFFER_BYTES)
+		writeIndex = 0;
+
+	if (writeIndex == rxDmaReadIndex_)
+		return;
+
+	const uint8_t errors = GetRxErrors();
+	if (errors)
+		HandleAndClearRxError();
+
+	if (writeIndex > rxDmaReadIndex_) {
+		DeliverRx(&rxDmaBuffer_[rxDmaReadIndex_], writeIndex - rxDmaReadIndex_, errors);
+	}
+	else {
+		DeliverRx(&rxDmaBuffer_[rxDmaReadIndex_], UART_DMA_RX_BUFFER_BYTES - rxDmaReadIndex_, errors);
+		if (writeIndex > 0)
+			DeliverRx(rxDmaBuffer_, writeIndex, errors);
+	}
+
+	rxDmaReadIndex_ = writeIndex;
+}
+
+/**
+ * @brief Passes a received span to the receiver, byte by byte through rxCharBuf_ if it does not take spans
+ * @param data Received bytes
+ * @param len Number of bytes
+ * @param errors UART receive errors
+ */
+void UARTDriver::DeliverRx(const uint8_t* data, uint16_t len, uint8_t errors)
+{
+	linkStats_.rxBytes += len;
+
+	// Nobody has called ReceiveIT yet, the bytes are dropped
+	if (rxReceiver_ == nullptr)
+		return;
+
+	if (rxReceiver_->InterruptRxSpan(data, len, errors))
+		return;
+
+	for (uint16_t i = 0; i < len; i++) {
+		if (rxCharBuf_ != nullptr)
+			*rxCharBuf_ = data[i];
+		rxReceiver_->InterruptRxData(errors);
+	}
+}
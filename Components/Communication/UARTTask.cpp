@@ -6,15 +6,35 @@
 */
 
 #include "UARTTask.hpp"
+#include "UARTDriver.hpp"
+
+#include <cstring>     // Support for memcpy
+#include <new>         // Support for placement new
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+	uint8_t uart5TxBuffers[2 * UART_DMA_TX_BUFFER_BYTES];	// UART 5 DMA transmit ping-pong buffers
+	uint8_t uart1RxBuffer[UART_DMA_RX_BUFFER_BYTES];		// UART 1 DMA circular receive buffer
+	UARTTxRing uart1TxRing;									// UART 1 interrupt transmit ring
+}
 
 /**
- * TODO: Currently not used, would be used for DMA buffer configuration or interrupt setup
  * @brief Configures UART DMA buffers and interrupts
  * 
 */
 void UARTTask::ConfigureUART()
 {
-	// UART 5 - Uses polling for now (switch to DMA or interrupts once SOAR-Protocol is defined)
+	// Measure the UART interrupt durations for the link statistics
+	UARTDriver::EnableIsrTiming();
+
+	// UART 5 - Debug output transmits through DMA1 Stream 7, receive stays on the RX interrupt
+	Driver::uart5.ConfigureTxDMA(&Driver::dma1Stream7, uart5TxBuffers);
+
+	// UART 1 - Protocol input receives through DMA2 Stream 2 with IDLE line detection, the debug console keeps RXNE per byte
+	Driver::uart1.ConfigureRxDMA(&Driver::dma2Stream2, uart1RxBuffer);
+
+	// UART 1 - Protocol output is queued to the TXE interrupt, so the task does not block for the wire time
+	Driver::uart1.ConfigureTxInterrupt(&uart1TxRing);
 }
 
 /**
@@ -26,19 +46,12 @@ void UARTTask::InitTask()
 	SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize UART task twice");
 	
 	// Start the task
-	BaseType_t rtValue =
-		xTaskCreate((TaskFunction_t)UARTTask::RunTask,
-			(const char*)"UARTTask",
-			(uint16_t)UART_TASK_STACK_DEPTH_WORDS,
-			(void*)this,
-			(UBaseType_t)UART_TASK_RTOS_PRIORITY,
-			(TaskHandle_t*)&rtTaskHandle);
-
-	//Ensure creation succeded
-	SOAR_ASSERT(rtValue == pdPASS, "UARTTask::InitTask() - xTaskCreate() failed");
+	//Create the task in its static stack and control block, ensure creation succeeded
+	SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)UARTTask::RunTask, "UARTTask", (UBaseType_t)UART_TASK_RTOS_PRIORITY),
+		"UARTTask::InitTask() - xTaskCreateStatic() failed");
 
 	// Configure DMA
-	 
+	ConfigureUART();
 }
 
 /**
@@ -47,49 +60,417 @@ void UARTTask::InitTask()
 */
 void UARTTask::Run(void * pvParams)
 {
+	EnableQueueEvents();
+
+	// Each channel is served without waiting for the other, a busy channel keeps its burst and wakes the task when it can take it
+	UART::Debug->SetTxNotifyTarget(xTaskGetCurrentTaskHandle(), UART_TASK_EVENT_TX_READY);
+	UART::Protocol->SetTxNotifyTarget(xTaskGetCurrentTaskHandle(), UART_TASK_EVENT_TX_READY);
+
+	// A task that fills its log ring wakes this task and waits for it to drain instead of dropping lines
+	TaskLog::SetConsumer(xTaskGetCurrentTaskHandle(), UART_TASK_EVENT_LOG);
+
 	//UART Task loop
 	while(1) {
 		Command cm;
 
-		//Wait forever for a command
-		qEvtQueue->ReceiveWait(cm);
-		
-		//Process the command
-		HandleCommand(cm);
+		//Wait for a command, a printed line or a free channel, waking up periodically to send deferred log records
+		//and when an open burst is due
+		WaitEvents(TASK_EVENT_QUEUE | UART_TASK_EVENT_LOG | UART_TASK_EVENT_TX_READY, GetWaitMs());
+
+		//Messages held while a channel was busy go first, they are older than anything still in the queue
+		ServiceChannel(protocolBurst);
+		ServiceChannel(debugBurst);
+
+		//Process all waiting commands, consecutive sends are coalesced and protocol output goes out first
+		while (ReceiveNext(cm))
+			Route(cm);
+		ServiceChannel(protocolBurst);
+
+		//Logs stay in their rings while the debug channel is busy, so they never hold up protocol output
+		DrainTaskLogs();
+		DrainBinaryLog();
+		ServiceChannel(debugBurst);
 	}
 }
 
 /**
- * @brief HandleCommand handles any command passed to the UART task primary event queue. Responsible for
- * 		  handling all commands, even if unsupported. (Unexpected commands must still be reset) 
- * @param cm Reference to the command object to handle
-*/
-void UARTTask::HandleCommand(Command& cm)
-{
-	//Switch for the GLOBAL_COMMAND
-	switch (cm.GetCommand()) {
-	case DATA_COMMAND: {
-		//Switch for task specific command within DATA_COMMAND
-		switch (cm.GetTaskCommand()) {
-		case UART_TASK_COMMAND_SEND_DEBUG:
-            UART::Debug->Transmit(cm.GetDataPointer(), cm.GetDataSize());
-			break;
-		case UART_TASK_COMMAND_SEND_PROTOCOL:
-            UART::Protocol->Transmit(cm.GetDataPointer(), cm.GetDataSize());
-		    break;
-		default:
-			SOAR_PRINT("UARTTask - Received Unsupported DATA_COMMAND {%d}\n", cm.GetTaskCommand());
-			break;
+ * @brief Sends what a channel has due without waiting, the burst once UART_TASK_BURST_LATENCY_MS has passed since
+ *        its first message, or straight away when a pending message is queued behind it
+ * @param burst Burst of the channel
+ * @return true if nothing due is left, false if the channel is busy
+ */
+bool UARTTask::ServiceChannel(Burst& burst)
+{
+	if (burst.pendingCount == 0 && !IsBurstDue(burst))
+		return true;
+
+	return SendChannel(burst);
+}
+
+/**
+ * @brief Gets how long the task may wait for events, until the next deferred log drain or the first open burst
+ *        becoming due. A due burst on a busy channel does not shorten the wait, the channel wakes the task.
+ * @return Time to wait in ms
+ */
+uint32_t UARTTask::GetWaitMs() const
+{
+	uint32_t wait_ms = BINARY_LOG_DRAIN_PERIOD_MS;
+	const TickType_t latency = MS_TO_TICKS(UART_TASK_BURST_LATENCY_MS);
+
+	for (const Burst* burst : { &protocolBurst, &debugBurst }) {
+		const TickType_t waited = xTaskGetTickCount() - burst->startTick;
+		if (burst->count == 0 || waited >= latency)
+			continue;
+
+		const uint32_t left_ms = TICKS_TO_MS(latency - waited);
+		if (left_ms < wait_ms)
+			wait_ms = (left_ms > 0) ? left_ms : 1;
+	}
+
+	return wait_ms;
+}
+
+/**
+ * @brief Receives the next command for a channel that can take it, a channel holding a pending message
+ *        leaves its lane in the queue so the other channel's messages are not held up behind it
+ * @param cm Command object to receive into
+ * @return true if a command was received
+ */
+bool UARTTask::ReceiveNext(Command& cm)
+{
+	if (protocolBurst.pendingCount == 0 && qEvtQueue->ReceiveFromLane(cm, protocolBurst.lane))
+		return true;
+
+	return debugBurst.pendingCount == 0 && qEvtQueue->ReceiveFromLane(cm, debugBurst.lane);
+}
+
+/**
+ * @brief Transmits all lines waiting in the task logs over the debug UART, oldest line first across all tasks
+ */
+void UARTTask::DrainTaskLogs()
+{
+	while (1) {
+		// Find the log holding the oldest line
+		TaskLog* oldest = nullptr;
+		uint32_t oldestTimestamp = 0;
+		uint16_t oldestLen = 0;
+		for (uint8_t i = 0; i < TaskLog::GetSourceCount(); i++) {
+			uint32_t timestamp;
+			uint16_t len;
+			TaskLog* source = TaskLog::GetSource(i);
+			if (source->Peek(timestamp, len) && (oldest == nullptr || timestamp < oldestTimestamp)) {
+				oldest = source;
+				oldestTimestamp = timestamp;
+				oldestLen = len;
+			}
 		}
+
+		// A line that does not fit while the debug channel is busy stays in its ring, it is still the oldest
+		if (oldest == nullptr || !MakeRoom(debugBurst, oldestLen))
+			return;
+
+		uint8_t* line = &debugBurst.stage[debugBurst.stageLen];
+		const uint16_t len = oldest->Read(line, oldestLen);
+		debugBurst.stageLen += len;
+		PackBytes(debugBurst, line, len);
 	}
-	case TASK_SPECIFIC_COMMAND: {
-		break;
+}
+
+/**
+ * @brief Transmits all pending deferred log records over the debug UART
+ */
+void UARTTask::DrainBinaryLog()
+{
+	while (MakeRoom(debugBurst, 0)) {
+		// Records are encoded straight into the burst, as many as fit behind what is already packed
+		uint16_t space = UART_TASK_BURST_BYTES - debugBurst.len;
+		if (space > BINARY_LOG_DRAIN_BUFFER_BYTES)
+			space = BINARY_LOG_DRAIN_BUFFER_BYTES;
+
+		uint8_t* records = &debugBurst.stage[debugBurst.stageLen];
+		const uint16_t len = BinaryLog::Drain(records, space);
+		if (len > 0) {
+			debugBurst.stageLen += len;
+			PackBytes(debugBurst, records, len);
+			continue;
+		}
+
+		// Nothing is pending, the burst stays open for more
+		if (space >= BINARY_LOG_RECORD_MAX_BYTES)
+			return;
+
+		// The next record may only fit in an empty burst, records stay in the ring while the channel is busy
+		if (debugBurst.len == 0 || !SendChannel(debugBurst))
+			return;
 	}
-	default:
-		SOAR_PRINT("UARTTask - Received Unsupported Command {%d}\n", cm.GetCommand());
-		break;
+}
+
+/**
+ * @brief Makes sure a burst has room for a message without waiting, sending the burst if the channel can take it
+ * @param burst Burst of the channel
+ * @param len Length of the message
+ * @param count Number of segments in the message
+ * @return true if the message can be packed
+ */
+bool UARTTask::MakeRoom(Burst& burst, uint16_t len, uint8_t count)
+{
+	return HasRoom(burst, len, count) || (SendChannel(burst) && HasRoom(burst, len, count));
+}
+
+/**
+ * @brief Packs a command's data into the burst of its channel, the burst is sent once its first message has waited
+ *        UART_TASK_BURST_LATENCY_MS or the next message does not fit. A message that does not fit while the channel is busy,
+ *        or that is larger than a burst, is held in the pending slot of the channel instead of waiting.
+ * @param burst Burst of the channel
+ * @param cm Command holding the message, its payload moves into the burst
+ */
+void UARTTask::Coalesce(Burst& burst, Command& cm)
+{
+	const uint16_t len = cm.GetDataSize();
+
+	// Nothing to send, Route releases the command
+	if (len == 0)
+		return;
+
+	if (len <= UART_TASK_BURST_BYTES && MakeRoom(burst, len)) {
+		PackCommand(burst, cm);
+		ServiceChannel(burst);
+		return;
+	}
+
+	// Only a message sent on the wrong lane can find the slot taken, it is dropped rather than stalling every channel
+	if (burst.pendingCount > 0) {
+		taskENTER_CRITICAL();
+		burstStats.droppedCount++;
+		taskEXIT_CRITICAL();
+		return;
 	}
 
-	//No matter what we happens, we must reset allocated data
-	cm.Reset();
+	HoldPending(burst, cm);
+	ServiceChannel(burst);
+}
+
+/**
+ * @brief Adds a command's data to a burst without copying it, the burst takes over the payload so the pool block or
+ *        shared buffer stays valid until the burst is sent. The burst must have room, see HasRoom.
+ * @param burst Burst of the channel
+ * @param cm Command holding the message, left without a payload
+ */
+void UARTTask::PackCommand(Burst& burst, Command& cm)
+{
+	// A raw copy moves the payload as a queue copy would, inline data moves with it
+	Command& held = burst.held[burst.count];
+	memcpy(static_cast<void*>(&held), static_cast<const void*>(&cm), sizeof(Command));
+
+	const GLOBAL_COMMANDS command = cm.GetCommand();
+	const uint16_t taskCommand = cm.GetTaskCommand();
+	new (&cm) Command(command, taskCommand);
+
+	PackBytes(burst, held.GetDataPointer(), held.GetDataSize());
+}
+
+/**
+ * @brief Adds a segment to a burst, the data must stay valid until the burst is sent. The burst must have room.
+ * @param burst Burst of the channel
+ * @param data Message to send
+ * @param len Length of the message
+ */
+void UARTTask::PackBytes(Burst& burst, const uint8_t* data, uint16_t len)
+{
+	if (burst.count == 0)
+		burst.startTick = xTaskGetTickCount();
+
+	burst.segments[burst.count] = { data, len };
+	burst.count++;
+	burst.len += len;
+}
+
+/**
+ * @brief Sends everything packed into a burst as one gathered transmit, and releases the held commands
+ * @param burst Burst to send
+ * @return true if the burst is empty afterwards, false if the channel is busy
+ */
+bool UARTTask::FlushBurst(Burst& burst)
+{
+	if (burst.count == 0)
+		return true;
+
+	if (!TransmitCounted(burst.uart, burst.segments, burst.count, burst.count))
+		return false;
+
+	// The driver has copied the data
+	for (uint8_t i = 0; i < burst.count; i++)
+		burst.held[i].Reset();
+
+	burst.len = 0;
+	burst.count = 0;
+	burst.stageLen = 0;
+	return true;
+}
+
+/**
+ * @brief Holds a message in the pending slot of its channel, it is sent by SendPending once the burst is out
+ * @param burst Burst of the channel, the pending slot must be free
+ * @param cm Command holding the message, its payload moves into the slot
+ */
+void UARTTask::HoldPending(Burst& burst, Command& cm)
+{
+	memcpy(static_cast<void*>(&burst.pending), static_cast<const void*>(&cm), sizeof(Command));
+
+	const GLOBAL_COMMANDS command = cm.GetCommand();
+	const uint16_t taskCommand = cm.GetTaskCommand();
+	new (&cm) Command(command, taskCommand);
+
+	burst.pendingSegment = { burst.pending.GetDataPointer(), burst.pending.GetDataSize() };
+	burst.pendingSegments = &burst.pendingSegment;
+	burst.pendingCount = 1;
+	burst.pendingIndex = 0;
+	burst.pendingOffset = 0;
+}
+
+/**
+ * @brief Sends the pending message of a channel without waiting, in pieces of up to UART_TASK_BURST_BYTES so that
+ *        any message fits a free DMA buffer or ring, continuing where the last call stopped
+ * @param burst Burst of the channel
+ * @return true if there is no pending message left, false if the channel is busy
+ */
+bool UARTTask::SendPending(Burst& burst)
+{
+	while (burst.pendingCount > 0) {
+		// Gather the next piece, a message larger than a burst is split between transmits
+		UARTSegment piece[UART_TASK_MAX_SEGMENTS];
+		uint8_t pieceCount = 0;
+		uint16_t pieceLen = 0;
+		uint8_t index = burst.pendingIndex;
+		uint16_t offset = burst.pendingOffset;
+
+		while (index < burst.pendingCount && pieceCount < UART_TASK_MAX_SEGMENTS && pieceLen < UART_TASK_BURST_BYTES) {
+			const UARTSegment& segment = burst.pendingSegments[index];
+			const uint16_t remaining = segment.len - offset;
+			const uint16_t len = (remaining < UART_TASK_BURST_BYTES - pieceLen) ? remaining : UART_TASK_BURST_BYTES - pieceLen;
+
+			piece[pieceCount++] = { segment.data + offset, len };
+			pieceLen += len;
+			offset += len;
+			if (offset == segment.len) {
+				index++;
+				offset = 0;
+			}
+		}
+
+		if (!TransmitCounted(burst.uart, piece, pieceCount, (index == burst.pendingCount) ? 1 : 0))
+			return false;
+
+		burst.pendingIndex = index;
+		burst.pendingOffset = offset;
+		if (index == burst.pendingCount) {
+			burst.pending.Reset();
+			burst.pendingCount = 0;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Transmits on a channel without waiting and counts the transmit in the burst statistics
+ * @param uart Channel to send on
+ * @param segments The buffers to transmit
+ * @param count Number of segments
+ * @param messages Number of messages the transmit completes
+ * @return true if the data was sent, false if the channel was busy
+ */
+bool UARTTask::TransmitCounted(UARTDriver* uart, const UARTSegment* segments, uint8_t count, uint16_t messages)
+{
+	const TickType_t start = xTaskGetTickCount();
+	if (!uart->TryTransmit(segments, count))
+		return false;
+	const TickType_t elapsed = xTaskGetTickCount() - start;
+
+	uint16_t bytes = 0;
+	for (uint8_t i = 0; i < count; i++)
+		bytes += segments[i].len;
+
+	taskENTER_CRITICAL();
+	burstStats.burstCount++;
+	burstStats.messageCount += messages;
+	burstStats.byteCount += bytes;
+	burstStats.transmitTicks += elapsed;
+	if (bytes > burstStats.maxBurstBytes)
+		burstStats.maxBurstBytes = bytes;
+	taskEXIT_CRITICAL();
+
+	return true;
+}
+
+/**
+ * @brief Gets a snapshot of the transmit coalescing statistics, safe to call from any task
+ * @param statsOut Filled with the statistics
+ */
+void UARTTask::GetBurstStats(UARTBurstStats& statsOut) const
+{
+	taskENTER_CRITICAL();
+	statsOut = burstStats;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Transmits the command data over the debug UART, the burst holds the payload and releases any
+ * 		  shared buffer once it is sent
+ */
+void UARTTask::OnMessage(const UARTSendDebugMessage& msg)
+{
+	Coalesce(debugBurst, msg.cm);
+}
+
+/**
+ * @brief Transmits the command data over the protocol UART
+ */
+void UARTTask::OnMessage(const UARTSendProtocolMessage& msg)
+{
+	Coalesce(protocolBurst, msg.cm);
+}
+
+/**
+ * @brief Queues a frame built from pieces on the protocol UART, the pieces are gathered into one command payload,
+ *        a pool block for frames up to 256 bytes, so the frame is assembled with a single copy and without a
+ *        buffer of the sender's own
+ * @param segments Frame pieces in order, eg. header, body, CRC and delimiter. They are copied before this returns,
+ *        the sender may reuse or change them straight away.
+ * @param count Number of segments, at most UART_TASK_MAX_SEGMENTS
+ * @return true if the frame was queued
+ */
+bool UARTTask::SendProtocolSegments(const UARTSegment* segments, uint8_t count)
+{
+	if (count == 0 || count > UART_TASK_MAX_SEGMENTS)
+		return false;
+
+	uint32_t len = 0;
+	for (uint8_t i = 0; i < count; i++)
+		len += segments[i].len;
+	if (len == 0 || len > UINT16_MAX)
+		return false;
+
+	// An inline payload is filled before the command is copied into the queue, so its pointer is still valid here
+	Command cmd(DATA_COMMAND, (uint16_t)UART_TASK_COMMAND_SEND_PROTOCOL);
+	uint8_t* frame = cmd.AllocateData((uint16_t)len);
+	if (frame == nullptr)
+		return false;
+
+	for (uint8_t i = 0; i < count; i++) {
+		memcpy(frame, segments[i].data, segments[i].len);
+		frame += segments[i].len;
+	}
+
+	// A failed send releases the payload
+	return Inst().GetEventQueue()->Send(cmd);
+}
+
+/**
+ * @brief Handles any command the task does not support, unexpected commands are still reset by Route
+ * @param cm Unsupported command
+ */
+void UARTTask::OnUnsupported(Command& cm)
+{
+	SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_UART, "UARTTask - Received Unsupported Command {%d, %d}\n", cm.GetCommand(), cm.GetTaskCommand());
 }
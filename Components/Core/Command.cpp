@@ -6,9 +6,16 @@
  * The order of usage for command memory requires that whenever a command is pulled out from a queue
  * you MUST call Reset() on the command. This will free any memory that was allocated for the command if
  * it is necessary, the logic is internal.
+ *
+ * Payloads of up to COMMAND_INLINE_DATA_SIZE bytes are stored inside the Command itself and travel
+ * with the raw-copy through the RTOS queue, so they never touch the allocator.
+ *
+ * Commands can also reference a SharedBuffer, in which case Reset() drops the reference instead of
+ * freeing, allowing one buffer to be sent to several tasks without copying.
  ******************************************************************************
 */
 #include "Command.hpp"
+#include "CommandPool.hpp"
 #include "SystemDefines.hpp"
 
 #include <cstring>     // Support for memcpy
@@ -30,6 +37,9 @@ Command::Command(void)
     data = nullptr;
     dataSize = 0;
     bShouldFreeData = false;
+    bInlineData = false;
+    bSharedData = false;
+    passedParam = 0;
 }
 
 /**
@@ -43,6 +53,9 @@ Command::Command(GLOBAL_COMMANDS command)
     data = nullptr;
     dataSize = 0;
     bShouldFreeData = false;
+    bInlineData = false;
+    bSharedData = false;
+    passedParam = 0;
 }
 
 /**
@@ -56,6 +69,9 @@ Command::Command(uint16_t taskCommand)
     data = nullptr;
     dataSize = 0;
     bShouldFreeData = false;
+    bInlineData = false;
+    bSharedData = false;
+    passedParam = 0;
 }
 
 /**
@@ -70,26 +86,38 @@ Command::Command(GLOBAL_COMMANDS command, uint16_t taskCommand)
     data = nullptr;
     dataSize = 0;
     bShouldFreeData = false;
+    bInlineData = false;
+    bSharedData = false;
+    passedParam = 0;
 }
 
 // We cannot use a Destructor, it would get destroyed at lifetime end
 //Command::~Command()
 //{
 //    if(bShouldFreeData && data != nullptr) {
-//        delete data; - Not this, pvPortFree
+//        delete data; - Not this, CommandPool::Free
 //    }
 //}
 
 /**
- * @brief Dynamically allocates memory for the command with the given data size
+ * @brief Allocates memory for the command with the given data size, small sizes are stored inline,
+ *        anything larger is allocated from the CommandPool
+ * @note  An inline pointer is only valid until the command is copied (eg. sent to a queue), fill it first
  * @param dataSize Size of array to allocate
  * @return Pointer to data on success, nullptr on failure (mem already allocated)
 */
 uint8_t* Command::AllocateData(uint16_t dataSize)
 {
+    // Small payloads are stored inside the command, no allocation necessary
+    if (!HasData() && !bShouldFreeData && dataSize <= COMMAND_INLINE_DATA_SIZE) {
+        this->bInlineData = true;
+        this->dataSize = dataSize;
+        return this->inlineData;
+    }
+
     // If we don't have anything allocated, allocate and return success
-    if (this->data == nullptr && !bShouldFreeData) {
-        this->data = soar_malloc(dataSize);
+    if (!HasData() && !bShouldFreeData) {
+        this->data = CommandPool::Allocate(dataSize);
         this->bShouldFreeData = true;
         this->dataSize = dataSize;
         statAllocationCounter += 1;
@@ -113,7 +141,7 @@ uint8_t* Command::AllocateData(uint16_t dataSize)
 bool Command::SetCommandToStaticExternalBuffer(uint8_t* existingPtr, uint16_t size)
 {
     // If we don't have anything allocated, set it and return success
-    if(this->data == nullptr) {
+    if(!HasData()) {
         this->data = existingPtr;
         this->bShouldFreeData = false;
         this->dataSize = size;
@@ -122,15 +150,36 @@ bool Command::SetCommandToStaticExternalBuffer(uint8_t* existingPtr, uint16_t si
     return false;
 }
 
+/**
+ * @brief Sets the command to reference a shared buffer, the data is not copied. The command holds its own
+ *        reference, the caller remains responsible for releasing any reference it holds itself.
+ * @param buffer Shared buffer to reference
+ * @param size Number of valid bytes in the buffer
+ * @return TRUE on success, FALSE on failure (mem already allocated)
+*/
+bool Command::SetCommandToSharedBuffer(SharedBuffer* buffer, uint16_t size)
+{
+    // If we don't have anything allocated, reference the buffer and return success
+    if(!HasData() && buffer != nullptr) {
+        SharedBufferPool::AddReference(buffer);
+        this->sharedBuffer = buffer;
+        this->bSharedData = true;
+        this->bShouldFreeData = false;
+        this->dataSize = size;
+        return true;
+    }
+    return false;
+}
+
 /**
  * @brief Copies data from the source array into memory owned by Command and sets the internal data pointer to the new array
  */
 bool Command::CopyDataToCommand(uint8_t* dataSrc, uint16_t size)
 {
     // If we successfully allocate, copy the data and return success
-    if(this->AllocateData(size)
-        && this->data != nullptr) {
-        memcpy(this->data, dataSrc, size);
+    uint8_t* dst = this->AllocateData(size);
+    if(dst != nullptr) {
+        memcpy(dst, dataSrc, size);
         return true;
     }
 
@@ -142,8 +191,19 @@ bool Command::CopyDataToCommand(uint8_t* dataSrc, uint16_t size)
 */
 void Command::Reset()
 {
-    if(bShouldFreeData && data != nullptr) {
-        soar_free(data);
+    if(bInlineData) {
+        bInlineData = false;
+        data = nullptr;
+        dataSize = 0;
+    }
+    else if(bSharedData) {
+        SharedBufferPool::Release(sharedBuffer);
+        bSharedData = false;
+        sharedBuffer = nullptr;
+        dataSize = 0;
+    }
+    else if(bShouldFreeData && data != nullptr) {
+        CommandPool::Free(data);
         statAllocationCounter -= 1;
 		data = nullptr;
         bShouldFreeData = false;
@@ -156,7 +216,20 @@ void Command::Reset()
 */
 uint16_t Command::GetDataSize() const
 {
-    if (data == nullptr)
+    if (!HasData())
         return 0;
     return dataSize;
 }
+
+/**
+ * @brief Getter for Data pointer, resolves inline and shared data
+ * @return pointer to the data, nullptr if there is no data
+*/
+uint8_t* Command::GetDataPointer() const
+{
+    if (bInlineData)
+        return const_cast<uint8_t*>(inlineData);
+    if (bSharedData)
+        return SharedBufferPool::GetData(sharedBuffer);
+    return data;
+}
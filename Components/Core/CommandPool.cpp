@@ -0,0 +1,212 @@
+/**
+ ******************************************************************************
+ * File Name          : CommandPool.cpp
+ * Description        : Implementation of the CommandPool size-class allocator.
+ *
+ * Each size class is an etl::generic_pool in static memory, so the storage is
+ * reserved at boot and never fragments the RTOS heap. Pool operations are guarded
+ * by a short interrupt-masking critical section which is far cheaper than heap_4's
+ * scheduler suspension.
+ ******************************************************************************
+*/
+#include "CommandPool.hpp"
+#include "SystemDefines.hpp"
+
+#include "etl/generic_pool.h"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr uint16_t POOL_BLOCK_SIZES[COMMAND_POOL_CLASS_COUNT] = { 32, 64, 128, 256 };
+constexpr uint16_t POOL_BLOCK_COUNTS[COMMAND_POOL_CLASS_COUNT] = { COMMAND_POOL_32B_BLOCKS, COMMAND_POOL_64B_BLOCKS,
+    COMMAND_POOL_128B_BLOCKS, COMMAND_POOL_256B_BLOCKS };
+
+// Handle layout, class in the top 2 bits, block index in the next 6 and the block generation in the low byte
+constexpr uint8_t POOL_HANDLE_CLASS_SHIFT = 14;
+constexpr uint8_t POOL_HANDLE_INDEX_SHIFT = 8;
+constexpr uint16_t POOL_HANDLE_INDEX_MASK = 0x3F;
+
+static_assert(COMMAND_POOL_CLASS_COUNT <= 4, "Pool class must fit in 2 bits of a handle");
+static_assert(COMMAND_POOL_32B_BLOCKS <= 64 && COMMAND_POOL_64B_BLOCKS <= 64 && COMMAND_POOL_128B_BLOCKS <= 64
+    && COMMAND_POOL_256B_BLOCKS <= 64, "Pool block index must fit in 6 bits of a handle");
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    // Storage is external so a block's index can be found from its address
+    template <uint16_t TBlockSize, uint16_t TBlocks>
+    struct PoolClass
+    {
+        using Pool = etl::generic_pool_ext<TBlockSize, alignof(uint32_t)>;
+        static_assert(sizeof(typename Pool::element) == TBlockSize, "Pool blocks must be packed at their size");
+
+        typename Pool::element storage[TBlocks];
+        Pool pool{ storage, TBlocks };
+        uint8_t generation[TBlocks] = {};    // Incremented on every Free
+    };
+
+    PoolClass<32, COMMAND_POOL_32B_BLOCKS> pool32;
+    PoolClass<64, COMMAND_POOL_64B_BLOCKS> pool64;
+    PoolClass<128, COMMAND_POOL_128B_BLOCKS> pool128;
+    PoolClass<256, COMMAND_POOL_256B_BLOCKS> pool256;
+
+    etl::ipool* const pools[COMMAND_POOL_CLASS_COUNT] = { &pool32.pool, &pool64.pool, &pool128.pool, &pool256.pool };
+    uint8_t* const poolStorage[COMMAND_POOL_CLASS_COUNT] = { reinterpret_cast<uint8_t*>(pool32.storage),
+        reinterpret_cast<uint8_t*>(pool64.storage), reinterpret_cast<uint8_t*>(pool128.storage), reinterpret_cast<uint8_t*>(pool256.storage) };
+    uint8_t* const poolGeneration[COMMAND_POOL_CLASS_COUNT] = { pool32.generation, pool64.generation, pool128.generation, pool256.generation };
+
+    uint16_t highWater[COMMAND_POOL_CLASS_COUNT] = {};
+    uint32_t exhaustionCount[COMMAND_POOL_CLASS_COUNT] = {};
+
+    /**
+     * @brief Finds the size class and block index of a pointer
+     * @return true if the pointer is the start of a pool block
+    */
+    bool FindBlock(const uint8_t* ptr, uint8_t& poolClass, uint16_t& index)
+    {
+        for (uint8_t i = 0; i < COMMAND_POOL_CLASS_COUNT; i++) {
+            if (ptr < poolStorage[i] || ptr >= poolStorage[i] + POOL_BLOCK_SIZES[i] * POOL_BLOCK_COUNTS[i])
+                continue;
+
+            const uint32_t offset = ptr - poolStorage[i];
+            if (offset % POOL_BLOCK_SIZES[i] != 0)
+                return false;
+
+            poolClass = i;
+            index = offset / POOL_BLOCK_SIZES[i];
+            return true;
+        }
+        return false;
+    }
+}
+
+uint32_t CommandPool::statHeapFallbackCounter = 0;
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Allocates a block from the smallest size class that fits and has space
+ * @param size Size of the block in bytes
+ * @return Pointer to the block, never nullptr (heap fallback asserts on failure)
+*/
+uint8_t* CommandPool::Allocate(uint16_t size)
+{
+    uint8_t* ret = nullptr;
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    for (uint8_t i = 0; i < COMMAND_POOL_CLASS_COUNT; i++) {
+        if (size > POOL_BLOCK_SIZES[i])
+            continue;
+
+        // Check for space first, etl asserts on allocating from a full pool in debug builds
+        if (pools[i]->full()) {
+            exhaustionCount[i]++;
+            continue;
+        }
+
+        ret = pools[i]->allocate<uint8_t>();
+        if (pools[i]->size() > highWater[i])
+            highWater[i] = pools[i]->size();
+        break;
+    }
+
+    // Too large, or every suitable class is exhausted, counted here as an ISR may allocate too
+    if (ret == nullptr)
+        statHeapFallbackCounter++;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    if (ret == nullptr)
+        ret = soar_malloc(size);
+
+    return ret;
+}
+
+/**
+ * @brief Returns a block to the pool it came from, or to the heap if it was a fallback allocation
+ * @param ptr Pointer returned by Allocate
+*/
+void CommandPool::Free(uint8_t* ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    uint8_t poolClass;
+    uint16_t index;
+    if (!FindBlock(ptr, poolClass, index)) {
+        soar_free(ptr);
+        return;
+    }
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    poolGeneration[poolClass][index]++;
+    pools[poolClass]->release(ptr);
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
+
+/**
+ * @brief Encodes a pool block as a 16 bit handle, only the owner of the block may call this
+ * @param ptr Pointer returned by Allocate
+ * @param handle Set to the handle of the block
+ * @return true on success, false if the block is a heap fallback allocation and has no handle
+*/
+bool CommandPool::GetHandle(const uint8_t* ptr, uint16_t& handle)
+{
+    uint8_t poolClass;
+    uint16_t index;
+    if (!FindBlock(ptr, poolClass, index))
+        return false;
+
+    // The generation only changes on Free, which the owner has not called, so no lock is needed
+    handle = (poolClass << POOL_HANDLE_CLASS_SHIFT) | (index << POOL_HANDLE_INDEX_SHIFT) | poolGeneration[poolClass][index];
+    return true;
+}
+
+/**
+ * @brief Decodes a handle from GetHandle back into the block pointer
+ * @param handle Handle of the block
+ * @return Pointer to the block, nullptr if the block was freed since the handle was made
+*/
+uint8_t* CommandPool::FromHandle(uint16_t handle)
+{
+    const uint8_t poolClass = handle >> POOL_HANDLE_CLASS_SHIFT;
+    const uint16_t index = (handle >> POOL_HANDLE_INDEX_SHIFT) & POOL_HANDLE_INDEX_MASK;
+
+    if (poolClass >= COMMAND_POOL_CLASS_COUNT || index >= POOL_BLOCK_COUNTS[poolClass]
+        || poolGeneration[poolClass][index] != (uint8_t)handle)
+        return nullptr;
+
+    return poolStorage[poolClass] + index * POOL_BLOCK_SIZES[poolClass];
+}
+
+/**
+ * @brief Copies the statistics for the given size class
+ * @param poolClass COMMAND_POOL_CLASS to get statistics for
+ * @param stats Struct to copy the statistics into
+ * @return true on success, false if the class is invalid
+*/
+bool CommandPool::GetStats(uint8_t poolClass, CommandPoolStats& stats)
+{
+    if (poolClass >= COMMAND_POOL_CLASS_COUNT)
+        return false;
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    stats.blockSize = POOL_BLOCK_SIZES[poolClass];
+    stats.capacity = pools[poolClass]->max_size();
+    stats.inUse = pools[poolClass]->size();
+    stats.highWater = highWater[poolClass];
+    stats.exhaustionCount = exhaustionCount[poolClass];
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    return true;
+}
+
+/**
+ * @brief Prints the statistics for all size classes
+*/
+void CommandPool::PrintStats()
+{
+    CommandPoolStats stats;
+    for (uint8_t i = 0; i < COMMAND_POOL_CLASS_COUNT; i++) {
+        GetStats(i, stats);
+        SOAR_PRINT("Pool %3dB\t: %d/%d used, high water %d, exhausted %d\n",
+            stats.blockSize, stats.inUse, stats.capacity, stats.highWater, stats.exhaustionCount);
+    }
+    SOAR_PRINT("Pool heap fallbacks\t: %d\n", statHeapFallbackCounter);
+}
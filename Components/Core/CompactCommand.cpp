@@ -0,0 +1,216 @@
+/**
+ ******************************************************************************
+ * File Name          : CompactCommand.cpp
+ * Description        : Implementation of CompactCommand and its slot table.
+ *
+ * Most commands carry no payload or a CommandPool or SharedBuffer payload, and travel
+ * as 8 bytes with the payload referenced by handle. Ownership moves with the handle:
+ * the pool block or the command's shared buffer reference is handed to whoever unpacks it.
+ *
+ * Anything the handles cannot describe parks a raw copy of the Command in a static slot
+ * table, the copy holds the data pointer, inline data or passedParam exactly as the RTOS
+ * queue copy used to, so ownership rules are unchanged.
+ ******************************************************************************
+*/
+#include "CompactCommand.hpp"
+#include "CommandPool.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>     // Support for memcpy
+#include <new>         // Support for placement new
+
+/* Structs -----------------------------------------------------------------*/
+struct CommandSlot
+{
+    alignas(Command) uint8_t bytes[sizeof(Command)];    // Raw copy of the parked Command
+    uint8_t generation;                                 // Incremented on every release
+    bool bInUse;                                        // Is the slot holding a command
+};
+
+static_assert(COMMAND_SLOT_COUNT <= 256, "COMMAND_SLOT_COUNT must fit in the low byte of a slot handle");
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    CommandSlot slots[COMMAND_SLOT_COUNT];
+    uint8_t nextSlot = 0;           // Where the next search for a free slot starts
+    uint16_t slotsInUse = 0;
+    uint16_t slotHighWater = 0;
+    uint32_t slotExhaustionCount = 0;
+}
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Encodes a command, by payload handle where possible and parking a copy in the slot table otherwise.
+ *        The command itself is not modified, if the compact command is sent the caller must not Reset() it,
+ *        as with a raw copy.
+ * @param cm Command to encode
+ * @return true on success, false if the command needs a slot and every slot is in use
+*/
+bool CompactCommand::Pack(const Command& cm)
+{
+    command = cm.command;
+    taskCommand = cm.taskCommand;
+    payload = COMPACT_PAYLOAD_NONE;
+    ref.handle = 0;
+    ref.dataSize = 0;
+
+    // Only a slot has room for the param
+    if (cm.passedParam != 0)
+        return PackSlot(cm);
+
+    if (cm.bInlineData) {
+        if (cm.dataSize > COMPACT_COMMAND_INLINE_BYTES)
+            return PackSlot(cm);
+
+        payload = COMPACT_PAYLOAD_INLINE | (cm.dataSize << 4);
+        memcpy(inlineData, cm.inlineData, cm.dataSize);
+        return true;
+    }
+
+    if (cm.bSharedData) {
+        payload = COMPACT_PAYLOAD_SHARED;
+        ref.handle = SharedBufferPool::GetHandle(cm.sharedBuffer);
+        ref.dataSize = cm.dataSize;
+        return true;
+    }
+
+    if (cm.data == nullptr)
+        return true;
+
+    // Heap fallback blocks have no handle, static external buffers are not owned by the command
+    if (cm.bShouldFreeData && CommandPool::GetHandle(cm.data, ref.handle)) {
+        payload = COMPACT_PAYLOAD_POOL;
+        ref.dataSize = cm.dataSize;
+        return true;
+    }
+
+    return PackSlot(cm);
+}
+
+/**
+ * @brief Parks a copy of the command in a free slot
+ * @param cm Command to park
+ * @return true on success, false if every slot is in use
+*/
+bool CompactCommand::PackSlot(const Command& cm)
+{
+    uint8_t slot = 0;
+    bool found = false;
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    for (uint8_t i = 0; i < COMMAND_SLOT_COUNT; i++) {
+        const uint8_t idx = (nextSlot + i) % COMMAND_SLOT_COUNT;
+        if (slots[idx].bInUse)
+            continue;
+
+        slots[idx].bInUse = true;
+        nextSlot = (idx + 1) % COMMAND_SLOT_COUNT;
+        slot = idx;
+        found = true;
+
+        slotsInUse++;
+        if (slotsInUse > slotHighWater)
+            slotHighWater = slotsInUse;
+        break;
+    }
+    if (!found)
+        slotExhaustionCount++;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    if (!found)
+        return false;
+
+    // Only this handle refers to the slot now, copy outside the critical section
+    memcpy(slots[slot].bytes, static_cast<const void*>(&cm), sizeof(Command));
+
+    payload = COMPACT_PAYLOAD_SLOT;
+    ref.handle = (slots[slot].generation << 8) | slot;
+    ref.dataSize = cm.GetDataSize();
+    return true;
+}
+
+/**
+ * @brief Decodes into a full Command and frees the slot, the compact command must not be unpacked twice
+ * @param cm Command to decode into, overwritten without a Reset()
+ * @return true on success, false if the payload was already released (stale handle)
+*/
+bool CompactCommand::Unpack(Command& cm)
+{
+    const COMPACT_PAYLOAD kind = GetPayload();
+
+    if (kind == COMPACT_PAYLOAD_SLOT)
+        return UnpackSlot(cm);
+
+    uint8_t* data = nullptr;
+    SharedBuffer* sharedBuffer = nullptr;
+    if (kind == COMPACT_PAYLOAD_POOL && (data = CommandPool::FromHandle(ref.handle)) == nullptr)
+        return false;
+    if (kind == COMPACT_PAYLOAD_SHARED && (sharedBuffer = SharedBufferPool::FromHandle(ref.handle)) == nullptr)
+        return false;
+
+    new (&cm) Command(command, taskCommand);
+
+    switch (kind) {
+    case COMPACT_PAYLOAD_INLINE:
+        cm.bInlineData = true;
+        cm.dataSize = GetDataSize();
+        memcpy(cm.inlineData, inlineData, cm.dataSize);
+        break;
+    case COMPACT_PAYLOAD_POOL:
+        cm.data = data;
+        cm.bShouldFreeData = true;
+        cm.dataSize = ref.dataSize;
+        break;
+    case COMPACT_PAYLOAD_SHARED:
+        cm.sharedBuffer = sharedBuffer;
+        cm.bSharedData = true;
+        cm.dataSize = ref.dataSize;
+        break;
+    default:
+        break;
+    }
+
+    // The payload belongs to cm now
+    payload = COMPACT_PAYLOAD_NONE;
+    return true;
+}
+
+/**
+ * @brief Restores the command parked in a slot and frees the slot
+ * @param cm Command to decode into
+ * @return true on success, false if the slot was already released (stale handle)
+*/
+bool CompactCommand::UnpackSlot(Command& cm)
+{
+    const uint8_t slot = (uint8_t)ref.handle;
+    const uint8_t generation = ref.handle >> 8;
+
+    if (slot >= COMMAND_SLOT_COUNT || !slots[slot].bInUse || slots[slot].generation != generation)
+        return false;
+
+    memcpy(static_cast<void*>(&cm), slots[slot].bytes, sizeof(Command));
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    slots[slot].generation++;
+    slots[slot].bInUse = false;
+    slotsInUse--;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    payload = COMPACT_PAYLOAD_NONE;
+    return true;
+}
+
+/**
+ * @brief Copies the slot table statistics
+ * @param stats Struct to copy the statistics into
+*/
+void CompactCommand::GetSlotStats(CommandSlotStats& stats)
+{
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    stats.capacity = COMMAND_SLOT_COUNT;
+    stats.inUse = slotsInUse;
+    stats.highWater = slotHighWater;
+    stats.exhaustionCount = slotExhaustionCount;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
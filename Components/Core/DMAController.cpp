@@ -0,0 +1,137 @@
+/**
+ ******************************************************************************
+ * File Name          : DMAController.cpp
+ * Description        : DMA stream wrapper, configures a stream through the LL library
+ *    and decodes its interrupt flags.
+ ******************************************************************************
+*/
+#include "DMAController.hpp"
+
+/* Variables -----------------------------------------------------------------*/
+namespace Driver {
+    DMAController dma1Stream7(DMA1, LL_DMA_STREAM_7, LL_DMA_CHANNEL_4, DMA1_Stream7_IRQn);
+    DMAController dma2Stream2(DMA2, LL_DMA_STREAM_2, LL_DMA_CHANNEL_4, DMA2_Stream2_IRQn);
+}
+
+namespace {
+    // Position of each stream's flags inside LISR/HISR (streams 0-3 and 4-7)
+    constexpr uint8_t DMA_FLAG_SHIFTS[4] = { 0, 6, 16, 22 };
+
+    // Flag bits relative to the stream's position
+    constexpr uint32_t DMA_FLAG_FE = (1UL << 0);
+    constexpr uint32_t DMA_FLAG_DME = (1UL << 2);
+    constexpr uint32_t DMA_FLAG_TE = (1UL << 3);
+    constexpr uint32_t DMA_FLAG_HT = (1UL << 4);
+    constexpr uint32_t DMA_FLAG_TC = (1UL << 5);
+    constexpr uint32_t DMA_FLAG_ALL = DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE | DMA_FLAG_HT | DMA_FLAG_TC;
+}
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Configures the stream for byte transfers from memory to a peripheral data register, and enables its interrupt
+ * @param peripheralAddress Address of the peripheral data register
+*/
+void DMAController::ConfigureMemoryToPeripheral(uint32_t peripheralAddress)
+{
+    ConfigureStream(LL_DMA_DIRECTION_MEMORY_TO_PERIPH, LL_DMA_MODE_NORMAL, peripheralAddress);
+}
+
+/**
+ * @brief Configures the stream for byte transfers from a peripheral data register into a circular memory buffer,
+ *        and enables its half transfer, transfer complete and error interrupts. Start() once with the whole buffer.
+ * @param peripheralAddress Address of the peripheral data register
+*/
+void DMAController::ConfigurePeripheralToMemoryCircular(uint32_t peripheralAddress)
+{
+    ConfigureStream(LL_DMA_DIRECTION_PERIPH_TO_MEMORY, LL_DMA_MODE_CIRCULAR, peripheralAddress);
+    LL_DMA_EnableIT_HT(kDma_, kStream_);
+}
+
+/**
+ * @brief Configures the stream for byte transfers between memory and a peripheral data register
+ * @param direction LL_DMA_DIRECTION_x
+ * @param mode LL_DMA_MODE_NORMAL or LL_DMA_MODE_CIRCULAR
+ * @param peripheralAddress Address of the peripheral data register
+*/
+void DMAController::ConfigureStream(uint32_t direction, uint32_t mode, uint32_t peripheralAddress)
+{
+    if (kDma_ == DMA1)
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+    else
+        LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA2);
+
+    Stop();
+
+    LL_DMA_SetChannelSelection(kDma_, kStream_, kChannel_);
+    LL_DMA_ConfigTransfer(kDma_, kStream_, direction | mode | LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT
+        | LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE | LL_DMA_PRIORITY_LOW);
+    LL_DMA_DisableFifoMode(kDma_, kStream_);
+    LL_DMA_SetPeriphAddress(kDma_, kStream_, peripheralAddress);
+
+    LL_DMA_EnableIT_TC(kDma_, kStream_);
+    LL_DMA_EnableIT_TE(kDma_, kStream_);
+
+    NVIC_SetPriority(kIrq_, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), DMA_IRQ_PRIORITY, 0));
+    NVIC_EnableIRQ(kIrq_);
+}
+
+/**
+ * @brief Starts a transfer, the stream must not be busy
+ * @param memory Memory buffer, must stay valid until the transfer completes
+ * @param len Number of bytes to transfer
+*/
+void DMAController::Start(const uint8_t* memory, uint16_t len)
+{
+    // Stale flags of the last transfer would block the stream from enabling
+    ReadAndClearFlags();
+
+    LL_DMA_SetMemoryAddress(kDma_, kStream_, static_cast<uint32_t>(reinterpret_cast<uintptr_t>(memory)));
+    LL_DMA_SetDataLength(kDma_, kStream_, len);
+    LL_DMA_EnableStream(kDma_, kStream_);
+}
+
+/**
+ * @brief Disables the stream and waits until the hardware has released it
+*/
+void DMAController::Stop()
+{
+    LL_DMA_DisableStream(kDma_, kStream_);
+    while (LL_DMA_IsEnabledStream(kDma_, kStream_)) {}
+    ReadAndClearFlags();
+}
+
+/**
+ * @brief Reads and clears the interrupt flags of the stream
+ * @return DMA_EVENT flags that were set
+*/
+uint32_t DMAController::HandleIRQ()
+{
+    return ReadAndClearFlags();
+}
+
+/**
+ * @brief Reads and clears every flag of the stream in LISR/HISR
+ * @return DMA_EVENT flags that were set
+*/
+uint32_t DMAController::ReadAndClearFlags()
+{
+    const uint8_t shift = DMA_FLAG_SHIFTS[kStream_ & 3];
+    const bool high = (kStream_ >= LL_DMA_STREAM_4);
+
+    const uint32_t flags = (((high ? kDma_->HISR : kDma_->LISR) >> shift) & DMA_FLAG_ALL);
+    if (high)
+        kDma_->HIFCR = flags << shift;
+    else
+        kDma_->LIFCR = flags << shift;
+
+    uint32_t events = 0;
+    if (flags & DMA_FLAG_TC)
+        events |= DMA_EVENT_TRANSFER_COMPLETE;
+    if (flags & DMA_FLAG_HT)
+        events |= DMA_EVENT_HALF_TRANSFER;
+    // FE is expected in direct mode (FIFO disabled) and is not an error
+    if (flags & (DMA_FLAG_TE | DMA_FLAG_DME))
+        events |= DMA_EVENT_ERROR;
+    return events;
+}
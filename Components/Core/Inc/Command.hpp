@@ -11,9 +11,13 @@
 #include <atomic>
 
 #include "cmsis_os.h"
+#include "SharedBuffer.hpp"
 
 /* Macros --------------------------------------------------------------------*/
 
+/* Constants -----------------------------------------------------------------*/
+constexpr uint16_t COMMAND_INLINE_DATA_SIZE = 8;    // Payloads up to this size are stored inside the Command, shares space with the data pointer
+
 /* Enums -----------------------------------------------------------------*/
 enum GLOBAL_COMMANDS : uint8_t
 {
@@ -46,15 +50,16 @@ public:
     //~Command();    // We can't handle memory like this, since the object would be 'destroyed' after copying to the RTOS queue
 
     // Functions
-    uint8_t* AllocateData(uint16_t dataSize);    // Dynamically allocates data for the command
+    uint8_t* AllocateData(uint16_t dataSize);    // Allocates data for the command, inline if small enough, otherwise from the CommandPool
     bool CopyDataToCommand(uint8_t* dataSrc, uint16_t size);    // Copies the data into the command, into newly allocated memory
     bool SetCommandToStaticExternalBuffer(uint8_t* existingPtr, uint16_t size);    // Set data pointer to a pre-allocated buffer, if bFreeMemory is set to true, responsibility for freeing memory will fall on Command
+    bool SetCommandToSharedBuffer(SharedBuffer* buffer, uint16_t size);    // Reference a shared buffer without copying, adds a reference that is dropped in Reset()
 
     void Reset();    // Reset the command, equivalent of a destructor that must be called, counts allocations and deallocations, asserts an error if the allocation count is too high
 
     // Getters
     uint16_t GetDataSize() const;
-    uint8_t* GetDataPointer() const { return data; }
+    uint8_t* GetDataPointer() const;
     GLOBAL_COMMANDS GetCommand() const { return command; }
     uint16_t GetTaskCommand() const { return taskCommand; }
 
@@ -68,17 +73,27 @@ protected:
     GLOBAL_COMMANDS command;    // General GLOBAL command, each task must be able to handle these types of commands
     uint16_t taskCommand;        // Task specific command, the task this command event is sent to needs to handle this
 
-    uint8_t* data;                // Pointer to optional data
+    union {
+        uint8_t* data;                                      // Pointer to optional data
+        SharedBuffer* sharedBuffer;                         // Referenced shared buffer, valid when bSharedData is set
+        uint8_t inlineData[COMMAND_INLINE_DATA_SIZE];       // Inline storage for small optional data, valid when bInlineData is set
+    };
     uint16_t dataSize;            // Size of optional data
 
 	uint32_t passedParam; 		// Any kind of param passed in with command
 
 private:
     bool bShouldFreeData;        // Should the Command handle freeing the data pointer (necessary to enable Command object to handle static memory ptrs)
+    bool bInlineData;            // Is the data stored in inlineData rather than behind the data pointer
+    bool bSharedData;            // Does the command hold a reference to sharedBuffer
+
+    bool HasData() const { return bInlineData || bSharedData || data != nullptr; }
 
     static std::atomic<uint16_t> statAllocationCounter;    // Static allocation counter shared by all command objects
 
     Command(const Command&);    // Prevent copy-construction
+
+    friend class CompactCommand;    // Encodes the payload descriptor without a full copy
 };
 
 #endif /* AVIONICS_INCLUDE_SOAR_CORE_COMMAND_H */
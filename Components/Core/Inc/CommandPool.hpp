@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ * File Name          : CommandPool.hpp
+ * Description        : CommandPool provides fixed-block size-class pools for
+ *    Command payloads, allocated once at boot instead of from the RTOS heap.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_CORE_COMMAND_POOL_H
+#define AVIONICS_INCLUDE_SOAR_CORE_COMMAND_POOL_H
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+/* Enums -----------------------------------------------------------------*/
+enum COMMAND_POOL_CLASS : uint8_t
+{
+    COMMAND_POOL_CLASS_32B = 0,     // Blocks of up to 32 bytes
+    COMMAND_POOL_CLASS_64B,         // Blocks of up to 64 bytes
+    COMMAND_POOL_CLASS_128B,        // Blocks of up to 128 bytes
+    COMMAND_POOL_CLASS_256B,        // Blocks of up to 256 bytes
+    COMMAND_POOL_CLASS_COUNT
+};
+
+/* Structs -----------------------------------------------------------------*/
+struct CommandPoolStats
+{
+    uint16_t blockSize;         // Size of each block in this class in bytes
+    uint16_t capacity;          // Number of blocks in this class
+    uint16_t inUse;             // Number of blocks currently allocated
+    uint16_t highWater;         // Maximum number of blocks ever allocated at once
+    uint32_t exhaustionCount;   // Number of allocations that found this class full
+};
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief CommandPool is a static allocator for Command payloads
+ *
+ * Allocations are served from the smallest size class that fits, falling through to larger classes
+ * when a class is exhausted, and to soar_malloc only if all suitable classes are full or the size
+ * exceeds the largest class. Safe to call from tasks and (for the pool path) from ISRs.
+ *
+ * A pool block can be referred to by a 16 bit handle instead of its pointer, each block has a generation
+ * that changes on every Free so a handle to a freed block is detected.
+*/
+class CommandPool
+{
+public:
+    static uint8_t* Allocate(uint16_t size);    // Allocates a block of at least size bytes
+    static void Free(uint8_t* ptr);             // Frees a block returned by Allocate
+
+    static bool GetHandle(const uint8_t* ptr, uint16_t& handle);    // Encodes a pool block as class, index and generation, false for a heap fallback block
+    static uint8_t* FromHandle(uint16_t handle);                    // Decodes a handle, nullptr if the block was freed since (stale handle)
+
+    static bool GetStats(uint8_t poolClass, CommandPoolStats& stats);    // Copies the statistics for a size class
+    static uint32_t GetHeapFallbackCount() { return statHeapFallbackCounter; }
+    static void PrintStats();                   // Prints the statistics for all size classes
+
+private:
+    static uint32_t statHeapFallbackCounter;    // Number of allocations that had to fall back to the heap
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_COMMAND_POOL_H */
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * File Name          : CommandRouter.hpp
+ * Description        : CommandRouter dispatches Commands to typed message handlers
+ *    declared by each task, in the style of etl::message_router.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_CORE_COMMAND_ROUTER_H
+#define AVIONICS_INCLUDE_SOAR_CORE_COMMAND_ROUTER_H
+/* Includes ------------------------------------------------------------------*/
+#include "Command.hpp"
+#include "Queue.hpp"
+#include "SystemDefines.hpp"
+
+#include "etl/type_traits.h"
+
+/* Structs -----------------------------------------------------------------*/
+
+/**
+ * @brief Typed message for a GLOBAL_COMMANDS and task command pair, the task command must be a value of the
+ *        task's own command enum so messages of different tasks are distinct types
+ * @param cm The Command being dispatched, for access to any data
+*/
+template <GLOBAL_COMMANDS TCommand, auto TTaskCommand>
+struct CommandMessage
+{
+    static constexpr GLOBAL_COMMANDS COMMAND = TCommand;
+    static constexpr uint16_t TASK_COMMAND = static_cast<uint16_t>(TTaskCommand);
+    static constexpr uint32_t KEY = (static_cast<uint32_t>(TCommand) << 16) | TASK_COMMAND;
+
+    Command& cm;
+};
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief CommandRouter is a CRTP base for tasks, TMessages lists every CommandMessage the task handles
+ *
+ * Usage:
+ *  - The task derives from CommandRouter<TTask, TMessages...> and declares OnMessage(const TMessage&) for each
+ *    message, a missing handler is a compile error
+ *  - Route(cm) calls the matching handler, or OnUnsupported(cm) for anything else, and always resets cm
+ *  - Post<TMessage>() sends a message to the task, sending a message the task does not handle is a compile error
+ *
+ * The dispatch is a chain of comparisons against compile-time keys, which the compiler lowers like a switch.
+*/
+template <typename TDerived, typename... TMessages>
+class CommandRouter
+{
+public:
+    /**
+     * @brief Checks at compile time if the router handles a message
+     * @return true if TMessage is one of TMessages
+    */
+    template <typename TMessage>
+    static constexpr bool Accepts() { return (etl::is_same<TMessage, TMessages>::value || ...); }
+
+    /**
+     * @brief Sends a message to the task, safe to call from any task
+     * @param lane QUEUE_LANE to send on
+    */
+    template <typename TMessage>
+    void Post(uint8_t lane = QUEUE_LANE_DEFAULT)
+    {
+        static_assert(Accepts<TMessage>(), "CommandRouter - task does not handle this message");
+        static_cast<TDerived*>(this)->SendCommand(Command(TMessage::COMMAND, TMessage::TASK_COMMAND), lane);
+    }
+
+protected:
+    /**
+     * @brief Dispatches a command to its typed handler, must be called with every received command
+     * @param cm Command to dispatch, reset after handling
+    */
+    void Route(Command& cm)
+    {
+        static_assert(sizeof...(TMessages) > 0, "CommandRouter - must handle at least one message");
+        static_assert(KeysUnique(), "CommandRouter - duplicate message");
+
+        const uint32_t key = (static_cast<uint32_t>(cm.GetCommand()) << 16) | cm.GetTaskCommand();
+
+        if (!(TryRoute<TMessages>(key, cm) || ...))
+            static_cast<TDerived*>(this)->OnUnsupported(cm);
+
+        //No matter what we happens, we must reset allocated data
+        cm.Reset();
+    }
+
+    /**
+     * @brief Default handler for commands that are not in TMessages, the task may hide this with its own
+     * @param cm Unsupported command
+    */
+    void OnUnsupported(Command& cm)
+    {
+        SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_SYSTEM, "Received Unsupported Command {%d, %d}\n", cm.GetCommand(), cm.GetTaskCommand());
+    }
+
+private:
+    template <typename TMessage>
+    bool TryRoute(uint32_t key, Command& cm)
+    {
+        if (key != TMessage::KEY)
+            return false;
+
+        static_cast<TDerived*>(this)->OnMessage(TMessage{ cm });
+        return true;
+    }
+
+    /**
+     * @brief Checks that no two messages share a command and task command pair
+     * @return true if every key is unique
+    */
+    static constexpr bool KeysUnique()
+    {
+        constexpr uint32_t keys[] = { TMessages::KEY... };
+        for (size_t i = 0; i < sizeof...(TMessages); i++) {
+            for (size_t j = i + 1; j < sizeof...(TMessages); j++) {
+                if (keys[i] == keys[j])
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_COMMAND_ROUTER_H */
@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * File Name          : CompactCommand.hpp
+ * Description        : CompactCommand is the 8 byte form of a Command that travels
+ *    through RTOS queues, a pool or shared buffer payload is referenced by handle
+ *    and anything else is parked in a slot table referenced by slot index and generation.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_CORE_COMPACT_COMMAND_H
+#define AVIONICS_INCLUDE_SOAR_CORE_COMPACT_COMMAND_H
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+#include "Command.hpp"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr uint8_t COMPACT_COMMAND_INLINE_BYTES = 4;    // Inline payloads up to this size travel in the compact command itself
+
+/* Enums -----------------------------------------------------------------*/
+enum COMPACT_PAYLOAD : uint8_t
+{
+    COMPACT_PAYLOAD_NONE = 0,       // No payload
+    COMPACT_PAYLOAD_INLINE,         // Small inline payload, stored in the compact command
+    COMPACT_PAYLOAD_POOL,           // CommandPool block, referenced by CommandPool handle
+    COMPACT_PAYLOAD_SHARED,         // SharedBuffer reference, referenced by SharedBufferPool handle
+    COMPACT_PAYLOAD_SLOT            // Anything else, the full Command is parked in a slot
+};
+
+/* Structs -----------------------------------------------------------------*/
+struct CommandSlotStats
+{
+    uint16_t capacity;          // Number of slots in the table
+    uint16_t inUse;             // Number of slots currently holding a command
+    uint16_t highWater;         // Maximum number of slots ever in use at once
+    uint32_t exhaustionCount;   // Number of packs that found the table full
+};
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief CompactCommand is what Queue copies in and out of the RTOS queues instead of the full Command
+ *
+ * Usage:
+ *  - Pack(cm) before sending, ownership of any payload moves with the compact command as it would with a raw copy
+ *  - Unpack(cm) after receiving restores the Command exactly and frees the slot, if one was used
+ *
+ * Commands without a payload, with an inline payload of up to COMPACT_COMMAND_INLINE_BYTES, a CommandPool block
+ * or a SharedBuffer are encoded in the 8 bytes with no copy of the Command. Only static external buffers, heap
+ * fallback blocks, larger inline payloads and commands with a passedParam park a copy of the Command in a slot.
+ *
+ * Pool blocks, shared buffers and slots all have a generation that changes on every release, so a stale or
+ * duplicated handle is detected on Unpack instead of silently reading another command's payload.
+ * Safe to use from tasks and ISRs.
+*/
+class CompactCommand
+{
+public:
+    CompactCommand() : command(COMMAND_NONE), payload(COMPACT_PAYLOAD_NONE), taskCommand(0), ref{ 0, 0 } {}
+
+    bool Pack(const Command& cm);    // Encodes the command, false if the command needs a slot and the slot table is full
+    bool Unpack(Command& cm);        // Decodes into cm and frees the slot, false on a stale handle
+
+    // Getters, valid without unpacking
+    GLOBAL_COMMANDS GetCommand() const { return command; }
+    uint16_t GetTaskCommand() const { return taskCommand; }
+    uint16_t GetDataSize() const { return (GetPayload() == COMPACT_PAYLOAD_INLINE) ? (payload >> 4) : ref.dataSize; }
+    bool HasPayload() const { return GetPayload() != COMPACT_PAYLOAD_NONE; }
+
+    static void GetSlotStats(CommandSlotStats& stats);    // Copies the slot table statistics
+
+private:
+    COMPACT_PAYLOAD GetPayload() const { return (COMPACT_PAYLOAD)(payload & 0x0F); }
+    bool PackSlot(const Command& cm);
+    bool UnpackSlot(Command& cm);
+
+    GLOBAL_COMMANDS command;    // General GLOBAL command
+    uint8_t payload;            // COMPACT_PAYLOAD in the low nibble, inline payload size in the high nibble
+    uint16_t taskCommand;       // Task specific command
+    union {
+        struct {
+            uint16_t handle;    // Pool or shared buffer handle, or slot index in the low byte and generation in the high byte
+            uint16_t dataSize;  // Size of the payload
+        } ref;
+        uint8_t inlineData[COMPACT_COMMAND_INLINE_BYTES];    // Inline payload
+    };
+};
+
+static_assert(sizeof(CompactCommand) == 8, "CompactCommand must stay 8 bytes");
+
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_COMPACT_COMMAND_H */
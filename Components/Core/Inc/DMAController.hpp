@@ -7,36 +7,64 @@
 #ifndef AVIONICS_INCLUDE_SOAR_CORE_DMA_CONTROLLER_BASE_H
 #define AVIONICS_INCLUDE_SOAR_CORE_DMA_CONTROLLER_BASE_H
 /* Includes ------------------------------------------------------------------*/
-#include "SystemDefines.hpp"
+#include "stm32f4xx_ll_dma.h"
+#include "stm32f4xx_ll_bus.h"
+#include "cmsis_os.h"
 
 /* Macros --------------------------------------------------------------------*/
-
-/* Enums -----------------------------------------------------------------*/
+constexpr uint32_t DMA_EVENT_TRANSFER_COMPLETE = (1UL << 0);    // The stream moved its last item
+constexpr uint32_t DMA_EVENT_HALF_TRANSFER = (1UL << 1);        // The stream moved half of its items
+constexpr uint32_t DMA_EVENT_ERROR = (1UL << 2);                // Transfer or direct mode error
+constexpr uint8_t DMA_IRQ_PRIORITY = 5;                         // Same as the UART IRQs, must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY
 
 /* Class -----------------------------------------------------------------*/
+class DMAController;
+
+namespace Driver {
+    extern DMAController dma1Stream7;    // UART5 TX, channel 4
+    extern DMAController dma2Stream2;    // USART1 RX, channel 4
+}
 
 /**
  * @brief DMA Controller Base class, handles interrupt setup and DMA buffer configuration, derivable for particular peripherals
+ *
+ * Wraps one stream of a DMA controller through the LL library. The owner configures the stream once,
+ * then starts transfers and must call HandleIRQ() inside the stream's IRQHandler.
 */
 class DMAController
 {
 public:
     // Constructors
-    DMAController(void);
+    DMAController(DMA_TypeDef* dma, uint32_t stream, uint32_t channel, IRQn_Type irq) :
+        kDma_(dma),
+        kStream_(stream),
+        kChannel_(channel),
+        kIrq_(irq) {}
+
+    // Setup
+    void ConfigureMemoryToPeripheral(uint32_t peripheralAddress);
+    void ConfigurePeripheralToMemoryCircular(uint32_t peripheralAddress);    // Also enables the half transfer interrupt
 
     // Functions
+    void Start(const uint8_t* memory, uint16_t len);
+    void Stop();
 
     // Getters
+    bool IsBusy() const { return LL_DMA_IsEnabledStream(kDma_, kStream_); }
+    uint16_t GetRemaining() const { return static_cast<uint16_t>(LL_DMA_GetDataLength(kDma_, kStream_)); }    // Items left before the stream completes or wraps
 
-    // Setters
-
-    // Static/Setup
-    static void SetupCallbacks();    // Register the DMA callbacks
+    // Interrupts
+    uint32_t HandleIRQ();    // MUST be called inside DMAx_Streamy_IRQHandler, returns the DMA_EVENT flags that were cleared
 
 protected:
+    void ConfigureStream(uint32_t direction, uint32_t mode, uint32_t peripheralAddress);
+    uint32_t ReadAndClearFlags();
 
-private:
-
+    // Constants
+    DMA_TypeDef* kDma_;
+    uint32_t kStream_;      // LL_DMA_STREAM_x
+    uint32_t kChannel_;     // LL_DMA_CHANNEL_x
+    IRQn_Type kIrq_;
 };
 
-#endif /* AVIONICS_INCLUDE_SOAR_CORE_DMA_CONTROLLER_BASE_H */
\ No newline at end of file
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_DMA_CONTROLLER_BASE_H */
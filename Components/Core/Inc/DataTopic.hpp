@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * File Name          : DataTopic.hpp
+ * Description        : DataTopic is a publish/subscribe slot for sensor samples,
+ *    holding the latest sample and a bounded history that any task can read
+ *    without a command round-trip to the publisher.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_CORE_DATA_TOPIC_H
+#define AVIONICS_INCLUDE_SOAR_CORE_DATA_TOPIC_H
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+#include "etl/circular_buffer.h"
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief DataTopic holds the last THistoryDepth samples published by one task
+ *
+ * Usage:
+ *  - The publisher calls Publish() with each new sample
+ *  - Subscribers call GetLatest() or GetHistory() at their own rate, comparing the returned sequence with
+ *    the last one they consumed to detect new samples
+ *
+ * Samples are copied under a short interrupt-masking critical section, so TSample should be small
+ * plain-old-data. Safe to use from tasks and ISRs.
+*/
+template <typename TSample, size_t THistoryDepth>
+class DataTopic
+{
+public:
+    DataTopic() : sequence(0) {}
+
+    /**
+     * @brief Publishes a sample, overwriting the oldest sample in the history if it is full
+     * @param sample Sample to publish
+    */
+    void Publish(const TSample& sample)
+    {
+        UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+        history.push(sample);
+        sequence++;
+        taskEXIT_CRITICAL_FROM_ISR(savedMask);
+    }
+
+    /**
+     * @brief Copies the latest sample
+     * @param sample Sample to copy into
+     * @param seq Set to the sequence number of the sample, 1 for the first sample published
+     * @return true on success, false if nothing has been published yet
+    */
+    bool GetLatest(TSample& sample, uint32_t& seq) const
+    {
+        bool ret = false;
+
+        UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+        if (!history.empty()) {
+            sample = history.back();
+            ret = true;
+        }
+        seq = sequence;
+        taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+        return ret;
+    }
+
+    /**
+     * @brief Copies up to maxCount of the most recent samples, oldest first
+     * @param samples Array of at least maxCount samples to copy into
+     * @param maxCount Max number of samples to copy
+     * @return Number of samples copied
+    */
+    uint16_t GetHistory(TSample* samples, uint16_t maxCount) const
+    {
+        UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+        const uint16_t count = (history.size() < maxCount) ? history.size() : maxCount;
+        const uint16_t first = history.size() - count;
+        for (uint16_t i = 0; i < count; i++)
+            samples[i] = history[first + i];
+        taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+        return count;
+    }
+
+    uint32_t GetSequence() const { return sequence; }    // Number of samples ever published
+
+private:
+    etl::circular_buffer<TSample, THistoryDepth> history;    // Most recent samples, oldest first
+    volatile uint32_t sequence;                              // Number of samples ever published
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_DATA_TOPIC_H */
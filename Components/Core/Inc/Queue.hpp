@@ -6,6 +6,15 @@
  *	Queue is a wrapper for RTOS xQueues for use in C++.
  *	with an internal queue handle and queue depth.
  *
+ *	A Queue can optionally have multiple priority lanes, each with its own depth.
+ *	Receives always return a command from the highest priority non-empty lane.
+ *
+ *	Each lane has a send policy for when it is full, and the Queue keeps send
+ *	statistics so drops are counted instead of printed (printing enqueues to the
+ *	UART queue, which could itself be full).
+ *
+ *	Commands travel through the RTOS queues as 8 byte CompactCommands, see CompactCommand.hpp.
+ *
  *	Currently only handles Command objects, may want to make this a base template
  *	class for which CommandQueue inherits from.
  ******************************************************************************
@@ -15,7 +24,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include "cmsis_os.h"
 #include "Command.hpp"
+#include "CompactCommand.hpp"
 #include "FreeRTOS.h"
+#include "semphr.h"
 #include "Utils.hpp"
 
 /* Macros --------------------------------------------------------------------*/
@@ -24,6 +35,32 @@
 /* Constants -----------------------------------------------------------------*/
 //constexpr uint16_t MAX_TICKS_TO_WAIT_SEND = MS_TO_TICKS(1000);
 
+/* Enums -----------------------------------------------------------------*/
+enum QUEUE_LANE : uint8_t
+{
+	QUEUE_LANE_CONTROL = 0,		// Highest priority, state changing commands (eg. tare, calibrate)
+	QUEUE_LANE_DEFAULT,			// Normal priority, sampling and telemetry requests
+	QUEUE_LANE_DEBUG,			// Lowest priority, debug output
+	QUEUE_LANE_COUNT
+};
+
+enum QUEUE_SEND_POLICY : uint8_t
+{
+	QUEUE_SEND_BLOCK = 0,			// Wait up to DEFAULT_QUEUE_SEND_WAIT_TICKS for space, then drop the new command
+	QUEUE_SEND_TRY_ONCE,			// Never wait, drop the new command if the lane is full
+	QUEUE_SEND_DROP_OLDEST,			// Never wait, drop the oldest command in the lane to make space
+	QUEUE_SEND_OVERWRITE_LATEST		// Mailbox for a single lane depth 1 queue, the new command replaces the waiting one (xQueueOverwrite)
+};
+
+/* Structs -----------------------------------------------------------------*/
+struct QueueStats
+{
+	uint32_t sendCount;			// Number of commands sent successfully
+	uint32_t dropCount;			// Number of commands dropped, new or displaced by the send policy
+	uint32_t blockedTicks;		// Total ticks senders spent waiting for space
+	uint16_t highWater;			// Max number of commands ever waiting
+};
+
 /* Class -----------------------------------------------------------------*/
 
 class Queue {
@@ -31,26 +68,57 @@ public:
 	//Constructors
 	Queue(void);
 	Queue(uint16_t depth);
+	Queue(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT]);	// Multi-lane queue, a lane with depth 0 is merged into the nearest higher priority lane
 
-	//Functions
-	bool Send(Command& command);
-	bool SendFromISR(Command& command);
+	//Static constructors, storage must hold the total depth in CompactCommands and outlive the queue
+	Queue(uint16_t depth, uint8_t* storage, StaticQueue_t* queueBuffer);
+	Queue(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT], uint8_t* storage, StaticQueue_t (&laneBuffers)[QUEUE_LANE_COUNT], StaticSemaphore_t* laneCountBuffer);
 
-	bool SendToFront(Command& command);
+	//Functions, lane is ignored for single lane queues
+	bool Send(Command& command, uint8_t lane = QUEUE_LANE_DEFAULT);
+	bool SendFromISR(Command& command, uint8_t lane = QUEUE_LANE_DEFAULT);
+
+	bool SendToFront(Command& command, uint8_t lane = QUEUE_LANE_DEFAULT);
 
 	bool Receive(Command& cm, uint32_t timeout_ms = 0);
 	bool ReceiveWait(Command& cm); //Blocks until a command is received
+	uint16_t ReceiveBatch(Command* cms, uint16_t maxCount, uint32_t timeout_ms = 0); //Blocks for the first command, then drains without blocking
+	bool ReceiveFromLane(Command& cm, uint8_t lane); //Receives from one lane only, never blocks, lets a receiver hold back a lane it can not serve yet
+
+	void SetNotifyTarget(TaskHandle_t task, uint32_t events); //Sets event bits on the given task whenever a command is sent
+	void SetSendPolicy(QUEUE_SEND_POLICY policy); //Sets the policy of every lane
+	void SetSendPolicy(QUEUE_SEND_POLICY policy, uint8_t lane); //Sets the policy of one lane, eg. drop oldest debug output while other lanes block
+
+	void GetStats(QueueStats& statsOut) const;
 
 	//Getters
-	uint16_t GetQueueMessageCount() const { return uxQueueMessagesWaiting(rtQueueHandle); }
+	uint16_t GetQueueMessageCount() const;
 	uint16_t GetQueueDepth() const { return queueDepth; }
+	QUEUE_SEND_POLICY GetSendPolicy(uint8_t lane = QUEUE_LANE_DEFAULT) const { return sendPolicy[(lane < QUEUE_LANE_COUNT) ? lane : QUEUE_LANE_COUNT - 1]; }
 
 protected:
+	void InitLanes(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT], uint8_t* storage, StaticQueue_t* laneBuffers, StaticSemaphore_t* laneCountBuffer);
+	QueueHandle_t GetLaneHandle(uint8_t lane) const;
+	bool ReceiveFromLanes(Command& cm, TickType_t ticksToWait);
+	bool SendToLane(Command& command, uint8_t lane, BaseType_t position);
+	bool DropOldest(QueueHandle_t handle, BaseType_t* pxHigherPriorityTaskWoken);
+	bool Overwrite(QueueHandle_t handle, CompactCommand& packed, BaseType_t* pxHigherPriorityTaskWoken);
+	void RecordSend(bool sent, TickType_t blockedTicks);
+
 	//RTOS
-	QueueHandle_t rtQueueHandle;	// RTOS Event Queue Handle
+	QueueHandle_t rtQueueHandle;	// RTOS Event Queue Handle, the only handle if the queue has a single lane
+	QueueHandle_t rtLaneHandles[QUEUE_LANE_COUNT];	// RTOS Queue Handle for each lane, nullptr if the lane is unused
+	SemaphoreHandle_t rtLaneCount;	// Counts commands across all lanes, nullptr if the queue has a single lane
+	TaskHandle_t rtNotifyTask;		// Task to notify on send, nullptr if none
+	uint32_t notifyEvents;			// Event bits to set on rtNotifyTask
 	
 	//Data
 	uint16_t queueDepth;			// Max queue depth
+	QUEUE_SEND_POLICY sendPolicy[QUEUE_LANE_COUNT];	// What a send does when the target lane is full, per lane
+	QueueStats stats;				// Send statistics, updated under a critical section
+
+	void NotifyTarget();
+	void NotifyTargetFromISR(BaseType_t* pxHigherPriorityTaskWoken);
 };
 
-#endif /* AVIONICS_INCLUDE_SOAR_CORE_QUEUE_H */
\ No newline at end of file
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_QUEUE_H */
@@ -12,4 +12,6 @@ void run_interface();
 
 void cpp_USART1_IRQHandler();
 void cpp_USART5_IRQHandler();
+void cpp_DMA1_Stream7_IRQHandler();
+void cpp_DMA2_Stream2_IRQHandler();
 #endif /* C__IFACE_HPP_ */
\ No newline at end of file
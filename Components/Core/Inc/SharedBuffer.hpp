@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * File Name          : SharedBuffer.hpp
+ * Description        : SharedBuffer is a reference-counted message buffer that producers
+ *    format or serialize into directly, and that one or more Commands can reference
+ *    without copying the payload.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_CORE_SHARED_BUFFER_H
+#define AVIONICS_INCLUDE_SOAR_CORE_SHARED_BUFFER_H
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+#include "etl/message.h"
+#include "etl/reference_counted_message.h"
+#include "etl/reference_counted_message_pool.h"
+#include "etl/fixed_sized_memory_block_allocator.h"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr uint16_t SHARED_BUFFER_SIZE_BYTES = 192;     // Payload capacity of a shared buffer, fits a full DEBUG_PRINT_MAX_SIZE print
+constexpr uint16_t SHARED_BUFFER_COUNT = 12;           // Number of shared buffers in the pool
+constexpr etl::message_id_t SHARED_BUFFER_MESSAGE_ID = 1;
+
+/* Structs -----------------------------------------------------------------*/
+struct SharedBufferMessage : public etl::message<SHARED_BUFFER_MESSAGE_ID>
+{
+    uint16_t size = 0;                          // Number of valid bytes in data
+    uint8_t index = 0;                          // Position of the buffer in the pool registry, see GetHandle
+    uint8_t data[SHARED_BUFFER_SIZE_BYTES];     // Payload
+};
+
+using SharedBuffer = etl::reference_counted_message<SharedBufferMessage, etl::atomic_int32_t>;
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief SharedBufferPool owns the static storage for all SharedBuffers
+ *
+ * Usage:
+ *  - Allocate() returns a buffer holding one reference owned by the producer
+ *  - The producer writes into GetData(buf) and attaches it to any number of Commands (each adds a reference)
+ *  - The producer calls Release(buf) to drop its own reference, each Command drops its reference in Reset()
+ *  - The buffer returns to the pool when the last reference is dropped
+ *
+ * A buffer can be referred to by a 16 bit handle instead of its pointer, the handle carries a generation that
+ * changes every time the buffer returns to the pool so a handle to a released buffer is detected.
+*/
+class SharedBufferPool : public etl::reference_counted_message_pool<etl::atomic_int32_t>
+{
+public:
+    static SharedBufferPool& Inst() {
+        static SharedBufferPool inst;
+        return inst;
+    }
+
+    static SharedBuffer* Allocate();            // Allocates a buffer with a reference count of 1, nullptr if the pool is exhausted
+    static void AddReference(SharedBuffer* buf);
+    static void Release(SharedBuffer* buf);     // Drops a reference, returns the buffer to the pool on the last one
+
+    static uint8_t* GetData(SharedBuffer* buf) { return buf->get_message().data; }
+
+    static uint16_t GetHandle(SharedBuffer* buf);           // Encodes a buffer as index and generation, only valid while a reference is held
+    static SharedBuffer* FromHandle(uint16_t handle);       // Decodes a handle, nullptr if the buffer returned to the pool since (stale handle)
+
+protected:
+    // Pool locking, safe from tasks and ISRs
+    void lock() override { savedMask = taskENTER_CRITICAL_FROM_ISR(); }
+    void unlock() override { taskEXIT_CRITICAL_FROM_ISR(savedMask); }
+
+private:
+    SharedBufferPool() : etl::reference_counted_message_pool<etl::atomic_int32_t>(allocator), savedMask(0) {}
+    SharedBufferPool(const SharedBufferPool&);                  // Prevent copy-construction
+    SharedBufferPool& operator=(const SharedBufferPool&);       // Prevent assignment
+
+    etl::fixed_sized_memory_block_allocator<sizeof(SharedBuffer), alignof(SharedBuffer), SHARED_BUFFER_COUNT> allocator;
+    UBaseType_t savedMask;
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_SHARED_BUFFER_H */
@@ -9,9 +9,15 @@
 /* Includes ------------------------------------------------------------------*/
 #include "cmsis_os.h"
 #include "Queue.hpp"
+#include "TaskLog.hpp"
 
 /* Macros --------------------------------------------------------------------*/
 
+/* Constants -----------------------------------------------------------------*/
+constexpr uint32_t TASK_EVENT_QUEUE = (1UL << 31);    // Reserved event bit, set when a command is sent to the task event queue
+                                                      // Bit 30 is reserved as well, UART_DRIVER_EVENT_TX_DONE in UARTDriver.hpp
+constexpr BaseType_t TASK_TLS_INDEX_OBJECT = 0;       // RTOS thread local storage slot holding the Task object
+
 /* Enums -----------------------------------------------------------------*/
 
 /* Class -----------------------------------------------------------------*/
@@ -21,19 +27,134 @@ public:
     //Constructors
     Task(void);
     Task(uint16_t depth);
+    Task(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT]);
 
     void InitTask();
 
     Queue* GetEventQueue() const { return qEvtQueue; }
-    void SendCommand(Command cmd) { qEvtQueue->Send(cmd); }
-    void SendCommandReference(Command& cmd) { qEvtQueue->Send(cmd); }
+    void SendCommand(Command cmd, uint8_t lane = QUEUE_LANE_DEFAULT) { qEvtQueue->Send(cmd, lane); }
+    void SendCommandReference(Command& cmd, uint8_t lane = QUEUE_LANE_DEFAULT) { qEvtQueue->Send(cmd, lane); }
+
+    // Event flags, signal-only events that bypass the event queue
+    bool Notify(uint32_t events);
+    bool NotifyFromISR(uint32_t events, BaseType_t* pxHigherPriorityTaskWoken);
+
+    uint32_t GetMergedCommandCount() const { return statMergedCommands; }
+
+    // Logging, print() formats into the log of the calling task
+    TaskLog& GetLog() { return log; }
+    static Task* GetCurrent();    // Task object of the calling RTOS task, nullptr from ISRs, before the scheduler or for foreign tasks
 
 protected:
+    uint32_t WaitEvents(uint32_t mask, uint32_t timeout_ms = portMAX_DELAY);    // Waits for any of the event bits in mask
+    void EnableQueueEvents();    // Sets TASK_EVENT_QUEUE whenever a command is sent to this task, call from Run()
+    void BindTaskObject();       // Links the created RTOS task to this object for GetCurrent(), call right after creating the task
+
+    // Receives a batch of commands and merges duplicate pending requests, see Task.cpp
+    uint16_t ReceiveCoalescedBatch(Command* cms, uint16_t maxCount, bool (*isCoalescable)(const Command& cm), uint32_t timeout_ms = portMAX_DELAY);
+
     //RTOS
     TaskHandle_t rtTaskHandle;        // RTOS Task Handle
 
     //Task structures
     Queue* qEvtQueue;    // Task event queue
+
+    //Statistics
+    uint32_t statMergedCommands;    // Number of duplicate commands merged by ReceiveCoalescedBatch
+
+    //Logging
+    TaskLog log;    // Lines printed by this task, drained by the UARTTask
+};
+
+/**
+ * @brief StaticTask is a Task with its stack, control block and event queue in the object itself, sized at
+ *        compile time, so nothing is taken from the RTOS heap. Task singletons live in .bss and sizeof(TTask)
+ *        is the exact RAM cost of the task.
+ * @param TStackWords Stack depth in words
+ * @param TLaneDepths Event queue depth, or the depth of each QUEUE_LANE for a multi-lane queue
+*/
+template <uint16_t TStackWords, uint16_t... TLaneDepths>
+class StaticTask : public Task
+{
+    static_assert(sizeof...(TLaneDepths) == 1 || sizeof...(TLaneDepths) == QUEUE_LANE_COUNT,
+        "StaticTask - give a single queue depth or one depth per QUEUE_LANE");
+    static_assert((TLaneDepths + ...) > 0, "StaticTask - event queue must not be empty");
+
+    static constexpr uint8_t LANE_COUNT = sizeof...(TLaneDepths);
+    static constexpr uint16_t QUEUE_DEPTH = (TLaneDepths + ...);
+    static constexpr uint16_t LANE_DEPTHS[LANE_COUNT] = { TLaneDepths... };
+
+protected:
+    StaticTask() : Task((uint16_t)0), queue(CreateQueue())
+    {
+        qEvtQueue = &queue;
+    }
+
+    /**
+     * @brief Creates the RTOS task in the static stack and control block
+     * @param taskFunction Static task entry point
+     * @param name Task name
+     * @param priority RTOS priority
+     * @return true on success, false otherwise
+    */
+    bool CreateTaskStatic(TaskFunction_t taskFunction, const char* name, UBaseType_t priority)
+    {
+        rtTaskHandle = xTaskCreateStatic(taskFunction, name, TStackWords, (void*)this, priority, stack, &tcb);
+        if (rtTaskHandle == nullptr)
+            return false;
+
+        BindTaskObject();
+        return true;
+    }
+
+private:
+    Queue CreateQueue()
+    {
+        if constexpr (LANE_COUNT == 1)
+            return Queue(QUEUE_DEPTH, queueStorage, &queueBuffers[0]);
+        else
+            return Queue(LANE_DEPTHS, queueStorage, queueBuffers, &laneCountBuffer);
+    }
+
+    StackType_t stack[TStackWords];                                // Task stack
+    StaticTask_t tcb;                                              // RTOS task control block
+    alignas(CompactCommand) uint8_t queueStorage[QUEUE_DEPTH * sizeof(CompactCommand)];    // Event queue storage
+    StaticQueue_t queueBuffers[LANE_COUNT == 1 ? 1 : QUEUE_LANE_COUNT];    // RTOS queue control block for each lane
+    StaticSemaphore_t laneCountBuffer;                             // RTOS semaphore control block, unused for a single lane queue
+    Queue queue;                                                   // Event queue, built in the storage above
+};
+
+/**
+ * @brief StaticTask without an event queue, for tasks driven only by event bits, a queue depth of 0 selects it.
+ *        GetEventQueue() returns nullptr and nothing may be sent to the task.
+ * @param TStackWords Stack depth in words
+*/
+template <uint16_t TStackWords>
+class StaticTask<TStackWords, 0> : public Task
+{
+protected:
+    StaticTask() : Task((uint16_t)0) {}
+
+    /**
+     * @brief Creates the RTOS task in the static stack and control block
+     * @param taskFunction Static task entry point
+     * @param name Task name
+     * @param priority RTOS priority
+     * @return true on success, false otherwise
+    */
+    bool CreateTaskStatic(TaskFunction_t taskFunction, const char* name, UBaseType_t priority)
+    {
+        rtTaskHandle = xTaskCreateStatic(taskFunction, name, TStackWords, (void*)this, priority, stack, &tcb);
+        if (rtTaskHandle == nullptr)
+            return false;
+
+        BindTaskObject();
+        return true;
+    }
+
+private:
+    StackType_t stack[TStackWords];                                // Task stack
+    StaticTask_t tcb;                                              // RTOS task control block
 };
 
 #endif /* AVIONICS_INCLUDE_SOAR_CORE_TASK_H */
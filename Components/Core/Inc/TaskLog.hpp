@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * File Name          : TaskLog.hpp
+ * Description        : TaskLog is a per-task text log ring, the owning task formats
+ *    into its own buffer without any lock and the UARTTask drains every ring.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_CORE_TASK_LOG_H
+#define AVIONICS_INCLUDE_SOAR_CORE_TASK_LOG_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include <cstdarg>
+
+#include "cmsis_os.h"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr uint16_t TASK_LOG_RING_BYTES = 512;          // Size of each task's log ring, must be a power of 2
+constexpr uint16_t TASK_LOG_FORMAT_BYTES = 192;        // Size of each task's format buffer, max length of one line
+constexpr uint8_t TASK_LOG_MAX_SOURCES = 12;           // Max number of TaskLogs the UARTTask can drain
+constexpr uint16_t TASK_LOG_FULL_WAIT_MS = 50;         // Max time a writer waits for the consumer to free space in a full ring before dropping a line
+
+static_assert((TASK_LOG_RING_BYTES & (TASK_LOG_RING_BYTES - 1)) == 0, "TASK_LOG_RING_BYTES must be a power of 2");
+
+/* Structs -----------------------------------------------------------------*/
+struct TaskLogEntryHeader
+{
+    uint32_t timestamp_ms;      // Time the line was written
+    uint16_t length;            // Number of text bytes after the header
+};
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief TaskLog is a single-producer single-consumer ring of formatted lines
+ *
+ * Usage:
+ *  - Every Task owns a TaskLog, print() writes into the log of the calling task
+ *  - The UARTTask drains all logs, merging them oldest line first
+ *
+ * Only the owning task may call Write(), only the UARTTask may call Peek() and Read(). A writer that
+ * finds its ring full wakes the consumer and yields to it for up to TASK_LOG_FULL_WAIT_MS, so a long command
+ * output larger than the ring is still delivered in full. The line is only dropped and counted if the consumer
+ * does not free enough space in that time, or if waiting is not possible (ISR, or the consumer itself writing).
+*/
+class TaskLog
+{
+public:
+    TaskLog();
+
+    // Producer
+    bool Write(const char* format, va_list args);    // Formats a line into the ring, false if it was dropped
+
+    // Consumer
+    bool Peek(uint32_t& timestamp_ms, uint16_t& length) const;    // Timestamp and length of the oldest line, false if the ring is empty
+    uint16_t Read(uint8_t* buffer, uint16_t size);      // Pops the oldest line into buffer, returns its length
+
+    uint32_t GetDroppedCount() const { return droppedCount; }
+
+    // Every TaskLog registers itself on construction
+    static uint8_t GetSourceCount();
+    static TaskLog* GetSource(uint8_t index);
+
+    static void SetConsumer(TaskHandle_t task, uint32_t events);    // Task to wake with events when a writer finds its ring full
+
+private:
+    TaskLog(const TaskLog&);                    // Prevent copy-construction
+    TaskLog& operator=(const TaskLog&);         // Prevent assignment
+
+    bool WaitForSpace(uint32_t entrySize);
+    void CopyIn(uint32_t position, const void* src, uint16_t len);
+    void CopyOut(uint32_t position, void* dst, uint16_t len) const;
+
+    char formatBuffer[TASK_LOG_FORMAT_BYTES];   // Dedicated format buffer, only used by the owning task
+    uint8_t ring[TASK_LOG_RING_BYTES];          // Entries of TaskLogEntryHeader followed by the text
+
+    std::atomic<uint32_t> writePosition;        // Free-running byte position, only advanced by the producer
+    std::atomic<uint32_t> readPosition;         // Free-running byte position, only advanced by the consumer
+    uint32_t droppedCount;                      // Number of lines dropped because the ring was full
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_CORE_TASK_LOG_H */
@@ -6,6 +6,7 @@
 */
 #include "Queue.hpp"
 #include "Command.hpp"
+#include "CompactCommand.hpp"
 #include "SystemDefines.hpp"
 #include "FreeRTOS.h"
 
@@ -16,8 +17,18 @@
 Queue::Queue(void)
 {
     //Initialize RTOS Queue handle
-    rtQueueHandle = xQueueCreate(DEFAULT_QUEUE_SIZE, sizeof(Command));
+    rtQueueHandle = xQueueCreate(DEFAULT_QUEUE_SIZE, sizeof(CompactCommand));
     queueDepth = 0;
+    rtNotifyTask = nullptr;
+    notifyEvents = 0;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        sendPolicy[i] = QUEUE_SEND_BLOCK;
+    stats = {};
+
+    //Every lane maps to the single queue
+    rtLaneCount = nullptr;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        rtLaneHandles[i] = rtQueueHandle;
 }
 
 /**
@@ -27,57 +38,380 @@ Queue::Queue(void)
 Queue::Queue(uint16_t depth)
 {
     //Initialize RTOS Queue handle with given depth
-    rtQueueHandle = xQueueCreate(depth, sizeof(Command));
+    rtQueueHandle = xQueueCreate(depth, sizeof(CompactCommand));
     queueDepth = depth;
+    rtNotifyTask = nullptr;
+    notifyEvents = 0;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        sendPolicy[i] = QUEUE_SEND_BLOCK;
+    stats = {};
+
+    //Every lane maps to the single queue
+    rtLaneCount = nullptr;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        rtLaneHandles[i] = rtQueueHandle;
+}
+
+/**
+ * @brief Constructor with depth for the Queue class, using caller provided static storage instead of the heap
+ * @param depth Queue depth
+ * @param storage Storage for at least depth CompactCommands
+ * @param queueBuffer RTOS queue control block
+*/
+Queue::Queue(uint16_t depth, uint8_t* storage, StaticQueue_t* queueBuffer)
+{
+    //Initialize RTOS Queue handle with given depth
+    rtQueueHandle = xQueueCreateStatic(depth, sizeof(CompactCommand), storage, queueBuffer);
+    queueDepth = depth;
+    rtNotifyTask = nullptr;
+    notifyEvents = 0;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        sendPolicy[i] = QUEUE_SEND_BLOCK;
+    stats = {};
+
+    //Every lane maps to the single queue
+    rtLaneCount = nullptr;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        rtLaneHandles[i] = rtQueueHandle;
+}
+
+/**
+ * @brief Constructor for a multi-lane Queue, each lane is a separate RTOS queue and receives are strict priority
+ * @param laneDepths Depth of each QUEUE_LANE, at least one lane must have a non-zero depth
+*/
+Queue::Queue(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT])
+{
+    InitLanes(laneDepths, nullptr, nullptr, nullptr);
+}
+
+/**
+ * @brief Constructor for a multi-lane Queue using caller provided static storage instead of the heap
+ * @param laneDepths Depth of each QUEUE_LANE, at least one lane must have a non-zero depth
+ * @param storage Storage for the sum of laneDepths CompactCommands, split between the lanes in order
+ * @param laneBuffers RTOS queue control block for each lane
+ * @param laneCountBuffer RTOS semaphore control block for the lane count
+*/
+Queue::Queue(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT], uint8_t* storage, StaticQueue_t (&laneBuffers)[QUEUE_LANE_COUNT], StaticSemaphore_t* laneCountBuffer)
+{
+    InitLanes(laneDepths, storage, laneBuffers, laneCountBuffer);
 }
 
 /**
- * @brief Sends a command object to the queue, safe to call from ISR
+ * @brief Creates the lanes of a multi-lane Queue
+ * @param laneDepths Depth of each QUEUE_LANE
+ * @param storage Static storage for every lane, nullptr to allocate the lanes from the heap
+ * @param laneBuffers RTOS queue control block for each lane, unused if storage is nullptr
+ * @param laneCountBuffer RTOS semaphore control block, unused if storage is nullptr
+*/
+void Queue::InitLanes(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT], uint8_t* storage, StaticQueue_t* laneBuffers, StaticSemaphore_t* laneCountBuffer)
+{
+    queueDepth = 0;
+    rtQueueHandle = nullptr;
+    rtNotifyTask = nullptr;
+    notifyEvents = 0;
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        sendPolicy[i] = QUEUE_SEND_BLOCK;
+    stats = {};
+
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++) {
+        if (laneDepths[i] == 0)
+            rtLaneHandles[i] = nullptr;
+        else if (storage == nullptr)
+            rtLaneHandles[i] = xQueueCreate(laneDepths[i], sizeof(CompactCommand));
+        else
+            rtLaneHandles[i] = xQueueCreateStatic(laneDepths[i], sizeof(CompactCommand), &storage[queueDepth * sizeof(CompactCommand)], &laneBuffers[i]);
+        queueDepth += laneDepths[i];
+
+        if (rtQueueHandle == nullptr)
+            rtQueueHandle = rtLaneHandles[i];
+    }
+
+    SOAR_ASSERT(rtQueueHandle != nullptr, "Queue - multi-lane queue has no lanes");
+
+    //Unused lanes map to the nearest higher priority lane, or the highest priority lane in use
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++) {
+        if (rtLaneHandles[i] == nullptr)
+            rtLaneHandles[i] = (i == 0) ? rtQueueHandle : rtLaneHandles[i - 1];
+    }
+
+    //Counts commands across all lanes so a receive can block on every lane at once
+    if (storage == nullptr)
+        rtLaneCount = xSemaphoreCreateCounting(queueDepth, 0);
+    else
+        rtLaneCount = xSemaphoreCreateCountingStatic(queueDepth, 0, laneCountBuffer);
+}
+
+/**
+ * @brief Gets the RTOS queue for a lane
+ * @param lane QUEUE_LANE, out of range lanes use the lowest priority lane
+ * @return Queue handle for the lane
+*/
+QueueHandle_t Queue::GetLaneHandle(uint8_t lane) const
+{
+    if (lane >= QUEUE_LANE_COUNT)
+        lane = QUEUE_LANE_COUNT - 1;
+    return rtLaneHandles[lane];
+}
+
+/**
+ * @brief Sends a command object to the queue, safe to call from ISR, never blocks
  * @param command Command object reference to send
+ * @param lane QUEUE_LANE to send to
  * @return true on success, false on failure (queue full)
 */
-bool Queue::SendFromISR(Command& command)
+bool Queue::SendFromISR(Command& command, uint8_t lane)
 {
-    //Note: There NULL param here could be used to wake a task right after after exiting the ISR
-    if (xQueueSendFromISR(rtQueueHandle, &command, NULL) == pdPASS)
-        return true;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    QueueHandle_t handle = GetLaneHandle(lane);
+    const QUEUE_SEND_POLICY policy = GetSendPolicy(lane);
+    CompactCommand packed;
+    bool sent = false;
 
-    command.Reset();
+    // Without a free slot for the payload the command is dropped, as on a full queue
+    if (packed.Pack(command)) {
+        if (policy == QUEUE_SEND_OVERWRITE_LATEST) {
+            sent = Overwrite(handle, packed, &xHigherPriorityTaskWoken);
+        }
+        else {
+            sent = (xQueueSendFromISR(handle, &packed, &xHigherPriorityTaskWoken) == pdPASS);
 
-    return false;
+            // Make space by dropping the oldest command, then try once more
+            if (!sent && policy == QUEUE_SEND_DROP_OLDEST && DropOldest(handle, &xHigherPriorityTaskWoken))
+                sent = (xQueueSendFromISR(handle, &packed, &xHigherPriorityTaskWoken) == pdPASS);
+        }
+
+        // Free the slot, the command itself still owns the payload
+        if (!sent)
+            packed.Unpack(command);
+    }
+
+    if (sent) {
+        if (rtLaneCount != nullptr)
+            xSemaphoreGiveFromISR(rtLaneCount, &xHigherPriorityTaskWoken);
+        NotifyTargetFromISR(&xHigherPriorityTaskWoken);
+    }
+    else {
+        command.Reset();
+    }
+
+    RecordSend(sent, 0);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+
+    return sent;
 }
 
 /**
  * @brief Sends a command object to the front of the queue, use for high priority commands
  * @param command Command object reference to send
+ * @param lane QUEUE_LANE to send to the front of
  * @return true on success, false on failure (queue full)
  */
-bool Queue::SendToFront(Command& command)
+bool Queue::SendToFront(Command& command, uint8_t lane)
 {
-    //Send to the back of the queue
-    if (xQueueSendToFront(rtQueueHandle, &command, DEFAULT_QUEUE_SEND_WAIT_TICKS) == pdPASS)
-        return true;
-
-    SOAR_PRINT("Could not send data to front of queue!");
-    command.Reset();
-
-    return false;
+    return SendToLane(command, lane, queueSEND_TO_FRONT);
 }
 
 /**
  * @brief Sends a command object to the queue (sends to back of queue in FIFO order)
  * @param command Command object reference to send
+ * @param lane QUEUE_LANE to send to
  * @return true on success, false on failure (queue full)
 */
-bool Queue::Send(Command& command)
+bool Queue::Send(Command& command, uint8_t lane)
+{
+    return SendToLane(command, lane, queueSEND_TO_BACK);
+}
+
+/**
+ * @brief Sends a command to a lane following the send policy, a command that is not sent is reset
+ * @param command Command object reference to send
+ * @param lane QUEUE_LANE to send to
+ * @param position queueSEND_TO_BACK or queueSEND_TO_FRONT
+ * @return true on success, false on failure (queue full)
+*/
+bool Queue::SendToLane(Command& command, uint8_t lane, BaseType_t position)
+{
+    QueueHandle_t handle = GetLaneHandle(lane);
+    const QUEUE_SEND_POLICY policy = GetSendPolicy(lane);
+    const TickType_t ticksToWait = (policy == QUEUE_SEND_BLOCK) ? DEFAULT_QUEUE_SEND_WAIT_TICKS : 0;
+    const TickType_t startTick = xTaskGetTickCount();
+    CompactCommand packed;
+    bool sent = false;
+
+    // Without a free slot for the payload the command is dropped, as on a full queue
+    if (packed.Pack(command)) {
+        if (policy == QUEUE_SEND_OVERWRITE_LATEST) {
+            sent = Overwrite(handle, packed, nullptr);
+        }
+        else {
+            sent = (xQueueGenericSend(handle, &packed, ticksToWait, position) == pdPASS);
+
+            // Make space by dropping the oldest command, then try once more
+            if (!sent && policy == QUEUE_SEND_DROP_OLDEST && DropOldest(handle, nullptr))
+                sent = (xQueueGenericSend(handle, &packed, 0, position) == pdPASS);
+        }
+
+        // Free the slot, the command itself still owns the payload
+        if (!sent)
+            packed.Unpack(command);
+    }
+
+    if (sent) {
+        if (rtLaneCount != nullptr)
+            xSemaphoreGive(rtLaneCount);
+        NotifyTarget();
+    }
+    else {
+        //TODO: It may be possible to have this automatically set the command to not free data externally as we've "passed" control of the data over, which might let us use a destructor to free the data
+
+        // Counted in the statistics rather than printed, a print could be sent to a full queue itself
+        command.Reset();
+    }
+
+    RecordSend(sent, xTaskGetTickCount() - startTick);
+
+    return sent;
+}
+
+/**
+ * @brief Removes and resets the oldest command in a lane to make space for a new one
+ * @param handle Lane to drop from
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a context switch should be requested on ISR exit, nullptr when called from a task
+ * @return true if a command was dropped
+*/
+bool Queue::DropOldest(QueueHandle_t handle, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    CompactCommand oldest;
+    const bool fromISR = (pxHigherPriorityTaskWoken != nullptr);
+
+    if ((fromISR ? xQueueReceiveFromISR(handle, &oldest, pxHigherPriorityTaskWoken) : xQueueReceive(handle, &oldest, 0)) != pdTRUE)
+        return false;
+
+    // Keep the lane count in step, if a receiver already took the count it waits again after finding the lane empty
+    if (rtLaneCount != nullptr) {
+        if (fromISR)
+            xSemaphoreTakeFromISR(rtLaneCount, pxHigherPriorityTaskWoken);
+        else
+            xSemaphoreTake(rtLaneCount, 0);
+    }
+
+    Command dropped;
+    if (oldest.Unpack(dropped))
+        dropped.Reset();
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    stats.dropCount++;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    return true;
+}
+
+/**
+ * @brief Writes a command to a depth 1 lane with xQueueOverwrite, the command it replaces is reset
+ * @param handle Lane to write to
+ * @param packed Command to write
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a context switch should be requested on ISR exit, nullptr when called from a task
+ * @return true, an overwrite never fails
+*/
+bool Queue::Overwrite(QueueHandle_t handle, CompactCommand& packed, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    CompactCommand replaced;
+    bool hasReplaced;
+
+    // Peek and overwrite together, so a receive in between cannot take the command being reset
+    if (pxHigherPriorityTaskWoken != nullptr) {
+        UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+        hasReplaced = (xQueuePeekFromISR(handle, &replaced) == pdTRUE);
+        xQueueOverwriteFromISR(handle, &packed, pxHigherPriorityTaskWoken);
+        taskEXIT_CRITICAL_FROM_ISR(savedMask);
+    }
+    else {
+        // xQueueOverwrite may unblock and yield to a receiver, which is not allowed in a critical section. With the
+        // scheduler suspended the yield waits for xTaskResumeAll, and only tasks receive from a Queue.
+        vTaskSuspendAll();
+        hasReplaced = (xQueuePeek(handle, &replaced, 0) == pdTRUE);
+        xQueueOverwrite(handle, &packed);
+        xTaskResumeAll();
+    }
+
+    if (hasReplaced) {
+        Command dropped;
+        if (replaced.Unpack(dropped))
+            dropped.Reset();
+
+        UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+        stats.dropCount++;
+        taskEXIT_CRITICAL_FROM_ISR(savedMask);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Updates the send statistics, safe to call from ISR
+ * @param sent true if the command was sent, false if it was dropped
+ * @param blockedTicks Ticks the sender spent waiting for space
+*/
+void Queue::RecordSend(bool sent, TickType_t blockedTicks)
+{
+    const uint16_t waiting = (rtLaneCount == nullptr) ? uxQueueMessagesWaitingFromISR(rtQueueHandle)
+        : uxQueueMessagesWaitingFromISR((QueueHandle_t)rtLaneCount);
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    if (sent)
+        stats.sendCount++;
+    else
+        stats.dropCount++;
+    stats.blockedTicks += blockedTicks;
+    if (waiting > stats.highWater)
+        stats.highWater = waiting;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
+
+/**
+ * @brief Decodes a received compact command, a stale handle means a command was received twice
+ * @param packed Compact command received from an RTOS queue
+ * @param cm Command object to decode into
+ * @return TRUE on success, FALSE otherwise
+*/
+static bool UnpackReceived(CompactCommand& packed, Command& cm)
+{
+    const bool ret = packed.Unpack(cm);
+    SOAR_ASSERT(ret, "Queue - received a stale command handle");
+    return ret;
+}
+
+/**
+ * @brief Receives from the highest priority non-empty lane
+ * @param cm Command object to copy received data into
+ * @param ticksToWait Ticks to block for
+ * @return TRUE if we received a command, FALSE otherwise
+*/
+bool Queue::ReceiveFromLanes(Command& cm, TickType_t ticksToWait)
 {
-    if (xQueueSend(rtQueueHandle, &command, DEFAULT_QUEUE_SEND_WAIT_TICKS) == pdPASS)
-        return true;
+    CompactCommand packed;
+
+    if (rtLaneCount == nullptr)
+        return xQueueReceive(rtQueueHandle, &packed, ticksToWait) == pdTRUE && UnpackReceived(packed, cm);
+
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+
+    do {
+        if (xSemaphoreTake(rtLaneCount, ticksToWait) != pdTRUE)
+            return false;
 
-    //TODO: It may be possible to have this automatically set the command to not free data externally as we've "passed" control of the data over, which might let us use a destructor to free the data
+        for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++) {
+            // Merged lanes share a handle, only check each queue once
+            if (i > 0 && rtLaneHandles[i] == rtLaneHandles[i - 1])
+                continue;
 
-    SOAR_PRINT("Could not send data to queue!");
-    command.Reset();
+            if (xQueueReceive(rtLaneHandles[i], &packed, 0) == pdTRUE)
+                return UnpackReceived(packed, cm);
+        }
+
+        // The count was given before the command it belongs to was taken by an earlier receive, wait again
+    } while (xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdFALSE);
 
     return false;
 }
@@ -90,10 +424,7 @@ bool Queue::Send(Command& command)
 */
 bool Queue::Receive(Command& cm, uint32_t timeout_ms)
 {
-    if(xQueueReceive(rtQueueHandle, &cm, MS_TO_TICKS(timeout_ms)) == pdTRUE) {
-        return true;
-    }
-    return false;
+    return ReceiveFromLanes(cm, MS_TO_TICKS(timeout_ms));
 }
 
 /**
@@ -103,8 +434,125 @@ bool Queue::Receive(Command& cm, uint32_t timeout_ms)
 */
 bool Queue::ReceiveWait(Command& cm)
 {
-    if (xQueueReceive(rtQueueHandle, &cm, HAL_MAX_DELAY) == pdTRUE) {
-        return true;
-    }
-    return false;
+    return ReceiveFromLanes(cm, HAL_MAX_DELAY);
+}
+
+/**
+ * @brief Receives up to maxCount commands, blocks for timeout_ms waiting for the first command then
+ *        drains whatever else is already waiting without blocking
+ * @param cms Array of at least maxCount Command objects to copy received data into
+ * @param maxCount Max number of commands to receive
+ * @param timeout_ms Time to block for the first command, portMAX_DELAY blocks forever
+ * @return Number of commands received, in priority order
+*/
+uint16_t Queue::ReceiveBatch(Command* cms, uint16_t maxCount, uint32_t timeout_ms)
+{
+    if (maxCount == 0)
+        return 0;
+
+    const TickType_t firstWait = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : MS_TO_TICKS(timeout_ms);
+    if (!ReceiveFromLanes(cms[0], firstWait))
+        return 0;
+
+    uint16_t count = 1;
+    while (count < maxCount && ReceiveFromLanes(cms[count], 0))
+        count++;
+
+    return count;
+}
+
+/**
+ * @brief Receives the oldest command of one lane without blocking, the other lanes are left as they are
+ * @param cm Command object to copy received data into
+ * @param lane QUEUE_LANE to receive from, merged lanes receive from the lane they are merged into
+ * @return TRUE if we received a command, FALSE if the lane is empty
+*/
+bool Queue::ReceiveFromLane(Command& cm, uint8_t lane)
+{
+    CompactCommand packed;
+    if (xQueueReceive(GetLaneHandle(lane), &packed, 0) != pdTRUE)
+        return false;
+
+    // Keep the lane count in step, as DropOldest does
+    if (rtLaneCount != nullptr)
+        xSemaphoreTake(rtLaneCount, 0);
+
+    return UnpackReceived(packed, cm);
+}
+
+/**
+ * @brief Gets the number of commands waiting across all lanes
+ * @return Number of commands waiting
+*/
+uint16_t Queue::GetQueueMessageCount() const
+{
+    if (rtLaneCount == nullptr)
+        return uxQueueMessagesWaiting(rtQueueHandle);
+
+    return uxSemaphoreGetCount(rtLaneCount);
+}
+
+/**
+ * @brief Sets event bits on a task whenever a command is sent, lets the task wait on this queue and its
+ *        task notifications together with Task::WaitEvents
+ * @param task Task to notify, nullptr disables notification
+ * @param events Event bits to set on the task
+*/
+void Queue::SetNotifyTarget(TaskHandle_t task, uint32_t events)
+{
+    notifyEvents = events;
+    rtNotifyTask = task;
+}
+
+/**
+ * @brief Sets what a send does when the target lane is full, for every lane
+ * @param policy QUEUE_SEND_POLICY to use, QUEUE_SEND_OVERWRITE_LATEST requires a single lane queue of depth 1
+*/
+void Queue::SetSendPolicy(QUEUE_SEND_POLICY policy)
+{
+    for (uint8_t i = 0; i < QUEUE_LANE_COUNT; i++)
+        SetSendPolicy(policy, i);
+}
+
+/**
+ * @brief Sets what a send does when one lane is full, lanes merged into it keep their own policy
+ * @param policy QUEUE_SEND_POLICY to use, QUEUE_SEND_OVERWRITE_LATEST requires a single lane queue of depth 1
+ * @param lane QUEUE_LANE to set the policy of
+*/
+void Queue::SetSendPolicy(QUEUE_SEND_POLICY policy, uint8_t lane)
+{
+    SOAR_ASSERT(policy != QUEUE_SEND_OVERWRITE_LATEST || (rtLaneCount == nullptr && queueDepth == 1),
+        "Queue::SetSendPolicy() - overwrite latest needs a single lane queue of depth 1");
+    SOAR_ASSERT(lane < QUEUE_LANE_COUNT, "Queue::SetSendPolicy() - invalid lane");
+    sendPolicy[lane] = policy;
+}
+
+/**
+ * @brief Copies the send statistics
+ * @param statsOut Struct to copy the statistics into
+*/
+void Queue::GetStats(QueueStats& statsOut) const
+{
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    statsOut = stats;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+}
+
+/**
+ * @brief Sets the notify events on the target task, if any
+*/
+void Queue::NotifyTarget()
+{
+    if (rtNotifyTask != nullptr)
+        xTaskNotify(rtNotifyTask, notifyEvents, eSetBits);
+}
+
+/**
+ * @brief Sets the notify events on the target task from an ISR, if any
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a context switch should be requested on ISR exit
+*/
+void Queue::NotifyTargetFromISR(BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (rtNotifyTask != nullptr)
+        xTaskNotifyFromISR(rtNotifyTask, notifyEvents, eSetBits, pxHigherPriorityTaskWoken);
 }
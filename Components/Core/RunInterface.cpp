@@ -23,4 +23,14 @@ extern "C" {
     {
         Driver::uart5.HandleIRQ_UART();
     }
+
+    void cpp_DMA1_Stream7_IRQHandler()
+    {
+        Driver::uart5.HandleIRQ_TxDMA();
+    }
+
+    void cpp_DMA2_Stream2_IRQHandler()
+    {
+        Driver::uart1.HandleIRQ_RxDMA();
+    }
 }
\ No newline at end of file
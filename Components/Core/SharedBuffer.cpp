@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ * File Name          : SharedBuffer.cpp
+ * Description        : Implementation of the SharedBufferPool
+ ******************************************************************************
+*/
+#include "SharedBuffer.hpp"
+#include "SystemDefines.hpp"
+
+#include <atomic>
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    std::atomic<uint16_t> outstandingBuffers;    // Number of buffers currently allocated from the pool
+
+    SharedBuffer* registry[SHARED_BUFFER_COUNT];   // Allocated buffers by handle index, nullptr if free
+    uint8_t generation[SHARED_BUFFER_COUNT];       // Incremented every time the buffer at an index returns to the pool
+}
+
+static_assert(SHARED_BUFFER_COUNT <= 256, "Shared buffer index must fit in the low byte of a handle");
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Allocates a shared buffer from the pool
+ * @return Buffer with a reference count of 1 owned by the caller, nullptr if the pool is exhausted
+*/
+SharedBuffer* SharedBufferPool::Allocate()
+{
+    // Reserve a slot first, etl asserts on an allocation failure in debug builds
+    if (outstandingBuffers.fetch_add(1) >= SHARED_BUFFER_COUNT) {
+        outstandingBuffers -= 1;
+        return nullptr;
+    }
+
+    SharedBuffer* buf = Inst().allocate<SharedBufferMessage>();
+    if (buf == nullptr) {
+        outstandingBuffers -= 1;
+        return nullptr;
+    }
+
+    // Register the buffer so it can travel as a handle, there is always a free index for an allocated buffer
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    uint8_t index = 0;
+    while (registry[index] != nullptr)
+        index++;
+    registry[index] = buf;
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    buf->get_message().size = 0;
+    buf->get_message().index = index;
+    buf->get_reference_counter().set_reference_count(1);
+    return buf;
+}
+
+/**
+ * @brief Adds a reference to the shared buffer
+ * @param buf Buffer to add a reference to
+*/
+void SharedBufferPool::AddReference(SharedBuffer* buf)
+{
+    buf->get_reference_counter().increment_reference_count();
+}
+
+/**
+ * @brief Drops a reference to the shared buffer, returning it to the pool if it was the last one
+ * @param buf Buffer to release
+*/
+void SharedBufferPool::Release(SharedBuffer* buf)
+{
+    if (buf == nullptr)
+        return;
+
+    if (buf->get_reference_counter().decrement_reference_count() == 0) {
+        const uint8_t index = buf->get_message().index;
+
+        UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+        generation[index]++;
+        registry[index] = nullptr;
+        taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+        buf->release();
+        outstandingBuffers -= 1;
+    }
+}
+
+/**
+ * @brief Encodes a shared buffer as a 16 bit handle, the caller must hold a reference
+ * @param buf Buffer to encode
+ * @return Handle with the registry index in the low byte and the generation in the high byte
+*/
+uint16_t SharedBufferPool::GetHandle(SharedBuffer* buf)
+{
+    const uint8_t index = buf->get_message().index;
+    return (generation[index] << 8) | index;
+}
+
+/**
+ * @brief Decodes a handle from GetHandle back into the buffer, no reference is added
+ * @param handle Handle of the buffer
+ * @return Buffer, nullptr if the buffer returned to the pool since the handle was made
+*/
+SharedBuffer* SharedBufferPool::FromHandle(uint16_t handle)
+{
+    const uint8_t index = (uint8_t)handle;
+    if (index >= SHARED_BUFFER_COUNT)
+        return nullptr;
+
+    // A valid handle holds a reference, so the entry cannot change while it is read
+    if (generation[index] != (uint8_t)(handle >> 8))
+        return nullptr;
+
+    return registry[index];
+}
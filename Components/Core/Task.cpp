@@ -6,6 +6,8 @@
 */
 #include "Task.hpp"
 
+#include <cstring>     // Support for memcpy
+
 /**
  * @brief Default constructor, instantiates event queue with default size
 */
@@ -13,6 +15,7 @@ Task::Task(void)
 {
     qEvtQueue = new Queue();
     rtTaskHandle = nullptr;
+    statMergedCommands = 0;
 }
 
 /**
@@ -26,4 +29,163 @@ Task::Task(uint16_t depth)
     else
         qEvtQueue = new Queue(depth);
     rtTaskHandle = nullptr;
+    statMergedCommands = 0;
+}
+
+/**
+ * @brief Constructor with a multi-lane event queue, commands are received in strict QUEUE_LANE priority order
+ * @param laneDepths Depth of each QUEUE_LANE
+*/
+Task::Task(const uint16_t (&laneDepths)[QUEUE_LANE_COUNT])
+{
+    qEvtQueue = new Queue(laneDepths);
+    rtTaskHandle = nullptr;
+    statMergedCommands = 0;
+}
+
+/**
+ * @brief Receives a batch of commands from the event queue and collapses duplicate pending requests into the
+ *        first occurrence. Only commands the task marks coalescable (and which carry no data) are merged, any other
+ *        command acts as a barrier so requests are never merged across it. Merged commands are reset.
+ * @param cms Array of at least maxCount Command objects to receive into
+ * @param maxCount Max number of commands to receive
+ * @param isCoalescable Task policy, returns true if the command may be merged with an identical earlier command
+ * @param timeout_ms Time to block for the first command, portMAX_DELAY blocks forever
+ * @return Number of commands left in cms to handle, in their original order
+*/
+uint16_t Task::ReceiveCoalescedBatch(Command* cms, uint16_t maxCount, bool (*isCoalescable)(const Command& cm), uint32_t timeout_ms)
+{
+    const uint16_t count = qEvtQueue->ReceiveBatch(cms, maxCount, timeout_ms);
+
+    uint16_t kept = 0;
+    uint16_t windowStart = 0;    // Index in the kept commands after the last barrier
+    for (uint16_t i = 0; i < count; i++) {
+        bool merged = false;
+
+        if (cms[i].GetDataSize() == 0 && isCoalescable(cms[i])) {
+            // Look for an identical request pending since the last barrier
+            for (uint16_t j = windowStart; j < kept; j++) {
+                if (cms[j].GetCommand() == cms[i].GetCommand() && cms[j].GetTaskCommand() == cms[i].GetTaskCommand()) {
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        else {
+            windowStart = kept + 1;
+        }
+
+        if (merged) {
+            cms[i].Reset();
+            statMergedCommands++;
+        }
+        else if (kept != i) {
+            // Commands are plain-old-data, a raw copy moves ownership of any data
+            memcpy(static_cast<void*>(&cms[kept++]), &cms[i], sizeof(Command));
+        }
+        else {
+            kept++;
+        }
+    }
+
+    return kept;
+}
+
+/**
+ * @brief Sets event bits on this task, waking it if it is waiting on any of them in WaitEvents
+ * @param events Event bits to set, TASK_EVENT_QUEUE is reserved
+ * @return true on success, false if the task has not been created
+*/
+bool Task::Notify(uint32_t events)
+{
+    if (rtTaskHandle == nullptr)
+        return false;
+
+    xTaskNotify(rtTaskHandle, events, eSetBits);
+    return true;
+}
+
+/**
+ * @brief Sets event bits on this task from an ISR
+ * @param events Event bits to set, TASK_EVENT_QUEUE is reserved
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if a context switch should be requested on ISR exit
+ * @return true on success, false if the task has not been created
+*/
+bool Task::NotifyFromISR(uint32_t events, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (rtTaskHandle == nullptr)
+        return false;
+
+    xTaskNotifyFromISR(rtTaskHandle, events, eSetBits, pxHigherPriorityTaskWoken);
+    return true;
+}
+
+/**
+ * @brief Waits until any of the event bits in mask are set, must be called from this task.
+ *        Received bits in mask are cleared, bits outside of mask are left pending and raised again on
+ *        return, so a later WaitEvents with a different mask still wakes on them.
+ * @param mask Event bits to wait for, include TASK_EVENT_QUEUE to also wake on queued commands
+ * @param timeout_ms Time to block for, portMAX_DELAY blocks forever
+ * @return The event bits in mask that were set, 0 on timeout
+*/
+uint32_t Task::WaitEvents(uint32_t mask, uint32_t timeout_ms)
+{
+    TickType_t ticksToWait = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : MS_TO_TICKS(timeout_ms);
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+    uint32_t received = 0;
+    uint32_t otherEvents = 0;
+
+    do {
+        uint32_t events = 0;
+        if (xTaskNotifyWait(0, mask, &events, ticksToWait) == pdTRUE) {
+            // Waking consumed the notified state, bits outside mask are raised again once we return
+            otherEvents |= events & ~mask;
+            received = events & mask;
+            if (received != 0)
+                break;
+        }
+    } while (xTaskCheckForTimeOut(&timeOut, &ticksToWait) == pdFALSE);
+
+    if (otherEvents != 0)
+        xTaskNotify(rtTaskHandle, otherEvents, eSetBits);
+
+    return received;
+}
+
+/**
+ * @brief Makes the event queue set TASK_EVENT_QUEUE on this task for every command sent to it, so the
+ *        run loop can wait on commands and events together. Must be called from this task.
+*/
+void Task::EnableQueueEvents()
+{
+    if (qEvtQueue == nullptr)
+        return;
+
+    qEvtQueue->SetNotifyTarget(xTaskGetCurrentTaskHandle(), TASK_EVENT_QUEUE);
+
+    // Commands sent before this point did not notify
+    if (qEvtQueue->GetQueueMessageCount() > 0)
+        xTaskNotify(xTaskGetCurrentTaskHandle(), TASK_EVENT_QUEUE, eSetBits);
+}
+
+/**
+ * @brief Stores this object in the RTOS task's thread local storage so print() can find the calling task's log
+*/
+void Task::BindTaskObject()
+{
+    if (rtTaskHandle != nullptr)
+        vTaskSetThreadLocalStoragePointer(rtTaskHandle, TASK_TLS_INDEX_OBJECT, this);
+}
+
+/**
+ * @brief Gets the Task object of the calling RTOS task
+ * @return The Task, nullptr if called from an ISR, before the scheduler starts, or from a task that was not bound
+*/
+Task* Task::GetCurrent()
+{
+    if (xPortIsInsideInterrupt() || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+        return nullptr;
+
+    return static_cast<Task*>(pvTaskGetThreadLocalStoragePointer(nullptr, TASK_TLS_INDEX_OBJECT));
 }
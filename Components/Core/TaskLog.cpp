@@ -0,0 +1,190 @@
+/**
+ ******************************************************************************
+ * File Name          : TaskLog.cpp
+ * Description        : Implementation of the per-task TaskLog ring.
+ *
+ * Utils::FormatStringV is reentrant and never allocates, so each task can format
+ * into its own buffer at the same time as the others, without the global
+ * vaListMutex. The mutex is only kept for the assert path, which still uses
+ * newlib vsnprintf.
+ ******************************************************************************
+*/
+#include "TaskLog.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>     // Support for memcpy
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    TaskLog* sources[TASK_LOG_MAX_SOURCES];
+    std::atomic<uint8_t> sourceCount;
+
+    TaskHandle_t consumerTask = nullptr;    // Task draining the logs, woken when a writer finds its ring full
+    uint32_t consumerEvents = 0;            // Event bits to set on consumerTask
+}
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Constructor, registers the log so the UARTTask drains it
+*/
+TaskLog::TaskLog() : writePosition(0), readPosition(0), droppedCount(0)
+{
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+    const uint8_t index = sourceCount.load(std::memory_order_relaxed);
+    if (index < TASK_LOG_MAX_SOURCES) {
+        sources[index] = this;
+        sourceCount.store(index + 1, std::memory_order_release);
+    }
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    SOAR_ASSERT(index < TASK_LOG_MAX_SOURCES, "TaskLog - too many logs, increase TASK_LOG_MAX_SOURCES");
+}
+
+/**
+ * @brief Formats a line into the dedicated buffer and copies it into the ring, must only be called by the owning task
+ * @param format printf style format string
+ * @param args Arguments for the format
+ * @return true on success, false if the ring did not have space and the line was dropped
+*/
+bool TaskLog::Write(const char* format, va_list args)
+{
+    const uint16_t len = Utils::FormatStringV(formatBuffer, sizeof(formatBuffer), format, args);
+    if (len == 0)
+        return true;
+
+    const TaskLogEntryHeader header = { TICKS_TO_MS(xTaskGetTickCount()), len };
+    const uint32_t entrySize = sizeof(header) + header.length;
+
+    const uint32_t writePos = writePosition.load(std::memory_order_relaxed);
+    if (!WaitForSpace(entrySize)) {
+        droppedCount++;
+        return false;
+    }
+
+    CopyIn(writePos, &header, sizeof(header));
+    CopyIn(writePos + sizeof(header), formatBuffer, header.length);
+
+    // Publish the line to the consumer
+    writePosition.store(writePos + entrySize, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Waits for the consumer to free space for an entry, yielding to it while the ring is full
+ * @param entrySize Size of the entry in bytes, header included
+ * @return true if there is space, false if the ring is still full after TASK_LOG_FULL_WAIT_MS or waiting is not possible
+*/
+bool TaskLog::WaitForSpace(uint32_t entrySize)
+{
+    const TickType_t startTick = xTaskGetTickCount();
+
+    while (entrySize > TASK_LOG_RING_BYTES - (writePosition.load(std::memory_order_relaxed) - readPosition.load(std::memory_order_acquire))) {
+        // The consumer cannot drain while it is the writer, and an ISR must never block
+        if (consumerTask == nullptr || consumerTask == xTaskGetCurrentTaskHandle() || xPortIsInsideInterrupt()
+            || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING || xTaskGetTickCount() - startTick >= MS_TO_TICKS(TASK_LOG_FULL_WAIT_MS))
+            return false;
+
+        // Every task shares a priority, so the consumer only drains once the writer gives up the CPU
+        xTaskNotify(consumerTask, consumerEvents, eSetBits);
+        vTaskDelay(1);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Gets the timestamp and length of the oldest line without popping it, consumer only
+ * @param timestamp_ms Set to the timestamp of the oldest line
+ * @param length Set to the text length of the oldest line
+ * @return true on success, false if the ring is empty
+*/
+bool TaskLog::Peek(uint32_t& timestamp_ms, uint16_t& length) const
+{
+    const uint32_t readPos = readPosition.load(std::memory_order_relaxed);
+    if (writePosition.load(std::memory_order_acquire) == readPos)
+        return false;
+
+    TaskLogEntryHeader header;
+    CopyOut(readPos, &header, sizeof(header));
+    timestamp_ms = header.timestamp_ms;
+    length = header.length;
+    return true;
+}
+
+/**
+ * @brief Pops the oldest line, consumer only
+ * @param buffer Buffer to copy the text into, lines longer than size are truncated
+ * @param size Size of the buffer in bytes
+ * @return Number of bytes copied, 0 if the ring is empty
+*/
+uint16_t TaskLog::Read(uint8_t* buffer, uint16_t size)
+{
+    const uint32_t readPos = readPosition.load(std::memory_order_relaxed);
+    if (writePosition.load(std::memory_order_acquire) == readPos)
+        return 0;
+
+    TaskLogEntryHeader header;
+    CopyOut(readPos, &header, sizeof(header));
+
+    const uint16_t len = (header.length < size) ? header.length : size;
+    CopyOut(readPos + sizeof(header), buffer, len);
+
+    // Free the space for the producer
+    readPosition.store(readPos + sizeof(header) + header.length, std::memory_order_release);
+    return len;
+}
+
+/**
+ * @brief Copies bytes into the ring at the given free-running position, wrapping at the end
+*/
+void TaskLog::CopyIn(uint32_t position, const void* src, uint16_t len)
+{
+    const uint16_t offset = position & (TASK_LOG_RING_BYTES - 1);
+    const uint16_t first = (len < TASK_LOG_RING_BYTES - offset) ? len : TASK_LOG_RING_BYTES - offset;
+
+    memcpy(&ring[offset], src, first);
+    memcpy(ring, static_cast<const uint8_t*>(src) + first, len - first);
+}
+
+/**
+ * @brief Copies bytes out of the ring from the given free-running position, wrapping at the end
+*/
+void TaskLog::CopyOut(uint32_t position, void* dst, uint16_t len) const
+{
+    const uint16_t offset = position & (TASK_LOG_RING_BYTES - 1);
+    const uint16_t first = (len < TASK_LOG_RING_BYTES - offset) ? len : TASK_LOG_RING_BYTES - offset;
+
+    memcpy(dst, &ring[offset], first);
+    memcpy(static_cast<uint8_t*>(dst) + first, ring, len - first);
+}
+
+/**
+ * @brief Gets the number of registered logs
+ * @return Number of logs
+*/
+uint8_t TaskLog::GetSourceCount()
+{
+    return sourceCount.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Gets a registered log
+ * @param index Index of the log, less than GetSourceCount()
+ * @return The log, nullptr if the index is invalid
+*/
+TaskLog* TaskLog::GetSource(uint8_t index)
+{
+    return (index < GetSourceCount()) ? sources[index] : nullptr;
+}
+
+/**
+ * @brief Sets the task that drains the logs, a writer that finds its ring full wakes it and waits for space
+ * @param task Consumer task, nullptr makes a full ring drop lines without waiting
+ * @param events Event bits to set on the task
+*/
+void TaskLog::SetConsumer(TaskHandle_t task, uint32_t events)
+{
+    consumerEvents = events;
+    consumerTask = task;
+}
@@ -7,11 +7,12 @@
 #include "FlightTask.hpp"
 #include "GPIO.hpp"
 #include "SystemDefines.hpp"
+#include "BinaryLog.hpp"
 
 /**
  * @brief Constructor for FlightTask
  */
-FlightTask::FlightTask() : Task(FLIGHT_TASK_QUEUE_DEPTH_OBJS)
+FlightTask::FlightTask()
 {
 }
 
@@ -23,15 +24,9 @@ void FlightTask::InitTask()
     // Make sure the task is not already initialized
     SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize flight task twice");
     
-    BaseType_t rtValue =
-        xTaskCreate((TaskFunction_t)FlightTask::RunTask,
-            (const char*)"FlightTask",
-            (uint16_t)FLIGHT_TASK_STACK_DEPTH_WORDS,
-            (void*)this,
-            (UBaseType_t)FLIGHT_TASK_RTOS_PRIORITY,
-            (TaskHandle_t*)&rtTaskHandle);
-
-    SOAR_ASSERT(rtValue == pdPASS, "FlightTask::InitTask() - xTaskCreate() failed");
+    //Create the task in its static stack and control block, ensure creation succeeded
+    SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)FlightTask::RunTask, "FlightTask", (UBaseType_t)FLIGHT_TASK_RTOS_PRIORITY),
+        "FlightTask::InitTask() - xTaskCreateStatic() failed");
 }
 
 /**
@@ -67,7 +62,7 @@ void FlightTask::Run(void * pvParams)
         osDelay(500);
 
         //Every cycle, print something out (for testing)
-        SOAR_PRINT("FlightTask::Run() - [%d] Seconds\n", tempSecondCounter++);
+        SOAR_LOG(LOG_LEVEL_VERBOSE, LOG_MODULE_FLIGHT, "FlightTask::Run() - [%d] Seconds\n", tempSecondCounter++);
 
         //osDelay(FLIGHT_PHASE_DISPLAY_FREQ);
 
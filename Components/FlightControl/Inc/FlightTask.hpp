@@ -8,7 +8,7 @@
 #define SOAR_FLIGHTTASK_HPP_
 #include "Task.hpp"
 #include "SystemDefines.hpp"
-class FlightTask : public Task
+class FlightTask : public StaticTask<FLIGHT_TASK_STACK_DEPTH_WORDS, FLIGHT_TASK_QUEUE_DEPTH_OBJS>
 {
 public:
     static FlightTask& Inst() {
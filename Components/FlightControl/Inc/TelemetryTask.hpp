@@ -9,8 +9,10 @@
 #define SOAR_TELEMETRYTASK_HPP_
 #include "Task.hpp"
 #include "SystemDefines.hpp"
+#include "LoadCellTask.hpp"
+#include "ThermocoupleTask.hpp"
 
-class TelemetryTask : public Task
+class TelemetryTask : public StaticTask<TELEMETRY_TASK_STACK_DEPTH_WORDS, TELEMETRY_TASK_QUEUE_DEPTH_OBJS>
 {
 public:
     static TelemetryTask& Inst() {
@@ -27,6 +29,8 @@ protected:
 
     void HandleCommand(Command& cm);
     void RunLogSequence();
+    void TransmitLoadCellSample(const LoadCellSample& sample);
+    void TransmitThermocoupleSample(const ThermocoupleSample& sample);
 
 
 private:
@@ -37,6 +41,8 @@ private:
 
     // Private Variables
     uint32_t loggingDelayMs;
+    uint32_t lastLoadCellSequence;      // Sequence of the last load cell sample transmitted
+    uint32_t lastThermocoupleSequence;  // Sequence of the last thermocouple sample transmitted
 };
 
 #endif    // SOAR_TELEMETRYTASK_HPP_
@@ -11,13 +11,16 @@
 #include "FlightTask.hpp"
 #include "LoadCellTask.hpp"
 #include "ThermocoupleTask.hpp"
+#include "TelemetryMessage.hpp"
 
 /**
  * @brief Constructor for TelemetryTask
  */
-TelemetryTask::TelemetryTask() : Task(TELEMETRY_TASK_QUEUE_DEPTH_OBJS)
+TelemetryTask::TelemetryTask()
 {
     loggingDelayMs = TELEMETRY_DEFAULT_LOGGING_RATE_MS;
+    lastLoadCellSequence = 0;
+    lastThermocoupleSequence = 0;
 }
 
 /**
@@ -28,15 +31,9 @@ void TelemetryTask::InitTask()
     // Make sure the task is not already initialized
     SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize telemetry task twice");
 
-    BaseType_t rtValue =
-        xTaskCreate((TaskFunction_t)TelemetryTask::RunTask,
-            (const char*)"TelemetryTask",
-            (uint16_t)TELEMETRY_TASK_STACK_DEPTH_WORDS,
-            (void*)this,
-            (UBaseType_t)TELEMETRY_TASK_RTOS_PRIORITY,
-            (TaskHandle_t*)&rtTaskHandle);
-
-    SOAR_ASSERT(rtValue == pdPASS, "TelemetryTask::InitTask() - xTaskCreate() failed");
+    //Create the task in its static stack and control block, ensure creation succeeded
+    SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)TelemetryTask::RunTask, "TelemetryTask", (UBaseType_t)TELEMETRY_TASK_RTOS_PRIORITY),
+        "TelemetryTask::InitTask() - xTaskCreateStatic() failed");
 }
 
 /**
@@ -69,7 +66,7 @@ void TelemetryTask::HandleCommand(Command& cm)
 	break;
     }
     default:
-        SOAR_PRINT("TelemetryTask - Received Unsupported Command {%d}\n", cm.GetCommand());
+        SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_TELEMETRY, "TelemetryTask - Received Unsupported Command {%d}\n", cm.GetCommand());
         break;
     }
 
@@ -78,16 +75,69 @@ void TelemetryTask::HandleCommand(Command& cm)
 }
 
 /**
- * @brief Runs a full logging sample/send sequence.
- *        can assume this is called with a period of loggingDelayMs
+ * @brief Runs a full logging send sequence, transmitting the latest sample each sensor has published since
+ *        the last sequence. Sensors sample at their own rate, can assume this is called with a period of loggingDelayMs
  */
 void TelemetryTask::RunLogSequence()
 {
+    uint32_t seq;
+
 	// Load Cell
-    LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, (uint16_t)LOADCELL_REQUEST_NEW_SAMPLE));
-    LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, (uint16_t)LOADCELL_REQUEST_TRANSMIT));
+    LoadCellSample loadCellSample;
+    if (LoadCellTask::Inst().GetSampleTopic().GetLatest(loadCellSample, seq) && seq != lastLoadCellSequence) {
+        lastLoadCellSequence = seq;
+        TransmitLoadCellSample(loadCellSample);
+    }
 
     // Thermocouple
-    ThermocoupleTask::Inst().SendCommand(Command(REQUEST_COMMAND, THERMOCOUPLE_REQUEST_NEW_SAMPLE));
-	ThermocoupleTask::Inst().SendCommand(Command(REQUEST_COMMAND, THERMOCOUPLE_REQUEST_TRANSMIT));
+    ThermocoupleSample thermocoupleSample;
+    if (ThermocoupleTask::Inst().GetSampleTopic().GetLatest(thermocoupleSample, seq) && seq != lastThermocoupleSequence) {
+        lastThermocoupleSequence = seq;
+        TransmitThermocoupleSample(thermocoupleSample);
+    }
+}
+
+/**
+ * @brief Transmits a protocol load cell data sample
+ * @param sample Sample to transmit
+ */
+void TelemetryTask::TransmitLoadCellSample(const LoadCellSample& sample)
+{
+    Proto::TelemetryMessage msg;
+	msg.set_source(Proto::Node::NODE_SOB);
+	msg.set_target(Proto::Node::NODE_RCU);
+	msg.set_message_id((uint32_t)Proto::MessageID::MSG_TELEMETRY);
+
+	Proto::LRLoadCell loadCellSample;
+	loadCellSample.set_rocket_mass(sample.weight_g);
+	msg.set_lr(loadCellSample);
+
+	EmbeddedProto::WriteBufferFixedSize<DEFAULT_PROTOCOL_WRITE_BUFFER_SIZE> writeBuffer;
+	msg.serialize(writeBuffer);
+
+    // Send the load cell data
+    SOBProtocolTask::SendProtobufMessage(writeBuffer, Proto::MessageID::MSG_TELEMETRY);
+}
+
+/**
+ * @brief Transmits a protocol thermocouple data sample
+ * @param sample Sample to transmit
+ */
+void TelemetryTask::TransmitThermocoupleSample(const ThermocoupleSample& sample)
+{
+    Proto::TelemetryMessage msg;
+    msg.set_source(Proto::Node::NODE_SOB);
+    msg.set_target(Proto::Node::NODE_RCU);
+    msg.set_message_id((uint32_t)Proto::MessageID::MSG_TELEMETRY);
+
+    Proto::SOBTemp tempData;
+	tempData.set_tc1_temp(sample.tc1_temp);
+	tempData.set_tc2_temp(sample.tc2_temp);
+	msg.set_tempsob(tempData);
+
+    EmbeddedProto::WriteBufferFixedSize<DEFAULT_PROTOCOL_WRITE_BUFFER_SIZE> writeBuffer;
+    msg.serialize(writeBuffer);
+
+    // Send the thermocouple data
+    SOBProtocolTask::SendProtobufMessage(writeBuffer, Proto::MessageID::MSG_TELEMETRY);
 }
@@ -7,13 +7,14 @@
 #include "IRTask.hpp"
 #include "GPIO.hpp"
 #include "SystemDefines.hpp"
+#include "BinaryLog.hpp"
 #include "../../Drivers/mlx90614 Driver/mlx90614.h"
 
 
 /**
  * @brief Constructor for IRTask
  */
-IRTask::IRTask() : Task(IR_TASK_QUEUE_DEPTH_OBJS)
+IRTask::IRTask()
 {
 }
 
@@ -25,15 +26,9 @@ void IRTask::InitTask()
     // Make sure the task is not already initialized
     SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize IR task twice");
 
-    BaseType_t rtValue =
-        xTaskCreate((TaskFunction_t)IRTask::RunTask,
-            (const char*)"IRTask",
-            (uint16_t)IR_TASK_STACK_DEPTH_WORDS,
-            (void*)this,
-            (UBaseType_t)IR_TASK_RTOS_PRIORITY,
-            (TaskHandle_t*)&rtTaskHandle);
-
-    SOAR_ASSERT(rtValue == pdPASS, "IRTask::InitTask() - xTaskCreate() failed");
+    //Create the task in its static stack and control block, ensure creation succeeded
+    SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)IRTask::RunTask, "IRTask", (UBaseType_t)IR_TASK_RTOS_PRIORITY),
+        "IRTask::InitTask() - xTaskCreateStatic() failed");
 
 }
 
@@ -46,67 +41,60 @@ void IRTask::Run(void * pvParams)
 
     while (1) {
 
-        Command cm;
+        Command cms[IR_TASK_QUEUE_DEPTH_OBJS];
 
-        //Wait forever for a command
-        qEvtQueue->ReceiveWait(cm);
+        //Wait forever for commands, duplicate requests that piled up while sampling are merged
+        uint16_t count = ReceiveCoalescedBatch(cms, IR_TASK_QUEUE_DEPTH_OBJS, IsCoalescable);
 
-        //Process the command
-        HandleCommand(cm);
+        //Process the commands
+        for (uint16_t i = 0; i < count; i++)
+            Route(cms[i]);
 
     }
 }
 
 /**
- * @brief Handles a command
- * @param cm Command reference to handle
+ * @brief Coalescing policy, all IR requests are idempotent so duplicates can be merged
+ * @param cm Command to check
+ * @return true if the command can be merged with an identical pending command
  */
-void IRTask::HandleCommand(Command& cm)
+bool IRTask::IsCoalescable(const Command& cm)
 {
-    //TODO: Since this task will stall for a few milliseconds, we may need a way to eat the whole queue (combine similar eg. REQUEST commands and eat to WDG command etc)
-    //TODO: Maybe a HandleEvtQueue instead that takes in the whole queue and eats the whole thing in order of non-blocking to blocking
+    return cm.GetCommand() == REQUEST_COMMAND;
+}
 
-    //Switch for the GLOBAL_COMMAND
-    switch (cm.GetCommand()) {
-    case REQUEST_COMMAND: {
-        HandleRequestCommand(cm.GetTaskCommand());
-    }
-    case TASK_SPECIFIC_COMMAND: {
-        break;
-    }
-    default:
-        SOAR_PRINT("IRTask - Received Unsupported Command {%d}\n", cm.GetCommand());
-        break;
-    }
+/**
+ * @brief Samples the IR sensor, task will be blocked for the polling time
+ */
+void IRTask::OnMessage(const IRNewSampleMessage& msg)
+{
+    SampleIRTemperature();
+}
 
-    //No matter what we happens, we must reset allocated data
-    cm.Reset();
+/**
+ * @brief Transmits the IR sample
+ */
+void IRTask::OnMessage(const IRTransmitMessage& msg)
+{
+    SOAR_PRINT_LEVEL(LOG_LEVEL_DEBUG, LOG_MODULE_IR, "Stubbed: IR task transmit not implemented\n");
 }
 
+/**
+ * @brief Prints the IR sample over the debug UART
+ */
+void IRTask::OnMessage(const IRDebugMessage& msg)
+{
+    SOAR_LOG(LOG_LEVEL_DEBUG, LOG_MODULE_IR, "|IR_TASK| Object Temp: %d, Ambient Temp: %d, MCU Timestamp: %u\n", static_cast<int>(irSample.object_temp * 100),
+    static_cast<int>(irSample.ambient_temp * 100),irSample.timestamp);
+}
 
 /**
- * @brief Handles a Request Command
- * @param taskCommand The command to handle
+ * @brief Handles any command the task does not support
+ * @param cm Unsupported command
  */
-void IRTask::HandleRequestCommand(uint16_t taskCommand)
+void IRTask::OnUnsupported(Command& cm)
 {
-	//Switch for task specific command within DATA_COMMAND
-	    switch (taskCommand) {
-	    case IR_REQUEST_NEW_SAMPLE:
-	    	SampleIRTemperature();
-	        break;
-	    case IR_REQUEST_TRANSMIT:
-	        SOAR_PRINT("Stubbed: IR task transmit not implemented\n");
-	        break;
-	    case IR_REQUEST_DEBUG: {
-	        SOAR_PRINT("|IR_TASK| Object Temp: %d, Ambient Temp: %d, MCU Timestamp: %u\n", static_cast<int>(irSample.object_temp * 100),
-	        static_cast<int>(irSample.ambient_temp * 100),irSample.timestamp);
-	        break;
-	    }
-	    default:
-	        SOAR_PRINT("IRTask - Received Unsupported REQUEST_COMMAND {%d}\n", taskCommand);
-	        break;
-	    }
+    SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_IR, "IRTask - Received Unsupported Command {%d, %d}\n", cm.GetCommand(), cm.GetTaskCommand());
 }
 
 /**
@@ -118,5 +106,6 @@ void IRTask::SampleIRTemperature()
 	irSample.object_temp = MLX90614_ReadTemp(hi2c1,MLX90614_DEFAULT_SA,MLX90614_TOBJ1);
 	irSample.ambient_temp = MLX90614_ReadTemp(hi2c1,MLX90614_DEFAULT_SA,MLX90614_TAMB);
 	irSample.timestamp = HAL_GetTick();
+	sampleTopic.Publish(irSample);
 }
 
@@ -7,6 +7,8 @@
 #ifndef SOAR_IRTASK_HPP_
 #define SOAR_IRTASK_HPP_
 #include "Task.hpp"
+#include "CommandRouter.hpp"
+#include "DataTopic.hpp"
 #include "SystemDefines.hpp"
 #include "../../Drivers/mlx90614 Driver/mlx90614.h"
 
@@ -19,6 +21,13 @@ enum IR_TASK_COMMANDS {
     IR_REQUEST_DEBUG,       // Send the current barometer data over the Debug UART
 };
 
+using IRNewSampleMessage = CommandMessage<REQUEST_COMMAND, IR_REQUEST_NEW_SAMPLE>;
+using IRTransmitMessage = CommandMessage<REQUEST_COMMAND, IR_REQUEST_TRANSMIT>;
+using IRDebugMessage = CommandMessage<REQUEST_COMMAND, IR_REQUEST_DEBUG>;
+
+class IRTask;
+using IRTaskRouter = CommandRouter<IRTask, IRNewSampleMessage, IRTransmitMessage, IRDebugMessage>;
+
 
 struct IRSample {
 	float object_temp;
@@ -27,7 +36,9 @@ struct IRSample {
 
 };
 
-class IRTask : public Task
+using IRTopic = DataTopic<IRSample, IR_TASK_SAMPLE_HISTORY_DEPTH>;
+
+class IRTask : public StaticTask<IR_TASK_STACK_DEPTH_WORDS, IR_TASK_QUEUE_DEPTH_OBJS>, public IRTaskRouter
 {
 public:
     static IRTask& Inst() {
@@ -37,15 +48,24 @@ public:
 
     void InitTask();
 
+    const IRTopic& GetSampleTopic() const { return sampleTopic; }    // Published samples, readable from any task
+
 protected:
     static void RunTask(void* pvParams) { IRTask::Inst().Run(pvParams); } // Static Task Interface, passes control to the instance Run();
 
     void Run(void * pvParams); // Main run code
-    void HandleCommand(Command& cm);
-    void HandleRequestCommand(uint16_t taskCommand);
+    static bool IsCoalescable(const Command& cm);
+
+    // Message handlers
+    friend IRTaskRouter;
+    void OnMessage(const IRNewSampleMessage& msg);
+    void OnMessage(const IRTransmitMessage& msg);
+    void OnMessage(const IRDebugMessage& msg);
+    void OnUnsupported(Command& cm);
 
     void SampleIRTemperature();
     IRSample irSample;
+    IRTopic sampleTopic;
 
 private:
     // Private Functions
@@ -9,6 +9,8 @@
 #define LBS_TO_GRAMS(lbs) ((lbs) * 453.592)
 #define GRAMS_TO_LBS(grams) ((grams) * 0.00220462)
 #include "Task.hpp"
+#include "CommandRouter.hpp"
+#include "DataTopic.hpp"
 #include "SystemDefines.hpp"
 #include "hx711.h"
 
@@ -18,8 +20,7 @@ enum LOADCELL_TASK_COMMANDS {
     LOADCELL_NONE = 0,
 	LOADCELL_REQUEST_TARE,		  			// Send the current load cell data during tare over the Debug UART
 	LOADCELL_REQUEST_CALIBRATE,   			// Calibrate load cell with known mass (in 10^-2 grams)
-    LOADCELL_REQUEST_NEW_SAMPLE,  			// Get a new load cell sample, task will be blocked for polling time
-    LOADCELL_REQUEST_TRANSMIT,    		 	// Send the current load cell data over the Radio
+    LOADCELL_REQUEST_NEW_SAMPLE,  			// Get a new load cell sample now, task will be blocked for polling time
 	LOADCELL_REQUEST_CALIBRATION_DEBUG, 	// Print the offset, scale, and known mass used for calibration
     LOADCELL_REQUEST_DEBUG        			// Send the current load cell data over the Debug UART
 };
@@ -30,7 +31,21 @@ struct LoadCellSample
 	uint32_t timestamp_ms;
 };
 
-class LoadCellTask : public Task
+using LoadCellTareMessage = CommandMessage<REQUEST_COMMAND, LOADCELL_REQUEST_TARE>;
+using LoadCellCalibrateMessage = CommandMessage<REQUEST_COMMAND, LOADCELL_REQUEST_CALIBRATE>;
+using LoadCellNewSampleMessage = CommandMessage<REQUEST_COMMAND, LOADCELL_REQUEST_NEW_SAMPLE>;
+using LoadCellCalibrationDebugMessage = CommandMessage<REQUEST_COMMAND, LOADCELL_REQUEST_CALIBRATION_DEBUG>;
+using LoadCellDebugMessage = CommandMessage<REQUEST_COMMAND, LOADCELL_REQUEST_DEBUG>;
+
+class LoadCellTask;
+using LoadCellTaskRouter = CommandRouter<LoadCellTask, LoadCellTareMessage, LoadCellCalibrateMessage, LoadCellNewSampleMessage,
+    LoadCellCalibrationDebugMessage, LoadCellDebugMessage>;
+
+using LoadCellTopic = DataTopic<LoadCellSample, LOADCELL_TASK_SAMPLE_HISTORY_DEPTH>;
+
+// Event queue lanes in QUEUE_LANE order, so tare and calibrate never wait behind sampling requests or debug prints
+class LoadCellTask : public StaticTask<LOADCELL_TASK_STACK_DEPTH_WORDS,
+    LOADCELL_TASK_CONTROL_QUEUE_DEPTH_OBJS, LOADCELL_TASK_QUEUE_DEPTH_OBJS, LOADCELL_TASK_DEBUG_QUEUE_DEPTH_OBJS>, public LoadCellTaskRouter
 {
 public:
     static LoadCellTask& Inst() {
@@ -42,22 +57,32 @@ public:
     void SetCalibrationMassGrams(const float mass_g) { calibration_mass_g = mass_g; };
     const float getCalibrationMassGrams() { return calibration_mass_g; };
 
+    const LoadCellTopic& GetSampleTopic() const { return sampleTopic; }    // Published samples, readable from any task
+
 protected:
     static void RunTask(void* pvParams) { LoadCellTask::Inst().Run(pvParams); } // Static Task Interface, passes control to the instance Run();
 
     void Run(void * pvParams); // Main run code
 
 
-    void HandleCommand(Command& cm);
-    void HandleRequestCommand(uint16_t taskCommand);
+    static bool IsCoalescable(const Command& cm);
+
+    // Message handlers
+    friend LoadCellTaskRouter;
+    void OnMessage(const LoadCellTareMessage& msg) { LoadCellTare(); }
+    void OnMessage(const LoadCellCalibrateMessage& msg) { LoadCellCalibrate(); }
+    void OnMessage(const LoadCellNewSampleMessage& msg) { SampleLoadCellData(); }
+    void OnMessage(const LoadCellCalibrationDebugMessage& msg);
+    void OnMessage(const LoadCellDebugMessage& msg);
+    void OnUnsupported(Command& cm);
 
     void SampleLoadCellData();
     void LoadCellTare();
     void LoadCellCalibrate();
-    void TransmitProtocolLoadCellData();
 
     hx711_t loadcell;
     LoadCellSample rocket_mass_sample;
+    LoadCellTopic sampleTopic;
     float calibration_mass_g;
 
 private:
@@ -13,18 +13,34 @@
 /* Includes ------------------------------------------------------------------*/
 
 #include "Task.hpp"
+#include "CommandRouter.hpp"
+#include "DataTopic.hpp"
 #include "SystemDefines.hpp"
 
 /* Macros/Enums ------------------------------------------------------------*/
 enum THERMOCOUPLE_TASK_COMMANDS {
 	THERMOCOUPLE_NONE= 0,
-	THERMOCOUPLE_REQUEST_NEW_SAMPLE,	// Get a new temperature sample
-	THERMOCOUPLE_REQUEST_TRANSMIT,		// Send the current temperature over the Protobuff
+	THERMOCOUPLE_REQUEST_NEW_SAMPLE,	// Get a new temperature sample now
 	THERMOCOUPLE_REQUEST_DEBUG       	// Send the current temperature data over the Debug UART
 };
 
+using ThermocoupleNewSampleMessage = CommandMessage<REQUEST_COMMAND, THERMOCOUPLE_REQUEST_NEW_SAMPLE>;
+using ThermocoupleDebugMessage = CommandMessage<REQUEST_COMMAND, THERMOCOUPLE_REQUEST_DEBUG>;
+
+class ThermocoupleTask;
+using ThermocoupleTaskRouter = CommandRouter<ThermocoupleTask, ThermocoupleNewSampleMessage, ThermocoupleDebugMessage>;
+
+struct ThermocoupleSample
+{
+	int16_t tc1_temp;		// Thermocouple 1 temperature in hundredths of a degree C
+	int16_t tc2_temp;		// Thermocouple 2 temperature in hundredths of a degree C
+	uint32_t timestamp_ms;
+};
+
+using ThermocoupleTopic = DataTopic<ThermocoupleSample, THERMOCOUPLE_TASK_SAMPLE_HISTORY_DEPTH>;
+
 /* Class ------------------------------------------------------------------*/
-class ThermocoupleTask : public Task
+class ThermocoupleTask : public StaticTask<THERMOCOUPLE_TASK_STACK_DEPTH_WORDS, THERMOCOUPLE_TASK_QUEUE_DEPTH_OBJS>, public ThermocoupleTaskRouter
 {
 public:
     static ThermocoupleTask& Inst() {
@@ -34,16 +50,22 @@ public:
 
     void InitTask();
 
+    const ThermocoupleTopic& GetSampleTopic() const { return sampleTopic; }    // Published samples, readable from any task
+
 protected:
     static void RunTask(void* pvParams) { ThermocoupleTask::Inst().Run(pvParams); } // Static Task Interface, passes control to the instance Run();
 
     void Run(void* pvParams);    // Main run code
 
-    void HandleCommand(Command& cm);
-    void HandleRequestCommand(uint16_t taskCommand);
+    static bool IsCoalescable(const Command& cm);
+
+    // Message handlers
+    friend ThermocoupleTaskRouter;
+    void OnMessage(const ThermocoupleNewSampleMessage& msg) { SampleThermocouple(); }
+    void OnMessage(const ThermocoupleDebugMessage& msg) { ThermocoupleDebugPrint(); }
+    void OnUnsupported(Command& cm);
 
     // Sampling
-    void TransmitProtocolThermoData();
     void SampleThermocouple();
     void ThermocoupleDebugPrint();
     int16_t ExtractTempurature(uint8_t temperatureData[]);
@@ -53,6 +75,7 @@ protected:
     uint8_t dataBuffer2[4] = {0};
     int16_t temperature1 = 0;
     int16_t temperature2 = 0;
+    ThermocoupleTopic sampleTopic;
 
 private:
     ThermocoupleTask();                                        	// Private constructor
@@ -8,12 +8,12 @@
 #include "LoadCellTask.hpp"
 #include "GPIO.hpp"
 #include "SystemDefines.hpp"
-#include "SOBProtocolTask.hpp"
+#include "BinaryLog.hpp"
 
 /**
  * @brief Constructor for LoadCellTask
  */
-LoadCellTask::LoadCellTask() : Task(LOADCELL_TASK_QUEUE_DEPTH_OBJS)
+LoadCellTask::LoadCellTask()
 {
 }
 
@@ -25,15 +25,9 @@ void LoadCellTask::InitTask()
     // Make sure the task is not already initialized
     SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize flight task twice");
     
-    BaseType_t rtValue =
-        xTaskCreate((TaskFunction_t)LoadCellTask::RunTask,
-            (const char*)"LoadCellTask",
-            (uint16_t)LOADCELL_TASK_STACK_DEPTH_WORDS,
-            (void*)this,
-            (UBaseType_t)LOADCELL_TASK_RTOS_PRIORITY,
-            (TaskHandle_t*)&rtTaskHandle);
-
-    SOAR_ASSERT(rtValue == pdPASS, "LoadCellTask::InitTask() - xTaskCreate() failed");
+    //Create the task in its static stack and control block, ensure creation succeeded
+    SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)LoadCellTask::RunTask, "LoadCellTask", (UBaseType_t)LOADCELL_TASK_RTOS_PRIORITY),
+        "LoadCellTask::InitTask() - xTaskCreateStatic() failed");
 }
 
 /**
@@ -43,86 +37,75 @@ void LoadCellTask::InitTask()
 void LoadCellTask::Run(void * pvParams)
 {
 	hx711_init(&loadcell, LC_CLK_GPIO_Port, LC_CLK_Pin , LC_DATA_GPIO_Port, LC_DATA_Pin);
+	TickType_t nextSampleTick = xTaskGetTickCount();
 	while (1) {
-
-    	Command cm;
-
-    	//Wait forever for a command
-    	qEvtQueue->ReceiveWait(cm);
-
-    	//Process the command
-    	HandleCommand(cm);
+		//Sample and publish when due, consumers read the sample topic at their own rate
+		int32_t ticksUntilSample = (int32_t)(nextSampleTick - xTaskGetTickCount());
+		if (ticksUntilSample <= 0) {
+			SampleLoadCellData();
+			nextSampleTick = xTaskGetTickCount() + MS_TO_TICKS(LOADCELL_TASK_SAMPLE_PERIOD_MS);
+			continue;
+		}
+
+    	Command cms[LOADCELL_TASK_QUEUE_DEPTH_OBJS];
+
+    	//Wait for commands until the next sample, duplicate requests that piled up behind a slow read are merged
+    	uint16_t count = ReceiveCoalescedBatch(cms, LOADCELL_TASK_QUEUE_DEPTH_OBJS, IsCoalescable, TICKS_TO_MS(ticksUntilSample));
+
+    	//Process the commands
+    	//NOTE: if receiving corrupt data from load cell task, consider disabling/enabling interrupts before/after reading load cell with bit banging
+    	for (uint16_t i = 0; i < count; i++)
+    		Route(cms[i]);
     }
 }
 
-
 /**
- * @brief Handles a command
- * @param cm Command reference to handle
+ * @brief Coalescing policy, sampling and reporting requests can be merged, tare and calibrate
+ *        change the load cell state so they are never merged and act as a barrier
+ * @param cm Command to check
+ * @return true if the command can be merged with an identical pending command
  */
-void LoadCellTask::HandleCommand(Command& cm)
+bool LoadCellTask::IsCoalescable(const Command& cm)
 {
-    //TODO: Since this task will stall for a few milliseconds, we may need a way to eat the whole queue (combine similar eg. REQUEST commands and eat to WDG command etc)
-    //TODO: Maybe a HandleEvtQueue instead that takes in the whole queue and eats the whole thing in order of non-blocking to blocking
-
-	//NOTE: if receiving corrupt data from load cell task, consider disabling/enabling interrupts before/after reading load cell with bit banging
-    //Switch for the GLOBAL_COMMAND
-    switch (cm.GetCommand()) {
-    case REQUEST_COMMAND: {
-        HandleRequestCommand(cm.GetTaskCommand());
-        break;
-    }
-    case TASK_SPECIFIC_COMMAND: {
-        break;
-    }
+    if (cm.GetCommand() != REQUEST_COMMAND)
+        return false;
+
+    switch (cm.GetTaskCommand()) {
+    case LOADCELL_REQUEST_NEW_SAMPLE:
+    case LOADCELL_REQUEST_CALIBRATION_DEBUG:
+    case LOADCELL_REQUEST_DEBUG:
+        return true;
     default:
-        SOAR_PRINT("LoadCellTask - Received Unsupported Command {%d}\n", cm.GetCommand());
-        break;
+        return false;
     }
+}
 
-    //No matter what we happens, we must reset allocated data
-    cm.Reset();
+
+/**
+ * @brief Prints the load cell calibration over the debug UART
+ */
+void LoadCellTask::OnMessage(const LoadCellCalibrationDebugMessage& msg)
+{
+	SOAR_PRINT_LEVEL(LOG_LEVEL_DEBUG, LOG_MODULE_LOADCELL, "Load Cell offset %d \n", loadcell.offset);
+	SOAR_PRINT_LEVEL(LOG_LEVEL_DEBUG, LOG_MODULE_LOADCELL, "Load Cell coef %.3f \n", loadcell.coef);
+	SOAR_PRINT_LEVEL(LOG_LEVEL_DEBUG, LOG_MODULE_LOADCELL, "Load Cell calibration weight %.3f grams\n", calibration_mass_g);
 }
 
+/**
+ * @brief Prints the load cell sample over the debug UART
+ */
+void LoadCellTask::OnMessage(const LoadCellDebugMessage& msg)
+{
+	SOAR_LOG(LOG_LEVEL_DEBUG, LOG_MODULE_LOADCELL, "Load Cell read weight: %.3f grams\n", rocket_mass_sample.weight_g);
+}
 
 /**
- * @brief Handles a Request Command
- * @param taskCommand The command to handle
+ * @brief Handles any command the task does not support
+ * @param cm Unsupported command
  */
-void LoadCellTask::HandleRequestCommand(uint16_t taskCommand)
+void LoadCellTask::OnUnsupported(Command& cm)
 {
-    //Switch for task specific command within DATA_COMMAND
-    switch (taskCommand) {
-    case LOADCELL_REQUEST_TARE: {
-    	LoadCellTare();
-    	break;
-    }
-    case LOADCELL_REQUEST_CALIBRATE: {
-       	LoadCellCalibrate();
-       	break;
-    }
-    case LOADCELL_REQUEST_NEW_SAMPLE: {
-    	SampleLoadCellData();
-        break;
-    }
-    case LOADCELL_REQUEST_TRANSMIT: {
-    	TransmitProtocolLoadCellData();
-        break;
-    }
-    case LOADCELL_REQUEST_CALIBRATION_DEBUG: {
-    	SOAR_PRINT("Load Cell offset %d \n", loadcell.offset);
-    	SOAR_PRINT("Load Cell coef %d.%d \n", (int)loadcell.coef, abs(int(loadcell.coef * 1000) % 1000));
-    	SOAR_PRINT("Load Cell calibration weight %d.%d grams\n", (int)calibration_mass_g, abs(int(calibration_mass_g * 1000) % 1000));
-    	break;
-    }
-    case LOADCELL_REQUEST_DEBUG: {
-        SOAR_PRINT("Load Cell read weight: %d.%d grams\n", (int)rocket_mass_sample.weight_g, abs(int(rocket_mass_sample.weight_g * 1000) % 1000));
-        break;
-    }
-    default:
-        SOAR_PRINT("LoadCellTask - Received Unsupported REQUEST_COMMAND {%d}\n", taskCommand);
-        break;
-    }
+	SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_LOADCELL, "LoadCellTask - Received Unsupported Command {%d, %d}\n", cm.GetCommand(), cm.GetTaskCommand());
 }
 
 /**
@@ -134,7 +117,7 @@ void LoadCellTask::LoadCellTare()
 {
 	hx711_reset_coef_offset(&loadcell);
 	hx711_tare(&loadcell, 10);
-	SOAR_PRINT("Load Cell offset %d \n", loadcell.offset);
+	SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_LOADCELL, "Load Cell offset %d \n", loadcell.offset);
 }
 /**
  * @brief Calculates the calibration coefficient for calibration with a known mass.
@@ -144,13 +127,13 @@ void LoadCellTask::LoadCellTare()
 void LoadCellTask::LoadCellCalibrate()
 {
 	if (calibration_mass_g <= 0) {
-		SOAR_PRINT("Load Cell requires positive, nonzero calibration weight\n");
+		SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_LOADCELL, "Load Cell requires positive, nonzero calibration weight\n");
 		return;
 	}
 
 	int32_t load_raw = hx711_value_ave(&loadcell, 10);
 	hx711_calibration(&loadcell, loadcell.offset, load_raw, calibration_mass_g);
-	SOAR_PRINT("Load Cell coef %d.%d \n", (int)loadcell.coef, abs(int(loadcell.coef * 1000) % 1000));
+	SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_LOADCELL, "Load Cell coef %.3f \n", loadcell.coef);
 }
 
 /**
@@ -163,22 +146,6 @@ void LoadCellTask::SampleLoadCellData()
 	uint32_t ADCdata;
 	rocket_mass_sample.weight_g = hx711_weight(&loadcell, 10, ADCdata);
 	rocket_mass_sample.timestamp_ms = HAL_GetTick();
+	sampleTopic.Publish(rocket_mass_sample);
 }
 
-void LoadCellTask::TransmitProtocolLoadCellData()
-{
-    Proto::TelemetryMessage msg;
-	msg.set_source(Proto::Node::NODE_SOB);
-	msg.set_target(Proto::Node::NODE_RCU);
-	msg.set_message_id((uint32_t)Proto::MessageID::MSG_TELEMETRY);
-
-	Proto::LRLoadCell loadCellSample;
-	loadCellSample.set_rocket_mass(rocket_mass_sample.weight_g);
-	msg.set_lr(loadCellSample);
-
-	EmbeddedProto::WriteBufferFixedSize<DEFAULT_PROTOCOL_WRITE_BUFFER_SIZE> writeBuffer;
-	msg.serialize(writeBuffer);
-
-    // Send the load cell data
-    SOBProtocolTask::SendProtobufMessage(writeBuffer, Proto::MessageID::MSG_TELEMETRY);
-}
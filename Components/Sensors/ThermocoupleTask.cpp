@@ -17,8 +17,7 @@
 #include "main.h"
 #include "DebugTask.hpp"
 #include "Task.hpp"
-#include "TelemetryMessage.hpp"
-#include "SOBProtocolTask.hpp"
+#include "BinaryLog.hpp"
 
 /* Macros --------------------------------------------------------------------*/
 
@@ -41,7 +40,7 @@ constexpr int CMD_TIMEOUT = 150;
 /**
  * @brief Default constructor
  */
-ThermocoupleTask::ThermocoupleTask() : Task(THERMOCOUPLE_TASK_QUEUE_DEPTH_OBJS)
+ThermocoupleTask::ThermocoupleTask()
 {
 	//Data is stored locally in object not using MALOC
 }
@@ -55,16 +54,9 @@ void ThermocoupleTask::InitTask()
     SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize Thermocouple task twice");
 
     // Start the task
-    BaseType_t rtValue =
-        xTaskCreate((TaskFunction_t)ThermocoupleTask::RunTask,
-            (const char*)"ThermocoupleTask",
-            (uint16_t)THERMOCOUPLE_TASK_STACK_DEPTH_WORDS,
-            (void*)this,
-            (UBaseType_t)THERMOCOUPLE_TASK_RTOS_PRIORITY,
-            (TaskHandle_t*)&rtTaskHandle);
-
-    //Ensure creation succeeded
-    SOAR_ASSERT(rtValue == pdPASS, "ThermocoupleTask::InitTask() - xTaskCreate() failed");
+    //Create the task in its static stack and control block, ensure creation succeeded
+    SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)ThermocoupleTask::RunTask, "ThermocoupleTask", (UBaseType_t)THERMOCOUPLE_TASK_RTOS_PRIORITY),
+        "ThermocoupleTask::InitTask() - xTaskCreateStatic() failed");
 }
 
 /**
@@ -73,88 +65,53 @@ void ThermocoupleTask::InitTask()
  */
 void ThermocoupleTask::Run(void * pvParams)
 {
-    while (1) {
-        Command cm;
-
-        //Wait forever for a command
-        qEvtQueue->ReceiveWait(cm);
+    EnableQueueEvents();
 
-        //Process the command
-        HandleCommand(cm);
-    }
-}
-
-/**
- * @brief Handles a command
- * @param cm Command reference to handle
- */
-void ThermocoupleTask::HandleCommand(Command& cm)
-{
-    //Switch for the GLOBAL_COMMAND
-    switch (cm.GetCommand()) {
-    case REQUEST_COMMAND: {
-        HandleRequestCommand(cm.GetTaskCommand()); //Sends task specific request command to task request handler
-        break;
-    }
-    case TASK_SPECIFIC_COMMAND: {
-        break; //No task specific commands need
-    }
-    default:
-        SOAR_PRINT("ThermocoupleTask - Received Unsupported Command {%d}\n", cm.GetCommand());
-        break;
+    TickType_t nextSampleTick = xTaskGetTickCount();
+    while (1) {
+        //Sample and publish when due, consumers read the sample topic at their own rate
+        int32_t ticksUntilSample = (int32_t)(nextSampleTick - xTaskGetTickCount());
+        if (ticksUntilSample <= 0) {
+            SampleThermocouple();
+            nextSampleTick = xTaskGetTickCount() + MS_TO_TICKS(THERMOCOUPLE_TASK_SAMPLE_PERIOD_MS);
+            continue;
+        }
+
+        //Wait for a command until the next sample
+        uint32_t events = WaitEvents(TASK_EVENT_QUEUE, TICKS_TO_MS(ticksUntilSample));
+
+        if (events & TASK_EVENT_QUEUE) {
+            Command cms[THERMOCOUPLE_TASK_QUEUE_DEPTH_OBJS];
+            uint16_t count;
+
+            //Drain the queue, duplicate requests that piled up while sampling are merged
+            while ((count = ReceiveCoalescedBatch(cms, THERMOCOUPLE_TASK_QUEUE_DEPTH_OBJS, IsCoalescable, 0)) > 0) {
+                for (uint16_t i = 0; i < count; i++)
+                    Route(cms[i]);
+            }
+        }
     }
-    //No matter what we happens, we must reset allocated data
-    cm.Reset();
 }
 
 /**
- * @brief Handles a Request Command
- * @param taskCommand The command to handle
+ * @brief Coalescing policy, all thermocouple requests are idempotent so duplicates can be merged
+ * @param cm Command to check
+ * @return true if the command can be merged with an identical pending command
  */
-void ThermocoupleTask::HandleRequestCommand(uint16_t taskCommand)
+bool ThermocoupleTask::IsCoalescable(const Command& cm)
 {
-    //Switch for task specific command within DATA_COMMAND
-    switch (taskCommand) {
-    case THERMOCOUPLE_REQUEST_NEW_SAMPLE: //Sample TC and store in class fields
-    	SampleThermocouple();
-        break;
-    case THERMOCOUPLE_REQUEST_TRANSMIT: //Sending data to PI
-        TransmitProtocolThermoData();
-        break;
-    case THERMOCOUPLE_REQUEST_DEBUG: //Output TC data
-        ThermocoupleDebugPrint();
-        break;
-    default:
-        SOAR_PRINT("UARTTask - Received Unsupported REQUEST_COMMAND {%d}\n", taskCommand);
-        break;
-    }
+    return cm.GetCommand() == REQUEST_COMMAND;
 }
 
 /**
- * @brief Transmits a protocol barometer data sample
+ * @brief Handles any command the task does not support
+ * @param cm Unsupported command
  */
-void ThermocoupleTask::TransmitProtocolThermoData()
+void ThermocoupleTask::OnUnsupported(Command& cm)
 {
-    SOAR_PRINT("Thermocouple Task Transmit...\n");
-    //ThermocoupleDebugPrint();
-
-    Proto::TelemetryMessage msg;
-    msg.set_source(Proto::Node::NODE_SOB);
-    msg.set_target(Proto::Node::NODE_RCU);
-    msg.set_message_id((uint32_t)Proto::MessageID::MSG_TELEMETRY);
-    Proto::SOBTemp tempData;
-	tempData.set_tc1_temp(temperature1);
-	tempData.set_tc2_temp(temperature2);
-	msg.set_tempsob(tempData);
-
-    EmbeddedProto::WriteBufferFixedSize<DEFAULT_PROTOCOL_WRITE_BUFFER_SIZE> writeBuffer;
-    msg.serialize(writeBuffer);
-
-    // Send the thermocouple data
-    SOBProtocolTask::SendProtobufMessage(writeBuffer, Proto::MessageID::MSG_TELEMETRY);
+    SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_THERMOCOUPLE, "ThermocoupleTask - Received Unsupported Command {%d, %d}\n", cm.GetCommand(), cm.GetTaskCommand());
 }
 
-
 /**
  * @brief display any error messages and the temperature
  */
@@ -163,21 +120,21 @@ void ThermocoupleTask::ThermocoupleDebugPrint()
 	//thermo 1 print
 	if(dataBuffer1[1] & 0x01)
 	{
-		SOAR_PRINT("There is an Error with Thermocouple 1 \n\n");
+		SOAR_LOG(LOG_LEVEL_WARN, LOG_MODULE_THERMOCOUPLE, "There is an Error with Thermocouple 1 \n\n");
 	}
 	else
 	{
-		SOAR_PRINT("Thermocouple 1 is reading %d.%d C \n\n" , temperature1/100, temperature1%100);
+		SOAR_LOG(LOG_LEVEL_DEBUG, LOG_MODULE_THERMOCOUPLE, "Thermocouple 1 is reading %.2f C \n\n", temperature1 / 100.0f);
 	}
 
 	//thermo 2 print
 	if(dataBuffer2[1] & 0x01)
 	{
-		SOAR_PRINT("There is an Error with Thermocouple 2 \n\n");
+		SOAR_LOG(LOG_LEVEL_WARN, LOG_MODULE_THERMOCOUPLE, "There is an Error with Thermocouple 2 \n\n");
 	}
 	else
 	{
-		SOAR_PRINT("Thermocouple 2 is reading %d.%d C \n\n", temperature2/100, temperature2%100);
+		SOAR_LOG(LOG_LEVEL_DEBUG, LOG_MODULE_THERMOCOUPLE, "Thermocouple 2 is reading %.2f C \n\n", temperature2 / 100.0f);
 	}
 }
 
@@ -260,7 +217,7 @@ void ThermocoupleTask::SampleThermocouple()
 
 	*///------------------------------------------------------------------------------
 
-	SOAR_PRINT("\n-- Sample Thermocouple Data --\n");
+	SOAR_LOG(LOG_LEVEL_VERBOSE, LOG_MODULE_THERMOCOUPLE, "\n-- Sample Thermocouple Data --\n");
 
 	uint8_t tempDataBuffer5[5] = {0};
 	//See Above bit mem-map
@@ -302,4 +259,7 @@ void ThermocoupleTask::SampleThermocouple()
 	}
 
 	temperature2 = ExtractTempurature(dataBuffer2);
+
+	ThermocoupleSample sample = { temperature1, temperature2, HAL_GetTick() };
+	sampleTopic.Publish(sample);
 }
@@ -0,0 +1,134 @@
+/**
+ ******************************************************************************
+ * File Name          : BinaryLog.cpp
+ * Description        : Implementation of the BinaryLog record ring.
+ *
+ * The ring is a bounded multi-producer queue: each cell carries a sequence number,
+ * producers claim a cell with a compare-and-swap on the write position and publish
+ * it by advancing the cell sequence. The UARTTask is the only consumer. No mutex
+ * or critical section is taken, so SOAR_LOG is safe and cheap from any context.
+ *
+ * Sequences are stored minus the cell index, so the zero-initialized ring is empty
+ * without an init call before the first SOAR_LOG.
+ ******************************************************************************
+*/
+#include "BinaryLog.hpp"
+#include "SystemDefines.hpp"
+
+#include <atomic>
+
+/* Structs -----------------------------------------------------------------*/
+struct BinaryLogCell
+{
+    std::atomic<uint32_t> sequence;     // Equals the write position when free, position + 1 when holding a record, minus the cell index
+    BinaryLogRecord record;
+};
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    BinaryLogCell cells[BINARY_LOG_RING_RECORDS];
+    std::atomic<uint32_t> writePosition;        // Next position a producer claims
+    uint32_t readPosition = 0;                  // Next position the consumer drains, only touched by the consumer
+    std::atomic<uint32_t> droppedCount;         // Records dropped because the ring was full
+
+    /**
+     * @brief Gets the current time in ms from a task or an ISR
+     * @return Time since scheduler start in ms
+    */
+    uint32_t GetTimestampMs()
+    {
+        return TICKS_TO_MS(xPortIsInsideInterrupt() ? xTaskGetTickCountFromISR() : xTaskGetTickCount());
+    }
+}
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Claims a cell and copies the record into it, drops the record if the ring is full
+ * @param format Format string, its address is the string ID
+ * @param args Raw argument words
+ * @param argCount Number of words in args
+*/
+void BinaryLog::Push(const char* format, const uint32_t* args, uint8_t argCount)
+{
+    uint32_t pos = writePosition.load(std::memory_order_relaxed);
+    uint32_t idx;
+
+    while (true) {
+        idx = pos & (BINARY_LOG_RING_RECORDS - 1);
+        const int32_t diff = static_cast<int32_t>(cells[idx].sequence.load(std::memory_order_acquire) + idx - pos);
+
+        if (diff == 0) {
+            // Cell is free, claim it, on failure pos is reloaded with the current position
+            if (writePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0) {
+            // Cell still holds a record the consumer has not drained, the ring is full
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            // Another producer claimed this position
+            pos = writePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    BinaryLogRecord& record = cells[idx].record;
+    record.formatAddress = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format));
+    record.timestamp_ms = GetTimestampMs();
+    record.argCount = argCount;
+    memcpy(record.args, args, argCount * sizeof(uint32_t));
+
+    // Publish the record to the consumer
+    cells[idx].sequence.store(pos + 1 - idx, std::memory_order_release);
+}
+
+/**
+ * @brief Encodes pending records into the buffer in wire format, only whole records are written. Only one
+ *        task may drain.
+ * @param buffer Buffer to encode into
+ * @param size Size of the buffer in bytes, at least one full record to make progress
+ * @return Number of bytes written
+*/
+uint16_t BinaryLog::Drain(uint8_t* buffer, uint16_t size)
+{
+    uint16_t written = 0;
+
+    while (true) {
+        const uint32_t idx = readPosition & (BINARY_LOG_RING_RECORDS - 1);
+
+        // Stop at the first cell that is not published, a producer may still be filling it
+        if (cells[idx].sequence.load(std::memory_order_acquire) + idx != readPosition + 1)
+            break;
+
+        const BinaryLogRecord& record = cells[idx].record;
+        const uint16_t recordSize = BINARY_LOG_RECORD_HEADER_BYTES + record.argCount * sizeof(uint32_t);
+        if (written + recordSize > size)
+            break;
+
+        buffer[written++] = BINARY_LOG_SYNC_BYTE;
+        buffer[written++] = record.argCount;
+        memcpy(&buffer[written], &record.formatAddress, sizeof(uint32_t));
+        written += sizeof(uint32_t);
+        memcpy(&buffer[written], &record.timestamp_ms, sizeof(uint32_t));
+        written += sizeof(uint32_t);
+        memcpy(&buffer[written], record.args, record.argCount * sizeof(uint32_t));
+        written += record.argCount * sizeof(uint32_t);
+
+        // Free the cell for the producer one lap ahead
+        cells[idx].sequence.store(readPosition + BINARY_LOG_RING_RECORDS - idx, std::memory_order_release);
+        readPosition++;
+    }
+
+    return written;
+}
+
+/**
+ * @brief Gets the number of records dropped because the ring was full
+ * @return Dropped record count
+*/
+uint32_t BinaryLog::GetDroppedCount()
+{
+    return droppedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,134 @@
+/**
+ ******************************************************************************
+ * File Name          : CrashRecord.cpp
+ * Description        : Implementation of the CrashRecord kept in no-init CCMRAM.
+ *
+ * The .ccmram_noinit section is NOLOAD in both linker scripts, so the record keeps its
+ * contents across a software or watchdog reset. After a power-on the contents are random,
+ * the magic and CRC reject them.
+ ******************************************************************************
+*/
+#include "CrashRecord.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstddef>     // Support for offsetof
+#include <cstring>     // Support for strlen and memset
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    __attribute__((section(".ccmram_noinit"))) CrashRecordData savedRecord;
+
+    /**
+     * @brief Gets the CRC16 of every field of a record before the crc
+    */
+    uint16_t GetRecordCrc(const CrashRecordData& record)
+    {
+        return Utils::getCRC16(reinterpret_cast<uint8_t*>(const_cast<CrashRecordData*>(&record)), offsetof(CrashRecordData, crc));
+    }
+}
+
+CrashRecordData CrashRecord::last;
+bool CrashRecord::hasLast = false;
+const char* CrashRecord::resetReason = "Unknown";
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Saves a crash record, called from the assert path with the scheduler suspended
+ * @param file File of the assert, only the end of the path is kept if it is too long
+ * @param line Line of the assert
+ * @param format Assert message format, may be nullptr
+ * @param args Arguments for the format
+*/
+void CrashRecord::Save(const char* file, uint16_t line, const char* format, va_list args)
+{
+    CrashRecordData& record = savedRecord;
+    memset(&record, 0, sizeof(record));
+
+    record.timestamp_ms = TICKS_TO_MS(xPortIsInsideInterrupt() ? xTaskGetTickCountFromISR() : xTaskGetTickCount());
+    record.stackPointer = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(__builtin_frame_address(0)));
+    record.freeHeapBytes = xPortGetFreeHeapSize();
+    record.minEverFreeHeapBytes = xPortGetMinimumEverFreeHeapSize();
+    record.line = line;
+
+    if (file != nullptr) {
+        const size_t fileLen = strlen(file);
+        const size_t skip = (fileLen >= sizeof(record.file)) ? fileLen - (sizeof(record.file) - 1) : 0;
+        Utils::FormatString(record.file, sizeof(record.file), "%s", file + skip);
+    }
+
+    const char* taskName = "None";
+    if (xPortIsInsideInterrupt())
+        taskName = "ISR";
+    else if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+        taskName = pcTaskGetName(nullptr);
+    Utils::FormatString(record.task, sizeof(record.task), "%s", taskName);
+
+    if (format != nullptr)
+        Utils::FormatStringV(record.message, sizeof(record.message), format, args);
+
+    record.magic = CRASH_RECORD_MAGIC;
+    record.crc = GetRecordCrc(record);
+}
+
+/**
+ * @brief Reads and clears the reset reason, takes the saved record if it is valid and invalidates it
+*/
+void CrashRecord::Init()
+{
+    resetReason = ReadResetReason();
+    hasLast = false;
+
+    if (savedRecord.magic == CRASH_RECORD_MAGIC && savedRecord.crc == GetRecordCrc(savedRecord)) {
+        last = savedRecord;
+        hasLast = true;
+    }
+
+    // Only report a record once
+    savedRecord.magic = 0;
+}
+
+/**
+ * @brief Prints the reset reason and the last crash record, keep this short as it is queued before the
+ *        scheduler starts
+*/
+void CrashRecord::PrintLast()
+{
+    SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_SYSTEM, "System Reset Reason: %s\n", resetReason);
+
+    if (!hasLast)
+        return;
+
+    SOAR_PRINT_LEVEL(LOG_LEVEL_ERROR, LOG_MODULE_SYSTEM, "-- LAST CRASH -- Assert in [%s] @ Line # [%d], task [%s] @%u ms\n",
+        last.file, last.line, last.task, last.timestamp_ms);
+    SOAR_PRINT_LEVEL(LOG_LEVEL_ERROR, LOG_MODULE_SYSTEM, "Crash SP 0x%08x, Heap Free %u, Lowest Ever %u Bytes, Message: %s\n",
+        last.stackPointer, last.freeHeapBytes, last.minEverFreeHeapBytes, last.message);
+}
+
+/**
+ * @brief Reads the RCC reset flags and clears them for the next reset
+ * @return Name of the reset cause
+*/
+const char* CrashRecord::ReadResetReason()
+{
+    const char* reason = "Unknown";
+
+    // Check the specific causes first, a pin reset flag is also set by every internal reset
+    if (__HAL_RCC_GET_FLAG(RCC_FLAG_LPWRRST))
+        reason = "Low Power";
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_WWDGRST))
+        reason = "Window Watchdog";
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST))
+        reason = "Independent Watchdog";
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST))
+        reason = "Software";
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST))
+        reason = "Power On";
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_BORRST))
+        reason = "Brown Out";
+    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_PINRST))
+        reason = "Reset Pin";
+
+    __HAL_RCC_CLEAR_RESET_FLAGS();
+    return reason;
+}
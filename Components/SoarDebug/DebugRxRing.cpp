@@ -0,0 +1,32 @@
+/**
+ ******************************************************************************
+ * File Name          : DebugRxRing.cpp
+ * Description        : Implementation of the DebugRxRing receive side.
+ ******************************************************************************
+*/
+#include "DebugRxRing.hpp"
+
+#include <cstring>     // Support for memset
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Constructor, starts with an empty ring and line
+*/
+DebugRxRing::DebugRxRing() : lineIdx(0), statOverflowCount(0)
+{
+    memset(line, 0, sizeof(line));
+}
+
+/**
+ * @brief Pushes a received byte, called from the receive ISR only
+ * @param c Received byte
+ * @return true on a line ending, or early if the ring is filling up during a burst
+*/
+bool DebugRxRing::Push(uint8_t c)
+{
+    if (!ring.push(c))
+        statOverflowCount++;
+
+    return c == '\r' || ring.size() >= DEBUG_RX_RING_WAKE_BYTES;
+}
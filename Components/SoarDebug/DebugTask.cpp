@@ -8,8 +8,13 @@
 /* Includes ------------------------------------------------------------------*/
 #include "DebugTask.hpp"
 #include "Command.hpp"
+#include "CommandPool.hpp"
+#include "CompactCommand.hpp"
+#include "BinaryLog.hpp"
+#include "CrashRecord.hpp"
 #include "Utils.hpp"
 #include <cstring>
+#include <cstdlib>
 
 #include "FlightTask.hpp"
 #include "LoadCellTask.hpp"
@@ -18,6 +23,8 @@
 #include "stm32f4xx_hal.h"
 #include "ThermocoupleTask.hpp"
 #include "SOBProtocolTask.hpp"
+#include "TelemetryTask.hpp"
+#include "UARTTask.hpp"
 
 /* Macros --------------------------------------------------------------------*/
 
@@ -29,6 +36,9 @@ constexpr uint8_t DEBUG_TASK_PERIOD = 100;
 /* Variables -----------------------------------------------------------------*/
 
 /* Prototypes ----------------------------------------------------------------*/
+static void PrintLinkStats(const char* name, const UARTDriver* uart);
+static void PrintQueueStats(const char* name, const Queue* queue);
+static void HandleLogLevelCommand(const char* args);
 
 /* HAL Callbacks ----------------------------------------------------------------*/
 
@@ -36,12 +46,9 @@ constexpr uint8_t DEBUG_TASK_PERIOD = 100;
 /**
  * @brief Constructor, sets all member variables
  */
-DebugTask::DebugTask() : Task(TASK_DEBUG_QUEUE_DEPTH_OBJS),
-        kUart_(UART::Debug)
+DebugTask::DebugTask() : kUart_(UART::Debug)
 {
-	memset(debugBuffer, 0, sizeof(debugBuffer));
-	debugMsgIdx = 0;
-	isDebugMsgReady = false;
+	debugRxChar = 0;
 }
 
 /**
@@ -53,16 +60,9 @@ void DebugTask::InitTask()
 	SOAR_ASSERT(rtTaskHandle == nullptr, "Cannot initialize Debug task twice");
 
 	// Start the task
-	BaseType_t rtValue =
-		xTaskCreate((TaskFunction_t)DebugTask::RunTask,
-			(const char*)"DebugTask",
-			(uint16_t)TASK_DEBUG_STACK_DEPTH_WORDS,
-			(void*)this,
-			(UBaseType_t)TASK_DEBUG_PRIORITY,
-			(TaskHandle_t*)&rtTaskHandle);
-
-	//Ensure creation succeded
-	SOAR_ASSERT(rtValue == pdPASS, "DebugTask::InitTask - xTaskCreate() failed");
+	//Create the task in its static stack and control block, ensure creation succeeded
+	SOAR_ASSERT(CreateTaskStatic((TaskFunction_t)DebugTask::RunTask, "DebugTask", (UBaseType_t)TASK_DEBUG_PRIORITY),
+		"DebugTask::InitTask - xTaskCreateStatic() failed");
 }
 
 // TODO: Only run thread when appropriate GPIO pin pulled HIGH (or by define)
@@ -75,17 +75,11 @@ void DebugTask::Run(void * pvParams)
 	ReceiveData();
 
 	while (1) {
-		Command cm;
+		//Wait forever for the ISR to signal a line ending or a nearly full ring
+		WaitEvents(DEBUG_EVENT_RX_LINE);
 
-		//Wait forever for a command
-		qEvtQueue->ReceiveWait(cm);
-
-		//Process the command
-		if(cm.GetCommand() == DATA_COMMAND && cm.GetTaskCommand() == EVENT_DEBUG_RX_COMPLETE) {
-			HandleDebugMessage((const char*)debugBuffer);
-		}
-
-		cm.Reset();
+		//Assemble and process every complete line in the ring
+		rxRing.Process([this](const char* line) { HandleDebugMessage(line); });
 	}
 }
 
@@ -99,36 +93,44 @@ void DebugTask::HandleDebugMessage(const char* msg)
 	if (strncmp(msg, "lccal ", 6) == 0) {
 		// Debug command for LoadCellCalibrate()
 		// NOTE: load cell calibration mass must be in milligrams, load cell will read/transmit in grams
-		SOAR_PRINT("Debug 'Load Cell Calibrate' command requested\n");
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'Load Cell Calibrate' command requested\n");
 		int32_t mass_mg = ExtractIntParameter(msg, 6);
 		if (mass_mg != ERRVAL && mass_mg != 0)
 		{
 			// update calibration mass directly
 			LoadCellTask::Inst().SetCalibrationMassGrams((float)mass_mg / 1000);
 			// send calibration command to queue -- could be blocking if we protect the LC read
-			LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_CALIBRATE));
+			LoadCellTask::Inst().Post<LoadCellCalibrateMessage>(QUEUE_LANE_CONTROL);
 		}
 	}
+	else if (strncmp(msg, "loglevel", 8) == 0 && (msg[8] == '\0' || msg[8] == ' ')) {
+		// Lists the log thresholds, or sets one with "loglevel <module|all> <level>"
+		HandleLogLevelCommand(&msg[8]);
+	}
 
 	//-- SYSTEM / CHAR COMMANDS -- (Must be last)
 	else if (strcmp(msg, "lctare") == 0) {
 		// Debug command for LoadCellTare()
-		SOAR_PRINT("Debug 'Load Cell Tare' command requested\n");
-		LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_TARE));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'Load Cell Tare' command requested\n");
+		LoadCellTask::Inst().Post<LoadCellTareMessage>(QUEUE_LANE_CONTROL);
 	}
 	else if (strcmp(msg, "lcweigh") == 0) {
 		// Debug command for SampleLoadCellData()
-		SOAR_PRINT("Debug 'Load Cell Weigh' command requested\n");
-		LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_NEW_SAMPLE));
-		LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_DEBUG));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'Load Cell Weigh' command requested\n");
+		LoadCellTask::Inst().Post<LoadCellNewSampleMessage>();
+		LoadCellTask::Inst().Post<LoadCellDebugMessage>(QUEUE_LANE_DEBUG);
 	}
 	else if (strcmp(msg, "lccaldebug") == 0) {
-		SOAR_PRINT("Debug 'Load Cell Calibration Debug' command requested\n");
-		LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_CALIBRATION_DEBUG));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'Load Cell Calibration Debug' command requested\n");
+		LoadCellTask::Inst().Post<LoadCellCalibrationDebugMessage>(QUEUE_LANE_DEBUG);
 	}
 	else if (strcmp(msg, "lcdebug") == 0) {
-		SOAR_PRINT("Debug 'Load Cell Sample Debug' command requested\n");
-		LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_DEBUG));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'Load Cell Sample Debug' command requested\n");
+		LoadCellTask::Inst().Post<LoadCellDebugMessage>(QUEUE_LANE_DEBUG);
+	}
+	else if (strcmp(msg, "crashinfo") == 0) {
+		// Reprints the reset reason and the crash record taken at boot
+		CrashRecord::PrintLast();
 	}
 	else if (strcmp(msg, "sysreset") == 0) {
 		// Reset the system
@@ -139,24 +141,89 @@ void DebugTask::HandleDebugMessage(const char* msg)
 		SOAR_PRINT("\n\t-- Avionics Core System Info --\n");
 		SOAR_PRINT("Current System Heap Use: %d Bytes\n", xPortGetFreeHeapSize());
 		SOAR_PRINT("Lowest Ever Heap Size\t: %d Bytes\n", xPortGetMinimumEverFreeHeapSize());
-		SOAR_PRINT("Debug Task Runtime  \t: %d ms\n\n", TICKS_TO_MS(xTaskGetTickCount()));
+		SOAR_PRINT("Debug Task Runtime  \t: %d ms\n", TICKS_TO_MS(xTaskGetTickCount()));
+		SOAR_PRINT("Debug Rx Overflows  \t: %d Bytes\n", rxRing.GetOverflowCount());
+		SOAR_PRINT("Binary Log Drops    \t: %d Records\n", BinaryLog::GetDroppedCount());
+		SOAR_PRINT("Log Suppressed      \t: %d Messages\n", LogLimiter::GetSuppressedCount());
+		uint32_t taskLogDrops = 0;
+		for (uint8_t i = 0; i < TaskLog::GetSourceCount(); i++)
+			taskLogDrops += TaskLog::GetSource(i)->GetDroppedCount();
+		SOAR_PRINT("Task Log Drops      \t: %d Lines\n", taskLogDrops);
+		SOAR_PRINT("Merged Requests \t: LC %d, TC %d, IR %d\n", LoadCellTask::Inst().GetMergedCommandCount(),
+			ThermocoupleTask::Inst().GetMergedCommandCount(), IRTask::Inst().GetMergedCommandCount());
+		UARTBurstStats burstStats;
+		UARTTask::Inst().GetBurstStats(burstStats);
+		SOAR_PRINT("UART Bursts         \t: %u, %u messages, %u transmits saved, avg %u max %u bytes, %u ms in transmit, %u dropped\n\n",
+			burstStats.burstCount, burstStats.messageCount, burstStats.messageCount - burstStats.burstCount,
+			(burstStats.burstCount != 0) ? burstStats.byteCount / burstStats.burstCount : 0,
+			burstStats.maxBurstBytes, TICKS_TO_MS(burstStats.transmitTicks), burstStats.droppedCount);
+	}
+	else if (strcmp(msg, "uartinfo") == 0) {
+		// Print UART link statistics
+		SOAR_PRINT("\n\t-- UART Link Info --\n");
+		PrintLinkStats("Protocol", UART::Protocol);
+		PrintLinkStats("Debug", UART::Debug);
+	}
+	else if (strcmp(msg, "uartreset") == 0) {
+		// Clear UART link statistics
+		UART::Protocol->ResetLinkStats();
+		UART::Debug->ResetLinkStats();
+		SOAR_PRINT("UART link statistics cleared\n");
+	}
+	else if (strcmp(msg, "poolinfo") == 0) {
+		// Print command payload pool usage
+		SOAR_PRINT("\n\t-- Command Pool Info --\n");
+		CommandPool::PrintStats();
+
+		CommandSlotStats slotStats;
+		CompactCommand::GetSlotStats(slotStats);
+		SOAR_PRINT("Command slots\t: %d/%d used, high water %d, exhausted %d\n",
+			slotStats.inUse, slotStats.capacity, slotStats.highWater, slotStats.exhaustionCount);
+	}
+	else if (strcmp(msg, "queueinfo") == 0) {
+		// Print event queue backpressure statistics
+		SOAR_PRINT("\n\t-- Queue Info --\n");
+		PrintQueueStats("UART", UARTTask::Inst().GetEventQueue());
+		PrintQueueStats("Telemetry", TelemetryTask::Inst().GetEventQueue());
+		PrintQueueStats("Flight", FlightTask::Inst().GetEventQueue());
+		PrintQueueStats("LoadCell", LoadCellTask::Inst().GetEventQueue());
+		PrintQueueStats("Thermocouple", ThermocoupleTask::Inst().GetEventQueue());
+		PrintQueueStats("IR", IRTask::Inst().GetEventQueue());
+	}
+	else if (strcmp(msg, "samples") == 0) {
+		// Print the published sensor samples without a request round-trip
+		SOAR_PRINT("\n\t-- Sensor Samples --\n");
+		LoadCellSample lcHistory[LOADCELL_TASK_SAMPLE_HISTORY_DEPTH];
+		uint16_t count = LoadCellTask::Inst().GetSampleTopic().GetHistory(lcHistory, LOADCELL_TASK_SAMPLE_HISTORY_DEPTH);
+		for (uint16_t i = 0; i < count; i++)
+			SOAR_PRINT("Load Cell @%d ms\t: %.3f grams\n", lcHistory[i].timestamp_ms, lcHistory[i].weight_g);
+
+		uint32_t seq;
+		ThermocoupleSample tcSample;
+		if (ThermocoupleTask::Inst().GetSampleTopic().GetLatest(tcSample, seq))
+			SOAR_PRINT("Thermocouple #%d @%d ms\t: TC1 %d, TC2 %d (C x100)\n", seq, tcSample.timestamp_ms, tcSample.tc1_temp, tcSample.tc2_temp);
+
+		IRSample irSample;
+		if (IRTask::Inst().GetSampleTopic().GetLatest(irSample, seq))
+			SOAR_PRINT("IR #%d @%d ms\t: Object %d, Ambient %d (C x100)\n\n", seq, irSample.timestamp,
+				static_cast<int>(irSample.object_temp * 100), static_cast<int>(irSample.ambient_temp * 100));
 	}
 	else if (strcmp(msg, "tct") == 0) {
-		SOAR_PRINT("Debug 'Thermocouple' Sampling Temperature Reading");
-		ThermocoupleTask::Inst().SendCommand(Command(REQUEST_COMMAND, THERMOCOUPLE_REQUEST_NEW_SAMPLE));
-		ThermocoupleTask::Inst().SendCommand(Command(REQUEST_COMMAND, THERMOCOUPLE_REQUEST_DEBUG));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'Thermocouple' Sampling Temperature Reading");
+		ThermocoupleTask::Inst().Post<ThermocoupleNewSampleMessage>();
+		ThermocoupleTask::Inst().Post<ThermocoupleDebugMessage>();
 	}
 	else if (strcmp(msg, "IRTemp") == 0) {
 		// Debug command for ir temp
-		SOAR_PRINT("Debug 'IRTemp sample and read' command requested\n");
-		IRTask::Inst().SendCommand(Command(REQUEST_COMMAND, IR_REQUEST_NEW_SAMPLE));
-		IRTask::Inst().SendCommand(Command(REQUEST_COMMAND, IR_REQUEST_DEBUG));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'IRTemp sample and read' command requested\n");
+		IRTask::Inst().Post<IRNewSampleMessage>();
+		IRTask::Inst().Post<IRDebugMessage>();
 	}
 	else if (strcmp(msg, "irtemp") == 0)
 	{
-		SOAR_PRINT("Debug 'IRTemp sample and read' command requested\n");
-		IRTask::Inst().SendCommand(Command(REQUEST_COMMAND, IR_REQUEST_NEW_SAMPLE));
-		IRTask::Inst().SendCommand(Command(REQUEST_COMMAND, IR_REQUEST_DEBUG));
+		SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_DEBUG, "Debug 'IRTemp sample and read' command requested\n");
+		IRTask::Inst().Post<IRNewSampleMessage>();
+		IRTask::Inst().Post<IRDebugMessage>();
 	}
 	else if (strcmp(msg, "timestamp") == 0)
 	{
@@ -167,14 +234,10 @@ void DebugTask::HandleDebugMessage(const char* msg)
 		// Single character command, or unknown command
 		switch (msg[0]) {
 		default:
-			SOAR_PRINT("Debug, unknown command: %s\n", msg);
+			SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_DEBUG, "Debug, unknown command: %s\n", msg);
 			break;
 		}
 	}
-
-	//We've read the data, clear the buffer
-	debugMsgIdx = 0;
-	isDebugMsgReady = false;
 }
 
 /**
@@ -186,36 +249,21 @@ bool DebugTask::ReceiveData()
 }
 
 /**
- * @brief Receive data to the buffer
- * @return Whether the debugBuffer is ready or not
+ * @brief Receive interrupt callback, pushes the byte into the receive ring and wakes the task at the end of a line
+ * @param errors UART receive errors
  */
 void DebugTask::InterruptRxData(uint8_t errors)
 {
-	// If we already have an unprocessed debug message, ignore this byte
-	if (!isDebugMsgReady) {
-		// Check byte for end of message - note if using termite you must turn on append CR
-		if (debugRxChar == '\r' || debugMsgIdx == DEBUG_RX_BUFFER_SZ_BYTES) {
-			// Null terminate and process
-			debugBuffer[debugMsgIdx++] = '\0';
-			isDebugMsgReady = true;
-
-			// Notify the debug task
-			Command cm(DATA_COMMAND, EVENT_DEBUG_RX_COMPLETE);
-			bool res = qEvtQueue->SendFromISR(cm);
-
-			// If we failed to send the event, we should reset the buffer, that way DebugTask doesn't stall
-			if (res == false) {
-				debugMsgIdx = 0;
-				isDebugMsgReady = false;
-			}
-		}
-		else {
-			debugBuffer[debugMsgIdx++] = debugRxChar;
-		}
-	}
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	// Wake the task on a line ending, or early if the ring is filling up during a burst
+	if (rxRing.Push(debugRxChar))
+		NotifyFromISR(DEBUG_EVENT_RX_LINE, &xHigherPriorityTaskWoken);
 
 	//Re-arm the interrupt
 	ReceiveData();
+
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 /* Helper Functions --------------------------------------------------------------*/
@@ -229,15 +277,98 @@ int32_t DebugTask::ExtractIntParameter(const char* msg, uint16_t identifierLen)
 {
 	// Handle a command with an int parameter at the end
 	if (static_cast<uint16_t>(strlen(msg)) < identifierLen+1) {
-		SOAR_PRINT("Int parameter command insufficient length\r\n");
+		SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_DEBUG, "Int parameter command insufficient length\r\n");
         return ERRVAL;
 	}
     
 	// Extract the value and attempt conversion to integer
 	const int32_t val = Utils::stringToLong(&msg[identifierLen]);
 	if (val == ERRVAL) {
-		SOAR_PRINT("Int parameter command invalid value\r\n");
+		SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_DEBUG, "Int parameter command invalid value\r\n");
 	}
 
 	return val;
 }
+
+/**
+ * @brief Prints the link statistics of a UART
+ * @param name UART name to print
+ * @param uart UART driver
+ */
+static void PrintLinkStats(const char* name, const UARTDriver* uart)
+{
+	UARTLinkStats stats;
+	uart->GetLinkStats(stats);
+	SOAR_PRINT("%-8s\t: rx %u, tx %u bytes, tx busy %u ms\n", name, stats.rxBytes, stats.txBytes, TICKS_TO_MS(stats.txBusyTicks));
+	SOAR_PRINT("\t\t  errors ORE %u, NE %u, FE %u, PE %u\n", stats.overrunErrors, stats.noiseErrors,
+		stats.framingErrors, stats.parityErrors);
+	SOAR_PRINT("\t\t  %u interrupts, longest %u us\n", stats.isrCount, stats.maxIsrCycles / (SystemCoreClock / 1000000));
+}
+
+/**
+ * @brief Prints the send statistics of a task event queue
+ * @param name Task name to print
+ * @param queue Event queue of the task
+ */
+static void PrintQueueStats(const char* name, const Queue* queue)
+{
+	QueueStats stats;
+	queue->GetStats(stats);
+	SOAR_PRINT("%-12s\t: high water %d/%d, sent %d, dropped %d, blocked %d ms\n", name, stats.highWater,
+		queue->GetQueueDepth(), stats.sendCount, stats.dropCount, TICKS_TO_MS(stats.blockedTicks));
+}
+
+/**
+ * @brief Handles the loglevel command, lists every module threshold if no arguments are given
+ * @param args Arguments after "loglevel", "<module|all> <level>" or empty
+ */
+static void HandleLogLevelCommand(const char* args)
+{
+	// Split "<module> <level>" in place, the module ends at the space before the level
+	const char* moduleName = (*args == ' ') ? args + 1 : args;
+	const char* levelName = strchr(moduleName, ' ');
+
+	if (levelName == nullptr || levelName == moduleName) {
+		SOAR_PRINT("\n\t-- Log Levels --\n");
+		for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+			const LOG_MODULE module = static_cast<LOG_MODULE>(i);
+			SOAR_PRINT("%-12s\t: %s (compiled %s)\n", LogLevel::GetModuleName(module),
+				LogLevel::GetLevelName(LogLevel::Get(module)), LogLevel::GetLevelName(LOG_COMPILE_LEVELS[module]));
+		}
+		SOAR_PRINT("Usage: loglevel <module|all> <off|error|warn|info|debug|verbose|0-5>\n\n");
+		return;
+	}
+	const uint16_t moduleLen = levelName - moduleName;
+	levelName++;
+
+	// Levels are accepted by name or by number
+	LOG_LEVEL level;
+	const int32_t levelNum = Utils::stringToLong(levelName);
+	if (*levelName != '\0' && levelNum != ERRVAL && levelNum < LOG_LEVEL_COUNT) {
+		level = static_cast<LOG_LEVEL>(levelNum);
+	}
+	else if (!LogLevel::ParseLevel(levelName, level)) {
+		SOAR_PRINT("Debug, unknown log level: %s\n", levelName);
+		return;
+	}
+
+	if (moduleLen == 3 && strncmp(moduleName, "all", 3) == 0) {
+		for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++)
+			LogLevel::Set(static_cast<LOG_MODULE>(i), level);
+		SOAR_PRINT("Log level of all modules set to %s\n", LogLevel::GetLevelName(level));
+		return;
+	}
+
+	for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+		const LOG_MODULE module = static_cast<LOG_MODULE>(i);
+		const char* name = LogLevel::GetModuleName(module);
+		if (strlen(name) != moduleLen || strncmp(moduleName, name, moduleLen) != 0)
+			continue;
+
+		// Statements compiled out can not be enabled, the threshold is clamped
+		SOAR_PRINT("Log level of %s set to %s\n", name, LogLevel::GetLevelName(LogLevel::Set(module, level)));
+		return;
+	}
+
+	SOAR_PRINT("Debug, unknown log module: %.*s\n", moduleLen, moduleName);
+}
@@ -0,0 +1,121 @@
+/**
+ ******************************************************************************
+ * File Name          : BinaryLog.hpp
+ * Description        : BinaryLog is a deferred logger, it records the address of the
+ *    format string, a timestamp and the raw arguments instead of formatting text.
+ *    The records are rendered on the host by SoarDebug/Tools/binary_log_decoder.py using the
+ *    strings in the firmware ELF.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_DEBUG_BINARY_LOG_H
+#define AVIONICS_INCLUDE_SOAR_DEBUG_BINARY_LOG_H
+/* Includes ------------------------------------------------------------------*/
+#include <cstring>
+#include <type_traits>
+
+#include "cmsis_os.h"
+#include "main_avionics.hpp"
+#include "LogLevel.hpp"
+
+/* Macros --------------------------------------------------------------------*/
+// SOAR_LOG macro, records a deferred log message for hot paths, see BinaryLog below. Filtered by level
+// and module and rate limited like SOAR_PRINT_LEVEL, a disabled statement does not evaluate its arguments
+// Example Usage: SOAR_LOG(LOG_LEVEL_DEBUG, LOG_MODULE_IR, "Object Temp: %d\n", temp);
+#define SOAR_LOG(level, module, str, ...) \
+    do { \
+        if constexpr (LogLevel::IsCompiled(level, module)) { \
+            if (LogLevel::IsEnabled(level, module) && LogLimiter::Allow(str, true)) \
+                BinaryLog::Write(str, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+/* Constants -----------------------------------------------------------------*/
+constexpr bool BINARY_LOG_ENABLED = true;               // Record SOAR_LOG messages in binary, false prints them as text like SOAR_PRINT
+constexpr uint16_t BINARY_LOG_RING_RECORDS = 32;        // Number of records in the ring, must be a power of 2
+constexpr uint8_t BINARY_LOG_MAX_ARGS = 6;              // Max number of arguments in one record
+constexpr uint8_t BINARY_LOG_RECORD_HEADER_BYTES = 10;  // Sync, argument count, format address and timestamp
+constexpr uint8_t BINARY_LOG_RECORD_MAX_BYTES = BINARY_LOG_RECORD_HEADER_BYTES + BINARY_LOG_MAX_ARGS * sizeof(uint32_t);    // Largest record on the wire
+constexpr uint16_t BINARY_LOG_DRAIN_PERIOD_MS = 20;     // Max time records wait in the ring before the UARTTask drains them
+constexpr uint16_t BINARY_LOG_DRAIN_BUFFER_BYTES = 128; // Size of the UARTTask buffer records are encoded into for transmission
+constexpr uint8_t BINARY_LOG_SYNC_BYTE = 0xA5;          // Starts every record, not printable ASCII so text prints can share the UART
+
+static_assert((BINARY_LOG_RING_RECORDS & (BINARY_LOG_RING_RECORDS - 1)) == 0, "BINARY_LOG_RING_RECORDS must be a power of 2");
+
+/* Structs -----------------------------------------------------------------*/
+struct BinaryLogRecord
+{
+    uint32_t formatAddress;                     // Address of the format string in flash, the string ID
+    uint32_t timestamp_ms;                      // Time the record was written
+    uint8_t argCount;                           // Number of valid words in args
+    uint32_t args[BINARY_LOG_MAX_ARGS];         // Raw arguments, integers and pointers as-is, floats as float bits
+};
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief BinaryLog is a lock-free multi-producer ring of log records drained by the UARTTask
+ *
+ * Usage:
+ *  - SOAR_LOG(level, module, format, args...) in place of SOAR_PRINT on hot paths, the format must be a string literal and
+ *    every argument an integer, enum, float or pointer (%s arguments must point to constant strings)
+ *  - The UARTTask calls Drain() and transmits the encoded records over the debug UART
+ *
+ * Each record on the wire is [BINARY_LOG_SYNC_BYTE][argCount][formatAddress][timestamp_ms][args...], all
+ * little endian. Writing never blocks and never formats, a full ring drops the record and counts it.
+ * Safe to call from tasks and ISRs.
+*/
+class BinaryLog
+{
+public:
+    /**
+     * @brief Records a log message, or prints it as text if BINARY_LOG_ENABLED is false
+     * @param format printf style format string literal
+     * @param args Arguments, at most BINARY_LOG_MAX_ARGS
+    */
+    template <typename... TArgs>
+    static void Write(const char* format, TArgs... args)
+    {
+        static_assert(sizeof...(TArgs) <= BINARY_LOG_MAX_ARGS, "BinaryLog - too many arguments");
+
+        if constexpr (!BINARY_LOG_ENABLED) {
+            print(format, args...);
+        }
+        else {
+            const uint32_t words[sizeof...(TArgs) + 1] = { ToWord(args)... };
+            Push(format, words, sizeof...(TArgs));
+        }
+    }
+
+    static uint16_t Drain(uint8_t* buffer, uint16_t size);    // Encodes pending records into buffer, returns the number of bytes written
+
+    static uint32_t GetDroppedCount();    // Number of records dropped because the ring was full
+
+private:
+    static void Push(const char* format, const uint32_t* args, uint8_t argCount);
+
+    /**
+     * @brief Converts an argument to its raw record word
+     * @param arg Argument to convert
+     * @return Raw word, floats are narrowed to float and stored as their bits
+    */
+    template <typename T>
+    static uint32_t ToWord(T arg)
+    {
+        if constexpr (std::is_floating_point<T>::value) {
+            const float f = static_cast<float>(arg);
+            uint32_t word;
+            memcpy(&word, &f, sizeof(word));
+            return word;
+        }
+        else if constexpr (std::is_pointer<T>::value) {
+            return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arg));
+        }
+        else {
+            static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                "BinaryLog - arguments must be integers, enums, floats or pointers");
+            return static_cast<uint32_t>(arg);
+        }
+    }
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_DEBUG_BINARY_LOG_H */
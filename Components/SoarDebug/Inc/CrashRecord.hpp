@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * File Name          : CrashRecord.hpp
+ * Description        : CrashRecord keeps the details of a failed assert in no-init
+ *    CCMRAM across the reset, so they can be printed at the next boot.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_DEBUG_CRASH_RECORD_H
+#define AVIONICS_INCLUDE_SOAR_DEBUG_CRASH_RECORD_H
+/* Includes ------------------------------------------------------------------*/
+#include <cstdarg>
+
+#include "cmsis_os.h"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr uint32_t CRASH_RECORD_MAGIC = 0x43525348;        // "CRSH", marks a written record
+constexpr uint8_t CRASH_RECORD_FILE_BYTES = 40;             // Max length of the file name, the end of the path is kept
+constexpr uint8_t CRASH_RECORD_TASK_BYTES = 16;             // Max length of the task name
+constexpr uint8_t CRASH_RECORD_MESSAGE_BYTES = 96;          // Max length of the formatted assert message
+
+/* Structs -----------------------------------------------------------------*/
+struct CrashRecordData
+{
+    uint32_t magic;                                 // CRASH_RECORD_MAGIC if the record was written
+    uint32_t timestamp_ms;                          // Time since scheduler start of the crash
+    uint32_t stackPointer;                          // Stack pointer in the asserting function
+    uint32_t freeHeapBytes;                         // Free heap at the crash
+    uint32_t minEverFreeHeapBytes;                  // Lowest free heap before the crash
+    uint16_t line;                                  // Line of the assert
+    char file[CRASH_RECORD_FILE_BYTES];             // Source file of the assert
+    char task[CRASH_RECORD_TASK_BYTES];             // Running task, "ISR" or "None" before the scheduler starts
+    char message[CRASH_RECORD_MESSAGE_BYTES];       // Formatted assert message, empty if none was given
+    uint16_t crc;                                   // CRC16 of every field above, rejects a partly written record
+};
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief CrashRecord stores one crash record in memory the startup code does not clear
+ *
+ * Usage:
+ *  - soar_assert_debug() calls Save() before it resets the system
+ *  - run_main() calls Init() at boot, which reads the reset reason and takes the saved record, then
+ *    PrintLast() prints both through the normal print path
+ *
+ * Save() does not allocate, lock or use the UART, so the record is kept even if the assert output fails.
+*/
+class CrashRecord
+{
+public:
+    static void Save(const char* file, uint16_t line, const char* format, va_list args);
+
+    static void Init();                 // Call once at boot, before anything can assert
+    static void PrintLast();            // Prints the reset reason and the last crash record, if any
+
+    static const char* GetResetReason() { return resetReason; }
+    static const CrashRecordData* GetLast() { return hasLast ? &last : nullptr; }
+
+private:
+    static const char* ReadResetReason();
+
+    static CrashRecordData last;        // Record taken from no-init memory at boot
+    static bool hasLast;
+    static const char* resetReason;
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_DEBUG_CRASH_RECORD_H */
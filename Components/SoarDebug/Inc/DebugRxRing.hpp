@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ * File Name          : DebugRxRing.hpp
+ * Description        : DebugRxRing carries debug UART input from the receive
+ *    interrupt to the DebugTask and assembles it into command lines.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_DEBUG_RX_RING_H
+#define AVIONICS_INCLUDE_SOAR_DEBUG_RX_RING_H
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+#include "etl/queue_spsc_atomic.h"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr uint16_t DEBUG_RX_BUFFER_SZ_BYTES = 48;		// Longest line handled as one command, the longest command is "loglevel thermocouple verbose" (29)
+// The ring is sized for a pasted batch of commands: 8 lines of up to 30 characters ("loglevel thermocouple verbose\r")
+// is 240 bytes, ~21ms of input at 115200 baud. The task is woken at each line ending or after 64 bytes, and with
+// every task at priority 2 it may wait behind the other ready tasks for a few 1ms time slices, so 192 bytes
+// (~17ms of input) of slack remain after the wake point.
+constexpr uint16_t DEBUG_RX_RING_SZ_BYTES = 256;		// ISR to task byte ring
+constexpr uint16_t DEBUG_RX_RING_WAKE_BYTES = 64;		// Wake the task early if this many bytes are pending without a line ending
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief DebugRxRing is a single producer (receive ISR), single consumer (DebugTask) byte ring with the line
+ *        being assembled on the task side
+ *
+ * Usage:
+ *  - The receive interrupt calls Push() for every byte and wakes the task if it returns true
+ *  - The task calls Process() when woken, the handler gets every complete line without its '\r'
+ *
+ * A line longer than DEBUG_RX_BUFFER_SZ_BYTES is handed over in pieces of DEBUG_RX_BUFFER_SZ_BYTES, no byte
+ * is lost. Bytes are only dropped, and counted, if the ring itself is full.
+*/
+class DebugRxRing
+{
+public:
+    DebugRxRing();
+
+    bool Push(uint8_t c);    // Called from the receive ISR, true if the task should be woken
+
+    /**
+     * @brief Drains the ring into the line buffer, handling each complete line, called from the task
+     * @param handler Called with each null terminated line, eg. [this](const char* line) { HandleDebugMessage(line); }
+    */
+    template <typename THandler>
+    void Process(THandler&& handler)
+    {
+        uint8_t c;
+        while (ring.pop(c)) {
+            // Check byte for end of message - note if using termite you must turn on append CR
+            if (c == '\r') {
+                HandleLine(handler);
+                continue;
+            }
+
+            // Line is too long, process what we have and start a new line with this byte
+            if (lineIdx == DEBUG_RX_BUFFER_SZ_BYTES)
+                HandleLine(handler);
+
+            line[lineIdx++] = c;
+        }
+    }
+
+    uint32_t GetOverflowCount() const { return statOverflowCount; }
+
+private:
+    template <typename THandler>
+    void HandleLine(THandler& handler)
+    {
+        line[lineIdx] = '\0';
+        handler((const char*)line);
+        lineIdx = 0;
+    }
+
+    uint8_t line[DEBUG_RX_BUFFER_SZ_BYTES + 1];    // Line being assembled, only touched by the task
+    uint8_t lineIdx;
+    etl::queue_spsc_atomic<uint8_t, DEBUG_RX_RING_SZ_BYTES, etl::memory_model::MEMORY_MODEL_MEDIUM> ring;
+    uint32_t statOverflowCount;                     // Number of bytes dropped because the ring was full
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_DEBUG_RX_RING_H */
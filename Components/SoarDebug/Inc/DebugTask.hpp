@@ -10,18 +10,13 @@
 #include "Task.hpp"
 #include "SystemDefines.hpp"
 #include "UARTDriver.hpp"
-
-/* Enums ------------------------------------------------------------------*/
-enum DEBUG_TASK_COMMANDS {
-	DEBUG_TASK_COMMAND_NONE = 0,
-	EVENT_DEBUG_RX_COMPLETE
-};
+#include "DebugRxRing.hpp"
 
 /* Macros ------------------------------------------------------------------*/
-constexpr uint16_t DEBUG_RX_BUFFER_SZ_BYTES = 16;
+constexpr uint32_t DEBUG_EVENT_RX_LINE = (1UL << 0);		// A line ending was received or the receive ring is filling up
 
 /* Class ------------------------------------------------------------------*/
-class DebugTask : public Task, public UARTReceiverBase
+class DebugTask : public StaticTask<TASK_DEBUG_STACK_DEPTH_WORDS, 0>, public UARTReceiverBase	// Driven by the receive interrupt only, no event queue
 {
 public:
 	static DebugTask& Inst() {
@@ -49,11 +44,8 @@ protected:
 	static int32_t ExtractIntParameter(const char* msg, uint16_t identifierLen);
 	
 	// Member variables
-	uint8_t debugBuffer[DEBUG_RX_BUFFER_SZ_BYTES+1];
-	uint8_t debugMsgIdx;
-	bool isDebugMsgReady;
-
 	uint8_t debugRxChar; // Character received from UART Interrupt
+	DebugRxRing rxRing;	// Receive ISR to task bytes, assembled into lines by the task
 
     UARTDriver* const kUart_; // UART Driver
 
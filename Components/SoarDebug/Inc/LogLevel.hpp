@@ -0,0 +1,120 @@
+/**
+ ******************************************************************************
+ * File Name          : LogLevel.hpp
+ * Description        : Log severity levels and modules. Every leveled log statement is
+ *    checked against a compile-time threshold for its module, statements above it compile
+ *    to nothing, and against a runtime threshold that can be changed from the debug console.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_DEBUG_LOG_LEVEL_H
+#define AVIONICS_INCLUDE_SOAR_DEBUG_LOG_LEVEL_H
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+
+#include "cmsis_os.h"
+#include "main_avionics.hpp"
+#include "LogLimiter.hpp"
+
+/* Enums -----------------------------------------------------------------*/
+enum LOG_LEVEL : uint8_t
+{
+    LOG_LEVEL_OFF = 0,      // Threshold only, disables every statement of the module
+    LOG_LEVEL_ERROR,        // Faults the system can not recover from by itself
+    LOG_LEVEL_WARN,         // Unexpected conditions, dropped or unsupported commands
+    LOG_LEVEL_INFO,         // State changes and command acknowledgements
+    LOG_LEVEL_DEBUG,        // Sensor readings and periodic status
+    LOG_LEVEL_VERBOSE,      // Per-sample and per-cycle detail
+    LOG_LEVEL_COUNT
+};
+
+enum LOG_MODULE : uint8_t
+{
+    LOG_MODULE_SYSTEM = 0,      // Startup, core and anything without a module of its own
+    LOG_MODULE_FLIGHT,
+    LOG_MODULE_TELEMETRY,
+    LOG_MODULE_LOADCELL,
+    LOG_MODULE_THERMOCOUPLE,
+    LOG_MODULE_IR,
+    LOG_MODULE_UART,
+    LOG_MODULE_DEBUG,
+    LOG_MODULE_PROTOCOL,
+    LOG_MODULE_COUNT
+};
+
+/* Constants -----------------------------------------------------------------*/
+// Define LOG_PRODUCTION_BUILD in the build configuration for static-fire builds, only warnings and errors are compiled in
+#ifdef LOG_PRODUCTION_BUILD
+constexpr LOG_LEVEL LOG_COMPILE_LEVEL_DEFAULT = LOG_LEVEL_WARN;
+#else
+constexpr LOG_LEVEL LOG_COMPILE_LEVEL_DEFAULT = LOG_LEVEL_VERBOSE;
+#endif
+
+// Compile-time threshold of each module, in LOG_MODULE order, statements with a higher level compile to nothing
+constexpr LOG_LEVEL LOG_COMPILE_LEVELS[LOG_MODULE_COUNT] = {
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_SYSTEM
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_FLIGHT
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_TELEMETRY
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_LOADCELL
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_THERMOCOUPLE
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_IR
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_UART
+    LOG_COMPILE_LEVEL_DEFAULT,      // LOG_MODULE_DEBUG
+    LOG_COMPILE_LEVEL_DEFAULT       // LOG_MODULE_PROTOCOL
+};
+
+/* Macros --------------------------------------------------------------------*/
+// SOAR_PRINT_LEVEL macro, SOAR_PRINT for a log statement with a level and module, the arguments are
+// not evaluated if the statement is disabled at compile-time or at runtime, or rate limited by LogLimiter
+// Example Usage: SOAR_PRINT_LEVEL(LOG_LEVEL_WARN, LOG_MODULE_LOADCELL, "Load Cell offset %d\n", offset);
+#define SOAR_PRINT_LEVEL(level, module, str, ...) \
+    do { \
+        if constexpr (LogLevel::IsCompiled(level, module)) { \
+            if (LogLevel::IsEnabled(level, module) && LogLimiter::Allow(str, false)) \
+                print(str, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief LogLevel holds the runtime threshold of each module
+ *
+ * A statement is printed if its level is at most both the compile-time threshold in LOG_COMPILE_LEVELS
+ * and the runtime threshold of its module. The runtime thresholds start at the compile-time thresholds
+ * and can only disable statements, statements that were compiled out can not be enabled at runtime.
+*/
+class LogLevel
+{
+public:
+    /**
+     * @brief Checks if statements of a level are compiled in for a module
+     * @return true if the statement is compiled in
+    */
+    static constexpr bool IsCompiled(LOG_LEVEL level, LOG_MODULE module)
+    {
+        return level != LOG_LEVEL_OFF && level <= LOG_COMPILE_LEVELS[module];
+    }
+
+    /**
+     * @brief Checks the runtime threshold of a module, call after IsCompiled()
+     * @return true if the statement should be printed
+    */
+    static bool IsEnabled(LOG_LEVEL level, LOG_MODULE module)
+    {
+        return level <= levels[module].load(std::memory_order_relaxed);
+    }
+
+    static LOG_LEVEL Set(LOG_MODULE module, LOG_LEVEL level);    // Sets the runtime threshold, returns the effective threshold
+    static LOG_LEVEL Get(LOG_MODULE module);
+
+    // Console names, eg. "thermocouple" and "debug"
+    static const char* GetModuleName(LOG_MODULE module);
+    static const char* GetLevelName(LOG_LEVEL level);
+    static bool ParseModule(const char* name, LOG_MODULE& module);
+    static bool ParseLevel(const char* name, LOG_LEVEL& level);
+
+private:
+    static std::atomic<uint8_t> levels[LOG_MODULE_COUNT];
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_DEBUG_LOG_LEVEL_H */
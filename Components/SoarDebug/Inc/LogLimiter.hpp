@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * File Name          : LogLimiter.hpp
+ * Description        : LogLimiter rate limits each leveled log call site, so a statement
+ *    repeating every cycle (eg. a disconnected sensor) can not saturate the debug UART.
+ ******************************************************************************
+*/
+#ifndef AVIONICS_INCLUDE_SOAR_DEBUG_LOG_LIMITER_H
+#define AVIONICS_INCLUDE_SOAR_DEBUG_LOG_LIMITER_H
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+/* Constants -----------------------------------------------------------------*/
+constexpr bool LOG_LIMIT_ENABLED = true;                // Rate limit SOAR_PRINT_LEVEL and SOAR_LOG statements
+constexpr uint16_t LOG_LIMIT_WINDOW_MS = 1000;          // Length of one rate limit window
+constexpr uint8_t LOG_LIMIT_BURST = 4;                  // Messages each call site may print per window, the rest are counted
+constexpr uint8_t LOG_LIMIT_TABLE_SIZE = 32;            // Number of call sites tracked at once, must be a power of 2
+constexpr uint8_t LOG_LIMIT_MAX_PROBES = 4;             // Slots searched per call site before the site is let through untracked
+
+static_assert((LOG_LIMIT_TABLE_SIZE & (LOG_LIMIT_TABLE_SIZE - 1)) == 0, "LOG_LIMIT_TABLE_SIZE must be a power of 2");
+
+/* Class -----------------------------------------------------------------*/
+
+/**
+ * @brief LogLimiter tracks call sites by the address of their format string in a bounded hash table
+ *
+ * Each call site may print LOG_LIMIT_BURST messages per LOG_LIMIT_WINDOW_MS. Further messages in the window
+ * are suppressed and counted, the next message after the window is preceded by a
+ * "[N repeats suppressed]" line. If the table is full around a call site, the site is not limited.
+ *
+ * Safe to call from tasks and ISRs, the table is updated in a short critical section.
+*/
+class LogLimiter
+{
+public:
+    /**
+     * @brief Checks if a statement may print, called by SOAR_PRINT_LEVEL and SOAR_LOG after the level check
+     * @param format Format string of the statement, its address identifies the call site
+     * @param binary true if the statement is a SOAR_LOG, the suppressed summary is written the same way
+     * @return true if the statement should print
+    */
+    static bool Allow(const char* format, bool binary)
+    {
+        if constexpr (!LOG_LIMIT_ENABLED)
+            return true;
+        return Check(format, binary);
+    }
+
+    static uint32_t GetSuppressedCount();    // Number of messages suppressed since boot
+
+private:
+    static bool Check(const char* format, bool binary);
+};
+
+#endif /* AVIONICS_INCLUDE_SOAR_DEBUG_LOG_LIMITER_H */
@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ * File Name          : LogLevel.cpp
+ * Description        : Runtime log thresholds and their debug console names.
+ ******************************************************************************
+*/
+#include "LogLevel.hpp"
+
+#include <cstring>     // Support for strcmp
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    // Console names, in enum order
+    const char* const MODULE_NAMES[LOG_MODULE_COUNT] = {
+        "system", "flight", "telemetry", "loadcell", "thermocouple", "ir", "uart", "debug", "protocol"
+    };
+    const char* const LEVEL_NAMES[LOG_LEVEL_COUNT] = {
+        "off", "error", "warn", "info", "debug", "verbose"
+    };
+}
+
+// Constant initialized, the thresholds are valid before any constructor runs
+std::atomic<uint8_t> LogLevel::levels[LOG_MODULE_COUNT] = {
+    LOG_COMPILE_LEVELS[LOG_MODULE_SYSTEM],
+    LOG_COMPILE_LEVELS[LOG_MODULE_FLIGHT],
+    LOG_COMPILE_LEVELS[LOG_MODULE_TELEMETRY],
+    LOG_COMPILE_LEVELS[LOG_MODULE_LOADCELL],
+    LOG_COMPILE_LEVELS[LOG_MODULE_THERMOCOUPLE],
+    LOG_COMPILE_LEVELS[LOG_MODULE_IR],
+    LOG_COMPILE_LEVELS[LOG_MODULE_UART],
+    LOG_COMPILE_LEVELS[LOG_MODULE_DEBUG],
+    LOG_COMPILE_LEVELS[LOG_MODULE_PROTOCOL]
+};
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Sets the runtime threshold of a module, clamped to its compile-time threshold
+ * @param module Module to set
+ * @param level Highest level to print, LOG_LEVEL_OFF disables the module
+ * @return The threshold that was set
+*/
+LOG_LEVEL LogLevel::Set(LOG_MODULE module, LOG_LEVEL level)
+{
+    if (level > LOG_COMPILE_LEVELS[module])
+        level = LOG_COMPILE_LEVELS[module];
+
+    levels[module].store(level, std::memory_order_relaxed);
+    return level;
+}
+
+/**
+ * @brief Gets the runtime threshold of a module
+ * @param module Module to get
+ * @return Highest level that is printed
+*/
+LOG_LEVEL LogLevel::Get(LOG_MODULE module)
+{
+    return static_cast<LOG_LEVEL>(levels[module].load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Gets the console name of a module
+ * @param module Module to name
+ * @return Module name, "?" if the module is invalid
+*/
+const char* LogLevel::GetModuleName(LOG_MODULE module)
+{
+    return (module < LOG_MODULE_COUNT) ? MODULE_NAMES[module] : "?";
+}
+
+/**
+ * @brief Gets the console name of a level
+ * @param level Level to name
+ * @return Level name, "?" if the level is invalid
+*/
+const char* LogLevel::GetLevelName(LOG_LEVEL level)
+{
+    return (level < LOG_LEVEL_COUNT) ? LEVEL_NAMES[level] : "?";
+}
+
+/**
+ * @brief Finds a module by its console name
+ * @param name Null terminated module name
+ * @param module Set to the module if found
+ * @return true if the name matched a module
+*/
+bool LogLevel::ParseModule(const char* name, LOG_MODULE& module)
+{
+    for (uint8_t i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (strcmp(name, MODULE_NAMES[i]) == 0) {
+            module = static_cast<LOG_MODULE>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Finds a level by its console name
+ * @param name Null terminated level name
+ * @param level Set to the level if found
+ * @return true if the name matched a level
+*/
+bool LogLevel::ParseLevel(const char* name, LOG_LEVEL& level)
+{
+    for (uint8_t i = 0; i < LOG_LEVEL_COUNT; i++) {
+        if (strcmp(name, LEVEL_NAMES[i]) == 0) {
+            level = static_cast<LOG_LEVEL>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,116 @@
+/**
+ ******************************************************************************
+ * File Name          : LogLimiter.cpp
+ * Description        : Implementation of the LogLimiter call site table.
+ *
+ * The table is open addressed on the format string address with a short linear
+ * probe, so a lookup touches at most LOG_LIMIT_MAX_PROBES entries inside the
+ * critical section. Entries are never removed, call sites are a fixed set.
+ ******************************************************************************
+*/
+#include "LogLimiter.hpp"
+#include "BinaryLog.hpp"
+#include "SystemDefines.hpp"
+
+#include <atomic>
+
+/* Structs -----------------------------------------------------------------*/
+struct LogLimiterEntry
+{
+    const char* format;         // Call site key, nullptr if the entry is free
+    uint32_t windowStart;       // Tick the current window started
+    uint16_t count;             // Messages printed in the current window
+    uint16_t suppressed;        // Messages suppressed in the current window
+};
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    LogLimiterEntry table[LOG_LIMIT_TABLE_SIZE];
+    std::atomic<uint32_t> suppressedCount;
+
+    /**
+     * @brief Gets the home slot of a call site, format strings are at least 4 byte apart in practice
+    */
+    uint8_t GetHomeSlot(const char* format)
+    {
+        const uint32_t address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format));
+        return (static_cast<uint32_t>((address >> 2) * 2654435761UL) >> 24) & (LOG_LIMIT_TABLE_SIZE - 1);
+    }
+}
+
+/* Function Implementation ------------------------------------------------------------------*/
+
+/**
+ * @brief Counts a message against its call site, prints the suppressed summary when a new window starts
+ * @param format Format string of the statement
+ * @param binary true to write the summary with BinaryLog, false to print it
+ * @return true if the statement should print
+*/
+bool LogLimiter::Check(const char* format, bool binary)
+{
+    const bool inIsr = xPortIsInsideInterrupt();
+    const uint32_t now = inIsr ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+    bool allow = true;
+    uint16_t reportSuppressed = 0;
+
+    UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+
+    const uint8_t home = GetHomeSlot(format);
+    for (uint8_t probe = 0; probe < LOG_LIMIT_MAX_PROBES; probe++) {
+        LogLimiterEntry& entry = table[(home + probe) & (LOG_LIMIT_TABLE_SIZE - 1)];
+
+        if (entry.format == nullptr) {
+            // First message from this call site
+            entry.format = format;
+            entry.windowStart = now;
+            entry.count = 1;
+            entry.suppressed = 0;
+            break;
+        }
+        if (entry.format != format)
+            continue;
+
+        // Start a new window, and report what the old window suppressed
+        if (now - entry.windowStart >= MS_TO_TICKS(LOG_LIMIT_WINDOW_MS)) {
+            reportSuppressed = entry.suppressed;
+            entry.windowStart = now;
+            entry.count = 0;
+            entry.suppressed = 0;
+        }
+
+        if (entry.count < LOG_LIMIT_BURST) {
+            entry.count++;
+        }
+        else {
+            if (entry.suppressed < UINT16_MAX)
+                entry.suppressed++;
+            allow = false;
+        }
+        break;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+    if (!allow) {
+        suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // The format is passed as an argument, it points to a constant string so BinaryLog can record it
+    if (reportSuppressed != 0) {
+        if (binary)
+            BinaryLog::Write("[%u repeats suppressed] %s", reportSuppressed, format);
+        else
+            print("[%u repeats suppressed] %s", reportSuppressed, format);
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the number of messages suppressed since boot
+ * @return Suppressed message count
+*/
+uint32_t LogLimiter::GetSuppressedCount()
+{
+    return suppressedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Decodes a debug UART capture containing BinaryLog records (see SoarDebug/Inc/BinaryLog.hpp).
+
+Text from SOAR_PRINT passes through unchanged. Each BinaryLog record is
+    [0xA5][argCount][formatAddress u32][timestamp_ms u32][args u32 x argCount]
+little endian, and is rendered using the format string found at formatAddress in
+the firmware ELF.
+
+Usage:
+    binary_log_decoder.py <firmware.elf> [capture.bin]
+    Reads the capture from stdin if no file is given, eg. cat /dev/ttyUSB0 | binary_log_decoder.py fw.elf
+"""
+import re
+import struct
+import sys
+
+SYNC_BYTE = 0xA5
+HEADER_BYTES = 10
+MAX_ARGS = 6
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+FORMAT_SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcsfFeEgGp%])")
+
+
+class ElfImage:
+    """Loaded sections of a 32-bit little endian ELF, addressable by target address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("expected a 32-bit little endian ELF")
+
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, sh_flags, sh_addr, sh_offset, sh_size) = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            if sh_flags & SHF_ALLOC and sh_type != SHT_NOBITS and sh_size > 0:
+                self.sections.append((sh_addr, data[sh_offset:sh_offset + sh_size]))
+
+    def read_string(self, address):
+        for base, contents in self.sections:
+            if base <= address < base + len(contents):
+                end = contents.find(b"\0", address - base)
+                return contents[address - base:end if end >= 0 else None].decode("ascii", errors="replace")
+        return None
+
+
+def render(elf, format_address, timestamp_ms, args):
+    fmt = elf.read_string(format_address)
+    if fmt is None:
+        return "[%10d ms] <unknown format 0x%08X> %s\n" % (timestamp_ms, format_address, " ".join("0x%08X" % a for a in args))
+
+    remaining = list(args)
+
+    def convert(match):
+        flags, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        if not remaining:
+            return "<missing>"
+        word = remaining.pop(0)
+
+        if conversion in "di":
+            return ("%" + flags + "d") % struct.unpack("<i", struct.pack("<I", word))[0]
+        if conversion in "ouxX":
+            return ("%" + flags + conversion) % word
+        if conversion == "c":
+            return chr(word & 0xFF)
+        if conversion in "fFeEgG":
+            return ("%" + flags + conversion) % struct.unpack("<f", struct.pack("<I", word))[0]
+        if conversion == "s":
+            string = elf.read_string(word)
+            return ("%" + flags + "s") % (string if string is not None else "<str 0x%08X>" % word)
+        return "0x%08X" % word
+
+    return "[%10d ms] %s" % (timestamp_ms, FORMAT_SPEC.sub(convert, fmt))
+
+
+def decode(elf, stream, out):
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+
+        while buffer:
+            sync = buffer.find(bytes([SYNC_BYTE]))
+            if sync != 0:
+                # Plain text up to the next record
+                text = buffer if sync < 0 else buffer[:sync]
+                out.write(text.decode("ascii", errors="replace"))
+                del buffer[:len(text)]
+                continue
+
+            if len(buffer) < 2:
+                break
+            arg_count = buffer[1]
+            if arg_count > MAX_ARGS:
+                # Not a record, a corrupted byte in the text
+                out.write("?")
+                del buffer[:1]
+                continue
+
+            record_size = HEADER_BYTES + 4 * arg_count
+            if len(buffer) < record_size:
+                break
+
+            format_address, timestamp_ms = struct.unpack_from("<II", buffer, 2)
+            args = struct.unpack_from("<%dI" % arg_count, buffer, HEADER_BYTES)
+            out.write(render(elf, format_address, timestamp_ms, args))
+            del buffer[:record_size]
+        out.flush()
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+
+    elf = ElfImage(sys.argv[1])
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "rb") as stream:
+            decode(elf, stream, sys.stdout)
+    else:
+        decode(elf, sys.stdin.buffer, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
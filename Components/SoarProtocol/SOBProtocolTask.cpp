@@ -29,6 +29,8 @@ void SOBProtocolTask::InitTask()
 
     //Ensure creation succeded
     SOAR_ASSERT(rtValue == pdPASS, "ProtocolTask::InitTask - xTaskCreate() failed");
+
+    BindTaskObject();
 }
 
 /**
@@ -57,25 +59,25 @@ void SOBProtocolTask::HandleProtobufCommandMessage(EmbeddedProto::ReadBufferFixe
     if (!msg.has_sob_command())
         return;
 
-    SOAR_PRINT("PROTO-INFO: Received SOB Command Message\n");
+    SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_PROTOCOL, "PROTO-INFO: Received SOB Command Message\n");
 
     // Process the SOB command
     switch (msg.get_sob_command().get_command_enum())
     {
     case Proto::SOBCommand::Command::SOB_TARE_LOAD_CELL: {
-        SOAR_PRINT("PROTO-INFO: Received SOB Tare Load Cell Command\n");
-        LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, (uint16_t)LOADCELL_REQUEST_TARE));
+        SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_PROTOCOL, "PROTO-INFO: Received SOB Tare Load Cell Command\n");
+        LoadCellTask::Inst().Post<LoadCellTareMessage>(QUEUE_LANE_CONTROL);
         break;
     }
     case Proto::SOBCommand::Command::SOB_CALIBRATE_LOAD_CELL: {
-        SOAR_PRINT("PROTO-INFO: Received SOB Calibrate Load Cell Command\n");
+        SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_PROTOCOL, "PROTO-INFO: Received SOB Calibrate Load Cell Command\n");
 
 		// update calibration mass directly
         int32_t mass_mg = msg.get_sob_command().get_command_param();
 		LoadCellTask::Inst().SetCalibrationMassGrams((float)mass_mg / 1000);
 
 		// send calibration command to queue -- could be blocking if we protect the LC read
-		LoadCellTask::Inst().SendCommand(Command(REQUEST_COMMAND, LOADCELL_REQUEST_CALIBRATE));
+		LoadCellTask::Inst().Post<LoadCellCalibrateMessage>(QUEUE_LANE_CONTROL);
 		break;
     }
     case Proto::SOBCommand::Command::SOB_SLOW_SAMPLE_IR:
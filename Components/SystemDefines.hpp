@@ -29,6 +29,7 @@
 #include "cmsis_os.h"	// CMSIS RTOS definitions
 #include "main_avionics.hpp"  // Main avionics definitions
 #include "Utils.hpp"	// Utility functions
+#include "LogLevel.hpp"	// Log levels and SOAR_PRINT_LEVEL
 #include "UARTDriver.hpp"
 
 /* Task Definitions ------------------------------------------------------------------*/
@@ -45,25 +46,32 @@ constexpr uint16_t FLIGHT_PHASE_DISPLAY_FREQ = 1000;	// Display frequency for fl
 constexpr uint8_t IR_TASK_RTOS_PRIORITY = 2;			// Priority of the IR task
 constexpr uint8_t IR_TASK_QUEUE_DEPTH_OBJS = 10;		// Size of the IR task queue
 constexpr uint16_t IR_TASK_STACK_DEPTH_WORDS = 512;		// Size of the IR task stack
+constexpr uint8_t IR_TASK_SAMPLE_HISTORY_DEPTH = 8;		// Number of samples kept in the IR sample topic
 
 // LoadCell Task
 constexpr uint8_t LOADCELL_TASK_RTOS_PRIORITY = 2;			// Priority of the LoadCell task
-constexpr uint8_t LOADCELL_TASK_QUEUE_DEPTH_OBJS = 10;		// Size of the LoadCell task queue
+constexpr uint8_t LOADCELL_TASK_QUEUE_DEPTH_OBJS = 10;		// Size of the LoadCell task queue (sampling lane)
+constexpr uint8_t LOADCELL_TASK_CONTROL_QUEUE_DEPTH_OBJS = 4;	// Size of the LoadCell task control lane (tare, calibrate)
+constexpr uint8_t LOADCELL_TASK_DEBUG_QUEUE_DEPTH_OBJS = 4;	// Size of the LoadCell task debug lane
 constexpr uint16_t LOADCELL_TASK_STACK_DEPTH_WORDS = 512;	// Size of the LoadCell task stack
+constexpr uint32_t LOADCELL_TASK_SAMPLE_PERIOD_MS = 1000;	// Period the LoadCell task samples and publishes at
+constexpr uint8_t LOADCELL_TASK_SAMPLE_HISTORY_DEPTH = 8;	// Number of samples kept in the LoadCell sample topic
 
 // Thermocouple Task
 constexpr uint8_t THERMOCOUPLE_TASK_RTOS_PRIORITY = 2;			// Priority of the Thermocouple task
 constexpr uint8_t THERMOCOUPLE_TASK_QUEUE_DEPTH_OBJS = 10;		// Size of the Thermocouple task queue
 constexpr uint16_t THERMOCOUPLE_TASK_STACK_DEPTH_WORDS = 512;	// Size of the Thermocouple task stack
+constexpr uint32_t THERMOCOUPLE_TASK_SAMPLE_PERIOD_MS = 1000;	// Period the Thermocouple task samples and publishes at
+constexpr uint8_t THERMOCOUPLE_TASK_SAMPLE_HISTORY_DEPTH = 8;	// Number of samples kept in the Thermocouple sample topic
 
 // UART TASK
 constexpr uint8_t UART_TASK_RTOS_PRIORITY = 2;			// Priority of the uart task
-constexpr uint8_t UART_TASK_QUEUE_DEPTH_OBJS = 10;		// Size of the uart task queue
+constexpr uint8_t UART_TASK_QUEUE_DEPTH_OBJS = 10;		// Size of the uart task queue (protocol lane)
+constexpr uint8_t UART_TASK_DEBUG_QUEUE_DEPTH_OBJS = 10;	// Size of the uart task debug lane (prints)
 constexpr uint16_t UART_TASK_STACK_DEPTH_WORDS = 256;	// Size of the uart task stack
 
 // DEBUG TASK
 constexpr uint8_t TASK_DEBUG_PRIORITY = 2;				// Priority of the debug task
-constexpr uint8_t TASK_DEBUG_QUEUE_DEPTH_OBJS = 10;		// Size of the debug task queue
 constexpr uint16_t TASK_DEBUG_STACK_DEPTH_WORDS = 256;	// Size of the debug task stack
 
 // TELEMETRY Task
@@ -71,7 +79,7 @@ constexpr uint8_t TELEMETRY_TASK_RTOS_PRIORITY = 2;            // Priority of th
 constexpr uint8_t TELEMETRY_TASK_QUEUE_DEPTH_OBJS = 10;        // Size of the telemetry task queue
 constexpr uint16_t TELEMETRY_TASK_STACK_DEPTH_WORDS = 512;     // Size of the telemetry task stack
 
-constexpr uint32_t TELEMETRY_DEFAULT_LOGGING_RATE_MS = 1000; // Default logging delay for telemetry task
+constexpr uint32_t TELEMETRY_DEFAULT_LOGGING_RATE_MS = 1000; // Default logging delay for telemetry task, sensors sample at their own rate
 
 
 /* System Defines ------------------------------------------------------------------*/
@@ -80,9 +88,16 @@ constexpr uint32_t TELEMETRY_DEFAULT_LOGGING_RATE_MS = 1000; // Default logging
 // RTOS
 constexpr uint8_t DEFAULT_QUEUE_SIZE = 10;					// Default size of the queue
 constexpr uint16_t MAX_NUMBER_OF_COMMAND_ALLOCATIONS = 100;	// Let's assume ~128B per allocation, 100 x 128B = 12800B = 12.8KB
+constexpr uint32_t TASK_STATIC_RAM_BUDGET_BYTES = 24576;		// Max static RAM for all StaticTask objects (stacks, control blocks, queues and members)
+
+// COMMAND POOLS (Static payload storage for Command, 24x32 + 16x64 + 12x128 + 8x256 = 5376B)
+constexpr uint16_t COMMAND_POOL_32B_BLOCKS = 24;			// Number of 32 byte blocks in the command payload pool
+constexpr uint16_t COMMAND_POOL_64B_BLOCKS = 16;			// Number of 64 byte blocks in the command payload pool
+constexpr uint16_t COMMAND_POOL_128B_BLOCKS = 12;			// Number of 128 byte blocks in the command payload pool
+constexpr uint16_t COMMAND_POOL_256B_BLOCKS = 8;			// Number of 256 byte blocks in the command payload pool (fits a full DEBUG_PRINT_MAX_SIZE print)
+constexpr uint8_t COMMAND_SLOT_COUNT = 16;					// Number of queued commands parked in a slot at once (static buffers, heap fallbacks, large inline payloads)
 
 // DEBUG
-constexpr uint16_t DEBUG_TAKE_MAX_TIME_MS = 500;		// Max time in ms to take the debug semaphore
 constexpr uint16_t DEBUG_SEND_MAX_TIME_MS = 500;		// Max time the assert fail is allowed to wait to send header and message to HAL
 constexpr uint16_t DEBUG_PRINT_MAX_SIZE = 192;			// Max size in bytes of message print buffers
 
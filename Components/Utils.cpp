@@ -7,6 +7,7 @@
 #include "Utils.hpp"
 
 #include <cstring>
+#include <cmath>
 
 #include "stm32f4xx.h"
 #include "stm32f4xx_hal_conf.h"
@@ -16,6 +17,180 @@
 
 #include "etl/crc16_xmodem.h"
 
+/* Formatting Helpers -----------------------------------------------------------------*/
+namespace {
+    constexpr uint8_t FORMAT_MAX_PRECISION = 9;         // Max fraction digits, 10^9 fits a uint32_t
+    constexpr uint8_t FORMAT_BODY_MAX_SIZE = 32;        // Max length of one formatted number excluding sign and padding
+    constexpr double FORMAT_FLOAT_MAX = 1.8e19;         // Floats at or above this do not fit the uint64_t integer part
+    constexpr uint32_t POWERS_OF_10[FORMAT_MAX_PRECISION + 1] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+
+    struct FormatSpec
+    {
+        bool leftAlign;         // '-' flag
+        bool zeroPad;           // '0' flag
+        bool plusSign;          // '+' flag
+        bool spaceSign;         // ' ' flag
+        uint16_t width;         // Minimum field width
+        int16_t precision;      // -1 if not given
+    };
+
+    /**
+     * @brief Bounded writer, keeps one byte free for the null terminator and drops anything past it
+    */
+    struct FormatWriter
+    {
+        char* buffer;
+        uint16_t size;
+        uint16_t length;
+
+        void Put(char c) { if (length + 1 < size) buffer[length++] = c; }
+        void Put(char c, uint16_t count) { while (count-- > 0) Put(c); }
+        void Put(const char* str, uint16_t len) { for (uint16_t i = 0; i < len; i++) Put(str[i]); }
+    };
+
+    /**
+     * @brief Writes the digits of value most significant first, uses 32 bit division whenever the value fits
+     * @return Number of digits written, at least 1
+    */
+    uint8_t ToDigits(char* out, uint64_t value, uint8_t base, bool upper)
+    {
+        const char* const digitChars = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+        char reversed[24];
+        uint8_t count = 0;
+
+        while (value > UINT32_MAX) {
+            reversed[count++] = digitChars[value % base];
+            value /= base;
+        }
+        uint32_t value32 = static_cast<uint32_t>(value);
+        do {
+            reversed[count++] = digitChars[value32 % base];
+            value32 /= base;
+        } while (value32 != 0);
+
+        for (uint8_t i = 0; i < count; i++)
+            out[i] = reversed[count - 1 - i];
+        return count;
+    }
+
+    /**
+     * @brief Writes an integer part, a point and a zero padded fraction, no point if digits is 0
+     * @return Length of the body
+    */
+    uint8_t ToFixedBody(char* out, uint64_t integerPart, uint32_t fraction, uint8_t digits)
+    {
+        uint8_t len = ToDigits(out, integerPart, 10, false);
+        if (digits == 0)
+            return len;
+
+        out[len++] = '.';
+        for (uint8_t i = digits; i > 0; i--) {
+            out[len + i - 1] = '0' + (fraction % 10);
+            fraction /= 10;
+        }
+        return len + digits;
+    }
+
+    /**
+     * @brief Writes the magnitude of a float, rounded to nearest with exact ties to even like newlib printf
+     * @return Length of the body
+    */
+    uint8_t ToFloatBody(char* out, double magnitude, uint8_t precision)
+    {
+        if (std::isnan(magnitude)) {
+            memcpy(out, "nan", 3);
+            return 3;
+        }
+        if (std::isinf(magnitude)) {
+            memcpy(out, "inf", 3);
+            return 3;
+        }
+        if (magnitude >= FORMAT_FLOAT_MAX) {
+            // Too large for the integer part, values this large are not expected from any sensor
+            memcpy(out, "ovf", 3);
+            return 3;
+        }
+        if (precision > FORMAT_MAX_PRECISION)
+            precision = FORMAT_MAX_PRECISION;
+
+        uint64_t integerPart = static_cast<uint64_t>(magnitude);
+
+        // Exact for any float value up to 6 digits, the product needs at most 44 of the 53 mantissa bits
+        const double scaled = (magnitude - integerPart) * POWERS_OF_10[precision];
+        uint32_t fraction = static_cast<uint32_t>(scaled);
+        const double remainder = scaled - fraction;
+        const bool lastDigitOdd = (precision > 0) ? (fraction & 1U) : (integerPart & 1U);
+        if (remainder > 0.5 || (remainder == 0.5 && lastDigitOdd))
+            fraction++;
+
+        // Rounding the fraction up may carry into the integer part, eg. 0.9996 to 3 digits
+        if (fraction >= POWERS_OF_10[precision]) {
+            fraction -= POWERS_OF_10[precision];
+            integerPart++;
+        }
+        return ToFixedBody(out, integerPart, fraction, precision);
+    }
+
+    /**
+     * @brief Gets the sign character of a field, 0 if none is printed
+    */
+    char GetSignChar(const FormatSpec& spec, bool negative)
+    {
+        if (negative)
+            return '-';
+        return spec.plusSign ? '+' : (spec.spaceSign ? ' ' : 0);
+    }
+
+    /**
+     * @brief Writes a field, padding it to the width, zero padding goes between the sign and the body
+    */
+    void PutField(FormatWriter& writer, const FormatSpec& spec, char sign, const char* body, uint16_t bodyLen)
+    {
+        const uint16_t len = bodyLen + (sign != 0 ? 1 : 0);
+        const uint16_t pad = (spec.width > len) ? spec.width - len : 0;
+
+        if (!spec.leftAlign && !spec.zeroPad)
+            writer.Put(' ', pad);
+        if (sign != 0)
+            writer.Put(sign);
+        if (!spec.leftAlign && spec.zeroPad)
+            writer.Put('0', pad);
+        writer.Put(body, bodyLen);
+        if (spec.leftAlign)
+            writer.Put(' ', pad);
+    }
+
+    /**
+     * @brief Writes an integer field, the precision is the minimum number of digits
+    */
+    void PutInteger(FormatWriter& writer, FormatSpec spec, bool negative, uint64_t magnitude, uint8_t base, bool upper)
+    {
+        char body[FORMAT_BODY_MAX_SIZE];
+        uint8_t len = 0;
+
+        if (spec.precision >= 0) {
+            // An explicit precision disables zero padding, and a zero precision prints nothing for zero
+            spec.zeroPad = false;
+            if (spec.precision != 0 || magnitude != 0) {
+                char digits[24];
+                const uint8_t digitCount = ToDigits(digits, magnitude, base, upper);
+                const uint8_t precision = (spec.precision < FORMAT_BODY_MAX_SIZE - 24) ? spec.precision : FORMAT_BODY_MAX_SIZE - 24;
+                while (len + digitCount < precision)
+                    body[len++] = '0';
+                memcpy(&body[len], digits, digitCount);
+                len += digitCount;
+            }
+        }
+        else {
+            len = ToDigits(body, magnitude, base, upper);
+        }
+
+        PutField(writer, spec, GetSignChar(spec, negative), body, len);
+    }
+}
+
 /**
  * @brief Calculates the average from a list of unsigned shorts
  * @param array: The array of unsigned shorts to average
@@ -158,3 +333,210 @@ int32_t Utils::stringToLong(const char* str)
     return result;
 
 }
+
+/**
+ * @brief Converts an int32_t to a c string
+ * @param buffer Buffer to write into, always null terminated if size is not 0
+ * @param size Size of the buffer in bytes
+ * @param value Value to convert
+ * @return Length written excluding the null terminator
+ */
+uint16_t Utils::FormatInt(char* buffer, uint16_t size, int32_t value)
+{
+    return FormatString(buffer, size, "%d", value);
+}
+
+/**
+ * @brief Converts a fixed-point value to a c string, eg. a temperature in C x100
+ * @param buffer Buffer to write into, always null terminated if size is not 0
+ * @param size Size of the buffer in bytes
+ * @param value Value scaled by 10^fractionDigits
+ * @param fractionDigits Number of digits after the point, at most 9
+ * @return Length written excluding the null terminator
+ */
+uint16_t Utils::FormatFixed(char* buffer, uint16_t size, int32_t value, uint8_t fractionDigits)
+{
+    if (size == 0)
+        return 0;
+    if (fractionDigits > FORMAT_MAX_PRECISION)
+        fractionDigits = FORMAT_MAX_PRECISION;
+
+    // Negate as unsigned so INT32_MIN does not overflow
+    const bool negative = (value < 0);
+    const uint32_t magnitude = negative ? 0U - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+
+    char body[FORMAT_BODY_MAX_SIZE];
+    const uint8_t len = ToFixedBody(body, magnitude / POWERS_OF_10[fractionDigits], magnitude % POWERS_OF_10[fractionDigits], fractionDigits);
+
+    FormatWriter writer = { buffer, size, 0 };
+    if (negative)
+        writer.Put('-');
+    writer.Put(body, len);
+    buffer[writer.length] = '\0';
+    return writer.length;
+}
+
+/**
+ * @brief Converts a float to a c string with a fixed number of fraction digits
+ * @param buffer Buffer to write into, always null terminated if size is not 0
+ * @param size Size of the buffer in bytes
+ * @param value Value to convert
+ * @param precision Number of digits after the point, at most 9
+ * @return Length written excluding the null terminator
+ */
+uint16_t Utils::FormatFloat(char* buffer, uint16_t size, float value, uint8_t precision)
+{
+    return FormatString(buffer, size, "%.*f", precision, static_cast<double>(value));
+}
+
+/**
+ * @brief printf style formatting into a buffer, see FormatStringV()
+ * @param buffer Buffer to write into, always null terminated if size is not 0
+ * @param size Size of the buffer in bytes
+ * @param format printf style format string
+ * @return Length written excluding the null terminator
+ */
+uint16_t Utils::FormatString(char* buffer, uint16_t size, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const uint16_t len = FormatStringV(buffer, size, format, args);
+    va_end(args);
+    return len;
+}
+
+/**
+ * @brief printf style formatting into a buffer. Does not allocate, lock or touch newlib, so it is
+ *        reentrant and safe from ISRs. Unsupported conversions are copied to the output as-is.
+ * @param buffer Buffer to write into, always null terminated if size is not 0
+ * @param size Size of the buffer in bytes
+ * @param format printf style format string
+ * @param args Arguments for the format
+ * @return Length written excluding the null terminator, output that does not fit is truncated
+ */
+uint16_t Utils::FormatStringV(char* buffer, uint16_t size, const char* format, va_list args)
+{
+    if (size == 0)
+        return 0;
+
+    FormatWriter writer = { buffer, size, 0 };
+
+    while (*format != '\0') {
+        if (*format != '%') {
+            writer.Put(*format++);
+            continue;
+        }
+
+        const char* specStart = format++;
+        FormatSpec spec = { false, false, false, false, 0, -1 };
+
+        // Flags
+        for (bool parsingFlags = true; parsingFlags; ) {
+            switch (*format) {
+            case '-': spec.leftAlign = true; format++; break;
+            case '0': spec.zeroPad = true; format++; break;
+            case '+': spec.plusSign = true; format++; break;
+            case ' ': spec.spaceSign = true; format++; break;
+            default: parsingFlags = false; break;
+            }
+        }
+
+        // Width
+        if (*format == '*') {
+            const int width = va_arg(args, int);
+            spec.leftAlign |= (width < 0);
+            spec.width = (width < 0) ? -width : width;
+            format++;
+        }
+        while (IsAsciiNum(*format))
+            spec.width = spec.width * 10 + (*format++ - '0');
+
+        // Precision
+        if (*format == '.') {
+            format++;
+            spec.precision = 0;
+            if (*format == '*') {
+                const int precision = va_arg(args, int);
+                spec.precision = (precision < 0) ? -1 : precision;
+                format++;
+            }
+            while (IsAsciiNum(*format))
+                spec.precision = spec.precision * 10 + (*format++ - '0');
+        }
+
+        // Length, h and hh arguments are promoted to int so only l and ll change how the argument is read
+        uint8_t longCount = 0;
+        while (*format == 'l' || *format == 'h' || *format == 'z' || *format == 'j' || *format == 't') {
+            if (*format == 'l' || *format == 'j')
+                longCount += (*format == 'j') ? 2 : 1;
+            format++;
+        }
+
+        const char conversion = *format;
+        if (conversion == '\0')
+            break;
+        format++;
+
+        switch (conversion) {
+        case 'd':
+        case 'i': {
+            const int64_t value = (longCount >= 2) ? va_arg(args, long long) : ((longCount == 1) ? va_arg(args, long) : va_arg(args, int));
+            const uint64_t magnitude = (value < 0) ? 0ULL - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+            PutInteger(writer, spec, value < 0, magnitude, 10, false);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X': {
+            const uint64_t value = (longCount >= 2) ? va_arg(args, unsigned long long) : ((longCount == 1) ? va_arg(args, unsigned long) : va_arg(args, unsigned int));
+            spec.plusSign = spec.spaceSign = false;
+            PutInteger(writer, spec, false, value, (conversion == 'u') ? 10 : 16, conversion == 'X');
+            break;
+        }
+        case 'p': {
+            char body[2 + 2 * sizeof(uintptr_t)] = { '0', 'x' };
+            const uint8_t len = 2 + ToDigits(&body[2], reinterpret_cast<uintptr_t>(va_arg(args, void*)), 16, false);
+            spec.zeroPad = false;
+            PutField(writer, spec, 0, body, len);
+            break;
+        }
+        case 'c': {
+            const char c = static_cast<char>(va_arg(args, int));
+            spec.zeroPad = false;
+            PutField(writer, spec, 0, &c, 1);
+            break;
+        }
+        case 's': {
+            const char* str = va_arg(args, const char*);
+            if (str == nullptr)
+                str = "(null)";
+            uint16_t len = 0;
+            while (str[len] != '\0' && (spec.precision < 0 || len < spec.precision))
+                len++;
+            spec.zeroPad = false;
+            PutField(writer, spec, 0, str, len);
+            break;
+        }
+        case 'f':
+        case 'F': {
+            const double value = va_arg(args, double);
+            char body[FORMAT_BODY_MAX_SIZE];
+            const uint8_t len = ToFloatBody(body, std::fabs(value), (spec.precision < 0) ? 6 : spec.precision);
+            if (!std::isfinite(value))
+                spec.zeroPad = false;
+            PutField(writer, spec, GetSignChar(spec, std::signbit(value) && !std::isnan(value)), body, len);
+            break;
+        }
+        case '%':
+            writer.Put('%');
+            break;
+        default:
+            // Unsupported, copy the specifier so the problem is visible in the output
+            writer.Put(specStart, format - specStart);
+            break;
+        }
+    }
+
+    buffer[writer.length] = '\0';
+    return writer.length;
+}
@@ -9,6 +9,7 @@
 */
 #ifndef AVIONICS_INCLUDE_SOAR_UTILS_HPP_
 #define AVIONICS_INCLUDE_SOAR_UTILS_HPP_
+#include <cstdarg>       // Support for va_list
 #include "cmsis_os.h"    // CMSIS RTOS definitions
 
 // Programmer Macros
@@ -52,6 +53,17 @@ namespace Utils
     // String to number conversion
     int32_t stringToLong(const char* str);
 
+    // Number to string conversion, allocation-free and safe from tasks and ISRs. Each returns the length
+    // written excluding the null terminator, output that does not fit is truncated
+    uint16_t FormatInt(char* buffer, uint16_t size, int32_t value);
+    uint16_t FormatFixed(char* buffer, uint16_t size, int32_t value, uint8_t fractionDigits);    // value / 10^fractionDigits, eg. -1205, 2 -> "-12.05"
+    uint16_t FormatFloat(char* buffer, uint16_t size, float value, uint8_t precision);          // Rounded like printf, precision at most 9
+
+    // printf style formatting, supports the flags "-0+ ", width, precision, the h/hh/l/ll/z length
+    // modifiers and %d %i %u %x %X %c %s %p %f %F %%. Used by print() in place of newlib vsnprintf
+    uint16_t FormatString(char* buffer, uint16_t size, const char* format, ...);
+    uint16_t FormatStringV(char* buffer, uint16_t size, const char* format, va_list args);
+
 }
 
 
@@ -13,6 +13,8 @@
 #include "../../Drivers/mlx90614 Driver/mlx90614.h"
 #include "Mutex.hpp"
 #include "Command.hpp"
+#include "SharedBuffer.hpp"
+#include "CrashRecord.hpp"
 #include "UARTDriver.hpp"
 
 // Tasks
@@ -28,12 +30,20 @@
 
 /* Global Variables ------------------------------------------------------------------*/
 Mutex Global::vaListMutex;
+
+// Task stacks, control blocks and queues are sized at compile time, catch a budget overrun at build time instead of boot
+static_assert(sizeof(UARTTask) + sizeof(DebugTask) + sizeof(TelemetryTask) + sizeof(FlightTask) + sizeof(IRTask)
+    + sizeof(ThermocoupleTask) + sizeof(LoadCellTask) <= TASK_STATIC_RAM_BUDGET_BYTES,
+    "Static task RAM exceeds TASK_STATIC_RAM_BUDGET_BYTES");
  
 /* Interface Functions ------------------------------------------------------------*/
 /**
  * @brief Main function interface, called inside main.cpp before os initialization takes place.
 */
 void run_main() {
+	// Take the reset reason and the crash record of the last run before anything can assert
+	CrashRecord::Init();
+
 	// Init Tasks
 	UARTTask::Inst().InitTask();
 	DebugTask::Inst().InitTask();
@@ -44,10 +54,10 @@ void run_main() {
 	FlightTask::Inst().InitTask();
 
 	// Print System Boot Info : Warning, don't queue more than 10 prints before scheduler starts
-	SOAR_PRINT("\n-- AVIONICS CORE --\n");
-	SOAR_PRINT("System Reset Reason: [TODO]\n"); //TODO: If we want a system reset reason we need to save it on flash
-	SOAR_PRINT("Current System Heap Use: %d Bytes\n", xPortGetFreeHeapSize());
-	SOAR_PRINT("Lowest Ever Heap Size: %d Bytes\n\n", xPortGetMinimumEverFreeHeapSize());
+	SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_SYSTEM, "\n-- AVIONICS CORE --\n");
+	CrashRecord::PrintLast();
+	SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_SYSTEM, "Current System Heap Use: %d Bytes\n", xPortGetFreeHeapSize());
+	SOAR_PRINT_LEVEL(LOG_LEVEL_INFO, LOG_MODULE_SYSTEM, "Lowest Ever Heap Size: %d Bytes\n\n", xPortGetMinimumEverFreeHeapSize());
 	
 	// Start the Scheduler
 	// Guidelines:
@@ -76,41 +86,58 @@ void run_StartDefaultTask()
 /* System Functions ------------------------------------------------------------*/
 
 /**
-* @brief Variadic print function, sends a command packet to the queue
+* @brief Variadic print function. From a task, formats into the task's own TaskLog without any lock and wakes
+*        the UARTTask, which merges the task logs by timestamp. Anywhere else (before the scheduler starts, or a
+*        task without a Task object) formats directly into a SharedBuffer (or a pool block if none are free) and
+*        sends it to the UARTTask queue.
 * @param str String to print with printf style formatting
 * @param ... Additional arguments to print if assertion fails, in same format as printf
 */
 void print(const char* str, ...)
 {
-	//Try to take the VA list mutex
-	if (Global::vaListMutex.Lock(DEBUG_TAKE_MAX_TIME_MS)) {
-		// If we have a message, and can use VA list, extract the string into a new buffer, and null terminate it
-		uint8_t str_buffer[DEBUG_PRINT_MAX_SIZE] = {};
-		va_list argument_list;
-		va_start(argument_list, str);
-		int16_t buflen = vsnprintf(reinterpret_cast<char*>(str_buffer), sizeof(str_buffer) - 1, str, argument_list);
+	va_list argument_list;
+	va_start(argument_list, str);
+
+	// Write into the calling task's log
+	Task* task = Task::GetCurrent();
+	if (task != nullptr) {
+		task->GetLog().Write(str, argument_list);
 		va_end(argument_list);
-		if (buflen > 0) {
-			str_buffer[buflen] = '\0';
-		}
 
-		// Release the VA List Mutex
-		Global::vaListMutex.Unlock();
-
-		//Generate a command
-		Command cmd(DATA_COMMAND, (uint16_t)UART_TASK_COMMAND_SEND_DEBUG); // Set the UART channel to send data on
-		
-		//Copy data into the command
-		cmd.CopyDataToCommand(str_buffer, buflen);
-			
-		//Send this packet off to the UART Task
-		UARTTask::Inst().GetEventQueue()->Send(cmd);
+		UARTTask::Inst().Notify(UART_TASK_EVENT_LOG);
+		return;
 	}
-	else
-	{
-		//TODO: Print out that we could not acquire the VA list mutex
-		SOAR_ASSERT(false, "Could not acquire VA_LIST mutex");
+
+	//Generate a command
+	Command cmd(DATA_COMMAND, (uint16_t)UART_TASK_COMMAND_SEND_DEBUG); // Set the UART channel to send data on
+
+	// Get a buffer to format into, prefer a shared buffer and fall back to a pool block
+	SharedBuffer* sharedBuf = SharedBufferPool::Allocate();
+	uint8_t* str_buffer = nullptr;
+	uint16_t bufSize = DEBUG_PRINT_MAX_SIZE;
+	if (sharedBuf != nullptr) {
+		str_buffer = SharedBufferPool::GetData(sharedBuf);
+		bufSize = SHARED_BUFFER_SIZE_BYTES;
 	}
+	else {
+		str_buffer = cmd.AllocateData(DEBUG_PRINT_MAX_SIZE);
+	}
+
+	// The formatter is reentrant and truncates to the buffer, so no lock or clamp is needed
+	const uint16_t buflen = Utils::FormatStringV(reinterpret_cast<char*>(str_buffer), bufSize - 1, str, argument_list);
+	va_end(argument_list);
+
+	// Point the command at the formatted data, the command takes its own reference to a shared buffer
+	if (sharedBuf != nullptr) {
+		cmd.SetCommandToSharedBuffer(sharedBuf, buflen);
+		SharedBufferPool::Release(sharedBuf);
+	}
+	else {
+		cmd.SetDataSize(buflen);
+	}
+
+	//Send this packet off to the UART Task, on the debug lane so it never displaces protocol output
+	UARTTask::Inst().GetEventQueue()->Send(cmd, QUEUE_LANE_DEBUG);
 }
 
 /**
@@ -140,6 +167,12 @@ void soar_assert_debug(bool condition, const char* file, const uint16_t line, co
 	
 	vTaskSuspendAll();
 
+	// Save the crash record first, it is printed at the next boot even if the output below fails
+	va_list record_argument_list;
+	va_start(record_argument_list, str);
+	CrashRecord::Save(file, line, str, record_argument_list);
+	va_end(record_argument_list);
+
 	//If we have the vaListMutex, we can safely use vsnprintf
 	if (printMessage) {
 		// Print out the assertion header through the supported interface, we don't have a UART task running, so we directly use HAL
@@ -151,7 +184,7 @@ void soar_assert_debug(bool condition, const char* file, const uint16_t line, co
 		}
 
 		// Output the header to the debug port
-        DEFAULT_ASSERT_UART_DRIVER->Transmit(header_buf, strlen(reinterpret_cast<char*>(header_buf)));
+        DEFAULT_ASSERT_UART_DRIVER->TransmitPolling(header_buf, strlen(reinterpret_cast<char*>(header_buf)));
 
 		// If we have a message, and can use VA list, extract the string into a new buffer, and null terminate it
 		if (printMessage && str != nullptr) {
@@ -162,13 +195,13 @@ void soar_assert_debug(bool condition, const char* file, const uint16_t line, co
 			va_end(argument_list);
 			if (buflen > 0) {
 				str_buffer[buflen] = '\0';
-                DEFAULT_ASSERT_UART_DRIVER->Transmit(str_buffer, buflen);
+                DEFAULT_ASSERT_UART_DRIVER->TransmitPolling(str_buffer, buflen);
 			}
 		}
 	}
 	else {
 		//TODO: Should manually print out the assertion header
-        DEFAULT_ASSERT_UART_DRIVER->Transmit((uint8_t*)"-- ASSERTION FAILED --\r\nCould not acquire vaListMutex\r\n", 55);
+        DEFAULT_ASSERT_UART_DRIVER->TransmitPolling((uint8_t*)"-- ASSERTION FAILED --\r\nCould not acquire vaListMutex\r\n", 55);
 	}
 
 	HAL_NVIC_SystemReset();
@@ -137,6 +137,8 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+#define configUSE_COUNTING_SEMAPHORES    1    /* Used by multi-lane Queues to block on every lane at once */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS    1    /* Slot 0 holds the Task object, see Task::GetCurrent() */
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
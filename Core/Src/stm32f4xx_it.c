@@ -202,5 +202,20 @@ void UART5_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA1 stream7 global interrupt, UART5 TX.
+  */
+void DMA1_Stream7_IRQHandler(void)
+{
+  cpp_DMA1_Stream7_IRQHandler();
+}
+
+/**
+  * @brief This function handles DMA2 stream2 global interrupt, USART1 RX.
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  cpp_DMA2_Stream2_IRQHandler();
+}
 
 /* USER CODE END 1 */
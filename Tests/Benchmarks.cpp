@@ -0,0 +1,671 @@
+/**
+ ******************************************************************************
+ * File Name          : Benchmarks.cpp
+ * Description        : Host benchmarks of the components against the code they
+ *    replaced. Times are host times and only the ratios carry over to the
+ *    target, run "soar_host_tests Benchmark" to see them.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "Command.hpp"
+#include "CommandPool.hpp"
+#include "CommandRouter.hpp"
+#include "CompactCommand.hpp"
+#include "HostPeripherals.hpp"
+#include "LogLimiter.hpp"
+#include "Queue.hpp"
+#include "SystemDefines.hpp"
+#include "TaskLog.hpp"
+#include "UARTTask.hpp"
+#include "UARTDriver.hpp"
+#include "Utils.hpp"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+/* Helpers -------------------------------------------------------------------*/
+// FreeRTOS heap_4.c built for the host, see Stub/Heap4/FreeRTOS.h
+extern "C" void* Heap4Malloc(size_t size);
+extern "C" void Heap4Free(void* ptr);
+
+namespace {
+    volatile uint32_t sink;    // Keeps the measured work from being optimized out
+
+    uint16_t FormatLibc(char* buffer, uint16_t size, const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        const int len = vsnprintf(buffer, size, format, args);
+        va_end(args);
+        return static_cast<uint16_t>(len);
+    }
+
+    bool WriteLine(TaskLog& log, const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        const bool written = log.Write(format, args);
+        va_end(args);
+        return written;
+    }
+}
+
+/* user-016 Formatter --------------------------------------------------------*/
+HOST_TEST(Benchmark, FormatStringVsVsnprintf)
+{
+    constexpr uint32_t COUNT = 200000;
+    char buffer[128];
+
+    HostTest::Report("Utils::FormatString \"%d %u %x\"", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = Utils::FormatString(buffer, sizeof(buffer), "LC %d: %u raw %x\n", -(int32_t)i, i, i); }), "ns");
+    HostTest::Report("vsnprintf \"%d %u %x\"", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = FormatLibc(buffer, sizeof(buffer), "LC %d: %u raw %x\n", -(int32_t)i, i, i); }), "ns");
+
+    HostTest::Report("Utils::FormatString \"%.3f\"", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = Utils::FormatString(buffer, sizeof(buffer), "Mass %.3f g\n", i * -0.37); }), "ns");
+    HostTest::Report("vsnprintf \"%.3f\"", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = FormatLibc(buffer, sizeof(buffer), "Mass %.3f g\n", i * -0.37); }), "ns");
+
+    HostTest::Report("Utils::FormatString \"%s %5d\"", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = Utils::FormatString(buffer, sizeof(buffer), "%s %5d\n", "Thermocouple", (int32_t)(i & 0xFFF)); }), "ns");
+    HostTest::Report("vsnprintf \"%s %5d\"", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = FormatLibc(buffer, sizeof(buffer), "%s %5d\n", "Thermocouple", (int32_t)(i & 0xFFF)); }), "ns");
+
+    // Same output, so the comparison is fair
+    char expected[128];
+    Utils::FormatString(buffer, sizeof(buffer), "Mass %.3f g\n", -12.3456);
+    FormatLibc(expected, sizeof(expected), "Mass %.3f g\n", -12.3456);
+    CHECK_STRING(expected, buffer);
+}
+
+/* user-001 Pool -------------------------------------------------------------*/
+HOST_TEST(Benchmark, PoolVsHeap4)
+{
+    // Payload sizes of prints and frames, with a few blocks in flight like commands waiting in queues. The scheduler
+    // lock heap_4 takes and the critical section of the pool are both left out on the host.
+    constexpr uint32_t COUNT = 200000;
+    constexpr uint16_t SIZES[8] = { 12, 24, 40, 18, 60, 30, 100, 16 };
+    constexpr uint8_t IN_FLIGHT = 8;
+    uint8_t* blocks[IN_FLIGHT] = {};
+    const uint32_t fallbacks = CommandPool::GetHeapFallbackCount();    // Counted since start, other suites may run first
+
+    HostTest::Report("CommandPool Allocate + Free", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        uint8_t*& block = blocks[i % IN_FLIGHT];
+        if (block != nullptr)
+            CommandPool::Free(block);
+        block = CommandPool::Allocate(SIZES[i % 8]);
+        block[0] = static_cast<uint8_t>(i); }), "ns");
+    for (uint8_t*& block : blocks) {
+        CommandPool::Free(block);
+        block = nullptr;
+    }
+
+    HostTest::Report("heap_4 pvPortMalloc + vPortFree", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        uint8_t*& block = blocks[i % IN_FLIGHT];
+        if (block != nullptr)
+            Heap4Free(block);
+        block = static_cast<uint8_t*>(Heap4Malloc(SIZES[i % 8]));
+        block[0] = static_cast<uint8_t>(i); }), "ns");
+    for (uint8_t*& block : blocks) {
+        Heap4Free(block);
+        block = nullptr;
+    }
+
+    CHECK_EQUAL(fallbacks, CommandPool::GetHeapFallbackCount());
+}
+
+/* user-002 Inline Payload ---------------------------------------------------*/
+namespace {
+    /**
+     * @brief Same members as Command, with TInlineBytes of inline storage sharing space with the data pointer
+    */
+    template <uint16_t TInlineBytes>
+    struct CommandLayout
+    {
+        GLOBAL_COMMANDS command;
+        uint16_t taskCommand;
+        union {
+            uint8_t* data;
+            uint8_t inlineData[(TInlineBytes > sizeof(uint8_t*)) ? TInlineBytes : sizeof(uint8_t*)];
+        };
+        uint16_t dataSize;
+        uint32_t passedParam;
+        bool bShouldFreeData;
+        bool bInlineData;
+        bool bSharedData;
+    };
+
+    /**
+     * @brief Sends commands with the given payload size through a raw copy queue, the way xQueueSend copied the
+     *        whole Command before CompactCommand. Payloads over the inline capacity go through the pool.
+     * @return Mean time per command in ns
+    */
+    template <uint16_t TInlineBytes>
+    double MeasureInlineCapacity(uint16_t payloadSize)
+    {
+        using Layout = CommandLayout<TInlineBytes>;
+        constexpr uint8_t QUEUE_DEPTH = 8;
+        alignas(Layout) static uint8_t queue[QUEUE_DEPTH * sizeof(Layout)];
+        volatile size_t itemSize = sizeof(Layout);    // The RTOS queue copies a runtime item size
+        const uint8_t payload[64] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+        return HostTest::MeasureNs(100000, [&](uint32_t i) {
+            Layout cm = {};
+            cm.dataSize = payloadSize;
+            if (payloadSize <= TInlineBytes) {
+                cm.bInlineData = true;
+                memcpy(cm.inlineData, payload, payloadSize);
+            }
+            else {
+                cm.data = CommandPool::Allocate(payloadSize);
+                cm.bShouldFreeData = true;
+                memcpy(cm.data, payload, payloadSize);
+            }
+
+            uint8_t* slot = &queue[(i % QUEUE_DEPTH) * sizeof(Layout)];
+            memcpy(slot, &cm, itemSize);
+            Layout received;
+            memcpy(&received, slot, itemSize);
+
+            const uint8_t* data = received.bInlineData ? received.inlineData : received.data;
+            sink = data[payloadSize - 1];
+            if (received.bShouldFreeData)
+                CommandPool::Free(received.data);
+        });
+    }
+
+    template <uint16_t TInlineBytes>
+    void ReportInlineCapacity()
+    {
+        char label[64];
+        for (uint16_t payloadSize : { 4, 8, 12, 24 }) {
+            snprintf(label, sizeof(label), "inline %2u B (Command %2u B), %2u B payload", TInlineBytes,
+                (unsigned)sizeof(CommandLayout<TInlineBytes>), payloadSize);
+            HostTest::Report(label, MeasureInlineCapacity<TInlineBytes>(payloadSize), "ns");
+        }
+    }
+}
+
+HOST_TEST(Benchmark, InlineCapacityVsQueueCopy)
+{
+    ReportInlineCapacity<0>();
+    ReportInlineCapacity<8>();
+    ReportInlineCapacity<12>();
+    ReportInlineCapacity<16>();
+    ReportInlineCapacity<32>();
+
+    // Queues copy the CompactCommand instead, so the inline capacity only costs Command's own size
+    HostTest::Report("sizeof(Command)", sizeof(Command), "B");
+    HostTest::Report("sizeof(CompactCommand), copied by the queues", sizeof(CompactCommand), "B");
+    CHECK(sizeof(CommandLayout<COMMAND_INLINE_DATA_SIZE>) == sizeof(Command));
+}
+
+/* user-008 Dispatch ---------------------------------------------------------*/
+namespace {
+    enum BENCHMARK_TASK_COMMANDS : uint16_t
+    {
+        BENCHMARK_SAMPLE = 1,
+        BENCHMARK_TARE,
+        BENCHMARK_CALIBRATE,
+        BENCHMARK_DUMP
+    };
+
+    using BenchmarkSampleMessage = CommandMessage<REQUEST_COMMAND, BENCHMARK_SAMPLE>;
+    using BenchmarkTareMessage = CommandMessage<TASK_SPECIFIC_COMMAND, BENCHMARK_TARE>;
+    using BenchmarkCalibrateMessage = CommandMessage<TASK_SPECIFIC_COMMAND, BENCHMARK_CALIBRATE>;
+    using BenchmarkDumpMessage = CommandMessage<DATA_COMMAND, BENCHMARK_DUMP>;
+
+    uint32_t handled[4];
+
+    class BenchmarkRouter : public CommandRouter<BenchmarkRouter, BenchmarkSampleMessage, BenchmarkTareMessage,
+        BenchmarkCalibrateMessage, BenchmarkDumpMessage>
+    {
+    public:
+        using CommandRouter::Route;
+
+        void OnMessage(const BenchmarkSampleMessage&) { handled[0]++; }
+        void OnMessage(const BenchmarkTareMessage&) { handled[1]++; }
+        void OnMessage(const BenchmarkCalibrateMessage&) { handled[2]++; }
+        void OnMessage(const BenchmarkDumpMessage& msg) { handled[3] += msg.cm.GetDataSize(); }
+        void OnUnsupported(Command&) {}
+        void SendCommand(Command, uint8_t) {}
+    };
+
+    /**
+     * @brief The nested switch each task had before CommandRouter
+    */
+    void HandleCommandSwitch(Command& cm)
+    {
+        switch (cm.GetCommand()) {
+        case REQUEST_COMMAND:
+            switch (cm.GetTaskCommand()) {
+            case BENCHMARK_SAMPLE: handled[0]++; break;
+            default: break;
+            }
+            break;
+        case TASK_SPECIFIC_COMMAND:
+            switch (cm.GetTaskCommand()) {
+            case BENCHMARK_TARE: handled[1]++; break;
+            case BENCHMARK_CALIBRATE: handled[2]++; break;
+            default: break;
+            }
+            break;
+        case DATA_COMMAND:
+            switch (cm.GetTaskCommand()) {
+            case BENCHMARK_DUMP: handled[3] += cm.GetDataSize(); break;
+            default: break;
+            }
+            break;
+        default:
+            break;
+        }
+
+        cm.Reset();
+    }
+}
+
+HOST_TEST(Benchmark, RouterVsSwitch)
+{
+    constexpr uint32_t COUNT = 1000000;
+    const GLOBAL_COMMANDS commands[4] = { REQUEST_COMMAND, TASK_SPECIFIC_COMMAND, TASK_SPECIFIC_COMMAND, DATA_COMMAND };
+    BenchmarkRouter router;
+
+    memset(handled, 0, sizeof(handled));
+    HostTest::Report("CommandRouter::Route", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        Command cm(commands[i & 3], static_cast<uint16_t>((i & 3) + 1));
+        router.Route(cm); }), "ns");
+    const uint32_t routed = handled[0] + handled[1] + handled[2];
+
+    memset(handled, 0, sizeof(handled));
+    HostTest::Report("switch", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        Command cm(commands[i & 3], static_cast<uint16_t>((i & 3) + 1));
+        HandleCommandSwitch(cm); }), "ns");
+
+    CHECK_EQUAL(COUNT / 4 * 3, routed);
+    CHECK_EQUAL(routed, handled[0] + handled[1] + handled[2]);
+}
+
+/* user-014 Task Logs --------------------------------------------------------*/
+HOST_TEST(Benchmark, TaskLogVsMutexStress)
+{
+    // Every task prints at once and yields between lines like tasks sharing a priority, the UARTTask drains on its own thread
+    constexpr uint8_t WRITERS = 4;
+    constexpr uint32_t LINES = 20000;
+    const char* const FORMAT = "[%u] Thermocouple %d: %.2f C, raw %x\n";
+
+    // Before, every task formatted into the buffer behind vaListMutex
+    std::mutex vaListMutex;
+    char sharedBuffer[TASK_LOG_FORMAT_BYTES];
+    std::atomic<uint64_t> lockWaitNs(0);
+    std::atomic<uint64_t> printNs(0);
+    std::thread writers[WRITERS];
+
+    for (uint8_t w = 0; w < WRITERS; w++) {
+        writers[w] = std::thread([&, w]() {
+            uint64_t waited = 0;
+            uint64_t printing = 0;
+            for (uint32_t i = 0; i < LINES; i++) {
+                const uint64_t start = HostTest::GetTimeNs();
+                vaListMutex.lock();
+                waited += HostTest::GetTimeNs() - start;
+                sink = FormatLibc(sharedBuffer, sizeof(sharedBuffer), FORMAT, i, w, i * 0.25, i);
+                vaListMutex.unlock();
+                printing += HostTest::GetTimeNs() - start;
+                std::this_thread::yield();
+            }
+            lockWaitNs += waited;
+            printNs += printing;
+        });
+    }
+    for (std::thread& writer : writers)
+        writer.join();
+
+    HostTest::Report("vaListMutex + vsnprintf, lock wait per line", static_cast<double>(lockWaitNs) / (WRITERS * LINES), "ns");
+    HostTest::Report("vaListMutex + vsnprintf, time in print per line", static_cast<double>(printNs) / (WRITERS * LINES), "ns");
+
+    // After, each task formats into its own log, there is no lock to wait for
+    static TaskLog logs[WRITERS];
+    std::atomic<bool> writing(true);
+    uint32_t drained = 0;
+    std::thread consumer([&]() {
+        uint8_t line[TASK_LOG_FORMAT_BYTES];
+        bool last = false;
+        while (!last) {
+            last = !writing;
+            for (TaskLog& log : logs) {
+                while (log.Read(line, sizeof(line)) > 0)
+                    drained++;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    printNs = 0;
+    for (uint8_t w = 0; w < WRITERS; w++) {
+        writers[w] = std::thread([&, w]() {
+            uint64_t printing = 0;
+            for (uint32_t i = 0; i < LINES; i++) {
+                const uint64_t start = HostTest::GetTimeNs();
+                WriteLine(logs[w], FORMAT, i, w, i * 0.25, i);
+                printing += HostTest::GetTimeNs() - start;
+                std::this_thread::yield();
+            }
+            printNs += printing;
+        });
+    }
+    for (std::thread& writer : writers)
+        writer.join();
+    writing = false;
+    consumer.join();
+
+    uint32_t dropped = 0;
+    for (TaskLog& log : logs)
+        dropped += log.GetDroppedCount();
+
+    HostTest::Report("TaskLog, lock wait per line", 0, "ns");
+    HostTest::Report("TaskLog, time in print per line", static_cast<double>(printNs) / (WRITERS * LINES), "ns");
+    HostTest::Report("TaskLog, lines dropped on a full ring", dropped, "lines");
+    CHECK_EQUAL(WRITERS * LINES, drained + dropped);
+}
+
+/* user-018 Suppression ------------------------------------------------------*/
+HOST_TEST(Benchmark, LogLimiterOverhead)
+{
+    constexpr uint32_t COUNT = 200000;
+    static const char callSites[2] = {};
+    char buffer[TASK_LOG_FORMAT_BYTES];
+
+    // A call site printing within its burst every window
+    HostTest::Report("LogLimiter::Allow, allowed", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = LogLimiter::Allow(&callSites[0], false);
+        if ((i + 1) % LOG_LIMIT_BURST == 0)
+            HostRtos::AdvanceMs(LOG_LIMIT_WINDOW_MS); }), "ns");
+
+    // A call site repeating every cycle, what each suppressed line saves
+    uint32_t allowed = 0;
+    HostTest::Report("LogLimiter::Allow, suppressed", HostTest::MeasureNs(COUNT, [&](uint32_t) {
+        allowed += LogLimiter::Allow(&callSites[1], false) ? 1 : 0; }), "ns");
+    HostTest::Report("Format of the line it suppresses", HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        sink = Utils::FormatString(buffer, sizeof(buffer), "There is an Error with Thermocouple %d\n", (int32_t)(i & 1) + 1); }), "ns");
+
+    CHECK_EQUAL(LOG_LIMIT_BURST, allowed);
+    HostRtos::ClearPrinted();
+}
+
+/* user-012 Compact Queue ----------------------------------------------------*/
+namespace {
+    /**
+     * @brief Fills a burst of commands, one in three each without a payload, with a 4 byte inline payload
+     *        and with a pool payload, as the tasks send them
+    */
+    void FillBurst(Command* cms, uint16_t count, uint32_t seed)
+    {
+        for (uint16_t i = 0; i < count; i++) {
+            new (&cms[i]) Command(DATA_COMMAND, (uint16_t)(seed + i));
+            if (i % 3 == 1)
+                memset(cms[i].AllocateData(4), i, 4);
+            else if (i % 3 == 2)
+                memset(cms[i].AllocateData(40), i, 40);
+        }
+    }
+}
+
+HOST_TEST(Benchmark, CompactQueueVsCommandQueue)
+{
+    constexpr uint32_t COUNT = 20000;
+    constexpr uint16_t BURST = DEFAULT_QUEUE_SIZE;
+    Command sent[BURST];
+    Command received;
+
+    // Before, the RTOS queue copied the whole Command in and out
+    QueueHandle_t rawQueue = xQueueCreate(BURST, sizeof(Command));
+    const double rawNs = HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        FillBurst(sent, BURST, i);
+        for (uint16_t j = 0; j < BURST; j++)
+            xQueueGenericSend(rawQueue, &sent[j], DEFAULT_QUEUE_SEND_WAIT_TICKS, queueSEND_TO_BACK);
+        for (uint16_t j = 0; j < BURST; j++) {
+            xQueueReceive(rawQueue, &received, 0);
+            sink = received.GetTaskCommand();
+            received.Reset();
+        }
+    });
+
+    Queue queue(BURST);
+    const double compactNs = HostTest::MeasureNs(COUNT, [&](uint32_t i) {
+        FillBurst(sent, BURST, i);
+        for (uint16_t j = 0; j < BURST; j++)
+            queue.Send(sent[j]);
+        for (uint16_t j = 0; j < BURST; j++) {
+            queue.Receive(received);
+            sink = received.GetTaskCommand();
+            received.Reset();
+        }
+    });
+
+    // The host copies 32 bytes about as fast as 8, on the target the copy runs byte by byte in the kernel
+    HostTest::Report("Command queue, send + receive per command", rawNs / BURST, "ns");
+    HostTest::Report("CompactCommand queue, send + receive per command", compactNs / BURST, "ns");
+    HostTest::Report("Command queue storage, DEFAULT_QUEUE_SIZE deep", DEFAULT_QUEUE_SIZE * sizeof(Command), "B");
+    HostTest::Report("CompactCommand queue storage, DEFAULT_QUEUE_SIZE deep", DEFAULT_QUEUE_SIZE * sizeof(CompactCommand), "B");
+
+    QueueStats stats;
+    queue.GetStats(stats);
+    CHECK_EQUAL(COUNT * BURST, stats.sendCount);
+    CHECK_EQUAL(0, stats.dropCount);
+}
+
+/* user-025 UART Channels ----------------------------------------------------*/
+namespace {
+    constexpr uint16_t FRAME_BYTES = 40;                // Telemetry frame, 3.5ms on the wire at 115200 baud
+    constexpr uint32_t FRAME_PERIOD_MS = 20;
+    constexpr uint16_t FRAMES_PER_PHASE = 40;           // Sent without, then with the debug load
+    constexpr uint32_t PHASE_MS = FRAMES_PER_PHASE * FRAME_PERIOD_MS;
+    constexpr uint16_t DEBUG_LINE_BYTES = 120;          // Sent every ms, ~10x what the debug UART carries
+
+    struct ChannelLoad
+    {
+        bool (*sendFrame)(const UARTSegment* segments, uint8_t count);
+        Queue* debugQueue;      // Queue and lane debug lines are sent to, as print() outside a task does
+        uint8_t debugLane;
+    };
+
+    struct FrameLatency
+    {
+        double meanMs;
+        double maxMs;
+        uint16_t count;         // Frames that reached the wire whole
+    };
+
+    uint64_t frameSentNs[2 * FRAMES_PER_PHASE];
+    uint64_t loadStartNs = 0;
+    uint8_t serialTxBuffers[2 * UART_DMA_TX_BUFFER_BYTES];
+    UARTTxRing serialTxRing;
+    Queue* serialQueue = nullptr;
+
+    // Attaches the driver instances to the interrupts of the register model, as RunInterface does
+    void AttachUARTInterrupts()
+    {
+        HostPeripherals::SetIrqHandler(USART1_IRQn, [] { Driver::uart1.HandleIRQ_UART(); });
+        HostPeripherals::SetIrqHandler(UART5_IRQn, [] { Driver::uart5.HandleIRQ_UART(); });
+        HostPeripherals::SetIrqHandler(DMA1_Stream7_IRQn, [] { Driver::uart5.HandleIRQ_TxDMA(); });
+        HostPeripherals::SetIrqHandler(DMA2_Stream2_IRQn, [] { Driver::uart1.HandleIRQ_RxDMA(); });
+    }
+
+    // Sends a frame through the serial task as one buffer
+    bool SendFrameSerially(const UARTSegment* segments, uint8_t count)
+    {
+        Command cmd(DATA_COMMAND, (uint16_t)UART_TASK_COMMAND_SEND_PROTOCOL);
+        uint8_t* frame = cmd.AllocateData(FRAME_BYTES);
+        for (uint8_t i = 0; i < count; i++) {
+            memcpy(frame, segments[i].data, segments[i].len);
+            frame += segments[i].len;
+        }
+        return serialQueue->Send(cmd);
+    }
+
+    // Before, one task sent every command in turn and waited for its UART, so a frame queued behind debug
+    // output waited for that output's wire time
+    void SendSerially(void* context)
+    {
+        (void)context;
+        Command cm;
+        while (true) {
+            if (!serialQueue->ReceiveWait(cm))
+                continue;
+
+            UARTDriver* uart = (cm.GetTaskCommand() == UART_TASK_COMMAND_SEND_DEBUG) ? UART::Debug : UART::Protocol;
+            uart->Transmit(cm.GetDataPointer(), cm.GetDataSize());
+            cm.Reset();
+        }
+    }
+
+    // Protocol task, sends a numbered frame every period as a header and a body segment, and overwrites both
+    // right away as segments may be reused once the send returns
+    void SendFrames(void* context)
+    {
+        const ChannelLoad& load = *static_cast<const ChannelLoad*>(context);
+        uint8_t header[2];
+        uint8_t body[FRAME_BYTES - sizeof(header)];
+
+        for (uint16_t seq = 0; seq < 2 * FRAMES_PER_PHASE; seq++) {
+            header[0] = 0xA5;
+            header[1] = (uint8_t)seq;
+            for (uint16_t i = 0; i < sizeof(body); i++)
+                body[i] = (uint8_t)(seq + i);
+
+            const UARTSegment segments[] = { { header, sizeof(header) }, { body, sizeof(body) } };
+            frameSentNs[seq] = HostRtos::GetTimeNs();
+            load.sendFrame(segments, 2);
+
+            memset(header, 0xEE, sizeof(header));
+            memset(body, 0xEE, sizeof(body));
+            vTaskDelay(MS_TO_TICKS(FRAME_PERIOD_MS));
+        }
+    }
+
+    // Debug output of every task at once, idle for the first phase then a line every tick
+    void SendDebugLoad(void* context)
+    {
+        const ChannelLoad& load = *static_cast<const ChannelLoad*>(context);
+        uint8_t line[DEBUG_LINE_BYTES];
+        memset(line, 'd', sizeof(line));
+        line[sizeof(line) - 1] = '\n';
+
+        vTaskDelay(MS_TO_TICKS(PHASE_MS));
+        loadStartNs = HostRtos::GetTimeNs();
+        for (TickType_t tick = 0; tick < MS_TO_TICKS(PHASE_MS); tick++) {
+            Command cmd(DATA_COMMAND, (uint16_t)UART_TASK_COMMAND_SEND_DEBUG);
+            cmd.CopyDataToCommand(line, sizeof(line));
+            load.debugQueue->Send(cmd, load.debugLane);
+            vTaskDelay(1);
+        }
+    }
+
+    /**
+     * @brief Finds the frames of one phase on the protocol wire, from the send to the end of the last byte
+     * @param first Sequence number of the first frame of the phase
+    */
+    FrameLatency MeasureFrames(uint16_t first)
+    {
+        const std::vector<HostWireByte>& wire = HostPeripherals::GetTransmitted(USART1);
+        FrameLatency latency = { 0, 0, 0 };
+
+        for (size_t pos = 0; pos + FRAME_BYTES <= wire.size(); pos += FRAME_BYTES) {
+            const uint16_t seq = wire[pos + 1].value;
+            bool intact = (wire[pos].value == 0xA5 && seq < 2 * FRAMES_PER_PHASE);
+            for (uint16_t i = 2; i < FRAME_BYTES && intact; i++)
+                intact = (wire[pos + i].value == (uint8_t)(seq + i - 2));
+            if (!intact || seq < first || seq >= first + FRAMES_PER_PHASE)
+                continue;
+
+            const double ms = (wire[pos + FRAME_BYTES - 1].endNs - frameSentNs[seq]) / 1e6;
+            latency.meanMs += ms;
+            latency.maxMs = (ms > latency.maxMs) ? ms : latency.maxMs;
+            latency.count++;
+        }
+
+        if (latency.count > 0)
+            latency.meanMs /= latency.count;
+        return latency;
+    }
+
+    void ReportFrames(const char* label, const FrameLatency& latency)
+    {
+        char line[64];
+        snprintf(line, sizeof(line), "%s, mean frame latency", label);
+        HostTest::Report(line, latency.meanMs, "ms");
+        snprintf(line, sizeof(line), "%s, max frame latency", label);
+        HostTest::Report(line, latency.maxMs, "ms");
+        snprintf(line, sizeof(line), "%s, frames delivered", label);
+        HostTest::Report(line, latency.count, "frames");
+    }
+
+    // Debug bytes on the wire during the load phase, to show the debug UART was saturated
+    double GetDebugLoadBytes()
+    {
+        double bytes = 0;
+        for (const HostWireByte& byte : HostPeripherals::GetTransmitted(UART5))
+            bytes += (byte.endNs >= loadStartNs);
+        return bytes;
+    }
+}
+
+HOST_TEST(Benchmark, ProtocolLatencyUnderDebugLoad)
+{
+    // Before, one queue and one task for both UARTs, on the same drivers as the UARTTask configures them
+    HostPeripherals::Reset();
+    AttachUARTInterrupts();
+    Driver::uart5.ConfigureTxDMA(&Driver::dma1Stream7, serialTxBuffers);
+    Driver::uart1.ConfigureTxInterrupt(&serialTxRing);
+
+    Queue queue(UART_TASK_QUEUE_DEPTH_OBJS + UART_TASK_DEBUG_QUEUE_DEPTH_OBJS);
+    serialQueue = &queue;
+    ChannelLoad serialLoad = { SendFrameSerially, &queue, QUEUE_LANE_DEFAULT };
+    uint8_t handles[3];
+    HostRtos::CreateTask(SendSerially, nullptr, &handles[0]);
+    HostRtos::CreateTask(SendFrames, &serialLoad, &handles[1]);
+    HostRtos::CreateTask(SendDebugLoad, &serialLoad, &handles[2]);
+    HostRtos::RunTasks(2 * PHASE_MS + 100);
+
+    const FrameLatency serialIdle = MeasureFrames(0);
+    const FrameLatency serialLoaded = MeasureFrames(FRAMES_PER_PHASE);
+    const double serialDebugBytes = GetDebugLoadBytes();
+
+    // Let the transfers in flight finish and release what the serial task did not get to
+    Driver::uart5.FlushTx();
+    Driver::uart1.FlushTx();
+    Command cm;
+    while (queue.Receive(cm))
+        cm.Reset();
+
+    // After, the UARTTask schedules each channel on its own
+    HostPeripherals::Reset();
+    AttachUARTInterrupts();
+    UARTTask::Inst().InitTask();
+
+    ChannelLoad taskLoad = { UARTTask::SendProtocolSegments, UARTTask::Inst().GetEventQueue(), QUEUE_LANE_DEBUG };
+    HostRtos::CreateTask(SendFrames, &taskLoad, &handles[1]);
+    HostRtos::CreateTask(SendDebugLoad, &taskLoad, &handles[2]);
+    HostRtos::RunTasks(2 * PHASE_MS + 100);
+
+    const FrameLatency taskIdle = MeasureFrames(0);
+    const FrameLatency taskLoaded = MeasureFrames(FRAMES_PER_PHASE);
+
+    ReportFrames("serial task, idle debug", serialIdle);
+    ReportFrames("serial task, debug load", serialLoaded);
+    HostTest::Report("serial task, debug bytes sent under load", serialDebugBytes, "B");
+    ReportFrames("UARTTask, idle debug", taskIdle);
+    ReportFrames("UARTTask, debug load", taskLoaded);
+    HostTest::Report("UARTTask, debug bytes sent under load", GetDebugLoadBytes(), "B");
+
+    // Every frame arrives as it was when sent, the burst latency is the only wait, debug load adds nothing
+    CHECK_EQUAL(FRAMES_PER_PHASE, taskIdle.count);
+    CHECK_EQUAL(FRAMES_PER_PHASE, taskLoaded.count);
+    CHECK(taskIdle.maxMs <= UART_TASK_BURST_LATENCY_MS + 5);
+    CHECK(taskLoaded.maxMs <= taskIdle.maxMs + 1);
+}
@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * File Name          : BinaryLogTest.cpp
+ * Description        : Host tests for BinaryLog, the wire format the decoder
+ *    expects and a full ring dropping records.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "BinaryLog.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    const char* const TEMP_FORMAT = "Temp %d C, mass %f kg, %s\n";
+    const char* const COUNT_FORMAT = "Count %u\n";
+
+    struct DecodedRecord
+    {
+        uint8_t sync;
+        uint8_t argCount;
+        uint32_t formatAddress;
+        uint32_t timestamp_ms;
+        uint32_t args[BINARY_LOG_MAX_ARGS];
+    };
+
+    uint32_t ReadWord(const uint8_t* bytes)
+    {
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    // Reads one record the way binary_log_decoder.py does, returns its size
+    uint16_t Decode(const uint8_t* bytes, DecodedRecord& record)
+    {
+        record.sync = bytes[0];
+        record.argCount = bytes[1];
+        record.formatAddress = ReadWord(&bytes[2]);
+        record.timestamp_ms = ReadWord(&bytes[6]);
+        for (uint8_t i = 0; i < record.argCount && i < BINARY_LOG_MAX_ARGS; i++)
+            record.args[i] = ReadWord(&bytes[BINARY_LOG_RECORD_HEADER_BYTES + i * sizeof(uint32_t)]);
+        return BINARY_LOG_RECORD_HEADER_BYTES + record.argCount * sizeof(uint32_t);
+    }
+
+    uint32_t AddressOf(const char* format)
+    {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format));
+    }
+
+    void DrainAll()
+    {
+        uint8_t buffer[BINARY_LOG_RECORD_MAX_BYTES];
+        while (BinaryLog::Drain(buffer, sizeof(buffer)) > 0) {}
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(BinaryLog, EncodesRecordsInWireFormat)
+{
+    DrainAll();
+    HostRtos::AdvanceMs(1234);
+
+    const char* const sensorName = "IR";
+    BinaryLog::Write(TEMP_FORMAT, -40, 1.5f, sensorName);
+
+    uint8_t buffer[BINARY_LOG_RECORD_MAX_BYTES * 2];
+    const uint16_t len = BinaryLog::Drain(buffer, sizeof(buffer));
+    CHECK_EQUAL(BINARY_LOG_RECORD_HEADER_BYTES + 3 * sizeof(uint32_t), len);
+
+    DecodedRecord record;
+    Decode(buffer, record);
+    CHECK_EQUAL(BINARY_LOG_SYNC_BYTE, record.sync);
+    CHECK_EQUAL(3, record.argCount);
+    CHECK_EQUAL(AddressOf(TEMP_FORMAT), record.formatAddress);
+    CHECK_EQUAL(1234, record.timestamp_ms);
+    CHECK_EQUAL(0xFFFFFFD8UL, record.args[0]);
+    CHECK_EQUAL(0x3FC00000UL, record.args[1]);
+    CHECK_EQUAL(AddressOf(sensorName), record.args[2]);
+
+    CHECK_EQUAL(0, BinaryLog::Drain(buffer, sizeof(buffer)));
+}
+
+HOST_TEST(BinaryLog, DrainsOnlyWholeRecords)
+{
+    DrainAll();
+    BinaryLog::Write(COUNT_FORMAT, 1U);
+    BinaryLog::Write(COUNT_FORMAT, 2U);
+    BinaryLog::Write("No arguments\n");
+
+    const uint16_t countRecordBytes = BINARY_LOG_RECORD_HEADER_BYTES + sizeof(uint32_t);
+    uint8_t buffer[BINARY_LOG_RECORD_MAX_BYTES * 4];
+
+    CHECK_EQUAL(0, BinaryLog::Drain(buffer, countRecordBytes - 1));
+    CHECK_EQUAL(countRecordBytes, BinaryLog::Drain(buffer, countRecordBytes * 2 - 1));
+
+    const uint16_t len = BinaryLog::Drain(buffer, sizeof(buffer));
+    CHECK_EQUAL(countRecordBytes + BINARY_LOG_RECORD_HEADER_BYTES, len);
+
+    DecodedRecord record;
+    const uint16_t first = Decode(buffer, record);
+    CHECK_EQUAL(2, record.args[0]);
+    Decode(&buffer[first], record);
+    CHECK_EQUAL(0, record.argCount);
+}
+
+HOST_TEST(BinaryLog, DropsRecordsWhenTheRingIsFull)
+{
+    DrainAll();
+    const uint32_t dropped = BinaryLog::GetDroppedCount();
+
+    for (uint32_t i = 0; i < BINARY_LOG_RING_RECORDS + 5; i++)
+        BinaryLog::Write(COUNT_FORMAT, i);
+    CHECK_EQUAL(dropped + 5, BinaryLog::GetDroppedCount());
+
+    // The oldest records are kept, in order, one per drain
+    uint8_t buffer[BINARY_LOG_RECORD_HEADER_BYTES + sizeof(uint32_t)];
+    for (uint32_t i = 0; i < BINARY_LOG_RING_RECORDS; i++) {
+        if (!CHECK(BinaryLog::Drain(buffer, sizeof(buffer)) > 0))
+            return;
+        DecodedRecord record;
+        Decode(buffer, record);
+        CHECK_EQUAL(i, record.args[0]);
+    }
+    CHECK_EQUAL(0, BinaryLog::Drain(buffer, sizeof(buffer)));
+}
+
+HOST_TEST(BinaryLog, KeepsOrderAcrossManyLaps)
+{
+    DrainAll();
+    uint8_t buffer[BINARY_LOG_RECORD_MAX_BYTES * 8];
+    uint32_t next = 0;
+
+    for (uint32_t i = 0; i < BINARY_LOG_RING_RECORDS * 10; i++) {
+        BinaryLog::Write(COUNT_FORMAT, i);
+        if (i % 3 != 0)
+            continue;
+
+        const uint16_t len = BinaryLog::Drain(buffer, sizeof(buffer));
+        for (uint16_t offset = 0; offset < len; ) {
+            DecodedRecord record;
+            offset += Decode(&buffer[offset], record);
+            if (!CHECK_EQUAL(next, record.args[0]))
+                return;
+            next++;
+        }
+    }
+}
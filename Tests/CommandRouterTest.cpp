@@ -0,0 +1,162 @@
+/**
+ ******************************************************************************
+ * File Name          : CommandRouterTest.cpp
+ * Description        : Host tests for CommandRouter dispatch, the unsupported
+ *    handler and the reset of every routed command.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "CommandRouter.hpp"
+#include "CommandPool.hpp"
+
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    enum TEST_ROUTER_COMMANDS : uint16_t
+    {
+        TEST_ROUTER_PING = 1,
+        TEST_ROUTER_DATA,
+        TEST_ROUTER_UNHANDLED
+    };
+
+    enum OTHER_ROUTER_COMMANDS : uint16_t
+    {
+        OTHER_ROUTER_PING = 1
+    };
+
+    using TestPingMessage = CommandMessage<TASK_SPECIFIC_COMMAND, TEST_ROUTER_PING>;
+    using TestDataMessage = CommandMessage<DATA_COMMAND, TEST_ROUTER_DATA>;
+    using TestRequestMessage = CommandMessage<REQUEST_COMMAND, TEST_ROUTER_PING>;
+    using OtherPingMessage = CommandMessage<TASK_SPECIFIC_COMMAND, OTHER_ROUTER_PING>;
+
+    class TestRouter : public CommandRouter<TestRouter, TestPingMessage, TestDataMessage, TestRequestMessage>
+    {
+    public:
+        using CommandRouter::Route;
+
+        void OnMessage(const TestPingMessage&) { pingCount++; }
+        void OnMessage(const TestRequestMessage&) { requestCount++; }
+        void OnMessage(const TestDataMessage& msg)
+        {
+            dataSize = msg.cm.GetDataSize();
+            memcpy(data, msg.cm.GetDataPointer(), (dataSize < sizeof(data)) ? dataSize : sizeof(data));
+        }
+        void OnUnsupported(Command& cm) { unsupportedTaskCommand = cm.GetTaskCommand(); }
+
+        void SendCommand(Command cmd, uint8_t lane)
+        {
+            sentCommand = cmd.GetCommand();
+            sentTaskCommand = cmd.GetTaskCommand();
+            sentLane = lane;
+        }
+
+        uint16_t pingCount = 0;
+        uint16_t requestCount = 0;
+        uint16_t dataSize = 0;
+        uint8_t data[64] = {};
+        uint16_t unsupportedTaskCommand = 0;
+
+        GLOBAL_COMMANDS sentCommand = COMMAND_NONE;
+        uint16_t sentTaskCommand = 0;
+        uint8_t sentLane = QUEUE_LANE_COUNT;
+    };
+
+    // Keeps the default OnUnsupported
+    class DefaultRouter : public CommandRouter<DefaultRouter, TestPingMessage>
+    {
+    public:
+        using CommandRouter::Route;
+        void OnMessage(const TestPingMessage&) {}
+    };
+
+    static_assert(TestRouter::Accepts<TestDataMessage>(), "TestRouter handles TestDataMessage");
+    static_assert(!TestRouter::Accepts<OtherPingMessage>(), "Messages of other tasks are distinct types, even with the same key");
+
+    uint16_t GetPoolBlocksInUse()
+    {
+        uint16_t inUse = 0;
+        CommandPoolStats stats;
+        for (uint8_t poolClass = 0; CommandPool::GetStats(poolClass, stats); poolClass++)
+            inUse += stats.inUse;
+        return inUse;
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(CommandRouter, DispatchesOnCommandAndTaskCommand)
+{
+    TestRouter router;
+
+    Command ping(TASK_SPECIFIC_COMMAND, TEST_ROUTER_PING);
+    router.Route(ping);
+    CHECK_EQUAL(1, router.pingCount);
+    CHECK_EQUAL(0, router.requestCount);
+
+    // Same task command under another GLOBAL_COMMANDS is another message
+    Command request(REQUEST_COMMAND, TEST_ROUTER_PING);
+    router.Route(request);
+    CHECK_EQUAL(1, router.pingCount);
+    CHECK_EQUAL(1, router.requestCount);
+    CHECK_EQUAL(0, router.unsupportedTaskCommand);
+}
+
+HOST_TEST(CommandRouter, HandsTheDataToTheHandlerAndResetsIt)
+{
+    TestRouter router;
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    uint8_t payload[48];
+    for (uint8_t i = 0; i < sizeof(payload); i++)
+        payload[i] = i * 3;
+
+    Command cm(DATA_COMMAND, TEST_ROUTER_DATA);
+    CHECK(cm.CopyDataToCommand(payload, sizeof(payload)));
+    CHECK_EQUAL(blocksInUse + 1, GetPoolBlocksInUse());
+
+    router.Route(cm);
+    CHECK_EQUAL(sizeof(payload), router.dataSize);
+    CHECK(memcmp(payload, router.data, sizeof(payload)) == 0);
+
+    CHECK_EQUAL(0, cm.GetDataSize());
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+}
+
+HOST_TEST(CommandRouter, SendsAnythingElseToOnUnsupported)
+{
+    TestRouter router;
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    uint8_t payload[40] = {};
+    Command cm(TASK_SPECIFIC_COMMAND, TEST_ROUTER_UNHANDLED);
+    cm.CopyDataToCommand(payload, sizeof(payload));
+
+    router.Route(cm);
+    CHECK_EQUAL(TEST_ROUTER_UNHANDLED, router.unsupportedTaskCommand);
+    CHECK_EQUAL(0, router.pingCount);
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+}
+
+HOST_TEST(CommandRouter, WarnsAboutUnsupportedCommandsByDefault)
+{
+    DefaultRouter router;
+    HostRtos::ClearPrinted();
+
+    Command cm(DATA_COMMAND, 77);
+    router.Route(cm);
+    CHECK(strstr(HostRtos::GetPrinted(), "Received Unsupported Command {2, 77}") != nullptr);
+}
+
+HOST_TEST(CommandRouter, PostsOnTheRequestedLane)
+{
+    TestRouter router;
+
+    router.Post<TestPingMessage>();
+    CHECK_EQUAL(TASK_SPECIFIC_COMMAND, router.sentCommand);
+    CHECK_EQUAL(TEST_ROUTER_PING, router.sentTaskCommand);
+    CHECK_EQUAL(QUEUE_LANE_DEFAULT, router.sentLane);
+
+    router.Post<TestDataMessage>(QUEUE_LANE_CONTROL);
+    CHECK_EQUAL(DATA_COMMAND, router.sentCommand);
+    CHECK_EQUAL(QUEUE_LANE_CONTROL, router.sentLane);
+}
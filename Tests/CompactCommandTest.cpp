@@ -0,0 +1,327 @@
+/**
+ ******************************************************************************
+ * File Name          : CompactCommandTest.cpp
+ * Description        : Host tests for the CompactCommand encodings, each payload
+ *    kind round trips and stale handles are rejected.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "CompactCommand.hpp"
+#include "CommandPool.hpp"
+#include "SharedBuffer.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    constexpr uint16_t TEST_TASK_COMMAND = 0x1234;
+
+    uint16_t GetPoolBlocksInUse()
+    {
+        uint16_t inUse = 0;
+        CommandPoolStats stats;
+        for (uint8_t poolClass = 0; CommandPool::GetStats(poolClass, stats); poolClass++)
+            inUse += stats.inUse;
+        return inUse;
+    }
+
+    uint16_t GetSlotsInUse()
+    {
+        CommandSlotStats stats;
+        CompactCommand::GetSlotStats(stats);
+        return stats.inUse;
+    }
+
+    void Fill(uint8_t* data, uint16_t size, uint8_t seed)
+    {
+        for (uint16_t i = 0; i < size; i++)
+            data[i] = (uint8_t)(seed + i * 7);
+    }
+
+    bool IsFilled(const uint8_t* data, uint16_t size, uint8_t seed)
+    {
+        for (uint16_t i = 0; i < size; i++) {
+            if (data[i] != (uint8_t)(seed + i * 7))
+                return false;
+        }
+        return true;
+    }
+
+    uint8_t staticBuffer[64];
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(CompactCommand, CommandsWithoutPayloadKeepTheirCommands)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+
+    Command cm(TASK_SPECIFIC_COMMAND, TEST_TASK_COMMAND);
+    CompactCommand packed;
+    CHECK(packed.Pack(cm));
+    CHECK(!packed.HasPayload());
+    CHECK_EQUAL(TASK_SPECIFIC_COMMAND, packed.GetCommand());
+    CHECK_EQUAL(TEST_TASK_COMMAND, packed.GetTaskCommand());
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+
+    Command out;
+    CHECK(packed.Unpack(out));
+    CHECK_EQUAL(TASK_SPECIFIC_COMMAND, out.GetCommand());
+    CHECK_EQUAL(TEST_TASK_COMMAND, out.GetTaskCommand());
+    CHECK_EQUAL(0, out.GetDataSize());
+}
+
+HOST_TEST(CompactCommand, InlinePayloadsOfUpToFourBytesTravelInTheCompactCommand)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+
+    for (uint16_t size = 1; size <= COMPACT_COMMAND_INLINE_BYTES; size++) {
+        Command cm(DATA_COMMAND, size);
+        Fill(cm.AllocateData(size), size, size);
+
+        CompactCommand packed;
+        CHECK(packed.Pack(cm));
+        CHECK_EQUAL(size, packed.GetDataSize());
+        CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+
+        Command out;
+        CHECK(packed.Unpack(out));
+        CHECK_EQUAL(size, out.GetTaskCommand());
+        CHECK_EQUAL(size, out.GetDataSize());
+        CHECK(IsFilled(out.GetDataPointer(), size, size));
+        out.Reset();
+    }
+}
+
+HOST_TEST(CompactCommand, LargerInlinePayloadsAreParkedInASlot)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    for (uint16_t size = COMPACT_COMMAND_INLINE_BYTES + 1; size <= COMMAND_INLINE_DATA_SIZE; size++) {
+        Command cm(DATA_COMMAND, size);
+        Fill(cm.AllocateData(size), size, size);
+        CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+
+        CompactCommand packed;
+        CHECK(packed.Pack(cm));
+        CHECK_EQUAL(size, packed.GetDataSize());
+        CHECK_EQUAL(slotsInUse + 1, GetSlotsInUse());
+
+        Command out;
+        CHECK(packed.Unpack(out));
+        CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+        CHECK_EQUAL(size, out.GetDataSize());
+        CHECK(IsFilled(out.GetDataPointer(), size, size));
+        out.Reset();
+    }
+}
+
+HOST_TEST(CompactCommand, PoolBlocksTravelAsClassIndexAndGeneration)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+    const uint16_t sizes[] = { 20, 50, 100, 200 };    // One per size class, smallest first
+
+    for (uint8_t poolClass = 0; poolClass < sizeof(sizes) / sizeof(sizes[0]); poolClass++) {
+        const uint16_t size = sizes[poolClass];
+        Command cm(DATA_COMMAND, TEST_TASK_COMMAND);
+        uint8_t* data = cm.AllocateData(size);
+        Fill(data, size, poolClass);
+
+        uint16_t handle = 0;
+        CHECK(CommandPool::GetHandle(data, handle));
+        CHECK_EQUAL(poolClass, handle >> 14);
+        CHECK(CommandPool::FromHandle(handle) == data);
+
+        CompactCommand packed;
+        CHECK(packed.Pack(cm));
+        CHECK_EQUAL(size, packed.GetDataSize());
+        CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+
+        // The block moves with the handle, it is not copied
+        Command out;
+        CHECK(packed.Unpack(out));
+        CHECK(out.GetDataPointer() == data);
+        CHECK_EQUAL(size, out.GetDataSize());
+        CHECK(IsFilled(out.GetDataPointer(), size, poolClass));
+
+        // Freeing the block moves its generation on, the old handle no longer decodes
+        out.Reset();
+        CHECK(CommandPool::FromHandle(handle) == nullptr);
+    }
+
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+}
+
+HOST_TEST(CompactCommand, SharedBuffersKeepTheCommandReference)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+
+    SharedBuffer* buf = SharedBufferPool::Allocate();
+    CHECK(buf != nullptr);
+    Fill(SharedBufferPool::GetData(buf), 40, 3);
+
+    Command cm(DATA_COMMAND, TEST_TASK_COMMAND);
+    CHECK(cm.SetCommandToSharedBuffer(buf, 40));
+    CHECK_EQUAL(2, buf->get_reference_counter().get_reference_count());
+
+    // The command's reference moves with the handle, the count is unchanged while queued
+    CompactCommand packed;
+    CHECK(packed.Pack(cm));
+    CHECK_EQUAL(40, packed.GetDataSize());
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+    CHECK_EQUAL(2, buf->get_reference_counter().get_reference_count());
+
+    Command out;
+    CHECK(packed.Unpack(out));
+    CHECK(out.GetDataPointer() == SharedBufferPool::GetData(buf));
+    CHECK_EQUAL(40, out.GetDataSize());
+    CHECK_EQUAL(2, buf->get_reference_counter().get_reference_count());
+
+    const uint16_t handle = SharedBufferPool::GetHandle(buf);
+    out.Reset();
+    CHECK_EQUAL(1, buf->get_reference_counter().get_reference_count());
+    SharedBufferPool::Release(buf);
+    CHECK(SharedBufferPool::FromHandle(handle) == nullptr);
+}
+
+HOST_TEST(CompactCommand, StaticBuffersAndHeapBlocksAreParkedInASlot)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    const uint32_t heapFallbacks = CommandPool::GetHeapFallbackCount();
+
+    Command external(DATA_COMMAND, TEST_TASK_COMMAND);
+    CHECK(external.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+
+    CompactCommand packedExternal;
+    CHECK(packedExternal.Pack(external));
+    CHECK_EQUAL(slotsInUse + 1, GetSlotsInUse());
+
+    // Larger than the largest size class, so the payload comes from the heap and has no pool handle
+    Command heap(DATA_COMMAND, TEST_TASK_COMMAND);
+    uint8_t* heapData = heap.AllocateData(300);
+    Fill(heapData, 300, 9);
+    CHECK_EQUAL(heapFallbacks + 1, CommandPool::GetHeapFallbackCount());
+
+    CompactCommand packedHeap;
+    CHECK(packedHeap.Pack(heap));
+    CHECK_EQUAL(300, packedHeap.GetDataSize());
+    CHECK_EQUAL(slotsInUse + 2, GetSlotsInUse());
+
+    Command out;
+    CHECK(packedExternal.Unpack(out));
+    CHECK(out.GetDataPointer() == staticBuffer);
+    CHECK_EQUAL(sizeof(staticBuffer), out.GetDataSize());
+    out.Reset();
+
+    CHECK(packedHeap.Unpack(out));
+    CHECK(out.GetDataPointer() == heapData);
+    CHECK(IsFilled(out.GetDataPointer(), 300, 9));
+    out.Reset();
+
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+}
+
+HOST_TEST(CompactCommand, PackFailsWhenEverySlotIsInUse)
+{
+    CommandSlotStats before;
+    CompactCommand::GetSlotStats(before);
+    CHECK_EQUAL(COMMAND_SLOT_COUNT, before.capacity);
+
+    Command cm(DATA_COMMAND, TEST_TASK_COMMAND);
+    CHECK(cm.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+
+    CompactCommand packed[COMMAND_SLOT_COUNT];
+    for (uint16_t i = before.inUse; i < COMMAND_SLOT_COUNT; i++)
+        CHECK(packed[i].Pack(cm));
+
+    CompactCommand overflow;
+    CHECK(!overflow.Pack(cm));
+
+    // Commands that need no slot still pack with the table full
+    Command small(DATA_COMMAND, TEST_TASK_COMMAND);
+    small.AllocateData(2);
+    CHECK(overflow.Pack(small));
+
+    CommandSlotStats full;
+    CompactCommand::GetSlotStats(full);
+    CHECK_EQUAL(COMMAND_SLOT_COUNT, full.inUse);
+    CHECK_EQUAL(COMMAND_SLOT_COUNT, full.highWater);
+    CHECK_EQUAL(before.exhaustionCount + 1, full.exhaustionCount);
+
+    Command out;
+    for (uint16_t i = before.inUse; i < COMMAND_SLOT_COUNT; i++)
+        CHECK(packed[i].Unpack(out));
+    CHECK_EQUAL(before.inUse, GetSlotsInUse());
+}
+
+HOST_TEST(CompactCommand, StaleSlotHandlesAreRejected)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+
+    Command cm(DATA_COMMAND, TEST_TASK_COMMAND);
+    CHECK(cm.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+
+    CompactCommand packed;
+    CHECK(packed.Pack(cm));
+    const CompactCommand duplicate = packed;
+
+    Command out;
+    CHECK(packed.Unpack(out));
+    CHECK(!packed.HasPayload());
+
+    // A second unpack of the same handle finds the slot free
+    CompactCommand stale = duplicate;
+    CHECK(!stale.Unpack(out));
+
+    // Once every slot is reused the old handle's slot holds a newer generation, it must not decode to that command
+    CompactCommand reused[COMMAND_SLOT_COUNT];
+    for (uint16_t i = slotsInUse; i < COMMAND_SLOT_COUNT; i++)
+        CHECK(reused[i].Pack(cm));
+
+    stale = duplicate;
+    CHECK(!stale.Unpack(out));
+    CHECK_EQUAL(COMMAND_SLOT_COUNT, GetSlotsInUse());
+
+    for (uint16_t i = slotsInUse; i < COMMAND_SLOT_COUNT; i++)
+        CHECK(reused[i].Unpack(out));
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+}
+
+HOST_TEST(CompactCommand, StalePoolAndSharedHandlesAreRejected)
+{
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    Command cm(DATA_COMMAND, TEST_TASK_COMMAND);
+    cm.AllocateData(40);
+
+    CompactCommand packed;
+    CHECK(packed.Pack(cm));
+    const CompactCommand duplicate = packed;
+
+    Command out;
+    CHECK(packed.Unpack(out));
+    out.Reset();
+
+    // The freed block may already belong to another command, the old handle must not reach it
+    Command next(DATA_COMMAND, TEST_TASK_COMMAND);
+    next.AllocateData(40);
+    CompactCommand stale = duplicate;
+    CHECK(!stale.Unpack(out));
+    next.Reset();
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+
+    SharedBuffer* buf = SharedBufferPool::Allocate();
+    Command shared(DATA_COMMAND, TEST_TASK_COMMAND);
+    CHECK(shared.SetCommandToSharedBuffer(buf, 8));
+    CHECK(packed.Pack(shared));
+    const CompactCommand sharedDuplicate = packed;
+
+    CHECK(packed.Unpack(out));
+    out.Reset();
+    SharedBufferPool::Release(buf);
+
+    stale = sharedDuplicate;
+    CHECK(!stale.Unpack(out));
+}
@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * File Name          : CrashRecordTest.cpp
+ * Description        : Host tests for CrashRecord, a record saved before a reset
+ *    is reported once at the next boot and then cleared. A boot is simulated by
+ *    calling CrashRecord::Init() with the no-init record left as it was.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "CrashRecord.hpp"
+#include "SystemDefines.hpp"
+#include "Utils.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    void SaveRecord(const char* file, uint16_t line, const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        CrashRecord::Save(file, line, format, args);
+        va_end(args);
+    }
+
+    // Resets with the given RCC flags set, only the no-init record survives
+    void SimulateBoot(uint32_t resetFlags)
+    {
+        HostRtos::Reset();
+        HostRtos::ClearPrinted();
+        HostHal::SetResetFlags(resetFlags);
+        CrashRecord::Init();
+    }
+
+    bool HasValidCrc(const CrashRecordData& record)
+    {
+        CrashRecordData copy = record;
+        return Utils::getCRC16(reinterpret_cast<uint8_t*>(&copy), offsetof(CrashRecordData, crc)) == record.crc;
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(CrashRecord, PowerOnHasNoRecord)
+{
+    SimulateBoot(RCC_FLAG_PORRST | RCC_FLAG_PINRST);
+    CHECK_STRING("Power On", CrashRecord::GetResetReason());
+    CHECK(CrashRecord::GetLast() == nullptr);
+    CHECK_EQUAL(0, HostHal::GetResetFlags());
+}
+
+HOST_TEST(CrashRecord, SavedRecordIsReportedOnceAfterAReset)
+{
+    HostRtos::AdvanceMs(1500);
+    SaveRecord("/home/soar/Avionics/Components/Sensors/BarometerTask.cpp", 321, "Barometer %s %d", "timeout", 7);
+
+    SimulateBoot(RCC_FLAG_SFTRST | RCC_FLAG_PINRST);
+    CHECK_STRING("Software", CrashRecord::GetResetReason());
+
+    const CrashRecordData* record = CrashRecord::GetLast();
+    CHECK(record != nullptr);
+    if (record == nullptr)
+        return;
+
+    CHECK_EQUAL(CRASH_RECORD_MAGIC, record->magic);
+    CHECK(HasValidCrc(*record));
+    CHECK_EQUAL(1500, record->timestamp_ms);
+    CHECK_EQUAL(321, record->line);
+    CHECK_STRING("cs/Components/Sensors/BarometerTask.cpp", record->file);    // Only the end of the path fits
+    CHECK_STRING("HostTask", record->task);
+    CHECK_STRING("Barometer timeout 7", record->message);
+
+    CrashRecord::PrintLast();
+    CHECK(strstr(HostRtos::GetPrinted(), "System Reset Reason: Software") != nullptr);
+    CHECK(strstr(HostRtos::GetPrinted(), "-- LAST CRASH -- Assert in [") != nullptr);
+    CHECK(strstr(HostRtos::GetPrinted(), "Message: Barometer timeout 7") != nullptr);
+
+    // The record was invalidated when it was taken, a second reset reports nothing
+    SimulateBoot(RCC_FLAG_IWDGRST | RCC_FLAG_PINRST);
+    CHECK_STRING("Independent Watchdog", CrashRecord::GetResetReason());
+    CHECK(CrashRecord::GetLast() == nullptr);
+
+    CrashRecord::PrintLast();
+    CHECK(strstr(HostRtos::GetPrinted(), "System Reset Reason: Independent Watchdog") != nullptr);
+    CHECK(strstr(HostRtos::GetPrinted(), "LAST CRASH") == nullptr);
+}
+
+HOST_TEST(CrashRecord, RecordsTheContextOfTheAssert)
+{
+    HostRtos::SetInsideInterrupt(true);
+    SaveRecord("Short.cpp", 10, nullptr);
+    SimulateBoot(RCC_FLAG_SFTRST);
+
+    const CrashRecordData* record = CrashRecord::GetLast();
+    CHECK(record != nullptr);
+    if (record == nullptr)
+        return;
+    CHECK_STRING("ISR", record->task);
+    CHECK_STRING("Short.cpp", record->file);
+    CHECK_STRING("", record->message);
+
+    HostRtos::SetSchedulerRunning(false);
+    SaveRecord("Short.cpp", 11, "Before the scheduler");
+    SimulateBoot(RCC_FLAG_SFTRST);
+
+    record = CrashRecord::GetLast();
+    CHECK(record != nullptr);
+    if (record == nullptr)
+        return;
+    CHECK_STRING("None", record->task);
+    CHECK_EQUAL(11, record->line);
+    CHECK(HasValidCrc(*record));
+}
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * File Name          : DataTopicTest.cpp
+ * Description        : Host tests for DataTopic, latest sample and bounded history.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "DataTopic.hpp"
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    struct TestSample
+    {
+        int32_t value;
+        uint32_t timestamp_ms;
+    };
+
+    constexpr uint8_t TEST_TOPIC_DEPTH = 4;
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(DataTopic, HasNoSampleBeforeThePublisher)
+{
+    DataTopic<TestSample, TEST_TOPIC_DEPTH> topic;
+    TestSample sample = { -1, 0 };
+    uint32_t seq = 99;
+
+    CHECK(!topic.GetLatest(sample, seq));
+    CHECK_EQUAL(0, seq);
+    CHECK_EQUAL(-1, sample.value);
+    CHECK_EQUAL(0, topic.GetHistory(&sample, 1));
+    CHECK_EQUAL(0, topic.GetSequence());
+}
+
+HOST_TEST(DataTopic, ReturnsTheLatestSample)
+{
+    DataTopic<TestSample, TEST_TOPIC_DEPTH> topic;
+    TestSample sample;
+    uint32_t seq;
+
+    topic.Publish({ 10, 100 });
+    CHECK(topic.GetLatest(sample, seq));
+    CHECK_EQUAL(1, seq);
+    CHECK_EQUAL(10, sample.value);
+
+    topic.Publish({ -20, 200 });
+    CHECK(topic.GetLatest(sample, seq));
+    CHECK_EQUAL(2, seq);
+    CHECK_EQUAL(-20, sample.value);
+    CHECK_EQUAL(200, sample.timestamp_ms);
+}
+
+HOST_TEST(DataTopic, KeepsTheMostRecentHistoryOldestFirst)
+{
+    DataTopic<TestSample, TEST_TOPIC_DEPTH> topic;
+    for (int32_t i = 1; i <= 10; i++)
+        topic.Publish({ i, static_cast<uint32_t>(i * 10) });
+
+    TestSample samples[TEST_TOPIC_DEPTH + 2];
+    CHECK_EQUAL(TEST_TOPIC_DEPTH, topic.GetHistory(samples, TEST_TOPIC_DEPTH + 2));
+    for (uint8_t i = 0; i < TEST_TOPIC_DEPTH; i++)
+        CHECK_EQUAL(7 + i, samples[i].value);
+
+    // Fewer than the depth gives the newest ones, still oldest first
+    CHECK_EQUAL(2, topic.GetHistory(samples, 2));
+    CHECK_EQUAL(9, samples[0].value);
+    CHECK_EQUAL(10, samples[1].value);
+
+    CHECK_EQUAL(10, topic.GetSequence());
+}
@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * File Name          : DebugRxRingTest.cpp
+ * Description        : Host tests for DebugRxRing, a paste into the debug UART at
+ *    115200 baud reaches the DebugTask as whole lines without losing bytes.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "DebugRxRing.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    constexpr uint32_t BAUD_RATE = 115200;
+    constexpr double BYTE_TIME_US = 10.0 * 1000000 / BAUD_RATE;    // 8N1, 86.8us per byte
+
+    /**
+     * @brief Feeds text to the ring one byte per UART frame, as the receive interrupt does. A woken task runs
+     *        taskLatencyUs later, standing in for the other priority 2 tasks it waits behind.
+     * @return Every line the task handled, in order
+    */
+    std::vector<std::string> Paste(DebugRxRing& ring, const std::string& text, double taskLatencyUs)
+    {
+        std::vector<std::string> lines;
+        auto runTask = [&]() { ring.Process([&](const char* line) { lines.emplace_back(line); }); };
+
+        bool taskPending = false;
+        double taskRunUs = 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            const double nowUs = i * BYTE_TIME_US;
+            if (taskPending && taskRunUs <= nowUs) {
+                runTask();
+                taskPending = false;
+            }
+
+            if (ring.Push((uint8_t)text[i]) && !taskPending) {
+                taskPending = true;
+                taskRunUs = nowUs + taskLatencyUs;
+            }
+        }
+
+        if (taskPending)
+            runTask();
+        return lines;
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(DebugRxRing, PastedCommandsArriveWhole)
+{
+    const char* commands[] = { "loglevel thermocouple verbose", "loglevel loadcell debug", "sysinfo", "uartinfo",
+        "queueinfo", "poolinfo", "lccal 1000", "loglevel all warn" };
+
+    std::string text;
+    for (const char* command : commands)
+        text += std::string(command) + "\r";
+
+    // Every line wakes the task, which is held off for 5ms of 1ms time slices
+    DebugRxRing ring;
+    const std::vector<std::string> lines = Paste(ring, text, 5000);
+
+    CHECK_EQUAL(0, ring.GetOverflowCount());
+    CHECK_EQUAL(sizeof(commands) / sizeof(commands[0]), lines.size());
+    for (size_t i = 0; i < lines.size() && i < sizeof(commands) / sizeof(commands[0]); i++)
+        CHECK_STRING(commands[i], lines[i].c_str());
+}
+
+HOST_TEST(DebugRxRing, LongPasteIsSplitWithoutLosingBytes)
+{
+    // One 200 character line between commands, longer than the line buffer and than the wake threshold
+    std::string longLine;
+    for (uint16_t i = 0; i < 200; i++)
+        longLine += (char)('a' + i % 26);
+    const std::string text = "sysinfo\r" + longLine + "\rpoolinfo\r";
+
+    // The long line only wakes the task once DEBUG_RX_RING_WAKE_BYTES are pending, the rest of the ring is the slack
+    DebugRxRing ring;
+    const std::vector<std::string> lines = Paste(ring, text, 15000);
+    CHECK_EQUAL(0, ring.GetOverflowCount());
+
+    CHECK(lines.size() >= 3);
+    if (lines.size() < 3)
+        return;
+    CHECK_STRING("sysinfo", lines.front().c_str());
+    CHECK_STRING("poolinfo", lines.back().c_str());
+
+    std::string rejoined;
+    for (size_t i = 1; i + 1 < lines.size(); i++) {
+        CHECK(lines[i].size() <= DEBUG_RX_BUFFER_SZ_BYTES);
+        rejoined += lines[i];
+    }
+    CHECK_STRING(longLine.c_str(), rejoined.c_str());
+    CHECK_EQUAL((longLine.size() + DEBUG_RX_BUFFER_SZ_BYTES - 1) / DEBUG_RX_BUFFER_SZ_BYTES, lines.size() - 2);
+}
+
+HOST_TEST(DebugRxRing, LineOfExactlyTheBufferSizeIsOneLine)
+{
+    const std::string full(DEBUG_RX_BUFFER_SZ_BYTES, 'x');
+
+    DebugRxRing ring;
+    std::vector<std::string> lines = Paste(ring, full + "\r", 0);
+    CHECK_EQUAL(1, lines.size());
+    CHECK_EQUAL(DEBUG_RX_BUFFER_SZ_BYTES, lines.empty() ? 0 : lines[0].size());
+
+    lines = Paste(ring, full + "y\r", 0);
+    CHECK_EQUAL(2, lines.size());
+    CHECK_STRING("y", lines.empty() ? "" : lines.back().c_str());
+}
+
+HOST_TEST(DebugRxRing, BytesAreCountedWhenTheTaskFallsBehind)
+{
+    // A task that never runs, the ring keeps the oldest bytes and counts the rest
+    DebugRxRing ring;
+    for (uint16_t i = 0; i < DEBUG_RX_RING_SZ_BYTES + 10; i++)
+        ring.Push('a');
+    CHECK_EQUAL(10, ring.GetOverflowCount());
+
+    // Once the task catches up the ring takes bytes again
+    std::vector<std::string> lines;
+    ring.Process([&](const char* line) { lines.emplace_back(line); });
+    CHECK(ring.Push('\r'));
+    ring.Process([&](const char* line) { lines.emplace_back(line); });
+    CHECK_EQUAL(10, ring.GetOverflowCount());
+
+    size_t received = 0;
+    for (const std::string& line : lines)
+        received += line.size();
+    CHECK_EQUAL(DEBUG_RX_RING_SZ_BYTES, received);
+}
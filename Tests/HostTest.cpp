@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * File Name          : HostTest.cpp
+ * Description        : Runs the registered host tests, every suite by default or
+ *    the suites named on the command line. Returns non-zero if a check failed.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "cmsis_os.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+/* Variables -----------------------------------------------------------------*/
+namespace {
+    constexpr uint16_t MAX_TESTS = 128;
+
+    struct TestCase
+    {
+        const char* suite;
+        const char* name;
+        HostTest::TestFunction function;
+    };
+
+    TestCase tests[MAX_TESTS];
+    uint16_t testCount = 0;
+    uint32_t failureCount = 0;
+    const TestCase* currentTest = nullptr;
+
+    void ReportFailure(const char* file, int line)
+    {
+        failureCount++;
+        printf("FAIL %s.%s (%s:%d): ", currentTest->suite, currentTest->name, file, line);
+    }
+}
+
+/* Function Implementation ---------------------------------------------------*/
+HostTest::Registration::Registration(const char* suite, const char* name, TestFunction function)
+{
+    if (testCount < MAX_TESTS)
+        tests[testCount++] = { suite, name, function };
+}
+
+bool HostTest::Check(bool passed, const char* expr, const char* file, int line)
+{
+    if (!passed) {
+        ReportFailure(file, line);
+        printf("%s\n", expr);
+    }
+    return passed;
+}
+
+bool HostTest::CheckEqual(long long expected, long long actual, const char* expr, const char* file, int line)
+{
+    if (expected != actual) {
+        ReportFailure(file, line);
+        printf("%s is %lld, expected %lld\n", expr, actual, expected);
+    }
+    return expected == actual;
+}
+
+bool HostTest::CheckString(const char* expected, const char* actual, const char* expr, const char* file, int line)
+{
+    const bool passed = strcmp(expected, actual) == 0;
+    if (!passed) {
+        ReportFailure(file, line);
+        printf("%s is \"%s\", expected \"%s\"\n", expr, actual, expected);
+    }
+    return passed;
+}
+
+uint64_t HostTest::GetTimeNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void HostTest::Report(const char* label, double value, const char* unit)
+{
+    printf("  %s.%s: %-48s %10.1f %s\n", currentTest->suite, currentTest->name, label, value, unit);
+}
+
+int main(int argc, char** argv)
+{
+    uint16_t runCount = 0;
+
+    for (uint16_t i = 0; i < testCount; i++) {
+        bool selected = (argc < 2);
+        for (int arg = 1; arg < argc; arg++)
+            selected |= (strcmp(argv[arg], tests[i].suite) == 0);
+        if (!selected)
+            continue;
+
+        currentTest = &tests[i];
+        HostRtos::Reset();
+        tests[i].function();
+        runCount++;
+    }
+
+    printf("%u tests, %u failed checks\n", runCount, failureCount);
+    return (runCount == 0 || failureCount != 0) ? 1 : 0;
+}
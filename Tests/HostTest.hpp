@@ -0,0 +1,57 @@
+/**
+ ******************************************************************************
+ * File Name          : HostTest.hpp
+ * Description        : Minimal test registry and checks for the host tests, no
+ *    framework is needed to build them.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_HOST_TEST_HPP
+#define SOAR_TESTS_HOST_TEST_HPP
+/* Includes ------------------------------------------------------------------*/
+#include <cstdint>
+
+/* Macros --------------------------------------------------------------------*/
+// Defines a test case in a suite, the suite name selects tests on the command line
+// Example Usage: HOST_TEST(TaskLog, ReadsLinesInOrder) { CHECK(...); }
+#define HOST_TEST(suite, name) \
+    static void suite##_##name(); \
+    static HostTest::Registration suite##_##name##_registration(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(expr) HostTest::Check((expr), #expr, __FILE__, __LINE__)
+#define CHECK_EQUAL(expected, actual) HostTest::CheckEqual(static_cast<long long>(expected), static_cast<long long>(actual), #actual, __FILE__, __LINE__)
+#define CHECK_STRING(expected, actual) HostTest::CheckString((expected), (actual), #actual, __FILE__, __LINE__)
+
+/* Functions -----------------------------------------------------------------*/
+namespace HostTest
+{
+    typedef void (*TestFunction)();
+
+    struct Registration
+    {
+        Registration(const char* suite, const char* name, TestFunction function);
+    };
+
+    bool Check(bool passed, const char* expr, const char* file, int line);
+    bool CheckEqual(long long expected, long long actual, const char* expr, const char* file, int line);
+    bool CheckString(const char* expected, const char* actual, const char* expr, const char* file, int line);
+
+    // Benchmarks
+    uint64_t GetTimeNs();    // Monotonic host clock
+    void Report(const char* label, double value, const char* unit);    // Prints a result of the running test
+
+    /**
+     * @brief Runs a function count times on the host clock, the function gets the iteration number
+     * @return Mean time per call in ns
+    */
+    template <typename TFunction>
+    double MeasureNs(uint32_t count, TFunction function)
+    {
+        const uint64_t start = GetTimeNs();
+        for (uint32_t i = 0; i < count; i++)
+            function(i);
+        return static_cast<double>(GetTimeNs() - start) / count;
+    }
+}
+
+#endif /* SOAR_TESTS_HOST_TEST_HPP */
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * File Name          : LogLimiterTest.cpp
+ * Description        : Host tests for LogLimiter, per call site windows, the
+ *    suppressed summary and call sites the table can not track.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "LogLimiter.hpp"
+#include "BinaryLog.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    // Call site keys are only compared by address, these stand in for format strings
+    char callSites[4096];
+
+    /**
+     * @brief Same as the home slot in LogLimiter.cpp, to pick call sites that collide
+    */
+    uint8_t GetHomeSlot(const char* format)
+    {
+        const uint32_t address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format));
+        return (static_cast<uint32_t>((address >> 2) * 2654435761UL) >> 24) & (LOG_LIMIT_TABLE_SIZE - 1);
+    }
+
+    uint16_t CountAllowed(const char* format, uint16_t attempts, bool binary)
+    {
+        uint16_t allowed = 0;
+        for (uint16_t i = 0; i < attempts; i++)
+            allowed += LogLimiter::Allow(format, binary) ? 1 : 0;
+        return allowed;
+    }
+
+    void DrainAll()
+    {
+        uint8_t buffer[BINARY_LOG_RECORD_MAX_BYTES];
+        while (BinaryLog::Drain(buffer, sizeof(buffer)) > 0) {}
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(LogLimiter, AllowsABurstPerWindow)
+{
+    const char* const site = "Sensor disconnected\n";
+    const uint32_t suppressed = LogLimiter::GetSuppressedCount();
+
+    CHECK_EQUAL(LOG_LIMIT_BURST, CountAllowed(site, 20, false));
+    CHECK_EQUAL(suppressed + 20 - LOG_LIMIT_BURST, LogLimiter::GetSuppressedCount());
+
+    // Still the same window
+    HostRtos::AdvanceMs(LOG_LIMIT_WINDOW_MS - 1);
+    CHECK_EQUAL(0, CountAllowed(site, 3, false));
+
+    HostRtos::AdvanceMs(1);
+    CHECK_EQUAL(LOG_LIMIT_BURST, CountAllowed(site, 10, false));
+}
+
+HOST_TEST(LogLimiter, PrintsWhatTheLastWindowSuppressed)
+{
+    const char* const site = "Queue full\n";
+    CountAllowed(site, LOG_LIMIT_BURST + 7, false);
+
+    HostRtos::ClearPrinted();
+    HostRtos::AdvanceMs(LOG_LIMIT_WINDOW_MS);
+    CHECK(LogLimiter::Allow(site, false));
+    CHECK_STRING("[7 repeats suppressed] Queue full\n", HostRtos::GetPrinted());
+
+    // Nothing was suppressed in the window that just ended
+    HostRtos::ClearPrinted();
+    HostRtos::AdvanceMs(LOG_LIMIT_WINDOW_MS);
+    CHECK(LogLimiter::Allow(site, false));
+    CHECK_STRING("", HostRtos::GetPrinted());
+}
+
+HOST_TEST(LogLimiter, WritesTheSummaryOfBinaryStatementsAsARecord)
+{
+    const char* const site = "Sample %d\n";
+    CountAllowed(site, LOG_LIMIT_BURST + 3, true);
+
+    DrainAll();
+    HostRtos::ClearPrinted();
+    HostRtos::AdvanceMs(LOG_LIMIT_WINDOW_MS);
+    CHECK(LogLimiter::Allow(site, true));
+    CHECK_STRING("", HostRtos::GetPrinted());
+
+    uint8_t buffer[BINARY_LOG_RECORD_MAX_BYTES];
+    CHECK_EQUAL(BINARY_LOG_RECORD_HEADER_BYTES + 2 * sizeof(uint32_t), BinaryLog::Drain(buffer, sizeof(buffer)));
+    CHECK_EQUAL(2, buffer[1]);
+    CHECK_EQUAL(3, buffer[BINARY_LOG_RECORD_HEADER_BYTES]);
+
+    uint32_t formatWord;
+    memcpy(&formatWord, &buffer[BINARY_LOG_RECORD_HEADER_BYTES + sizeof(uint32_t)], sizeof(formatWord));
+    CHECK_EQUAL(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(site)), formatWord);
+}
+
+HOST_TEST(LogLimiter, LimitsEachCallSiteOnItsOwn)
+{
+    const char* const first = "First site\n";
+    const char* const second = "Second site\n";
+
+    CHECK_EQUAL(LOG_LIMIT_BURST, CountAllowed(first, 10, false));
+    CHECK_EQUAL(LOG_LIMIT_BURST, CountAllowed(second, 10, false));
+}
+
+HOST_TEST(LogLimiter, LetsUntrackedCallSitesThrough)
+{
+    // Pick call sites sharing one home slot, after LOG_LIMIT_MAX_PROBES of them every probed entry is taken
+    const char* sites[LOG_LIMIT_MAX_PROBES + 1];
+    uint8_t found = 0;
+    const uint8_t home = GetHomeSlot(&callSites[0]);
+    for (uint16_t offset = 0; offset < sizeof(callSites) && found < LOG_LIMIT_MAX_PROBES + 1; offset += 4) {
+        if (GetHomeSlot(&callSites[offset]) == home)
+            sites[found++] = &callSites[offset];
+    }
+    if (!CHECK_EQUAL(LOG_LIMIT_MAX_PROBES + 1, found))
+        return;
+
+    for (uint8_t i = 0; i < LOG_LIMIT_MAX_PROBES; i++)
+        LogLimiter::Allow(sites[i], false);
+
+    CHECK_EQUAL(50, CountAllowed(sites[LOG_LIMIT_MAX_PROBES], 50, false));
+}
@@ -0,0 +1,326 @@
+/**
+ ******************************************************************************
+ * File Name          : QueueTest.cpp
+ * Description        : Host tests for Queue, commands round trip through the RTOS
+ *    queues as CompactCommands and every send policy releases what it drops.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "Queue.hpp"
+#include "CommandPool.hpp"
+#include "SharedBuffer.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    // Exposes the RTOS handle so a test can corrupt what is queued
+    class TestQueue : public Queue
+    {
+    public:
+        using Queue::Queue;
+        QueueHandle_t GetHandle() const { return rtQueueHandle; }
+    };
+
+    uint16_t GetPoolBlocksInUse()
+    {
+        uint16_t inUse = 0;
+        CommandPoolStats stats;
+        for (uint8_t poolClass = 0; CommandPool::GetStats(poolClass, stats); poolClass++)
+            inUse += stats.inUse;
+        return inUse;
+    }
+
+    uint16_t GetSlotsInUse()
+    {
+        CommandSlotStats stats;
+        CompactCommand::GetSlotStats(stats);
+        return stats.inUse;
+    }
+
+    // Sends a command with a pool payload, its first byte is the value
+    bool SendPoolCommand(Queue& queue, uint8_t value, uint8_t lane = QUEUE_LANE_DEFAULT)
+    {
+        Command cm(DATA_COMMAND, value);
+        memset(cm.AllocateData(40), value, 40);
+        return queue.Send(cm, lane);
+    }
+
+    uint8_t staticBuffer[32];
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(Queue, EveryPayloadKindRoundTrips)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    alignas(CompactCommand) static uint8_t storage[8 * sizeof(CompactCommand)];
+    static StaticQueue_t queueBuffer;
+    Queue queue(8, storage, &queueBuffer);
+
+    Command none(CONTROL_ACTION, 1);
+    CHECK(queue.Send(none));
+
+    Command small(DATA_COMMAND, 2);
+    memcpy(small.AllocateData(3), "abc", 3);
+    CHECK(queue.Send(small));
+
+    Command large(DATA_COMMAND, 3);
+    memcpy(large.AllocateData(7), "abcdefg", 7);
+    CHECK(queue.Send(large));
+
+    CHECK(SendPoolCommand(queue, 4));
+
+    SharedBuffer* buf = SharedBufferPool::Allocate();
+    memcpy(SharedBufferPool::GetData(buf), "shared", 6);
+    Command shared(DATA_COMMAND, 5);
+    CHECK(shared.SetCommandToSharedBuffer(buf, 6));
+    SharedBufferPool::Release(buf);
+    CHECK(queue.Send(shared));
+
+    Command external(DATA_COMMAND, 6);
+    CHECK(external.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+    CHECK(queue.Send(external));
+
+    CHECK_EQUAL(6, queue.GetQueueMessageCount());
+    CHECK_EQUAL(slotsInUse + 2, GetSlotsInUse());
+
+    Command cm;
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(CONTROL_ACTION, cm.GetCommand());
+    CHECK_EQUAL(0, cm.GetDataSize());
+
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(2, cm.GetTaskCommand());
+    CHECK_EQUAL(3, cm.GetDataSize());
+    CHECK(memcmp(cm.GetDataPointer(), "abc", 3) == 0);
+    cm.Reset();
+
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(3, cm.GetTaskCommand());
+    CHECK_EQUAL(7, cm.GetDataSize());
+    CHECK(memcmp(cm.GetDataPointer(), "abcdefg", 7) == 0);
+    cm.Reset();
+
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(4, cm.GetTaskCommand());
+    CHECK_EQUAL(40, cm.GetDataSize());
+    CHECK_EQUAL(4, cm.GetDataPointer()[39]);
+    cm.Reset();
+
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(5, cm.GetTaskCommand());
+    CHECK(memcmp(cm.GetDataPointer(), "shared", 6) == 0);
+    CHECK_EQUAL(1, buf->get_reference_counter().get_reference_count());
+    cm.Reset();
+
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(6, cm.GetTaskCommand());
+    CHECK(cm.GetDataPointer() == staticBuffer);
+    cm.Reset();
+
+    CHECK(!queue.Receive(cm));
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+
+    QueueStats stats;
+    queue.GetStats(stats);
+    CHECK_EQUAL(6, stats.sendCount);
+    CHECK_EQUAL(0, stats.dropCount);
+    CHECK_EQUAL(6, stats.highWater);
+}
+
+HOST_TEST(Queue, LanesAreReceivedInPriorityOrder)
+{
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+    Queue queue({ 2, 4, 4 });
+
+    CHECK(SendPoolCommand(queue, 1, QUEUE_LANE_DEBUG));
+    CHECK(SendPoolCommand(queue, 2, QUEUE_LANE_DEFAULT));
+    CHECK(SendPoolCommand(queue, 3, QUEUE_LANE_CONTROL));
+    CHECK(SendPoolCommand(queue, 4, QUEUE_LANE_DEFAULT));
+    CHECK_EQUAL(4, queue.GetQueueMessageCount());
+
+    // A receiver may hold back a lane, the lane count stays in step
+    Command cm;
+    CHECK(queue.ReceiveFromLane(cm, QUEUE_LANE_DEBUG));
+    CHECK_EQUAL(1, cm.GetTaskCommand());
+    cm.Reset();
+    CHECK_EQUAL(3, queue.GetQueueMessageCount());
+
+    const uint8_t expected[] = { 3, 2, 4 };
+    for (uint8_t value : expected) {
+        CHECK(queue.Receive(cm));
+        CHECK_EQUAL(value, cm.GetTaskCommand());
+        CHECK_EQUAL(value, cm.GetDataPointer()[0]);
+        cm.Reset();
+    }
+
+    CHECK(!queue.Receive(cm, 5));
+    CHECK_EQUAL(0, queue.GetQueueMessageCount());
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+}
+
+HOST_TEST(Queue, SendToFrontIsReceivedFirst)
+{
+    Queue queue(4);
+
+    Command first(CONTROL_ACTION, 1);
+    Command urgent(CONTROL_ACTION, 2);
+    CHECK(queue.Send(first));
+    CHECK(queue.SendToFront(urgent));
+
+    Command cm;
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(2, cm.GetTaskCommand());
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(1, cm.GetTaskCommand());
+}
+
+HOST_TEST(Queue, BlockPolicyWaitsThenResetsTheNewCommand)
+{
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+    Queue queue(1);
+
+    CHECK(SendPoolCommand(queue, 1));
+    const TickType_t startTick = xTaskGetTickCount();
+    CHECK(!SendPoolCommand(queue, 2));
+    CHECK_EQUAL(DEFAULT_QUEUE_SEND_WAIT_TICKS, xTaskGetTickCount() - startTick);
+
+    QueueStats stats;
+    queue.GetStats(stats);
+    CHECK_EQUAL(1, stats.sendCount);
+    CHECK_EQUAL(1, stats.dropCount);
+    CHECK_EQUAL(DEFAULT_QUEUE_SEND_WAIT_TICKS, stats.blockedTicks);
+    CHECK_EQUAL(blocksInUse + 1, GetPoolBlocksInUse());
+
+    Command cm;
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(1, cm.GetTaskCommand());
+    cm.Reset();
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+}
+
+HOST_TEST(Queue, DropOldestReleasesTheDroppedPayloads)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    Queue queue({ 0, 2, 2 });
+    queue.SetSendPolicy(QUEUE_SEND_DROP_OLDEST, QUEUE_LANE_DEBUG);
+
+    SharedBuffer* buf = SharedBufferPool::Allocate();
+    Command shared(DATA_COMMAND, 1);
+    CHECK(shared.SetCommandToSharedBuffer(buf, 8));
+    CHECK(queue.Send(shared, QUEUE_LANE_DEBUG));
+
+    Command external(DATA_COMMAND, 2);
+    CHECK(external.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+    CHECK(queue.Send(external, QUEUE_LANE_DEBUG));
+    CHECK_EQUAL(2, buf->get_reference_counter().get_reference_count());
+    CHECK_EQUAL(slotsInUse + 1, GetSlotsInUse());
+
+    // Each send displaces the oldest command, which gives up its shared reference, slot and pool block
+    CHECK(SendPoolCommand(queue, 3, QUEUE_LANE_DEBUG));
+    CHECK_EQUAL(1, buf->get_reference_counter().get_reference_count());
+    CHECK(SendPoolCommand(queue, 4, QUEUE_LANE_DEBUG));
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+    CHECK(SendPoolCommand(queue, 5, QUEUE_LANE_DEBUG));
+    CHECK_EQUAL(blocksInUse + 2, GetPoolBlocksInUse());
+    CHECK_EQUAL(2, queue.GetQueueMessageCount());
+
+    // Other lanes keep the block policy
+    CHECK(SendPoolCommand(queue, 6, QUEUE_LANE_DEFAULT));
+
+    QueueStats stats;
+    queue.GetStats(stats);
+    CHECK_EQUAL(6, stats.sendCount);
+    CHECK_EQUAL(3, stats.dropCount);
+
+    const uint8_t expected[] = { 6, 4, 5 };
+    Command cm;
+    for (uint8_t value : expected) {
+        CHECK(queue.Receive(cm));
+        CHECK_EQUAL(value, cm.GetTaskCommand());
+        cm.Reset();
+    }
+
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+    SharedBufferPool::Release(buf);
+}
+
+HOST_TEST(Queue, OverwriteLatestReleasesTheReplacedCommand)
+{
+    const uint16_t blocksInUse = GetPoolBlocksInUse();
+
+    Queue queue(1);
+    queue.SetSendPolicy(QUEUE_SEND_OVERWRITE_LATEST);
+
+    CHECK(SendPoolCommand(queue, 1));
+    CHECK(SendPoolCommand(queue, 2));
+    CHECK_EQUAL(blocksInUse + 1, GetPoolBlocksInUse());
+    CHECK_EQUAL(1, queue.GetQueueMessageCount());
+
+    Command cm;
+    CHECK(queue.Receive(cm));
+    CHECK_EQUAL(2, cm.GetTaskCommand());
+    cm.Reset();
+
+    QueueStats stats;
+    queue.GetStats(stats);
+    CHECK_EQUAL(2, stats.sendCount);
+    CHECK_EQUAL(1, stats.dropCount);
+    CHECK_EQUAL(blocksInUse, GetPoolBlocksInUse());
+}
+
+HOST_TEST(Queue, FullSlotTableDropsTheCommand)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    Queue queue(4);
+
+    Command external(DATA_COMMAND, 1);
+    CHECK(external.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+
+    CompactCommand parked[COMMAND_SLOT_COUNT];
+    for (uint16_t i = slotsInUse; i < COMMAND_SLOT_COUNT; i++)
+        CHECK(parked[i].Pack(external));
+
+    // Dropped without waiting for queue space, as the queue is not the problem
+    const TickType_t startTick = xTaskGetTickCount();
+    CHECK(!queue.Send(external));
+    CHECK_EQUAL(startTick, xTaskGetTickCount());
+    CHECK_EQUAL(0, queue.GetQueueMessageCount());
+
+    QueueStats stats;
+    queue.GetStats(stats);
+    CHECK_EQUAL(1, stats.dropCount);
+
+    Command cm;
+    for (uint16_t i = slotsInUse; i < COMMAND_SLOT_COUNT; i++)
+        CHECK(parked[i].Unpack(cm));
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+}
+
+HOST_TEST(Queue, StaleHandleAssertsOnReceive)
+{
+    const uint16_t slotsInUse = GetSlotsInUse();
+    const uint32_t assertCount = HostRtos::GetAssertCount();
+    TestQueue queue(2);
+
+    Command external(DATA_COMMAND, 1);
+    CHECK(external.SetCommandToStaticExternalBuffer(staticBuffer, sizeof(staticBuffer)));
+    CHECK(queue.Send(external));
+
+    // Release the slot behind the queue's back, as a duplicated receive would
+    CompactCommand queued;
+    CHECK(xQueuePeek(queue.GetHandle(), &queued, 0) == pdTRUE);
+    Command cm;
+    CHECK(queued.Unpack(cm));
+    CHECK_EQUAL(slotsInUse, GetSlotsInUse());
+
+    CHECK(!queue.Receive(cm));
+    CHECK_EQUAL(assertCount + 1, HostRtos::GetAssertCount());
+    CHECK_EQUAL(0, queue.GetQueueMessageCount());
+}
@@ -0,0 +1,10 @@
+/**
+ ******************************************************************************
+ * File Name          : FreeRTOS.h
+ * Description        : Host stand-in, everything the components use is in cmsis_os.h
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_FREERTOS_H
+#define SOAR_TESTS_STUB_FREERTOS_H
+#include "cmsis_os.h"
+#endif /* SOAR_TESTS_STUB_FREERTOS_H */
@@ -0,0 +1,62 @@
+/**
+ ******************************************************************************
+ * File Name          : FreeRTOS.h
+ * Description        : Host configuration for building FreeRTOS heap_4.c as the
+ *    baseline of the allocator benchmark. The functions are renamed with a
+ *    Heap4 prefix so they do not replace pvPortMalloc of the stand-in RTOS,
+ *    and the scheduler locks do nothing as the benchmark is single threaded.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_HEAP4_FREERTOS_H
+#define SOAR_TESTS_STUB_HEAP4_FREERTOS_H
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+
+/* Configuration -------------------------------------------------------------*/
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configAPPLICATION_ALLOCATED_HEAP 0
+#define configTOTAL_HEAP_SIZE ((size_t)65536)    // Same as Core/Inc/FreeRTOSConfig.h
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configASSERT(x) ((void)0)
+
+#define portBYTE_ALIGNMENT 8
+#define portBYTE_ALIGNMENT_MASK (0x0007)
+#define portMAX_DELAY ((uint32_t)0xffffffffUL)
+#define portPOINTER_SIZE_TYPE size_t
+
+#define mtCOVERAGE_TEST_MARKER()
+#define traceMALLOC(pvAddress, uiSize)
+#define traceFREE(pvAddress, uiSize)
+
+#define taskENTER_CRITICAL() ((void)0)
+#define taskEXIT_CRITICAL() ((void)0)
+
+/* Renames -------------------------------------------------------------------*/
+#define pvPortMalloc Heap4Malloc
+#define vPortFree Heap4Free
+#define xPortGetFreeHeapSize Heap4GetFreeHeapSize
+#define xPortGetMinimumEverFreeHeapSize Heap4GetMinimumEverFreeHeapSize
+#define vPortInitialiseBlocks Heap4InitialiseBlocks
+#define vPortGetHeapStats Heap4GetHeapStats
+
+/* Types ---------------------------------------------------------------------*/
+typedef struct xHeapStats
+{
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;
+
+/* Functions -----------------------------------------------------------------*/
+static inline void vTaskSuspendAll(void) {}
+static inline long xTaskResumeAll(void) { return 1; }
+
+void* pvPortMalloc(size_t xSize);
+void vPortFree(void* pv);
+
+#endif /* SOAR_TESTS_STUB_HEAP4_FREERTOS_H */
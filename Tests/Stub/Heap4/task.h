@@ -0,0 +1,10 @@
+/**
+ ******************************************************************************
+ * File Name          : task.h
+ * Description        : Host stand-in, see FreeRTOS.h in this directory
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_HEAP4_TASK_H
+#define SOAR_TESTS_STUB_HEAP4_TASK_H
+#include "FreeRTOS.h"
+#endif /* SOAR_TESTS_STUB_HEAP4_TASK_H */
@@ -0,0 +1,35 @@
+/**
+ ******************************************************************************
+ * File Name          : HostKernel.hpp
+ * Description        : Internal to the stand-in RTOS, the kernel lock and the
+ *    blocking wait shared by HostRtos.cpp and HostQueue.cpp.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_HOST_KERNEL_HPP
+#define SOAR_TESTS_STUB_HOST_KERNEL_HPP
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+#include <functional>
+#include <mutex>
+
+/* Functions -----------------------------------------------------------------*/
+namespace HostKernel
+{
+    // Taken by critical sections, a suspended scheduler and every queue operation
+    std::recursive_mutex& GetLock();
+
+    /**
+     * @brief Waits until ready() holds, the caller holds the kernel lock once. A task thread sleeps until another
+     *        thread or the clock of RunTasks makes it ready or its timeout passes. Nothing else runs on the test
+     *        thread, so a wait there steps the peripheral hook until ready() holds or the timeout passes, or
+     *        without one moves time on by the timeout, then runs the delay hook before checking once more.
+     * @return ready() after the wait
+    */
+    bool Block(const std::function<bool()>& ready, TickType_t ticksToWait);
+
+    // Wakes waiting task threads to check their condition again, the caller holds the kernel lock
+    void Changed();
+}
+
+#endif /* SOAR_TESTS_STUB_HOST_KERNEL_HPP */
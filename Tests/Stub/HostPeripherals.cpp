@@ -0,0 +1,450 @@
+/**
+ ******************************************************************************
+ * File Name          : HostPeripherals.cpp
+ * Description        : Host register model of the USARTs and DMA streams, see
+ *    HostPeripherals.hpp. Everything runs under the kernel lock, the model is
+ *    stepped by the kernel's peripheral hook and the LL stand-ins call in from
+ *    task threads.
+ ******************************************************************************
+*/
+#include "HostPeripherals.hpp"
+#include "stm32f4xx_ll_dma.h"
+#include "stm32f4xx_ll_usart.h"
+#include "HostKernel.hpp"
+
+#include <deque>
+#include <map>
+#include <set>
+
+/* Variables -----------------------------------------------------------------*/
+namespace HostPeripherals {
+    USART_TypeDef usart1;
+    USART_TypeDef uart5;
+    DMA_TypeDef dma1;
+    DMA_TypeDef dma2;
+    DWT_Type dwt;
+    CoreDebug_Type coreDebug;
+}
+
+namespace {
+    constexpr uint32_t DEFAULT_BAUD_RATE = 115200;
+    constexpr uint8_t MAX_IRQ_CALLS = 8;        // An interrupt still pending after this many calls in a step waits for the next
+
+    // Stream flags in LISR/HISR, as decoded by DMAController
+    constexpr uint8_t DMA_FLAG_SHIFTS[4] = { 0, 6, 16, 22 };
+    constexpr uint32_t DMA_FLAG_TE = (1UL << 3);
+    constexpr uint32_t DMA_FLAG_HT = (1UL << 4);
+    constexpr uint32_t DMA_FLAG_TC = (1UL << 5);
+
+    struct UsartModel
+    {
+        USART_TypeDef* regs;
+        IRQn_Type irq;
+        uint64_t byteNs;                    // Frame time of one byte, 10 bits at 8N1
+
+        // Transmitter, the data register feeds the shift register
+        bool txHeld;
+        bool txFull;                        // A byte waits in the data register, TXE is clear
+        uint8_t txData;
+        bool txShifting;
+        uint8_t txShiftByte;
+        uint64_t txShiftEndNs;
+        std::vector<HostWireByte> wire;
+
+        // Receiver
+        std::deque<HostWireByte> rxPending; // Bytes on their way, with the time their stop bit ends
+        bool rxIdleArmed;                   // A byte was received, IDLE sets once the line stays quiet for a frame
+        uint64_t rxIdleNs;
+        bool statusRead;                    // SR was read, the next DR read clears IDLE and the errors
+
+        uint32_t txOverwrites;
+        uint32_t rxOverruns;
+        uint32_t stolenReads;
+    };
+
+    struct StreamModel
+    {
+        DMA_TypeDef* dma;
+        uint32_t index;
+        uint32_t length;                    // NDTR when the stream was enabled, reloaded in circular mode
+    };
+
+    uint8_t addressAnchor;                  // Static, memory given to a stream is found near it
+    UsartModel usarts[2];
+    StreamModel streams[16];                // DMA1 streams 0-7 then DMA2
+    std::map<int, std::function<void()>> irqHandlers;
+    std::set<int> enabledIrqs;
+    uint64_t irqsHeldUntilNs = 0;
+
+    UsartModel& GetModel(const USART_TypeDef* usart) { return (usart == USART1) ? usarts[0] : usarts[1]; }
+    StreamModel& GetModel(const DMA_TypeDef* dma, uint32_t stream) { return streams[(dma == DMA1 ? 0 : 8) + stream]; }
+
+    /**
+     * @brief Rebuilds a pointer from a 32 bit address, the upper bits are those of a static variable so the
+     *        address must be of static storage
+    */
+    uint8_t* FromAddress(uint32_t address)
+    {
+        const uint64_t anchor = reinterpret_cast<uintptr_t>(&addressAnchor);
+        uint64_t pointer = (anchor & ~0xFFFFFFFFULL) | address;
+        if (pointer > anchor + 0x80000000ULL)
+            pointer -= 0x100000000ULL;
+        else if (pointer + 0x80000000ULL < anchor)
+            pointer += 0x100000000ULL;
+        return reinterpret_cast<uint8_t*>(static_cast<uintptr_t>(pointer));
+    }
+
+    // Enabled stream serving the data register of a USART in a direction, nullptr if none
+    StreamModel* FindStream(const UsartModel& usart, uint32_t direction)
+    {
+        const uint32_t address = LL_USART_DMA_GetRegAddr(usart.regs);
+        for (StreamModel& model : streams) {
+            const DMA_Stream_TypeDef& stream = model.dma->stream[model.index];
+            if ((stream.CR & DMA_SxCR_EN) && stream.PAR == address && (stream.CR & DMA_SxCR_DIR_0) == direction && stream.NDTR > 0)
+                return &model;
+        }
+        return nullptr;
+    }
+
+    void SetStreamFlags(StreamModel& model, uint32_t flags)
+    {
+        HostDmaStatus& status = (model.index >= 4) ? model.dma->HISR : model.dma->LISR;
+        status.value |= flags << DMA_FLAG_SHIFTS[model.index & 3];
+    }
+
+    uint32_t GetStreamFlags(const StreamModel& model)
+    {
+        const HostDmaStatus& status = (model.index >= 4) ? model.dma->HISR : model.dma->LISR;
+        return status.value >> DMA_FLAG_SHIFTS[model.index & 3];
+    }
+
+    // Byte at the stream's current position
+    uint8_t* GetStreamMemory(const StreamModel& model)
+    {
+        const DMA_Stream_TypeDef& stream = model.dma->stream[model.index];
+        return FromAddress(stream.M0AR) + (model.length - stream.NDTR);
+    }
+
+    // Counts one item moved, sets HT and TC, and reloads or releases the stream at the end
+    void CountTransfer(StreamModel& model)
+    {
+        DMA_Stream_TypeDef& stream = model.dma->stream[model.index];
+        stream.NDTR--;
+        if (stream.NDTR == model.length / 2)
+            SetStreamFlags(model, DMA_FLAG_HT);
+        if (stream.NDTR > 0)
+            return;
+
+        SetStreamFlags(model, DMA_FLAG_TC);
+        if (stream.CR & DMA_SxCR_CIRC)
+            stream.NDTR = model.length;
+        else
+            stream.CR &= ~DMA_SxCR_EN;
+    }
+
+    // Moves the data register into the shift register if it is free
+    void StartShift(UsartModel& usart, uint64_t startNs)
+    {
+        if (usart.txShifting || !usart.txFull || usart.txHeld)
+            return;
+
+        usart.txShifting = true;
+        usart.txShiftByte = usart.txData;
+        usart.txShiftEndNs = startNs + usart.byteNs;
+        usart.txFull = false;
+        usart.regs->SR |= USART_SR_TXE;
+    }
+
+    void WriteTransmitData(UsartModel& usart, uint8_t value, uint64_t nowNs)
+    {
+        if (!(usart.regs->SR & USART_SR_TXE))
+            usart.txOverwrites++;
+
+        usart.txData = value;
+        usart.txFull = true;
+        usart.regs->SR &= ~(USART_SR_TXE | USART_SR_TC);
+        StartShift(usart, nowNs);
+    }
+
+    uint8_t ReadReceiveData(UsartModel& usart)
+    {
+        const uint8_t value = static_cast<uint8_t>(usart.regs->DR);
+        usart.regs->SR &= ~USART_SR_RXNE;
+        if (usart.statusRead) {
+            usart.regs->SR &= ~(USART_SR_IDLE | USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE);
+            usart.statusRead = false;
+        }
+        return value;
+    }
+
+    // The transmit stream refills the data register on every TXE
+    void ServeTxStream(UsartModel& usart, uint64_t nowNs)
+    {
+        while ((usart.regs->SR & USART_SR_TXE) && (usart.regs->CR3 & USART_CR3_DMAT)) {
+            StreamModel* stream = FindStream(usart, LL_DMA_DIRECTION_MEMORY_TO_PERIPH);
+            if (stream == nullptr)
+                return;
+
+            const uint8_t value = *GetStreamMemory(*stream);
+            CountTransfer(*stream);
+            WriteTransmitData(usart, value, nowNs);
+        }
+    }
+
+    // The receive stream empties the data register on every RXNE
+    void ServeRxStream(UsartModel& usart)
+    {
+        if (!(usart.regs->SR & USART_SR_RXNE) || !(usart.regs->CR3 & USART_CR3_DMAR))
+            return;
+
+        StreamModel* stream = FindStream(usart, LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+        if (stream == nullptr)
+            return;
+
+        *GetStreamMemory(*stream) = ReadReceiveData(usart);
+        CountTransfer(*stream);
+    }
+
+    void StepUsart(UsartModel& usart, uint64_t nowNs)
+    {
+        // Bytes leave back to back as long as the data register is refilled within a frame
+        StartShift(usart, nowNs);
+        while (true) {
+            ServeTxStream(usart, nowNs);
+            if (!usart.txShifting || usart.txShiftEndNs > nowNs)
+                break;
+
+            usart.wire.push_back({ usart.txShiftByte, usart.txShiftEndNs });
+            usart.txShifting = false;
+            if (usart.txFull)
+                StartShift(usart, usart.txShiftEndNs);
+            else
+                usart.regs->SR |= USART_SR_TC;
+        }
+
+        // The stream takes a received byte by the next step, an interrupt in the step it arrived still sees RXNE.
+        // A byte arriving while the last one is still in DR is lost.
+        ServeRxStream(usart);
+        while (!usart.rxPending.empty() && usart.rxPending.front().endNs <= nowNs) {
+            const HostWireByte received = usart.rxPending.front();
+            usart.rxPending.pop_front();
+            ServeRxStream(usart);
+
+            if (usart.rxIdleArmed && received.endNs - usart.byteNs >= usart.rxIdleNs) {
+                usart.regs->SR |= USART_SR_IDLE;
+                usart.rxIdleArmed = false;
+            }
+            if (usart.regs->SR & USART_SR_RXNE) {
+                usart.regs->SR |= USART_SR_ORE;
+                usart.rxOverruns++;
+            }
+            else {
+                usart.regs->DR = received.value;
+                usart.regs->SR |= USART_SR_RXNE;
+            }
+            usart.rxIdleArmed = true;
+            usart.rxIdleNs = received.endNs + usart.byteNs;
+        }
+
+        if (usart.rxIdleArmed && nowNs >= usart.rxIdleNs) {
+            usart.regs->SR |= USART_SR_IDLE;
+            usart.rxIdleArmed = false;
+        }
+    }
+
+    bool IsUsartIrqPending(const UsartModel& usart)
+    {
+        const uint32_t sr = usart.regs->SR;
+        const uint32_t cr1 = usart.regs->CR1;
+        return ((cr1 & USART_CR1_RXNEIE) && (sr & (USART_SR_RXNE | USART_SR_ORE)))
+            || ((cr1 & USART_CR1_TXEIE) && (sr & USART_SR_TXE))
+            || ((cr1 & USART_CR1_TCIE) && (sr & USART_SR_TC))
+            || ((cr1 & USART_CR1_IDLEIE) && (sr & USART_SR_IDLE));
+    }
+
+    bool IsStreamIrqPending(const StreamModel& model)
+    {
+        const uint32_t cr = model.dma->stream[model.index].CR;
+        const uint32_t flags = GetStreamFlags(model);
+        return ((cr & DMA_SxCR_TCIE) && (flags & DMA_FLAG_TC))
+            || ((cr & DMA_SxCR_HTIE) && (flags & DMA_FLAG_HT))
+            || ((cr & DMA_SxCR_TEIE) && (flags & DMA_FLAG_TE));
+    }
+
+    // Calls the handler of an enabled interrupt while its source is pending
+    template <typename TPending>
+    void RaiseIrq(int irq, TPending pending)
+    {
+        auto handler = irqHandlers.find(irq);
+        if (handler == irqHandlers.end() || enabledIrqs.count(irq) == 0)
+            return;
+
+        for (uint8_t i = 0; i < MAX_IRQ_CALLS && pending(); i++)
+            handler->second();
+    }
+
+    int GetStreamIrq(const StreamModel& model)
+    {
+        if (model.dma == DMA1 && model.index == LL_DMA_STREAM_7)
+            return DMA1_Stream7_IRQn;
+        if (model.dma == DMA2 && model.index == LL_DMA_STREAM_2)
+            return DMA2_Stream2_IRQn;
+        return -1;
+    }
+
+    // Peripheral hook of the kernel, moves every peripheral to the current time then runs the pending interrupts
+    void Step(void* context)
+    {
+        (void)context;
+        const uint64_t nowNs = HostRtos::GetTimeNs();
+        for (UsartModel& usart : usarts)
+            StepUsart(usart, nowNs);
+
+        if (nowNs < irqsHeldUntilNs)
+            return;
+        for (UsartModel& usart : usarts)
+            RaiseIrq(usart.irq, [&usart] { return IsUsartIrqPending(usart); });
+        for (StreamModel& model : streams)
+            RaiseIrq(GetStreamIrq(model), [&model] { return IsStreamIrqPending(model); });
+    }
+}
+
+/* Registers -----------------------------------------------------------------*/
+HostDmaStatus::operator uint32_t() const
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    return value;
+}
+
+HostDmaFlagClear& HostDmaFlagClear::operator=(uint32_t flags)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    status_.value &= ~flags;
+    return *this;
+}
+
+void LL_DMA_EnableStream(DMA_TypeDef* DMAx, uint32_t Stream)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    GetModel(DMAx, Stream).length = DMAx->stream[Stream].NDTR;
+    DMAx->stream[Stream].CR |= DMA_SxCR_EN;
+}
+
+uint32_t HostPeripherals::ReadRegister(const volatile uint32_t& reg)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    return reg;
+}
+
+void HostPeripherals::ModifyRegister(volatile uint32_t& reg, uint32_t clear, uint32_t set)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    reg = (reg & ~clear) | set;
+}
+
+uint32_t HostPeripherals::ReadStatus(USART_TypeDef* usart)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    GetModel(usart).statusRead = true;
+    return usart->SR;
+}
+
+/**
+ * @brief CPU read of DR, counted as stolen if a receive stream was meant to take the byte
+*/
+uint8_t HostPeripherals::ReadData(USART_TypeDef* usart)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    UsartModel& model = GetModel(usart);
+    if ((usart->CR3 & USART_CR3_DMAR) && (usart->SR & USART_SR_RXNE))
+        model.stolenReads++;
+    return ReadReceiveData(model);
+}
+
+void HostPeripherals::WriteData(USART_TypeDef* usart, uint8_t value)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    WriteTransmitData(GetModel(usart), value, HostRtos::GetTimeNs());
+}
+
+void HostPeripherals::EnableIRQ(IRQn_Type irq)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    enabledIrqs.insert(irq);
+}
+
+/* Host Control --------------------------------------------------------------*/
+void HostPeripherals::Reset()
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+
+    const IRQn_Type usartIrqs[2] = { USART1_IRQn, UART5_IRQn };
+    USART_TypeDef* usartRegs[2] = { USART1, UART5 };
+    for (uint8_t i = 0; i < 2; i++) {
+        *usartRegs[i] = { USART_SR_TXE | USART_SR_TC, 0, 0, 0 };
+        usarts[i] = UsartModel{};
+        usarts[i].regs = usartRegs[i];
+        usarts[i].irq = usartIrqs[i];
+    }
+    SetBaudRate(USART1, DEFAULT_BAUD_RATE);
+    SetBaudRate(UART5, DEFAULT_BAUD_RATE);
+
+    for (DMA_TypeDef* dma : { DMA1, DMA2 }) {
+        dma->LISR.value = 0;
+        dma->HISR.value = 0;
+        for (uint32_t s = 0; s < 8; s++) {
+            dma->stream[s] = {};
+            GetModel(dma, s) = { dma, s, 0 };
+        }
+    }
+
+    // The CubeMX init enables the USART interrupts, DMAController enables its stream's
+    irqHandlers.clear();
+    enabledIrqs = { USART1_IRQn, UART5_IRQn };
+    irqsHeldUntilNs = 0;
+    HostRtos::SetPeripheralHook(Step, nullptr);
+}
+
+void HostPeripherals::SetBaudRate(USART_TypeDef* usart, uint32_t baud)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    GetModel(usart).byteNs = 10ULL * 1000000000ULL / baud;
+}
+
+void HostPeripherals::SetIrqHandler(IRQn_Type irq, std::function<void()> handler)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    if (handler)
+        irqHandlers[irq] = handler;
+    else
+        irqHandlers.erase(irq);
+}
+
+void HostPeripherals::HoldTx(USART_TypeDef* usart, bool hold)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    GetModel(usart).txHeld = hold;
+}
+
+void HostPeripherals::HoldIrqs(uint64_t untilNs)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    irqsHeldUntilNs = untilNs;
+}
+
+void HostPeripherals::Receive(USART_TypeDef* usart, const uint8_t* data, uint16_t len)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    UsartModel& model = GetModel(usart);
+
+    uint64_t endNs = model.rxPending.empty() ? HostRtos::GetTimeNs() : model.rxPending.back().endNs;
+    for (uint16_t i = 0; i < len; i++) {
+        endNs += model.byteNs;
+        model.rxPending.push_back({ data[i], endNs });
+    }
+}
+
+const std::vector<HostWireByte>& HostPeripherals::GetTransmitted(USART_TypeDef* usart) { return GetModel(usart).wire; }
+uint32_t HostPeripherals::GetTxOverwriteCount(USART_TypeDef* usart) { return GetModel(usart).txOverwrites; }
+uint32_t HostPeripherals::GetRxOverrunCount(USART_TypeDef* usart) { return GetModel(usart).rxOverruns; }
+uint32_t HostPeripherals::GetStolenReadCount(USART_TypeDef* usart) { return GetModel(usart).stolenReads; }
@@ -0,0 +1,163 @@
+/**
+ ******************************************************************************
+ * File Name          : HostPeripherals.hpp
+ * Description        : Host register model of the USARTs and DMA streams the
+ *    UART driver uses, and the LL, NVIC and DWT calls it makes on them. Bytes
+ *    take their frame time on the wire, TXE, TC, RXNE, IDLE and ORE behave as
+ *    on the STM32F4 and a stream moves one byte per USART request. The model
+ *    runs as the kernel's peripheral hook, see HostRtos::SetPeripheralHook,
+ *    and raises the USART and stream interrupts through handlers the test
+ *    attaches in place of the vector table.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_HOST_PERIPHERALS_HPP
+#define SOAR_TESTS_STUB_HOST_PERIPHERALS_HPP
+/* Includes ------------------------------------------------------------------*/
+#include "cmsis_os.h"
+
+#include <functional>
+#include <vector>
+
+/* Types ---------------------------------------------------------------------*/
+typedef enum
+{
+    USART1_IRQn = 37,
+    DMA1_Stream7_IRQn = 47,
+    UART5_IRQn = 53,
+    DMA2_Stream2_IRQn = 58,
+} IRQn_Type;
+
+struct USART_TypeDef
+{
+    volatile uint32_t SR;
+    volatile uint32_t DR;       // Last received byte, a written byte goes to the transmit data register of the model
+    volatile uint32_t CR1;
+    volatile uint32_t CR3;
+};
+
+struct DMA_Stream_TypeDef
+{
+    volatile uint32_t CR;
+    volatile uint32_t NDTR;
+    volatile uint32_t PAR;
+    volatile uint32_t M0AR;
+};
+
+// LISR and HISR, read under the kernel lock as the model sets flags from the clock thread
+class HostDmaStatus
+{
+public:
+    operator uint32_t() const;
+    uint32_t value = 0;
+};
+
+// LIFCR and HIFCR, writing a one clears the flag in the status register
+class HostDmaFlagClear
+{
+public:
+    explicit HostDmaFlagClear(HostDmaStatus& status) : status_(status) {}
+    HostDmaFlagClear& operator=(uint32_t flags);
+
+private:
+    HostDmaStatus& status_;
+};
+
+struct DMA_TypeDef
+{
+    DMA_TypeDef() : LIFCR(LISR), HIFCR(HISR), stream{} {}
+
+    HostDmaStatus LISR;
+    HostDmaStatus HISR;
+    HostDmaFlagClear LIFCR;
+    HostDmaFlagClear HIFCR;
+    DMA_Stream_TypeDef stream[8];    // The stream registers follow the controller's, as on the STM32F4
+};
+
+struct DWT_Type { volatile uint32_t CTRL; volatile uint32_t CYCCNT; };
+struct CoreDebug_Type { volatile uint32_t DEMCR; };
+
+// One byte that left the transmitter
+struct HostWireByte
+{
+    uint8_t value;
+    uint64_t endNs;     // Virtual time its stop bit ended
+};
+
+/* Register Bits -------------------------------------------------------------*/
+#define USART_SR_PE (1UL << 0)
+#define USART_SR_FE (1UL << 1)
+#define USART_SR_NE (1UL << 2)
+#define USART_SR_ORE (1UL << 3)
+#define USART_SR_IDLE (1UL << 4)
+#define USART_SR_RXNE (1UL << 5)
+#define USART_SR_TC (1UL << 6)
+#define USART_SR_TXE (1UL << 7)
+#define USART_CR1_IDLEIE (1UL << 4)
+#define USART_CR1_RXNEIE (1UL << 5)
+#define USART_CR1_TCIE (1UL << 6)
+#define USART_CR1_TXEIE (1UL << 7)
+#define USART_CR3_DMAR (1UL << 6)
+#define USART_CR3_DMAT (1UL << 7)
+
+#define DMA_SxCR_EN (1UL << 0)
+#define DMA_SxCR_TEIE (1UL << 2)
+#define DMA_SxCR_HTIE (1UL << 3)
+#define DMA_SxCR_TCIE (1UL << 4)
+#define DMA_SxCR_DIR_0 (1UL << 6)
+#define DMA_SxCR_CIRC (1UL << 8)
+#define DMA_SxCR_MINC (1UL << 10)
+#define DMA_SxCR_CHSEL (7UL << 25)
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+
+/* Instances -----------------------------------------------------------------*/
+namespace HostPeripherals
+{
+    extern USART_TypeDef usart1;
+    extern USART_TypeDef uart5;
+    extern DMA_TypeDef dma1;
+    extern DMA_TypeDef dma2;
+    extern DWT_Type dwt;
+    extern CoreDebug_Type coreDebug;
+}
+
+#define USART1 (&HostPeripherals::usart1)
+#define UART5 (&HostPeripherals::uart5)
+#define DMA1 (&HostPeripherals::dma1)
+#define DMA2 (&HostPeripherals::dma2)
+#define DWT (&HostPeripherals::dwt)
+#define CoreDebug (&HostPeripherals::coreDebug)
+
+/* Host Control --------------------------------------------------------------*/
+// Lets a test drive the peripherals, see HostPeripherals.cpp
+namespace HostPeripherals
+{
+    void Reset();                                   // Registers as after the CubeMX init, idle lines, installs the hook
+    void SetBaudRate(USART_TypeDef* usart, uint32_t baud);    // 8N1, 115200 after Reset
+    void SetIrqHandler(IRQn_Type irq, std::function<void()> handler);    // Stands in for the IRQHandler, empty to detach
+    void HoldTx(USART_TypeDef* usart, bool hold);   // A held transmitter shifts nothing out, eg. to time out a transfer
+    void HoldIrqs(uint64_t untilNs);                // Interrupts wait until then, as behind a long critical section
+    void Receive(USART_TypeDef* usart, const uint8_t* data, uint16_t len);    // Arrives back to back after what is on its way
+
+    const std::vector<HostWireByte>& GetTransmitted(USART_TypeDef* usart);
+    uint32_t GetTxOverwriteCount(USART_TypeDef* usart);     // Bytes written to DR while TXE was clear, one was lost
+    uint32_t GetRxOverrunCount(USART_TypeDef* usart);       // Bytes lost because DR was not read in time
+    uint32_t GetStolenReadCount(USART_TypeDef* usart);      // Received bytes the CPU read from DR while a stream owned it
+
+    // Used by the LL stand-ins, under the kernel lock
+    uint32_t ReadRegister(const volatile uint32_t& reg);
+    void ModifyRegister(volatile uint32_t& reg, uint32_t clear, uint32_t set);
+    uint32_t ReadStatus(USART_TypeDef* usart);     // Also starts the SR then DR clear sequence
+    uint8_t ReadData(USART_TypeDef* usart);
+    void WriteData(USART_TypeDef* usart, uint8_t value);
+    void EnableIRQ(IRQn_Type irq);
+}
+
+/* NVIC ----------------------------------------------------------------------*/
+inline uint32_t NVIC_GetPriorityGrouping() { return 0; }
+inline uint32_t NVIC_EncodePriority(uint32_t group, uint32_t preempt, uint32_t sub) { (void)group; (void)sub; return preempt; }
+inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+inline void NVIC_EnableIRQ(IRQn_Type irq) { HostPeripherals::EnableIRQ(irq); }
+
+#endif /* SOAR_TESTS_STUB_HOST_PERIPHERALS_HPP */
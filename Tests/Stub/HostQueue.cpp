@@ -0,0 +1,158 @@
+/**
+ ******************************************************************************
+ * File Name          : HostQueue.cpp
+ * Description        : Host implementation of the stand-in RTOS queues and
+ *    counting semaphores, a semaphore is a queue of items with no size as in
+ *    FreeRTOS. Every operation runs under the kernel lock, see HostKernel.hpp.
+ ******************************************************************************
+*/
+#include "cmsis_os.h"
+#include "HostKernel.hpp"
+
+#include <cstring>
+#include <new>
+
+/* Structs -------------------------------------------------------------------*/
+namespace {
+    struct HostQueue
+    {
+        uint8_t* storage;       // length items of itemSize bytes, nullptr for a semaphore
+        UBaseType_t length;
+        UBaseType_t itemSize;
+        UBaseType_t head;       // Index of the oldest item
+        UBaseType_t count;      // Number of items waiting
+    };
+
+    static_assert(sizeof(HostQueue) <= sizeof(StaticQueue_t), "HostQueue must fit in a StaticQueue_t");
+    static_assert(sizeof(HostQueue) <= sizeof(StaticSemaphore_t), "HostQueue must fit in a StaticSemaphore_t");
+
+    HostQueue* Init(void* control, UBaseType_t length, UBaseType_t itemSize, uint8_t* storage, UBaseType_t initialCount)
+    {
+        return new (control) HostQueue{ storage, length, itemSize, 0, initialCount };
+    }
+
+    void Write(HostQueue* queue, const void* item, BaseType_t position)
+    {
+        if (position == queueOVERWRITE)
+            queue->count = 0;
+
+        UBaseType_t index;
+        if (position == queueSEND_TO_FRONT) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            index = queue->head;
+        }
+        else {
+            index = (queue->head + queue->count) % queue->length;
+        }
+
+        if (queue->itemSize > 0)
+            memcpy(&queue->storage[index * queue->itemSize], item, queue->itemSize);
+        queue->count++;
+    }
+
+    void Read(HostQueue* queue, void* buffer, bool remove)
+    {
+        if (queue->itemSize > 0)
+            memcpy(buffer, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+
+        if (remove) {
+            queue->head = (queue->head + 1) % queue->length;
+            queue->count--;
+        }
+    }
+
+    BaseType_t Send(QueueHandle_t handle, const void* item, TickType_t ticksToWait, BaseType_t position)
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+        HostQueue* queue = static_cast<HostQueue*>(handle);
+
+        // An overwrite needs no space, it is only used on a queue of length 1
+        if (position != queueOVERWRITE && !HostKernel::Block([queue] { return queue->count < queue->length; }, ticksToWait))
+            return pdFAIL;
+
+        Write(queue, item, position);
+        HostKernel::Changed();
+        return pdPASS;
+    }
+
+    BaseType_t Receive(QueueHandle_t handle, void* buffer, TickType_t ticksToWait, bool remove)
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+        HostQueue* queue = static_cast<HostQueue*>(handle);
+
+        if (!HostKernel::Block([queue] { return queue->count > 0; }, ticksToWait))
+            return pdFALSE;
+
+        Read(queue, buffer, remove);
+        if (remove)
+            HostKernel::Changed();
+        return pdTRUE;
+    }
+
+    UBaseType_t GetCount(QueueHandle_t handle)
+    {
+        std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+        return static_cast<HostQueue*>(handle)->count;
+    }
+}
+
+/* Queues --------------------------------------------------------------------*/
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    return Init(new StaticQueue_t, length, itemSize, new uint8_t[length * itemSize], 0);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t* storage, StaticQueue_t* buffer)
+{
+    return Init(buffer, length, itemSize, storage, 0);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait, BaseType_t position)
+{
+    return Send(queue, item, ticksToWait, position);
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* pxHigherPriorityTaskWoken, BaseType_t position)
+{
+    (void)pxHigherPriorityTaskWoken;
+    return Send(queue, item, 0, position);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) { return Receive(queue, buffer, ticksToWait, true); }
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* buffer, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    (void)pxHigherPriorityTaskWoken;
+    return Receive(queue, buffer, 0, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) { return Receive(queue, buffer, ticksToWait, false); }
+BaseType_t xQueuePeekFromISR(QueueHandle_t queue, void* buffer) { return Receive(queue, buffer, 0, false); }
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) { return GetCount(queue); }
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t queue) { return GetCount(queue); }
+
+/* Semaphores ----------------------------------------------------------------*/
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    return Init(new StaticSemaphore_t, maxCount, 0, nullptr, initialCount);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t maxCount, UBaseType_t initialCount, StaticSemaphore_t* buffer)
+{
+    return Init(buffer, maxCount, 0, nullptr, initialCount);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) { return Send(semaphore, nullptr, 0, queueSEND_TO_BACK); }
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    (void)pxHigherPriorityTaskWoken;
+    return Send(semaphore, nullptr, 0, queueSEND_TO_BACK);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) { return Receive(semaphore, nullptr, ticksToWait, true); }
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    (void)pxHigherPriorityTaskWoken;
+    return Receive(semaphore, nullptr, 0, true);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) { return GetCount(semaphore); }
@@ -0,0 +1,386 @@
+/**
+ ******************************************************************************
+ * File Name          : HostRtos.cpp
+ * Description        : Host implementation of the stand-in RTOS, HAL and main_avionics
+ *    functions, see cmsis_os.h in this directory.
+ ******************************************************************************
+*/
+#include "cmsis_os.h"
+#include "HostKernel.hpp"
+#include "main_avionics.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Variables -----------------------------------------------------------------*/
+I2C_HandleTypeDef hi2c1;
+SPI_HandleTypeDef hspi3;
+CRC_HandleTypeDef hcrc;
+
+namespace {
+    constexpr uint64_t NS_PER_TICK = 1000000000ULL / configTICK_RATE_HZ;
+    constexpr uint64_t STEP_NS = 10000;                 // Peripheral hook period, ~1/9 of a byte at 115200 baud
+    constexpr TickType_t TEST_THREAD_MAX_WAIT = 10000;  // A wait forever on the test thread gives up after 10s of stepping
+
+    // A blocked task thread, for the clock to see whether it can run
+    struct Waiter
+    {
+        const std::function<bool()>* ready;
+        TickType_t startTick;
+        TickType_t ticksToWait;
+    };
+
+    struct HostTask
+    {
+        HostRtos::TaskFunction function;
+        void* context;
+        TaskHandle_t handle;
+        std::thread thread;
+    };
+
+    std::atomic<uint64_t> timeNs(0);
+    thread_local TaskHandle_t currentTask = nullptr;
+    thread_local bool insideInterrupt = false;
+    thread_local bool taskThread = false;               // Set on the threads of RunTasks
+    bool schedulerRunning = true;
+    HostRtos::DelayHook delayHook = nullptr;
+    void* delayHookContext = nullptr;
+    HostRtos::PeripheralHook peripheralHook = nullptr;
+    void* peripheralHookContext = nullptr;
+    uint32_t notifyCount = 0;
+    std::map<TaskHandle_t, uint32_t> notifyValues;    // Pending notification bits of each task
+    std::map<std::pair<TaskHandle_t, BaseType_t>, void*> localStorage;    // Thread local storage pointers of each task
+    uint32_t assertCount = 0;
+    uint32_t resetFlags = 0;
+    std::string printed;
+
+    // Task threads, all of these are under the kernel lock
+    std::condition_variable_any changed;
+    std::list<HostTask> tasks;
+    std::vector<Waiter*> waiters;
+    size_t runningTasks = 0;
+    bool stopping = false;
+
+    TickType_t GetTick() { return static_cast<TickType_t>(timeNs / NS_PER_TICK); }
+
+    bool IsRunnable(const Waiter& waiter)
+    {
+        return (*waiter.ready)() || (waiter.ticksToWait != portMAX_DELAY && GetTick() - waiter.startTick >= waiter.ticksToWait);
+    }
+
+    bool AnyRunnable()
+    {
+        return std::any_of(waiters.begin(), waiters.end(), [](const Waiter* waiter) { return IsRunnable(*waiter); });
+    }
+
+    // Moves time on by one step and runs the peripheral hook as an interrupt, the caller holds the kernel lock
+    void Step()
+    {
+        timeNs += STEP_NS;
+        if (peripheralHook == nullptr)
+            return;
+
+        const bool wasInside = insideInterrupt;
+        insideInterrupt = true;
+        peripheralHook(peripheralHookContext);
+        insideInterrupt = wasInside;
+    }
+
+    void RunTask(HostTask* task)
+    {
+        currentTask = task->handle;
+        taskThread = true;
+        try {
+            task->function(task->context);
+        }
+        catch (const HostRtos::TaskStopped&) {}
+
+        std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+        runningTasks--;
+        changed.notify_all();
+    }
+}
+
+/* RTOS ----------------------------------------------------------------------*/
+TickType_t xTaskGetTickCount() { return GetTick(); }
+TickType_t xTaskGetTickCountFromISR() { return GetTick(); }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return currentTask; }
+const char* pcTaskGetName(TaskHandle_t task) { (void)task; return "HostTask"; }
+BaseType_t xTaskGetSchedulerState() { return schedulerRunning ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED; }
+BaseType_t xPortIsInsideInterrupt() { return insideInterrupt ? pdTRUE : pdFALSE; }
+void* pvPortMalloc(size_t size) { return malloc(size); }
+void vPortFree(void* ptr) { free(ptr); }
+size_t xPortGetFreeHeapSize() { return 0; }
+size_t xPortGetMinimumEverFreeHeapSize() { return 0; }
+
+void vPortEnterCritical() { HostKernel::GetLock().lock(); }
+void vPortExitCritical() { HostKernel::GetLock().unlock(); }
+void vTaskSuspendAll() { HostKernel::GetLock().lock(); }
+BaseType_t xTaskResumeAll() { HostKernel::GetLock().unlock(); return pdFALSE; }
+
+std::recursive_mutex& HostKernel::GetLock()
+{
+    static std::recursive_mutex lock;
+    return lock;
+}
+
+void HostKernel::Changed() { changed.notify_all(); }
+
+bool HostKernel::Block(const std::function<bool()>& ready, TickType_t ticksToWait)
+{
+    if (ready() || ticksToWait == 0)
+        return ready();
+
+    Waiter waiter = { &ready, GetTick(), ticksToWait };
+
+    if (taskThread) {
+        waiters.push_back(&waiter);
+        changed.notify_all();
+        changed.wait(GetLock(), [&waiter] { return stopping || IsRunnable(waiter); });
+        waiters.erase(std::find(waiters.begin(), waiters.end(), &waiter));
+
+        if (stopping)
+            throw HostRtos::TaskStopped();
+        return ready();
+    }
+
+    if (peripheralHook != nullptr) {
+        if (waiter.ticksToWait == portMAX_DELAY)
+            waiter.ticksToWait = TEST_THREAD_MAX_WAIT;
+        while (!IsRunnable(waiter))
+            Step();
+    }
+    else if (ticksToWait != portMAX_DELAY) {
+        timeNs += ticksToWait * NS_PER_TICK;
+    }
+
+    if (delayHook != nullptr)
+        delayHook(delayHookContext);
+    return ready();
+}
+
+/**
+ * @brief The control block stands in for the handle, the task runs in the next RunTasks
+*/
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameters,
+    UBaseType_t priority, StackType_t* stack, StaticTask_t* tcb)
+{
+    (void)name; (void)stackDepth; (void)priority; (void)stack;
+    HostRtos::CreateTask(function, parameters, tcb);
+    return tcb;
+}
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    localStorage[{ (task != nullptr) ? task : currentTask, index }] = value;
+}
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    auto entry = localStorage.find({ (task != nullptr) ? task : currentTask, index });
+    return (entry != localStorage.end()) ? entry->second : nullptr;
+}
+
+/**
+ * @brief Only eSetBits is used by the components, any other action is counted but does not set bits
+*/
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    if (action == eSetBits)
+        notifyValues[task] |= value;
+    notifyCount++;
+    HostKernel::Changed();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != nullptr)
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticksToWait)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    const TaskHandle_t task = currentTask;
+
+    // Only the bits set before the wait count as pending, as notifications are a single flag and value on the target
+    notifyValues[task] &= ~clearOnEntry;
+    if (!HostKernel::Block([task] { return notifyValues[task] != 0; }, ticksToWait))
+        return pdFALSE;
+
+    if (value != nullptr)
+        *value = notifyValues[task];
+    notifyValues[task] &= ~clearOnExit;
+    return pdTRUE;
+}
+
+void vTaskSetTimeOutState(TimeOut_t* timeOut) { timeOut->entryTick = GetTick(); }
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t* timeOut, TickType_t* ticksToWait)
+{
+    if (*ticksToWait == portMAX_DELAY)
+        return pdFALSE;
+
+    const TickType_t tick = GetTick();
+    const TickType_t elapsed = tick - timeOut->entryTick;
+    if (elapsed >= *ticksToWait) {
+        *ticksToWait = 0;
+        return pdTRUE;
+    }
+
+    *ticksToWait -= elapsed;
+    timeOut->entryTick = tick;
+    return pdFALSE;
+}
+
+/**
+ * @brief Waits out the delay, on the test thread the delay hook stands in for the tasks that would run meanwhile
+*/
+void vTaskDelay(TickType_t ticks)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    HostKernel::Block([] { return false; }, ticks);
+}
+
+osStatus osDelay(uint32_t millisec)
+{
+    vTaskDelay(millisec * configTICK_RATE_HZ / 1000);
+    return osOK;
+}
+
+/* HAL -----------------------------------------------------------------------*/
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef* handle, uint32_t* buffer, uint32_t length)
+{
+    (void)handle; (void)buffer; (void)length;
+    return 0;
+}
+
+uint32_t HostHal::GetResetFlags() { return resetFlags; }
+void HostHal::SetResetFlags(uint32_t flags) { resetFlags = flags; }
+
+/* main_avionics -------------------------------------------------------------*/
+void print(const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    Utils::FormatStringV(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    printed += buffer;
+}
+
+void soar_assert_debug(bool condition, const char* file, uint16_t line, const char* str, ...)
+{
+    (void)condition; (void)file; (void)line; (void)str;
+    assertCount++;
+}
+
+/* Host Control --------------------------------------------------------------*/
+void HostRtos::Reset()
+{
+    timeNs = 0;
+    currentTask = nullptr;
+    insideInterrupt = false;
+    schedulerRunning = true;
+    delayHook = nullptr;
+    delayHookContext = nullptr;
+    peripheralHook = nullptr;
+    peripheralHookContext = nullptr;
+    notifyCount = 0;
+    notifyValues.clear();
+    localStorage.clear();
+}
+
+void HostRtos::AdvanceMs(uint32_t ms) { timeNs += MS_TO_TICKS(ms) * NS_PER_TICK; }
+uint64_t HostRtos::GetTimeNs() { return timeNs; }
+void HostRtos::SetCurrentTask(TaskHandle_t task) { currentTask = task; }
+void HostRtos::SetInsideInterrupt(bool inside) { insideInterrupt = inside; }
+void HostRtos::SetSchedulerRunning(bool running) { schedulerRunning = running; }
+uint32_t HostRtos::GetNotifyCount() { return notifyCount; }
+
+void HostRtos::SetDelayHook(DelayHook hook, void* context)
+{
+    delayHook = hook;
+    delayHookContext = context;
+}
+
+void HostRtos::SetPeripheralHook(PeripheralHook hook, void* context)
+{
+    peripheralHook = hook;
+    peripheralHookContext = context;
+}
+
+void HostRtos::CreateTask(TaskFunction function, void* context, TaskHandle_t handle)
+{
+    std::lock_guard<std::recursive_mutex> lock(HostKernel::GetLock());
+    tasks.push_back(HostTask{ function, context, handle, std::thread() });
+}
+
+/**
+ * @brief Runs the created tasks, the test thread is the clock. Time moves on only once every task is blocked and
+ *        none of them can run, by one step of the peripheral hook or, without one, to the next timeout. The hook's
+ *        interrupts are what wakes tasks waiting on peripherals.
+ * @param ms Virtual time to run for, tasks still running after it are stopped at their next blocking call
+ * @return true if every task returned by itself
+*/
+bool HostRtos::RunTasks(uint32_t ms)
+{
+    std::unique_lock<std::recursive_mutex> lock(HostKernel::GetLock());
+    const uint64_t endNs = timeNs + ms * NS_PER_TICK;
+
+    stopping = false;
+    runningTasks = tasks.size();
+    for (HostTask& task : tasks)
+        task.thread = std::thread(RunTask, &task);
+
+    while (true) {
+        changed.wait(lock, [] { return waiters.size() == runningTasks && !AnyRunnable(); });
+        if (runningTasks == 0 || timeNs >= endNs)
+            break;
+
+        if (peripheralHook != nullptr) {
+            Step();
+        }
+        else {
+            uint64_t nextNs = endNs;
+            for (const Waiter* waiter : waiters) {
+                if (waiter->ticksToWait != portMAX_DELAY)
+                    nextNs = std::min(nextNs, (uint64_t)(waiter->startTick + waiter->ticksToWait) * NS_PER_TICK);
+            }
+            timeNs = std::max(nextNs, timeNs + 1);
+        }
+
+        if (AnyRunnable())
+            changed.notify_all();
+    }
+
+    const bool finished = (runningTasks == 0);
+    stopping = true;
+    changed.notify_all();
+    changed.wait(lock, [] { return runningTasks == 0; });
+    stopping = false;
+    lock.unlock();
+
+    for (HostTask& task : tasks)
+        task.thread.join();
+    tasks.clear();
+    return finished;
+}
+
+const char* HostRtos::GetPrinted() { return printed.c_str(); }
+void HostRtos::ClearPrinted() { printed.clear(); }
+uint32_t HostRtos::GetAssertCount() { return assertCount; }
@@ -0,0 +1,140 @@
+/**
+ ******************************************************************************
+ * File Name          : cmsis_os.h
+ * Description        : Host stand-in for the CMSIS-RTOS and FreeRTOS API used by
+ *    the components under test. Time only moves when a test advances it, a call
+ *    that would block the test moves time on by its timeout instead, stepping
+ *    the simulated peripherals through the wait if a test installed them.
+ *    HostRtos::RunTasks runs task threads against a virtual clock that only
+ *    moves while every task is blocked, xTaskCreateStatic adds a task to the
+ *    next run as HostRtos::CreateTask does. Critical sections take one kernel
+ *    lock, so threads of a test exclude each other as tasks and ISRs do.
+ *    print() and asserts are captured by HostRtos.cpp so tests can check them,
+ *    queues and semaphores are in HostQueue.cpp.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_CMSIS_OS_H
+#define SOAR_TESTS_STUB_CMSIS_OS_H
+/* Includes ------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+
+/* Types ---------------------------------------------------------------------*/
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void* parameters);
+typedef uint32_t StackType_t;
+struct StaticTask_t { uint8_t reserved[96]; };
+struct StaticQueue_t { uint8_t reserved[80]; };
+struct StaticSemaphore_t { uint8_t reserved[80]; };
+struct TimeOut_t { TickType_t entryTick; };
+
+enum osStatus { osOK = 0, osEventTimeout = 0x40, osErrorOS = 0xFF };
+enum eNotifyAction { eNoAction = 0, eSetBits, eIncrement, eSetValueWithOverwrite, eSetValueWithoutOverwrite };
+
+/* Constants -----------------------------------------------------------------*/
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define osKernelSysTickFrequency (configTICK_RATE_HZ)
+#define taskSCHEDULER_SUSPENDED ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING ((BaseType_t)2)
+#define queueSEND_TO_BACK ((BaseType_t)0)
+#define queueSEND_TO_FRONT ((BaseType_t)1)
+#define queueOVERWRITE ((BaseType_t)2)
+
+/* Functions -----------------------------------------------------------------*/
+TickType_t xTaskGetTickCount();
+TickType_t xTaskGetTickCountFromISR();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameters,
+    UBaseType_t priority, StackType_t* stack, StaticTask_t* tcb);
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value);
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index);    // nullptr for the calling task
+const char* pcTaskGetName(TaskHandle_t task);
+BaseType_t xTaskGetSchedulerState();
+BaseType_t xPortIsInsideInterrupt();
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticksToWait);
+void vTaskDelay(TickType_t ticks);
+osStatus osDelay(uint32_t millisec);
+void vTaskSetTimeOutState(TimeOut_t* timeOut);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t* timeOut, TickType_t* ticksToWait);
+void vTaskSuspendAll();
+BaseType_t xTaskResumeAll();
+void* pvPortMalloc(size_t size);
+void vPortFree(void* ptr);
+size_t xPortGetFreeHeapSize();
+size_t xPortGetMinimumEverFreeHeapSize();
+void vPortEnterCritical();
+void vPortExitCritical();
+
+#define taskENTER_CRITICAL() vPortEnterCritical()
+#define taskEXIT_CRITICAL() vPortExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR() (vPortEnterCritical(), (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(mask) ((void)(mask), vPortExitCritical())
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+// Queues and semaphores, see HostQueue.cpp
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t* storage, StaticQueue_t* buffer);
+BaseType_t xQueueGenericSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait, BaseType_t position);
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* pxHigherPriorityTaskWoken, BaseType_t position);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* buffer, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticksToWait);
+BaseType_t xQueuePeekFromISR(QueueHandle_t queue, void* buffer);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t queue);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t maxCount, UBaseType_t initialCount, StaticSemaphore_t* buffer);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait);
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t* pxHigherPriorityTaskWoken);
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore);
+
+#define xQueueSendFromISR(queue, item, woken) xQueueGenericSendFromISR((queue), (item), (woken), queueSEND_TO_BACK)
+#define xQueueOverwrite(queue, item) xQueueGenericSend((queue), (item), 0, queueOVERWRITE)
+#define xQueueOverwriteFromISR(queue, item, woken) xQueueGenericSendFromISR((queue), (item), (woken), queueOVERWRITE)
+
+/* Host Control --------------------------------------------------------------*/
+// Lets a test drive the stand-in RTOS, see HostRtos.cpp
+namespace HostRtos
+{
+    typedef void (*DelayHook)(void* context);
+    typedef void (*PeripheralHook)(void* context);
+    typedef void (*TaskFunction)(void* context);
+
+    // Thrown out of the blocking call of a task thread when RunTasks ends, the thread then returns
+    struct TaskStopped {};
+
+    void Reset();                                   // Tick 0, scheduler running, task context, no hooks
+    void AdvanceMs(uint32_t ms);
+    uint64_t GetTimeNs();                           // Virtual time, the tick count is this in whole ms
+    void SetCurrentTask(TaskHandle_t task);
+    void SetInsideInterrupt(bool inside);
+    void SetSchedulerRunning(bool running);
+    void SetDelayHook(DelayHook hook, void* context);    // Called by vTaskDelay, eg. to play the consumer task
+    void SetPeripheralHook(PeripheralHook hook, void* context);    // Called as an interrupt every step of a wait, see HostPeripherals.hpp
+
+    // Task threads, created before RunTasks and gone after it
+    void CreateTask(TaskFunction function, void* context, TaskHandle_t handle);
+    bool RunTasks(uint32_t ms);                     // true if every task returned within ms of virtual time, the rest are stopped
+    uint32_t GetNotifyCount();
+
+    const char* GetPrinted();                       // Everything print() wrote since the last ClearPrinted
+    void ClearPrinted();
+    uint32_t GetAssertCount();
+}
+
+#endif /* SOAR_TESTS_STUB_CMSIS_OS_H */
@@ -0,0 +1,10 @@
+/**
+ ******************************************************************************
+ * File Name          : semphr.h
+ * Description        : Host stand-in, everything the components use is in cmsis_os.h
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_SEMPHR_H
+#define SOAR_TESTS_STUB_SEMPHR_H
+#include "cmsis_os.h"
+#endif /* SOAR_TESTS_STUB_SEMPHR_H */
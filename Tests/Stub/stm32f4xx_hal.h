@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32f4xx_hal.h
+ * Description        : Host stand-in for the HAL handles named in main_avionics.hpp,
+ *    only the CRC peripheral and the RCC reset flags are used by the components
+ *    under test.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_STM32F4XX_HAL_H
+#define SOAR_TESTS_STUB_STM32F4XX_HAL_H
+#include "cmsis_os.h"
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+struct I2C_HandleTypeDef {};
+struct SPI_HandleTypeDef {};
+struct CRC_HandleTypeDef {};
+struct DMA_HandleTypeDef {};
+
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef* hcrc, uint32_t* buffer, uint32_t length);
+
+// RCC reset flags, a test sets them before it simulates a boot
+#define RCC_FLAG_BORRST (1U << 0)
+#define RCC_FLAG_PINRST (1U << 1)
+#define RCC_FLAG_PORRST (1U << 2)
+#define RCC_FLAG_SFTRST (1U << 3)
+#define RCC_FLAG_IWDGRST (1U << 4)
+#define RCC_FLAG_WWDGRST (1U << 5)
+#define RCC_FLAG_LPWRRST (1U << 6)
+#define __HAL_RCC_GET_FLAG(flag) ((HostHal::GetResetFlags() & (flag)) != 0)
+#define __HAL_RCC_CLEAR_RESET_FLAGS() HostHal::SetResetFlags(0)
+
+namespace HostHal
+{
+    uint32_t GetResetFlags();
+    void SetResetFlags(uint32_t flags);
+}
+
+#endif /* SOAR_TESTS_STUB_STM32F4XX_HAL_H */
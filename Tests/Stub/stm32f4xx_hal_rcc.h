@@ -0,0 +1,10 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32f4xx_hal_rcc.h
+ * Description        : Host stand-in, see stm32f4xx_hal.h
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_STM32F4XX_HAL_RCC_H
+#define SOAR_TESTS_STUB_STM32F4XX_HAL_RCC_H
+#include "stm32f4xx_hal.h"
+#endif /* SOAR_TESTS_STUB_STM32F4XX_HAL_RCC_H */
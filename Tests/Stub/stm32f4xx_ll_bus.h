@@ -0,0 +1,16 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32f4xx_ll_bus.h
+ * Description        : Host stand-in, the modelled peripherals are always clocked
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_STM32F4XX_LL_BUS_H
+#define SOAR_TESTS_STUB_STM32F4XX_LL_BUS_H
+#include "HostPeripherals.hpp"
+
+#define LL_AHB1_GRP1_PERIPH_DMA1 (1UL << 21)
+#define LL_AHB1_GRP1_PERIPH_DMA2 (1UL << 22)
+
+inline void LL_AHB1_GRP1_EnableClock(uint32_t Periphs) { (void)Periphs; }
+
+#endif /* SOAR_TESTS_STUB_STM32F4XX_LL_BUS_H */
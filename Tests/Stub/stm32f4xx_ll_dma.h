@@ -0,0 +1,56 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32f4xx_ll_dma.h
+ * Description        : Host stand-in for the LL DMA calls of DMAController, on
+ *    the register model in HostPeripherals.hpp. Addresses are 32 bits as on
+ *    the target, so memory a stream uses must be static.
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_STM32F4XX_LL_DMA_H
+#define SOAR_TESTS_STUB_STM32F4XX_LL_DMA_H
+#include "HostPeripherals.hpp"
+
+#define LL_DMA_STREAM_0 0U
+#define LL_DMA_STREAM_1 1U
+#define LL_DMA_STREAM_2 2U
+#define LL_DMA_STREAM_3 3U
+#define LL_DMA_STREAM_4 4U
+#define LL_DMA_STREAM_5 5U
+#define LL_DMA_STREAM_6 6U
+#define LL_DMA_STREAM_7 7U
+#define LL_DMA_CHANNEL_4 (4UL << 25)
+
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY 0U
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH DMA_SxCR_DIR_0
+#define LL_DMA_MODE_NORMAL 0U
+#define LL_DMA_MODE_CIRCULAR DMA_SxCR_CIRC
+#define LL_DMA_PERIPH_NOINCREMENT 0U
+#define LL_DMA_MEMORY_INCREMENT DMA_SxCR_MINC
+#define LL_DMA_PDATAALIGN_BYTE 0U
+#define LL_DMA_MDATAALIGN_BYTE 0U
+#define LL_DMA_PRIORITY_LOW 0U
+
+inline void LL_DMA_SetChannelSelection(DMA_TypeDef* DMAx, uint32_t Stream, uint32_t Channel)
+{
+    HostPeripherals::ModifyRegister(DMAx->stream[Stream].CR, DMA_SxCR_CHSEL, Channel);
+}
+inline void LL_DMA_ConfigTransfer(DMA_TypeDef* DMAx, uint32_t Stream, uint32_t Configuration)
+{
+    HostPeripherals::ModifyRegister(DMAx->stream[Stream].CR, DMA_SxCR_DIR_0 | DMA_SxCR_CIRC | DMA_SxCR_MINC, Configuration);
+}
+inline void LL_DMA_DisableFifoMode(DMA_TypeDef* DMAx, uint32_t Stream) { (void)DMAx; (void)Stream; }    // The model is direct mode only
+inline void LL_DMA_SetPeriphAddress(DMA_TypeDef* DMAx, uint32_t Stream, uint32_t Address) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].PAR, 0xFFFFFFFFU, Address); }
+inline void LL_DMA_SetMemoryAddress(DMA_TypeDef* DMAx, uint32_t Stream, uint32_t Address) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].M0AR, 0xFFFFFFFFU, Address); }
+inline void LL_DMA_SetDataLength(DMA_TypeDef* DMAx, uint32_t Stream, uint32_t NbData) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].NDTR, 0xFFFFFFFFU, NbData); }
+inline uint32_t LL_DMA_GetDataLength(DMA_TypeDef* DMAx, uint32_t Stream) { return HostPeripherals::ReadRegister(DMAx->stream[Stream].NDTR); }
+
+inline void LL_DMA_EnableIT_TC(DMA_TypeDef* DMAx, uint32_t Stream) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].CR, 0, DMA_SxCR_TCIE); }
+inline void LL_DMA_EnableIT_TE(DMA_TypeDef* DMAx, uint32_t Stream) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].CR, 0, DMA_SxCR_TEIE); }
+inline void LL_DMA_EnableIT_HT(DMA_TypeDef* DMAx, uint32_t Stream) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].CR, 0, DMA_SxCR_HTIE); }
+
+// The model latches NDTR on enable and releases the stream at once on disable
+void LL_DMA_EnableStream(DMA_TypeDef* DMAx, uint32_t Stream);
+inline void LL_DMA_DisableStream(DMA_TypeDef* DMAx, uint32_t Stream) { HostPeripherals::ModifyRegister(DMAx->stream[Stream].CR, DMA_SxCR_EN, 0); }
+inline uint32_t LL_DMA_IsEnabledStream(DMA_TypeDef* DMAx, uint32_t Stream) { return (HostPeripherals::ReadRegister(DMAx->stream[Stream].CR) & DMA_SxCR_EN) != 0; }
+
+#endif /* SOAR_TESTS_STUB_STM32F4XX_LL_DMA_H */
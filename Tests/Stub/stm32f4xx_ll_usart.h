@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * File Name          : stm32f4xx_ll_usart.h
+ * Description        : Host stand-in for the LL USART calls of the UART driver,
+ *    on the register model in HostPeripherals.hpp
+ ******************************************************************************
+*/
+#ifndef SOAR_TESTS_STUB_STM32F4XX_LL_USART_H
+#define SOAR_TESTS_STUB_STM32F4XX_LL_USART_H
+#include "HostPeripherals.hpp"
+
+inline uint32_t LL_USART_IsActiveFlag_PE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_PE) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_FE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_FE) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_NE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_NE) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_ORE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_ORE) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_IDLE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_IDLE) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_RXNE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_RXNE) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_TC(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_TC) != 0; }
+inline uint32_t LL_USART_IsActiveFlag_TXE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadStatus(USARTx) & USART_SR_TXE) != 0; }
+
+// As in the LL library, ORE is cleared by reading SR then DR
+inline void LL_USART_ClearFlag_ORE(USART_TypeDef* USARTx)
+{
+    (void)HostPeripherals::ReadStatus(USARTx);
+    (void)HostPeripherals::ReadData(USARTx);
+}
+inline void LL_USART_ClearFlag_RXNE(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->SR, USART_SR_RXNE, 0); }
+
+inline uint8_t LL_USART_ReceiveData8(USART_TypeDef* USARTx) { return HostPeripherals::ReadData(USARTx); }
+inline void LL_USART_TransmitData8(USART_TypeDef* USARTx, uint8_t Value) { HostPeripherals::WriteData(USARTx, Value); }
+
+inline void LL_USART_EnableIT_IDLE(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR1, 0, USART_CR1_IDLEIE); }
+inline void LL_USART_EnableIT_RXNE(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR1, 0, USART_CR1_RXNEIE); }
+inline void LL_USART_EnableIT_TXE(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR1, 0, USART_CR1_TXEIE); }
+inline void LL_USART_DisableIT_RXNE(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR1, USART_CR1_RXNEIE, 0); }
+inline void LL_USART_DisableIT_TXE(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR1, USART_CR1_TXEIE, 0); }
+inline uint32_t LL_USART_IsEnabledIT_IDLE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadRegister(USARTx->CR1) & USART_CR1_IDLEIE) != 0; }
+inline uint32_t LL_USART_IsEnabledIT_TXE(USART_TypeDef* USARTx) { return (HostPeripherals::ReadRegister(USARTx->CR1) & USART_CR1_TXEIE) != 0; }
+
+inline void LL_USART_EnableDMAReq_RX(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR3, 0, USART_CR3_DMAR); }
+inline void LL_USART_EnableDMAReq_TX(USART_TypeDef* USARTx) { HostPeripherals::ModifyRegister(USARTx->CR3, 0, USART_CR3_DMAT); }
+inline uint32_t LL_USART_DMA_GetRegAddr(USART_TypeDef* USARTx) { return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&USARTx->DR)); }
+
+#endif /* SOAR_TESTS_STUB_STM32F4XX_LL_USART_H */
@@ -0,0 +1,187 @@
+/**
+ ******************************************************************************
+ * File Name          : TaskLogTest.cpp
+ * Description        : Host tests for TaskLog, lines wrapping the ring and a
+ *    full ring waiting for, or giving up on, the consumer.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "TaskLog.hpp"
+#include "SystemDefines.hpp"
+
+#include <cstring>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    TaskLog taskLog;
+
+    bool WriteLine(TaskLog& target, const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        const bool written = target.Write(format, args);
+        va_end(args);
+        return written;
+    }
+
+    void DrainAll(TaskLog& target)
+    {
+        uint8_t line[TASK_LOG_FORMAT_BYTES];
+        while (target.Read(line, sizeof(line)) > 0) {}
+    }
+
+    // Fills the ring with lines of 40 text bytes, returns the number written
+    uint16_t Fill(TaskLog& target)
+    {
+        uint16_t count = 0;
+        while (WriteLine(target, "%040d", count))
+            count++;
+        return count;
+    }
+
+    // Stands in for the UARTTask while a writer waits, pops one line per tick
+    void ConsumeOneLine(void* context)
+    {
+        uint8_t line[TASK_LOG_FORMAT_BYTES];
+        static_cast<TaskLog*>(context)->Read(line, sizeof(line));
+    }
+
+    int consumerTask;
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(TaskLog, RegistersAsSource)
+{
+    bool found = false;
+    for (uint8_t i = 0; i < TaskLog::GetSourceCount(); i++)
+        found |= (TaskLog::GetSource(i) == &taskLog);
+    CHECK(found);
+    CHECK(TaskLog::GetSource(TaskLog::GetSourceCount()) == nullptr);
+}
+
+HOST_TEST(TaskLog, ReadsLinesOldestFirst)
+{
+    DrainAll(taskLog);
+    uint32_t timestamp;
+    uint16_t length;
+    CHECK(!taskLog.Peek(timestamp, length));
+
+    HostRtos::AdvanceMs(25);
+    CHECK(WriteLine(taskLog, "first %d\n", 1));
+    HostRtos::AdvanceMs(5);
+    CHECK(WriteLine(taskLog, "second %s\n", "line"));
+
+    CHECK(taskLog.Peek(timestamp, length));
+    CHECK_EQUAL(25, timestamp);
+    CHECK_EQUAL(strlen("first 1\n"), length);
+
+    char line[TASK_LOG_FORMAT_BYTES] = {};
+    CHECK_EQUAL(length, taskLog.Read(reinterpret_cast<uint8_t*>(line), sizeof(line)));
+    CHECK_STRING("first 1\n", line);
+
+    CHECK(taskLog.Peek(timestamp, length));
+    CHECK_EQUAL(30, timestamp);
+    memset(line, 0, sizeof(line));
+    taskLog.Read(reinterpret_cast<uint8_t*>(line), sizeof(line));
+    CHECK_STRING("second line\n", line);
+
+    CHECK(!taskLog.Peek(timestamp, length));
+    CHECK_EQUAL(0, taskLog.Read(reinterpret_cast<uint8_t*>(line), sizeof(line)));
+}
+
+HOST_TEST(TaskLog, KeepsLinesIntactAcrossTheRingEnd)
+{
+    DrainAll(taskLog);
+
+    // Line sizes that do not divide the ring, so headers and text both straddle the end
+    for (uint16_t i = 0; i < 200; i++) {
+        CHECK(WriteLine(taskLog, "line %u %.*s\n", i, i % 37, "abcdefghijklmnopqrstuvwxyz0123456789"));
+
+        char expected[TASK_LOG_FORMAT_BYTES];
+        Utils::FormatString(expected, sizeof(expected), "line %u %.*s\n", i, i % 37, "abcdefghijklmnopqrstuvwxyz0123456789");
+
+        char line[TASK_LOG_FORMAT_BYTES] = {};
+        taskLog.Read(reinterpret_cast<uint8_t*>(line), sizeof(line) - 1);
+        if (!CHECK_STRING(expected, line))
+            return;
+    }
+}
+
+HOST_TEST(TaskLog, TruncatesReadsButPopsTheLine)
+{
+    DrainAll(taskLog);
+    WriteLine(taskLog, "0123456789");
+    WriteLine(taskLog, "next");
+
+    uint8_t line[TASK_LOG_FORMAT_BYTES] = {};
+    CHECK_EQUAL(4, taskLog.Read(line, 4));
+    CHECK(memcmp(line, "0123", 4) == 0);
+    CHECK_EQUAL(4, taskLog.Read(line, sizeof(line)));
+    CHECK(memcmp(line, "next", 4) == 0);
+}
+
+HOST_TEST(TaskLog, DropsWhenFullWithoutConsumer)
+{
+    TaskLog::SetConsumer(nullptr, 0);
+    DrainAll(taskLog);
+
+    const uint32_t dropped = taskLog.GetDroppedCount();
+    const uint16_t count = Fill(taskLog);
+    CHECK_EQUAL((TASK_LOG_RING_BYTES / (sizeof(TaskLogEntryHeader) + 40)), count);
+    CHECK_EQUAL(dropped + 1, taskLog.GetDroppedCount());
+    CHECK_EQUAL(0, HostRtos::GetNotifyCount());
+}
+
+HOST_TEST(TaskLog, WaitsForTheConsumerWhenFull)
+{
+    TaskLog::SetConsumer(&consumerTask, 1);
+    DrainAll(taskLog);
+    Fill(taskLog);
+
+    // Every further line is delivered once the consumer frees space
+    const uint32_t dropped = taskLog.GetDroppedCount();
+    HostRtos::SetDelayHook(ConsumeOneLine, &taskLog);
+    for (uint16_t i = 0; i < 50; i++)
+        CHECK(WriteLine(taskLog, "%040d", i));
+
+    CHECK_EQUAL(dropped, taskLog.GetDroppedCount());
+    CHECK(HostRtos::GetNotifyCount() >= 50);
+    TaskLog::SetConsumer(nullptr, 0);
+}
+
+HOST_TEST(TaskLog, GivesUpOnAStalledConsumer)
+{
+    TaskLog::SetConsumer(&consumerTask, 1);
+    DrainAll(taskLog);
+    Fill(taskLog);
+
+    const uint32_t dropped = taskLog.GetDroppedCount();
+    const TickType_t start = xTaskGetTickCount();
+    CHECK(!WriteLine(taskLog, "%040d", -1));
+    CHECK_EQUAL(MS_TO_TICKS(TASK_LOG_FULL_WAIT_MS), xTaskGetTickCount() - start);
+    CHECK_EQUAL(dropped + 1, taskLog.GetDroppedCount());
+    TaskLog::SetConsumer(nullptr, 0);
+}
+
+HOST_TEST(TaskLog, NeverWaitsInAnInterruptOrOnTheConsumer)
+{
+    TaskLog::SetConsumer(nullptr, 0);
+    DrainAll(taskLog);
+    Fill(taskLog);
+    TaskLog::SetConsumer(&consumerTask, 1);
+
+    HostRtos::SetInsideInterrupt(true);
+    CHECK(!WriteLine(taskLog, "%040d", -2));
+    HostRtos::SetInsideInterrupt(false);
+
+    HostRtos::SetCurrentTask(&consumerTask);
+    CHECK(!WriteLine(taskLog, "%040d", -3));
+
+    HostRtos::SetCurrentTask(nullptr);
+    HostRtos::SetSchedulerRunning(false);
+    CHECK(!WriteLine(taskLog, "%040d", -4));
+
+    CHECK_EQUAL(0, xTaskGetTickCount());
+    CHECK_EQUAL(0, HostRtos::GetNotifyCount());
+    TaskLog::SetConsumer(nullptr, 0);
+}
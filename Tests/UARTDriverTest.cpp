@@ -0,0 +1,402 @@
+/**
+ ******************************************************************************
+ * File Name          : UARTDriverTest.cpp
+ * Description        : Host tests for UARTDriver on the USART and DMA register
+ *    model in Stub/HostPeripherals.hpp. Transmits through the DMA ping-pong
+ *    buffers leave the wire without gaps, a stalled transfer times out, the
+ *    circular receive stream hands over every byte, and concurrent producers
+ *    on the TXE interrupt ring never cut into each other's messages.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "UARTDriver.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    constexpr uint64_t BYTE_NS = 10ULL * 1000000000ULL / 115200;    // 8N1, 86.8us per byte
+    constexpr uint32_t TASK_EVENT_TEST = (1UL << 3);
+
+    // Memory a stream uses must be static, the model rebuilds pointers from 32 bit addresses
+    uint8_t txBuffers[2 * UART_DMA_TX_BUFFER_BYTES];
+    uint8_t rxBuffer[UART_DMA_RX_BUFFER_BYTES];
+    UARTTxRing txRing;
+
+    uint8_t testTask;    // Handle of the test thread, standing in for the transmitting task
+
+    class SpanReceiver : public UARTReceiverBase
+    {
+    public:
+        void InterruptRxData(uint8_t errors) override { (void)errors; received += (char)rxChar; }
+        bool InterruptRxSpan(const uint8_t* data, uint16_t len, uint8_t errors) override
+        {
+            (void)errors;
+            received.append(reinterpret_cast<const char*>(data), len);
+            spanCount++;
+            return true;
+        }
+
+        uint8_t rxChar = 0;
+        std::string received;
+        uint32_t spanCount = 0;
+    };
+
+    std::vector<uint8_t> MakeData(uint16_t len, uint8_t seed)
+    {
+        std::vector<uint8_t> data(len);
+        for (uint16_t i = 0; i < len; i++)
+            data[i] = (uint8_t)(seed + i * 7);
+        return data;
+    }
+
+    std::vector<uint8_t> GetWireBytes(USART_TypeDef* usart)
+    {
+        std::vector<uint8_t> bytes;
+        for (const HostWireByte& byte : HostPeripherals::GetTransmitted(usart))
+            bytes.push_back(byte.value);
+        return bytes;
+    }
+
+    // Number of places a byte did not follow the one before it straight away
+    uint32_t CountGaps(USART_TypeDef* usart)
+    {
+        const std::vector<HostWireByte>& wire = HostPeripherals::GetTransmitted(usart);
+        uint32_t gaps = 0;
+        for (size_t i = 1; i < wire.size(); i++)
+            gaps += (wire[i].endNs - wire[i - 1].endNs != BYTE_NS);
+        return gaps;
+    }
+
+    // UART5 transmitting through DMA1 Stream 7 as configured by UARTTask
+    struct DmaTxFixture
+    {
+        DmaTxFixture() : dma(DMA1, LL_DMA_STREAM_7, LL_DMA_CHANNEL_4, DMA1_Stream7_IRQn), uart(UART5)
+        {
+            HostPeripherals::Reset();
+            HostPeripherals::SetIrqHandler(UART5_IRQn, [this] { uart.HandleIRQ_UART(); });
+            HostPeripherals::SetIrqHandler(DMA1_Stream7_IRQn, [this] { uart.HandleIRQ_TxDMA(); });
+            HostRtos::SetCurrentTask(&testTask);
+            uart.ConfigureTxDMA(&dma, txBuffers);
+        }
+
+        DMAController dma;
+        UARTDriver uart;
+    };
+
+    // USART1 receiving through DMA2 Stream 2 as configured by UARTTask
+    struct DmaRxFixture
+    {
+        DmaRxFixture() : dma(DMA2, LL_DMA_STREAM_2, LL_DMA_CHANNEL_4, DMA2_Stream2_IRQn), uart(USART1)
+        {
+            HostPeripherals::Reset();
+            HostPeripherals::SetIrqHandler(USART1_IRQn, [this] { uart.HandleIRQ_UART(); });
+            HostPeripherals::SetIrqHandler(DMA2_Stream2_IRQn, [this] { uart.HandleIRQ_RxDMA(); });
+            uart.ConfigureRxDMA(&dma, rxBuffer);
+            uart.ReceiveIT(&receiver.rxChar, &receiver);
+        }
+
+        DMAController dma;
+        UARTDriver uart;
+        SpanReceiver receiver;
+    };
+
+    // USART1 transmitting through the TXE interrupt ring as configured by UARTTask
+    struct RingTxFixture
+    {
+        RingTxFixture() : uart(USART1)
+        {
+            HostPeripherals::Reset();
+            HostPeripherals::SetIrqHandler(USART1_IRQn, [this] { uart.HandleIRQ_UART(); });
+            uart.ConfigureTxInterrupt(&txRing);
+        }
+
+        UARTDriver uart;
+    };
+
+    constexpr uint8_t PRODUCER_COUNT = 3;
+    // 906 bytes in all, nearly twice the ring but less than UART_TX_RING_TIMEOUT_MS on the wire, so no wait can
+    // time out however the producers are ordered
+    constexpr uint8_t MESSAGES_PER_PRODUCER = 4;
+
+    // Producer id, sequence number and length, then bytes derived from all three, 4 to 153 bytes
+    std::vector<uint8_t> MakeMessage(uint8_t producer, uint8_t sequence)
+    {
+        const uint8_t len = (uint8_t)(4 + (producer * 37 + sequence * 23) % 150);
+        std::vector<uint8_t> message(len);
+        message[0] = producer;
+        message[1] = sequence;
+        message[2] = len;
+        for (uint8_t i = 3; i < len; i++)
+            message[i] = (uint8_t)(producer * 64 + sequence + i);
+        return message;
+    }
+
+    /**
+     * @brief Splits the wire into the messages of MakeMessage
+     * @return false if a message was cut into or corrupted by another
+    */
+    bool ParseMessages(const std::vector<uint8_t>& wire, std::vector<uint8_t> (&sequences)[PRODUCER_COUNT])
+    {
+        size_t pos = 0;
+        while (pos < wire.size()) {
+            if (pos + 3 > wire.size() || wire[pos] >= PRODUCER_COUNT)
+                return false;
+
+            const std::vector<uint8_t> message = MakeMessage(wire[pos], wire[pos + 1]);
+            if (pos + message.size() > wire.size() || !std::equal(message.begin(), message.end(), wire.begin() + pos))
+                return false;
+
+            sequences[wire[pos]].push_back(wire[pos + 1]);
+            pos += message.size();
+        }
+        return true;
+    }
+
+    struct Producer
+    {
+        UARTDriver* uart;
+        uint8_t id;
+        bool useTryTransmit;    // Retry TryTransmit every tick instead of waiting in Transmit
+        uint32_t failures;
+        uint32_t refusals;
+    };
+
+    // Task sending its messages as a header and body segment, pausing 0-2 ticks between them
+    void ProduceMessages(void* context)
+    {
+        Producer& producer = *static_cast<Producer*>(context);
+        for (uint8_t sequence = 0; sequence < MESSAGES_PER_PRODUCER; sequence++) {
+            const std::vector<uint8_t> message = MakeMessage(producer.id, sequence);
+            const UARTSegment segments[] = { { message.data(), 3 }, { message.data() + 3, (uint16_t)(message.size() - 3) } };
+
+            if (producer.useTryTransmit) {
+                while (!producer.uart->TryTransmit(segments, 2)) {
+                    producer.refusals++;
+                    vTaskDelay(1);
+                }
+            }
+            else if (!producer.uart->Transmit(segments, 2)) {
+                producer.failures++;
+            }
+
+            vTaskDelay(sequence % 3);
+        }
+    }
+
+    // Runs the producers as concurrent tasks and checks every message reached the wire whole and in order
+    void RunProducers(RingTxFixture& fixture, Producer (&producers)[PRODUCER_COUNT])
+    {
+        uint8_t handles[PRODUCER_COUNT];
+        for (uint8_t i = 0; i < PRODUCER_COUNT; i++)
+            HostRtos::CreateTask(ProduceMessages, &producers[i], &handles[i]);
+        CHECK(HostRtos::RunTasks(5000));
+        CHECK(fixture.uart.FlushTx());
+
+        std::vector<uint8_t> sequences[PRODUCER_COUNT];
+        CHECK(ParseMessages(GetWireBytes(USART1), sequences));
+        for (uint8_t i = 0; i < PRODUCER_COUNT; i++) {
+            CHECK_EQUAL(0, producers[i].failures);
+            CHECK_EQUAL(MESSAGES_PER_PRODUCER, sequences[i].size());
+            for (uint8_t sequence = 0; sequence < sequences[i].size(); sequence++)
+                CHECK_EQUAL(sequence, sequences[i][sequence]);
+        }
+        CHECK_EQUAL(0, HostPeripherals::GetTxOverwriteCount(USART1));
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(UARTDriver, DmaTransmitWaitsOnlyWhileBothBuffersAreInUse)
+{
+    DmaTxFixture fixture;
+    std::vector<uint8_t> first = MakeData(200, 1);
+    std::vector<uint8_t> second = MakeData(200, 2);
+
+    // The first message goes straight onto the wire, the second into the other buffer behind it
+    CHECK(fixture.uart.Transmit(first.data(), (uint16_t)first.size()));
+    CHECK_EQUAL(0, HostRtos::GetTimeNs());
+    CHECK(fixture.uart.Transmit(second.data(), (uint16_t)second.size()));
+
+    // The second waited for the first transfer to complete, its last byte then still in the data register
+    const uint64_t returnedNs = HostRtos::GetTimeNs();
+    CHECK(returnedNs >= 198 * BYTE_NS && returnedNs <= 200 * BYTE_NS);
+
+    CHECK(fixture.uart.FlushTx());
+    std::vector<uint8_t> expected = first;
+    expected.insert(expected.end(), second.begin(), second.end());
+    CHECK(GetWireBytes(UART5) == expected);
+    CHECK_EQUAL(0, CountGaps(UART5));
+    CHECK_EQUAL(0, HostPeripherals::GetTxOverwriteCount(UART5));
+}
+
+HOST_TEST(UARTDriver, DmaTransmitLongerThanABufferIsGapFree)
+{
+    DmaTxFixture fixture;
+    std::vector<uint8_t> data = MakeData(600, 3);
+
+    // 256 + 256 + 88, each buffer starts as the one before it completes
+    CHECK(fixture.uart.Transmit(data.data(), (uint16_t)data.size()));
+    CHECK(fixture.uart.FlushTx());
+
+    CHECK(GetWireBytes(UART5) == data);
+    CHECK_EQUAL(0, CountGaps(UART5));
+
+    UARTLinkStats stats;
+    fixture.uart.GetLinkStats(stats);
+    CHECK_EQUAL(600, stats.txBytes);
+    CHECK_EQUAL(3, stats.isrCount);    // One transfer complete per buffer
+}
+
+HOST_TEST(UARTDriver, DmaSegmentsAreGatheredIntoOneTransfer)
+{
+    DmaTxFixture fixture;
+    const uint8_t header[] = { 0xAA, 0x55, 3 };
+    const uint8_t body[] = { 'a', 'b', 'c' };
+    const uint8_t crc[] = { 0x12, 0x34 };
+    const UARTSegment segments[] = { { header, sizeof(header) }, { body, sizeof(body) }, { crc, sizeof(crc) } };
+
+    CHECK(fixture.uart.Transmit(segments, 3));
+    CHECK(fixture.uart.FlushTx());
+
+    const std::vector<uint8_t> expected = { 0xAA, 0x55, 3, 'a', 'b', 'c', 0x12, 0x34 };
+    CHECK(GetWireBytes(UART5) == expected);
+    CHECK_EQUAL(0, CountGaps(UART5));
+}
+
+HOST_TEST(UARTDriver, TryTransmitIsRefusedWhileTheStreamIsBusy)
+{
+    DmaTxFixture fixture;
+    fixture.uart.SetTxNotifyTarget(&testTask, TASK_EVENT_TEST);
+    std::vector<uint8_t> first = MakeData(100, 4);
+    std::vector<uint8_t> second = MakeData(50, 5);
+    const UARTSegment firstSegment = { first.data(), (uint16_t)first.size() };
+    const UARTSegment secondSegment = { second.data(), (uint16_t)second.size() };
+
+    CHECK(fixture.uart.TryTransmit(&firstSegment, 1));
+    CHECK(!fixture.uart.TryTransmit(&secondSegment, 1));
+
+    // The notify target is told when the transfer completes, the retry then starts at once
+    uint32_t events = 0;
+    CHECK(xTaskNotifyWait(0, TASK_EVENT_TEST, &events, MS_TO_TICKS(20)) == pdTRUE);
+    CHECK_EQUAL(TASK_EVENT_TEST, events);
+    CHECK(fixture.uart.TryTransmit(&secondSegment, 1));
+
+    CHECK(fixture.uart.FlushTx());
+    std::vector<uint8_t> expected = first;
+    expected.insert(expected.end(), second.begin(), second.end());
+    CHECK(GetWireBytes(UART5) == expected);
+
+    UARTLinkStats stats;
+    fixture.uart.GetLinkStats(stats);
+    CHECK_EQUAL(150, stats.txBytes);
+}
+
+HOST_TEST(UARTDriver, StalledDmaTransferTimesOut)
+{
+    DmaTxFixture fixture;
+    std::vector<uint8_t> data = MakeData(300, 6);
+
+    // Nothing leaves the transmitter, the second buffer waits for the first until the timeout
+    HostPeripherals::HoldTx(UART5, true);
+    CHECK(!fixture.uart.Transmit(data.data(), (uint16_t)data.size()));
+    CHECK_EQUAL(UART_DMA_TX_TIMEOUT_MS, xTaskGetTickCount());
+    CHECK(!fixture.dma.IsBusy());
+
+    // The stream was stopped, the next transmit starts a fresh transfer
+    HostPeripherals::HoldTx(UART5, false);
+    std::vector<uint8_t> next = MakeData(10, 7);
+    CHECK(fixture.uart.Transmit(next.data(), (uint16_t)next.size()));
+    CHECK(fixture.uart.FlushTx());
+
+    // Only the byte that was already in the data register went out before it
+    const std::vector<uint8_t> wire = GetWireBytes(UART5);
+    CHECK_EQUAL(next.size() + 1, wire.size());
+    CHECK(std::vector<uint8_t>(wire.end() - next.size(), wire.end()) == next);
+}
+
+HOST_TEST(UARTDriver, DmaReceiveHandsOverEveryByte)
+{
+    DmaRxFixture fixture;
+
+    // A burst longer than the buffer wraps it, then a short frame is handed over on IDLE
+    std::vector<uint8_t> burst = MakeData(300, 8);
+    std::vector<uint8_t> frame = MakeData(20, 9);
+    HostPeripherals::Receive(USART1, burst.data(), (uint16_t)burst.size());
+    osDelay(40);
+    HostPeripherals::Receive(USART1, frame.data(), (uint16_t)frame.size());
+    osDelay(5);
+
+    std::string expected(burst.begin(), burst.end());
+    expected.append(frame.begin(), frame.end());
+    CHECK(fixture.receiver.received == expected);
+    CHECK(fixture.receiver.spanCount >= 4);    // Half, complete, wrap and IDLE for the burst, IDLE for the frame
+    CHECK_EQUAL(0, HostPeripherals::GetStolenReadCount(USART1));
+    CHECK_EQUAL(0, HostPeripherals::GetRxOverrunCount(USART1));
+
+    UARTLinkStats stats;
+    fixture.uart.GetLinkStats(stats);
+    CHECK_EQUAL(burst.size() + frame.size(), stats.rxBytes);
+    CHECK_EQUAL(0, stats.overrunErrors);
+}
+
+HOST_TEST(UARTDriver, IdleInterruptLeavesTheNextByteToTheStream)
+{
+    DmaRxFixture fixture;
+    std::vector<uint8_t> first = MakeData(10, 10);
+    std::vector<uint8_t> second = MakeData(10, 11);
+
+    // The line goes idle after the first frame, but the interrupt is held off until the next frame's first byte
+    // is in DR and the stream has not taken it yet
+    HostPeripherals::HoldIrqs(HostRtos::GetTimeNs() + 1000000 + BYTE_NS);
+    HostPeripherals::Receive(USART1, first.data(), (uint16_t)first.size());
+    osDelay(1);
+    HostPeripherals::Receive(USART1, second.data(), (uint16_t)second.size());
+    osDelay(5);
+
+    std::string expected(first.begin(), first.end());
+    expected.append(second.begin(), second.end());
+    CHECK(fixture.receiver.received == expected);
+    CHECK_EQUAL(0, HostPeripherals::GetStolenReadCount(USART1));
+}
+
+HOST_TEST(UARTDriver, RingTransmitReturnsBeforeTheWire)
+{
+    RingTxFixture fixture;
+    std::vector<uint8_t> data = MakeData(400, 12);
+
+    // The message fits the ring, the caller does not wait for the ~35ms it takes on the wire
+    CHECK(fixture.uart.Transmit(data.data(), (uint16_t)data.size()));
+    CHECK_EQUAL(0, HostRtos::GetTimeNs());
+
+    CHECK(fixture.uart.FlushTx());
+    CHECK(GetWireBytes(USART1) == data);
+    CHECK_EQUAL(0, CountGaps(USART1));    // The TXE interrupt refills the data register within a frame
+}
+
+HOST_TEST(UARTDriver, RingProducersNeverInterleave)
+{
+    RingTxFixture fixture;
+    Producer producers[PRODUCER_COUNT] = { { &fixture.uart, 0, false, 0, 0 }, { &fixture.uart, 1, false, 0, 0 },
+        { &fixture.uart, 2, false, 0, 0 } };
+
+    // The producers offer more than the ring holds at once, so they wait for room in turn
+    RunProducers(fixture, producers);
+
+    UARTLinkStats stats;
+    fixture.uart.GetLinkStats(stats);
+    CHECK(stats.txBusyTicks > 0);
+}
+
+HOST_TEST(UARTDriver, RingTryTransmitProducersNeverInterleave)
+{
+    RingTxFixture fixture;
+    Producer producers[PRODUCER_COUNT] = { { &fixture.uart, 0, true, 0, 0 }, { &fixture.uart, 1, true, 0, 0 },
+        { &fixture.uart, 2, true, 0, 0 } };
+
+    // A refused message is pushed whole on a later try, never part of it
+    RunProducers(fixture, producers);
+    CHECK(producers[0].refusals + producers[1].refusals + producers[2].refusals > 0);
+}
@@ -0,0 +1,217 @@
+/**
+ ******************************************************************************
+ * File Name          : UtilsTest.cpp
+ * Description        : Host tests for Utils::FormatStringV, compared against the
+ *    host printf, which rounds exact binary ties to even like newlib.
+ ******************************************************************************
+*/
+#include "HostTest.hpp"
+#include "Utils.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+/* Helpers -------------------------------------------------------------------*/
+namespace {
+    constexpr uint16_t FORMAT_TEST_BUFFER_BYTES = 96;
+
+    const char* const INT_FORMATS[] = {
+        "%d", "%+d", "% d", "%i", "%6d", "%-6d|", "%06d", "%+06d", "% 06d", "%-+6d|",
+        "%.3d", "%8.3d", "%-8.3d|", "%08.3d", "%.0d", "%+.0d", "% .0d", "%*d", "%-*d|"
+    };
+    const char* const UNSIGNED_FORMATS[] = {
+        "%u", "%x", "%X", "%8x", "%08X", "%-8x|", "%.6x", "%+u", "% u", "%.0u"
+    };
+    const char* const FLOAT_FORMATS[] = {
+        "%f", "%.0f", "%.1f", "%.2f", "%.3f", "%.4f", "%.5f", "%.6f", "%.7f", "%.9f", "%+.2f", "% .2f",
+        "%8.2f", "%-8.2f|", "%08.2f", "%+08.2f", "% 08.3f", "%-+9.1f|", "%.*f", "%F"
+    };
+
+    /**
+     * @brief Formats with FormatStringV and the host snprintf, and checks they agree
+    */
+    bool FormatsLikePrintf(const char* format, ...)
+    {
+        char actual[FORMAT_TEST_BUFFER_BYTES];
+        char expected[FORMAT_TEST_BUFFER_BYTES];
+
+        va_list args;
+        va_start(args, format);
+        va_list hostArgs;
+        va_copy(hostArgs, args);
+        const uint16_t len = Utils::FormatStringV(actual, sizeof(actual), format, args);
+        vsnprintf(expected, sizeof(expected), format, hostArgs);
+        va_end(hostArgs);
+        va_end(args);
+
+        const bool passed = CHECK_STRING(expected, actual) && CHECK_EQUAL(strlen(expected), len);
+        if (!passed)
+            printf("  format \"%s\"\n", format);
+        return passed;
+    }
+
+    /**
+     * @brief Small deterministic generator, the tests must not change from run to run
+    */
+    uint32_t NextRandom(uint32_t& state)
+    {
+        state = state * 1664525UL + 1013904223UL;
+        return state;
+    }
+}
+
+/* Tests ---------------------------------------------------------------------*/
+HOST_TEST(Utils, FormatsSignedIntegersLikePrintf)
+{
+    const int32_t edges[] = { 0, 1, -1, 9, -9, 10, -10, 99, -99, 100, -100, 12345, -12345, 999999, -1000000,
+                              INT32_MAX, INT32_MIN, INT32_MIN + 1 };
+
+    for (const char* format : INT_FORMATS) {
+        const bool star = strchr(format, '*') != nullptr;
+        for (int32_t value : edges) {
+            if (!(star ? FormatsLikePrintf(format, 7, value) : FormatsLikePrintf(format, value)))
+                return;
+        }
+        for (int32_t value = -2100; value <= 2100; value++) {
+            if (!(star ? FormatsLikePrintf(format, -5, value) : FormatsLikePrintf(format, value)))
+                return;
+        }
+        uint32_t state = 1;
+        for (uint32_t i = 0; i < 20000; i++) {
+            const int32_t value = static_cast<int32_t>(NextRandom(state)) >> (i % 31);
+            if (!(star ? FormatsLikePrintf(format, 12, value) : FormatsLikePrintf(format, value)))
+                return;
+        }
+    }
+}
+
+HOST_TEST(Utils, FormatsUnsignedIntegersLikePrintf)
+{
+    for (const char* format : UNSIGNED_FORMATS) {
+        uint32_t state = 7;
+        const uint32_t edges[] = { 0, 1, 9, 10, 15, 16, 255, 256, 0xFFFF, 0x10000, INT32_MAX, 0x80000000UL, UINT32_MAX };
+        for (uint32_t value : edges) {
+            if (!FormatsLikePrintf(format, value))
+                return;
+        }
+        for (uint32_t i = 0; i < 20000; i++) {
+            if (!FormatsLikePrintf(format, NextRandom(state) >> (i % 32)))
+                return;
+        }
+    }
+}
+
+HOST_TEST(Utils, FormatsLongIntegersLikePrintf)
+{
+    const long long edges[] = { 0, -1, 1, 4294967295LL, 4294967296LL, -4294967296LL, 1234567890123LL,
+                                std::numeric_limits<long long>::max(), std::numeric_limits<long long>::min() };
+    for (long long value : edges) {
+        FormatsLikePrintf("%lld", value);
+        FormatsLikePrintf("%+20lld", value);
+        FormatsLikePrintf("%-20lld|", value);
+        FormatsLikePrintf("%llx", static_cast<unsigned long long>(value));
+        FormatsLikePrintf("%llu", static_cast<unsigned long long>(value));
+        FormatsLikePrintf("%ld", static_cast<long>(value));
+    }
+}
+
+HOST_TEST(Utils, FormatsFloatsLikePrintf)
+{
+    for (const char* format : FLOAT_FORMATS) {
+        const bool star = strchr(format, '*') != nullptr;
+        const double edges[] = { 0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 1.5, 2.5, -2.5, 0.05, 0.125, -0.125, 0.375,
+                                 0.9996, -0.9996, 9.9999995, 99.995, 123456.5, -123456.5, 1e-7, -1e-7, 16777216.0 };
+        for (double value : edges) {
+            const double narrowed = static_cast<float>(value);
+            if (!(star ? FormatsLikePrintf(format, 3, narrowed) : FormatsLikePrintf(format, narrowed)))
+                return;
+        }
+
+        // Exact binary fractions hit every rounding tie, each must round half to even
+        for (int32_t numerator = -4096; numerator <= 4096; numerator++) {
+            for (uint8_t shift = 1; shift <= 10; shift++) {
+                const double value = std::ldexp(static_cast<double>(numerator), -shift);
+                if (!(star ? FormatsLikePrintf(format, shift % 7, value) : FormatsLikePrintf(format, value)))
+                    return;
+            }
+        }
+
+        // Any float a sensor produces, across magnitudes
+        uint32_t state = 3;
+        for (uint32_t i = 0; i < 20000; i++) {
+            uint32_t bits = NextRandom(state);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            if (!std::isfinite(value) || std::fabs(value) >= 1e9f)
+                continue;
+            if (!(star ? FormatsLikePrintf(format, i % 7, static_cast<double>(value)) : FormatsLikePrintf(format, static_cast<double>(value))))
+                return;
+        }
+    }
+}
+
+HOST_TEST(Utils, FormatsSpecialFloats)
+{
+    char buffer[FORMAT_TEST_BUFFER_BYTES];
+
+    Utils::FormatString(buffer, sizeof(buffer), "%f|%f|%+.2f", INFINITY, -INFINITY, INFINITY);
+    CHECK_STRING("inf|-inf|+inf", buffer);
+
+    Utils::FormatString(buffer, sizeof(buffer), "%f|%08.2f", NAN, -INFINITY);
+    CHECK_STRING("nan|    -inf", buffer);
+
+    Utils::FormatString(buffer, sizeof(buffer), "%f", 2e19);
+    CHECK_STRING("ovf", buffer);
+
+    Utils::FormatString(buffer, sizeof(buffer), "%.2f", -0.001);
+    CHECK_STRING("-0.00", buffer);
+}
+
+HOST_TEST(Utils, FormatsStringsAndCharacters)
+{
+    FormatsLikePrintf("%s|%5s|%-5s|%.2s|%c|%3c|%-3c|%%", "abc", "ab", "ab", "abc", 'x', 'y', 'z');
+    FormatsLikePrintf("[%s] %d %s", "TaskLog", -7, "");
+
+    char buffer[FORMAT_TEST_BUFFER_BYTES];
+    Utils::FormatString(buffer, sizeof(buffer), "%s", static_cast<const char*>(nullptr));
+    CHECK_STRING("(null)", buffer);
+
+    // Unsupported conversions are copied so the mistake shows in the output
+    Utils::FormatString(buffer, sizeof(buffer), "%e|%d", 5);
+    CHECK_STRING("%e|5", buffer);
+}
+
+HOST_TEST(Utils, TruncatesToTheBuffer)
+{
+    char buffer[8];
+    memset(buffer, 'x', sizeof(buffer));
+
+    CHECK_EQUAL(7, Utils::FormatString(buffer, sizeof(buffer), "%d", -123456789));
+    CHECK_STRING("-123456", buffer);
+
+    CHECK_EQUAL(3, Utils::FormatString(buffer, 4, "%.2f", 12.345));
+    CHECK_STRING("12.", buffer);
+
+    CHECK_EQUAL(0, Utils::FormatString(buffer, 1, "abc"));
+    CHECK_STRING("", buffer);
+
+    buffer[0] = 'x';
+    CHECK_EQUAL(0, Utils::FormatString(buffer, 0, "abc"));
+    CHECK_EQUAL('x', buffer[0]);
+}
+
+HOST_TEST(Utils, FormatsFixedPoint)
+{
+    char buffer[FORMAT_TEST_BUFFER_BYTES];
+
+    Utils::FormatFixed(buffer, sizeof(buffer), -1205, 2);
+    CHECK_STRING("-12.05", buffer);
+    Utils::FormatFixed(buffer, sizeof(buffer), -5, 2);
+    CHECK_STRING("-0.05", buffer);
+    Utils::FormatFixed(buffer, sizeof(buffer), INT32_MIN, 3);
+    CHECK_STRING("-2147483.648", buffer);
+    Utils::FormatFixed(buffer, sizeof(buffer), 42, 0);
+    CHECK_STRING("42", buffer);
+}
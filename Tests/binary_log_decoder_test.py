@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+Host tests for SoarDebug/Tools/binary_log_decoder.py, run by ctest.
+
+Builds a minimal 32-bit ELF holding the format strings at firmware-like addresses
+and checks captures that mix SOAR_PRINT text with BinaryLog records.
+"""
+import io
+import os
+import struct
+import sys
+import tempfile
+import unittest
+
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Components", "SoarDebug", "Tools"))
+import binary_log_decoder as decoder  # noqa: E402
+
+RODATA_ADDRESS = 0x08010000
+BSS_ADDRESS = 0x20000000
+
+
+def build_elf(rodata):
+    """Returns an ELF with a loaded .rodata at RODATA_ADDRESS and a .bss at BSS_ADDRESS that is not in the file."""
+    header_bytes = 52
+    section_bytes = 40
+    sections = [
+        (0, 0, 0, 0, 0),                                       # Null section
+        (1, decoder.SHF_ALLOC, RODATA_ADDRESS, header_bytes, len(rodata)),
+        (decoder.SHT_NOBITS, decoder.SHF_ALLOC | 1, BSS_ADDRESS, 0, 64),
+    ]
+    shoff = header_bytes + len(rodata)
+
+    elf = bytearray(b"\x7fELF" + bytes([1, 1, 1]) + bytes(9))
+    elf += struct.pack("<HHIIIIIHHHHHH", 2, 40, 1, 0, 0, shoff, 0, header_bytes, 0, 0, section_bytes, len(sections), 0)
+    elf += rodata
+    for sh_type, sh_flags, sh_addr, sh_offset, sh_size in sections:
+        elf += struct.pack("<IIIIIIIIII", 0, sh_type, sh_flags, sh_addr, sh_offset, sh_size, 0, 0, 4, 0)
+    return bytes(elf)
+
+
+def record(format_address, timestamp_ms, *args):
+    """Encodes a record like BinaryLog::Drain."""
+    return struct.pack("<BBII%dI" % len(args), decoder.SYNC_BYTE, len(args), format_address, timestamp_ms, *args)
+
+
+def float_bits(value):
+    return struct.unpack("<I", struct.pack("<f", value))[0]
+
+
+class ChunkedStream:
+    """Returns at most chunk bytes per read, like a serial port."""
+
+    def __init__(self, data, chunk):
+        self.data = data
+        self.chunk = chunk
+
+    def read(self, size):
+        size = min(size, self.chunk)
+        piece, self.data = self.data[:size], self.data[size:]
+        return piece
+
+
+class BinaryLogDecoderTest(unittest.TestCase):
+    STRINGS = [b"Temp %d C, mass %.2f kg\n", b"%s: %u records, 0x%08X, %c%%\n", b"LoadCell", b"Two %d %d\n"]
+
+    def setUp(self):
+        rodata = bytearray()
+        self.addresses = []
+        for string in self.STRINGS:
+            self.addresses.append(RODATA_ADDRESS + len(rodata))
+            rodata += string + b"\0"
+        handle, self.elf_path = tempfile.mkstemp(suffix=".elf")
+        with os.fdopen(handle, "wb") as f:
+            f.write(build_elf(bytes(rodata)))
+        self.elf = decoder.ElfImage(self.elf_path)
+
+    def tearDown(self):
+        os.remove(self.elf_path)
+
+    def decode(self, capture, chunk=256):
+        out = io.StringIO()
+        decoder.decode(self.elf, ChunkedStream(capture, chunk), out)
+        return out.getvalue()
+
+    def test_renders_signed_and_float_arguments(self):
+        capture = record(self.addresses[0], 1234, 0xFFFFFFD8, float_bits(1.5))
+        self.assertEqual(self.decode(capture), "[      1234 ms] Temp -40 C, mass 1.50 kg\n")
+
+    def test_renders_strings_from_the_elf_and_other_conversions(self):
+        capture = record(self.addresses[1], 7, self.addresses[2], 42, 0xBEEF, ord("x"))
+        self.assertEqual(self.decode(capture), "[         7 ms] LoadCell: 42 records, 0x0000BEEF, x%\n")
+
+    def test_passes_text_through_between_records(self):
+        capture = b"boot\r\n" + record(self.addresses[3], 1, 1, 2) + b"text " + record(self.addresses[3], 2, 3, 4)
+        self.assertEqual(self.decode(capture), "boot\r\n[         1 ms] Two 1 2\ntext [         2 ms] Two 3 4\n")
+
+    def test_reassembles_records_split_across_reads(self):
+        capture = b"a" + record(self.addresses[0], 5, 7, float_bits(-0.25)) + b"b"
+        for chunk in range(1, len(capture) + 1):
+            self.assertEqual(self.decode(capture, chunk), "a[         5 ms] Temp 7 C, mass -0.25 kg\nb")
+
+    def test_reports_unknown_formats_and_missing_arguments(self):
+        self.assertEqual(self.decode(record(0x1000, 3, 0xAB)), "[         3 ms] <unknown format 0x00001000> 0x000000AB\n")
+        self.assertEqual(self.decode(record(BSS_ADDRESS, 3)), "[         3 ms] <unknown format 0x%08X> \n" % BSS_ADDRESS)
+        self.assertEqual(self.decode(record(self.addresses[3], 4, 9)), "[         4 ms] Two 9 <missing>\n")
+        self.assertEqual(self.decode(record(self.addresses[1], 4, 0x1000, 1, 2, 3)),
+                         "[         4 ms] <str 0x00001000>: 1 records, 0x00000002, \x03%\n")
+
+    def test_skips_a_sync_byte_that_is_not_a_record(self):
+        capture = bytes([decoder.SYNC_BYTE, decoder.MAX_ARGS + 1]) + b"ok"
+        self.assertEqual(self.decode(capture), "?\x07ok")
+
+    def test_waits_for_the_rest_of_a_truncated_record(self):
+        self.assertEqual(self.decode(record(self.addresses[0], 1, 1, 2)[:-1]), "")
+
+
+if __name__ == "__main__":
+    unittest.main()